@@ -0,0 +1,998 @@
+// Micro-benchmarks. Usage: fnn_bench <command> [args...]
+//
+//   backends [trials] [seed]  differential check + timing of every kernel
+//                             backend against "reference"
+//   gemm-tune M N K           time the autotuner's candidate GEMM
+//                             configurations for one shape
+//   dense-packed [in] [out]   Dense forward latency for batch sizes 1-64,
+//                             packing W per call vs pre-packed weights
+//   dense-backward [batch] [in] [out]
+//                             fused Dense backward vs separate dZ, db, dW
+//                             and dX passes: dY-side bytes read and time
+//   buffer-pool [threads] [iters]
+//                             churn of short-lived tensors, pooled Tensor2D
+//                             vs plain std::vector, with pool hit rates
+//   huge-pages [gemv_n] [gemm_n]
+//                             GEMV / GEMM throughput with buffers on huge
+//                             pages vs regular 4 KiB pages
+//   gemm-scaling [M] [N] [K]  GEMM throughput and parallel efficiency for
+//                             1 thread up to the whole pool (FNN_NUM_THREADS)
+//   strassen [n] [depth]      Strassen-Winograd at 1..depth levels vs the
+//                             classical GEMM: time and error on sampled rows
+//                             against an extended-precision reference, then
+//                             the tuned crossover
+//   conv1d [batch] [length] [out_channels]
+//                             Conv1D forward / backward, im2col GEMM vs
+//                             direct loops, over in_channels x kernel_size
+//   conv2d [batch] [size] [in_channels] [out_channels]
+//                             3 x 3 Conv2D forward / backward on the NCHWc
+//                             layout vs NCHW im2col + GEMM
+//   predict [width] [depth]   single-sample Dense latency, packed GEMM with
+//                             one row vs the GEMV path, and Sequential
+//                             predict over `depth` layers
+//   incremental [in] [hidden] Sequential predict_incremental per event vs
+//                             predict, by number of changed features
+//   moe [batch] [width] [experts]
+//                             MixtureOfExperts forward for top-k = 1, 2, 4
+//                             vs running every expert on every row
+//   sampled-softmax [classes] [hidden] [batch] [samples]
+//                             sampled softmax loss + gradients vs the full
+//                             softmax loss alone, and the loss estimate
+//   hsoftmax [classes] [hidden] [batch]
+//                             hierarchical softmax loss + gradients and
+//                             greedy decode vs the full softmax and argmax
+//   mips [classes] [hidden] [queries]
+//                             top-10 of a wide Dense layer: full logits +
+//                             top_k vs a full sort, and MipsIndex latency
+//                             and recall per probe count
+//   predict-cache [width] [distinct] [capacity]
+//                             PredictCache in front of Sequential predict on
+//                             Zipf-distributed repeated inputs
+//   graph [width] [branches] [blocks]
+//                             GraphModel predict over residual blocks of
+//                             parallel Dense branches vs running the same
+//                             layers one by one, with the buffer plan
+
+#include "fnn/fnn.hpp"
+#include "fnn/util/buffer_pool.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Best-of-`reps` wall time of fn(), in seconds.
+template <typename F>
+double best_time(int reps, F&& fn) {
+    double best = 0.0;
+    for (int i = 0; i < reps; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        best = i == 0 ? took.count() : std::min(best, took.count());
+    }
+    return best;
+}
+
+int bench_backends(int argc, char** argv) {
+    const std::size_t trials = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 4;
+    const std::uint64_t seed = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 42;
+
+    std::printf("%-12s %-10s %-20s %12s %12s\n", "kernel", "backend", "shape", "max|err|",
+                "ms");
+    for (const auto& row : fnn::compare_backends(trials, seed)) {
+        std::printf("%-12s %-10s %-20s %12.3e %12.3f\n", row.kernel.c_str(), row.backend.c_str(),
+                    row.shape.c_str(), row.max_abs_error, row.seconds * 1e3);
+    }
+    return 0;
+}
+
+int bench_gemm_tune(int argc, char** argv) {
+    if (argc < 3) {
+        return -1;
+    }
+    const auto m = std::strtoull(argv[0], nullptr, 10);
+    const auto n = std::strtoull(argv[1], nullptr, 10);
+    const auto k = std::strtoull(argv[2], nullptr, 10);
+    const auto trials = fnn::benchmark_gemm_configs(m, n, k);
+    const double flops =
+        2.0 * static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k);
+
+    std::printf("host: %s\n", fnn::gemm_host_key().c_str());
+    std::printf("%6s %6s %6s %8s %12s %10s\n", "mc", "kc", "nc", "threads", "ms", "GFLOP/s");
+    for (const auto& t : trials) {
+        std::printf("%6zu %6zu %6zu %8zu %12.3f %10.2f\n", t.config.mc, t.config.kc, t.config.nc,
+                    t.config.threads, t.seconds * 1e3,
+                    t.seconds > 0.0 ? flops / t.seconds * 1e-9 : 0.0);
+    }
+    return 0;
+}
+
+int bench_dense_packed(int argc, char** argv) {
+    const std::size_t in = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 512;
+    const std::size_t out = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 512;
+    fnn::Dense layer(in, out, fnn::CounterRng(1));
+    layer.set_training(false);
+    const auto& w = layer.weights();
+    const fnn::MatrixRef wt{w.data(), in, out, 1, in};
+
+    std::printf("Dense %zu -> %zu, packed weights %zu KiB\n", in, out,
+                fnn::PackedMatrix(wt).bytes() / 1024);
+    std::printf("%6s %14s %14s %9s\n", "batch", "repack us", "prepacked us", "speedup");
+    for (std::size_t batch = 1; batch <= 64; batch *= 2) {
+        fnn::Tensor2D x(batch, in);
+        fnn::fill_uniform(x, fnn::CounterRng(2), -1.0, 1.0);
+        fnn::Tensor2D y(batch, out);
+        const auto repack = best_time(50, [&] {
+            for (std::size_t r = 0; r < batch; ++r) {
+                std::copy(layer.bias().data(), layer.bias().data() + out, y.data() + r * out);
+            }
+            fnn::gemm(1.0, {x.data(), batch, in, in, 1}, wt, 1.0, {y.data(), batch, out, out, 1});
+        });
+        const auto packed = best_time(50, [&] { y = layer.forward_batch(x); });
+        std::printf("%6zu %14.2f %14.2f %8.2fx\n", batch, repack * 1e6, packed * 1e6,
+                    repack / packed);
+    }
+    return 0;
+}
+
+int bench_dense_backward(int argc, char** argv) {
+    const std::size_t batch = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 128;
+    const std::size_t in = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 512;
+    const std::size_t out = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 512;
+    fnn::Dense layer(in, out, fnn::CounterRng(1), fnn::ActivationKind::Sigmoid);
+    fnn::Tensor2D x(batch, in);
+    fnn::Tensor2D dy(batch, out);
+    fnn::fill_uniform(x, fnn::CounterRng(2), -1.0, 1.0);
+    fnn::fill_uniform(dy, fnn::CounterRng(3), -1.0, 1.0);
+    const auto y = layer.forward_batch(x);
+    const auto& w = layer.weights();
+
+    // Unfused: materialize dZ = dY * y(1 - y), then one pass each for db,
+    // dW and dX.
+    fnn::Tensor2D dz(batch, out);
+    fnn::Tensor2D dw(out, in);
+    fnn::Tensor2D db(1, out);
+    fnn::Tensor2D dx(batch, in);
+    const auto unfused = best_time(10, [&] {
+        for (std::size_t i = 0; i < dz.size(); ++i) {
+            dz.data()[i] = dy.data()[i] * y.data()[i] * (1.0 - y.data()[i]);
+        }
+        for (std::size_t r = 0; r < batch; ++r) {
+            for (std::size_t j = 0; j < out; ++j) {
+                db.data()[j] += dz(r, j);
+            }
+        }
+        fnn::gemm(1.0, {dz.data(), out, batch, 1, out}, {x.data(), batch, in, in, 1}, 1.0,
+                  {dw.data(), out, in, in, 1});
+        fnn::gemm(1.0, {dz.data(), batch, out, out, 1}, {w.data(), out, in, in, 1}, 0.0,
+                  {dx.data(), batch, in, in, 1});
+    });
+    const auto fused = best_time(10, [&] { dx = layer.backward_batch(dy); });
+
+    // dY and y are read once either way; unfused also reads dZ three times.
+    const double stream = static_cast<double>(batch * out * sizeof(fnn::Scalar));
+    std::printf("Dense backward, batch %zu, %zu -> %zu, sigmoid\n", batch, in, out);
+    std::printf("%-8s %18s %10s\n", "version", "dY-side MiB read", "ms");
+    std::printf("%-8s %18.2f %10.3f\n", "unfused", 5.0 * stream / (1 << 20), unfused * 1e3);
+    std::printf("%-8s %18.2f %10.3f\n", "fused", 2.0 * stream / (1 << 20), fused * 1e3);
+    return 0;
+}
+
+// `threads` threads each creating `iters` rounds of temporaries shaped like
+// a small MLP's activations and gradients.
+template <typename Make>
+double churn(std::size_t threads, std::size_t iters, Make make) {
+    const std::size_t shapes[][2] = {{32, 784}, {32, 256}, {32, 128}, {32, 10}, {256, 128}};
+    return best_time(3, [&] {
+        std::vector<std::thread> pool;
+        for (std::size_t t = 0; t < threads; ++t) {
+            pool.emplace_back([&] {
+                fnn::Scalar sink = 0.0;
+                for (std::size_t i = 0; i < iters; ++i) {
+                    for (const auto& s : shapes) {
+                        sink += make(s[0], s[1]);
+                    }
+                }
+                volatile fnn::Scalar keep = sink;
+                (void)keep;
+            });
+        }
+        for (auto& th : pool) {
+            th.join();
+        }
+    });
+}
+
+int bench_buffer_pool(int argc, char** argv) {
+    const std::size_t threads = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 4;
+    const std::size_t iters = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+
+    const auto plain = churn(threads, iters, [](std::size_t r, std::size_t c) {
+        std::vector<fnn::Scalar> v(r * c);
+        return v[r * c / 2];
+    });
+    fnn::util::reset_buffer_pool_stats();
+    const auto pooled = churn(threads, iters, [](std::size_t r, std::size_t c) {
+        fnn::Tensor2D t(r, c);
+        return t.data()[t.size() / 2];
+    });
+    const auto stats = fnn::util::buffer_pool_stats();
+
+    std::printf("%zu threads x %zu iterations x 5 temporaries\n", threads, iters);
+    std::printf("std::vector  %10.3f ms\n", plain * 1e3);
+    std::printf("Tensor2D     %10.3f ms\n", pooled * 1e3);
+    std::printf("pool: %llu allocations, %.4f hit rate (thread %llu, depot %llu, system %llu)\n",
+                static_cast<unsigned long long>(stats.allocations), stats.hit_rate(),
+                static_cast<unsigned long long>(stats.thread_hits),
+                static_cast<unsigned long long>(stats.depot_hits),
+                static_cast<unsigned long long>(stats.system_allocations));
+    return 0;
+}
+
+// AnonHugePages of this process in KiB, or -1 where it cannot be read.
+long anon_huge_kib() {
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("AnonHugePages:", 0) == 0) {
+            return std::strtol(line.c_str() + std::strlen("AnonHugePages:"), nullptr, 10);
+        }
+    }
+    return -1;
+}
+
+int bench_huge_pages(int argc, char** argv) {
+    const std::size_t gemv_n = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 4096;
+    const std::size_t gemm_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1536;
+
+    std::printf("GEMV %zux%zu (%.0f MiB matrix), GEMM %zu^3\n", gemv_n, gemv_n,
+                static_cast<double>(gemv_n * gemv_n * sizeof(fnn::Scalar)) / (1 << 20), gemm_n);
+    std::printf("%-8s %12s %12s %16s\n", "pages", "GEMV GB/s", "GEMM GFLOP/s", "AnonHuge MiB");
+    for (const auto mode : {fnn::util::HugePages::Off, fnn::util::HugePages::Advise}) {
+        // Drop cached blocks so every buffer below is mapped under `mode`.
+        fnn::util::trim_buffer_pool();
+        fnn::util::set_huge_page_policy({mode, std::size_t{4} << 20});
+        fnn::util::reset_buffer_pool_stats();
+        const auto huge_before = anon_huge_kib();
+
+        fnn::Tensor2D m(gemv_n, gemv_n);
+        fnn::fill_uniform(m, fnn::CounterRng(1), -1.0, 1.0);
+        std::vector<fnn::Scalar> x(gemv_n, 1.0);
+        std::vector<fnn::Scalar> y(gemv_n);
+        const auto gemv = best_time(5, [&] {
+            fnn::util::gemv(1.0, {m.data(), gemv_n, gemv_n, gemv_n, 1}, x, 0.0, y);
+        });
+
+        fnn::Tensor2D a(gemm_n, gemm_n);
+        fnn::Tensor2D b(gemm_n, gemm_n);
+        fnn::fill_uniform(a, fnn::CounterRng(2), -1.0, 1.0);
+        fnn::fill_uniform(b, fnn::CounterRng(3), -1.0, 1.0);
+        fnn::Tensor2D c(gemm_n, gemm_n);
+        const auto gemm = best_time(3, [&] {
+            fnn::gemm(1.0, {a.data(), gemm_n, gemm_n, gemm_n, 1},
+                      {b.data(), gemm_n, gemm_n, gemm_n, 1}, 0.0,
+                      {c.data(), gemm_n, gemm_n, gemm_n, 1});
+        });
+
+        const auto huge_after = anon_huge_kib();
+        const double n3 = static_cast<double>(gemm_n) * static_cast<double>(gemm_n) *
+                          static_cast<double>(gemm_n);
+        std::printf("%-8s %12.2f %12.2f %16.1f\n",
+                    mode == fnn::util::HugePages::Off ? "4 KiB" : "huge",
+                    static_cast<double>(m.size() * sizeof(fnn::Scalar)) / gemv * 1e-9,
+                    2.0 * n3 / gemm * 1e-9,
+                    huge_before < 0 ? -1.0 : static_cast<double>(huge_after - huge_before) / 1024);
+    }
+    return 0;
+}
+
+int bench_gemm_scaling(int argc, char** argv) {
+    const std::size_t m = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 1024;
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : m;
+    const std::size_t k = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : m;
+    std::vector<fnn::Scalar> a(m * k, 0.5);
+    std::vector<fnn::Scalar> b(k * n, 0.25);
+    std::vector<fnn::Scalar> c(m * n);
+    const auto pool = fnn::util::ThreadPool::instance().num_threads();
+    std::vector<std::size_t> counts;
+    for (std::size_t t = 1; t < pool; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(pool);
+
+    std::printf("GEMM %zu x %zu x %zu, pool of %zu threads\n", m, n, k, pool);
+    std::printf("%8s %8s %10s %10s %9s %11s\n", "threads", "grid", "ms", "GFLOP/s", "speedup",
+                "efficiency");
+    double serial = 0.0;
+    for (const auto t : counts) {
+        fnn::GemmConfig config;
+        config.threads = t;
+        const auto grid = fnn::gemm_grid(m, n, k, config);
+        const auto seconds = best_time(5, [&] {
+            fnn::gemm(1.0, {a.data(), m, k, k, 1}, {b.data(), k, n, n, 1}, 0.0,
+                      {c.data(), m, n, n, 1}, config);
+        });
+        serial = t == 1 ? seconds : serial;
+        const auto speedup = serial / seconds;
+        const auto used = grid.rows * grid.cols;
+        char shape[32];
+        std::snprintf(shape, sizeof shape, "%zux%zu", grid.rows, grid.cols);
+        std::printf("%8zu %8s %10.2f %10.2f %8.2fx %10.0f%%\n", used, shape, seconds * 1e3,
+                    2.0 * static_cast<double>(m * n * k) / seconds * 1e-9, speedup,
+                    100.0 * speedup / static_cast<double>(used));
+    }
+    return 0;
+}
+
+int bench_strassen(int argc, char** argv) {
+    const std::size_t n = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 2048;
+    const std::size_t depth = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3;
+    fnn::Tensor2D a(n, n);
+    fnn::Tensor2D b(n, n);
+    fnn::fill_uniform(a, fnn::CounterRng(1), -1.0, 1.0);
+    fnn::fill_uniform(b, fnn::CounterRng(2), -1.0, 1.0);
+
+    // Exact-ish rows of A * B for the error estimate.
+    constexpr std::size_t kSampledRows = 8;
+    std::vector<long double> reference(kSampledRows * n);
+    for (std::size_t s = 0; s < kSampledRows; ++s) {
+        const auto i = s * (n - 1) / (kSampledRows - 1);
+        for (std::size_t p = 0; p < n; ++p) {
+            const long double aip = a(i, p);
+            for (std::size_t j = 0; j < n; ++j) {
+                reference[s * n + j] += aip * b(p, j);
+            }
+        }
+    }
+    const auto max_error = [&](const fnn::Tensor2D& c) {
+        long double worst = 0.0;
+        for (std::size_t s = 0; s < kSampledRows; ++s) {
+            const auto i = s * (n - 1) / (kSampledRows - 1);
+            for (std::size_t j = 0; j < n; ++j) {
+                worst = std::max(worst, std::abs(c(i, j) - reference[s * n + j]));
+            }
+        }
+        return static_cast<double>(worst);
+    };
+
+    std::printf("%zu x %zu x %zu\n", n, n, n);
+    std::printf("%10s %10s %10s %9s %12s\n", "levels", "ms", "GFLOP/s*", "speedup", "max error");
+    fnn::Tensor2D c(n, n);
+    const auto classical = best_time(3, [&] { c = fnn::matmul(a, b); });
+    const auto size = static_cast<double>(n);
+    const auto flops = 2.0 * size * size * size;
+    std::printf("%10s %10.1f %10.2f %8.2fx %12.3e\n", "classical", classical * 1e3,
+                flops / classical * 1e-9, 1.0, max_error(c));
+    for (std::size_t d = 1; d <= depth; ++d) {
+        const fnn::StrassenConfig config{std::max<std::size_t>(n >> (d - 1), 16), d};
+        const auto seconds = best_time(3, [&] { c = fnn::matmul_strassen(a, b, config); });
+        std::printf("%10zu %10.1f %10.2f %8.2fx %12.3e\n", d, seconds * 1e3,
+                    flops / seconds * 1e-9, classical / seconds, max_error(c));
+    }
+    std::printf("* classical-equivalent rate, 2n^3 / time\n");
+    const auto crossover = fnn::tune_strassen_crossover(n);
+    if (crossover == 0) {
+        std::printf("tuned crossover: none (one level never beat GEMM up to %zu)\n", n);
+    } else {
+        std::printf("tuned crossover: %zu\n", crossover);
+    }
+    return 0;
+}
+
+int bench_conv1d(int argc, char** argv) {
+    const std::size_t batch = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 16;
+    const std::size_t length = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 512;
+    const std::size_t out_channels = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 32;
+    using Algorithm = fnn::Conv1D::Algorithm;
+
+    std::printf("batch %zu, length %zu, out_channels %zu, stride 1, same padding\n", batch,
+                length, out_channels);
+    std::printf("%6s %6s %6s %12s %12s %12s %12s %8s\n", "in_ch", "kernel", "depth", "gemm fwd us",
+                "direct fwd us", "gemm bwd us", "direct bwd us", "auto fwd");
+    for (const std::size_t in_channels : {1, 2, 4, 16, 64}) {
+        for (const std::size_t kernel : {1, 3, 7}) {
+            fnn::Conv1D conv(in_channels, out_channels, kernel, fnn::CounterRng(1), 1, kernel / 2);
+            fnn::Tensor x({batch, in_channels, length});
+            fnn::Tensor dy({batch, out_channels, conv.output_length(length)});
+            std::fill_n(x.data(), x.numel(), 0.5);
+            std::fill_n(dy.data(), dy.numel(), 0.25);
+            double fwd[2];
+            double bwd[2];
+            for (const auto algorithm : {Algorithm::Gemm, Algorithm::Direct}) {
+                const auto i = algorithm == Algorithm::Gemm ? 0 : 1;
+                conv.set_algorithm(algorithm);
+                fwd[i] = best_time(5, [&] { (void)conv.forward_batch(x); });
+                bwd[i] = best_time(5, [&] { (void)conv.backward_batch(dy); });
+            }
+            conv.set_algorithm(Algorithm::Auto);
+            std::printf("%6zu %6zu %6zu %12.1f %12.1f %12.1f %12.1f %8s\n", in_channels, kernel,
+                        in_channels * kernel, fwd[0] * 1e6, fwd[1] * 1e6, bwd[0] * 1e6,
+                        bwd[1] * 1e6,
+                        conv.forward_algorithm() == Algorithm::Direct ? "direct" : "gemm");
+        }
+    }
+    return 0;
+}
+
+int bench_conv2d(int argc, char** argv) {
+    const std::size_t batch = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 8;
+    const std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 32;
+    const std::size_t in_channels = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 32;
+    const std::size_t out_channels = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+    constexpr std::size_t kKernel = 3;
+    const std::size_t depth = in_channels * kKernel * kKernel;
+    const std::size_t pixels = size * size;
+
+    fnn::Conv2D conv(in_channels, out_channels, kKernel, kKernel, fnn::CounterRng(1), 1, 1);
+    fnn::Tensor x({batch, in_channels, size, size});
+    fnn::Tensor dy({batch, out_channels, size, size});
+    std::fill_n(x.data(), x.numel(), 0.5);
+    std::fill_n(dy.data(), dy.numel(), 0.25);
+    const auto xb = fnn::to_nchwc(x);
+    const auto dyb = fnn::to_nchwc(dy);
+
+    // Baseline: NCHW with an explicit im2col buffer per sample and one GEMM
+    // per pass, col2im scattering dX back.
+    const auto w = conv.weights();
+    std::vector<fnn::Scalar> col(depth * pixels);
+    std::vector<fnn::Scalar> dcol(depth * pixels);
+    std::vector<fnn::Scalar> y(batch * out_channels * pixels);
+    std::vector<fnn::Scalar> dw(out_channels * depth);
+    std::vector<fnn::Scalar> dx(x.numel());
+    const auto for_each_tap = [&](auto&& fn) {
+        for (std::size_t c = 0; c < in_channels; ++c) {
+            for (std::size_t ky = 0; ky < kKernel; ++ky) {
+                for (std::size_t kx = 0; kx < kKernel; ++kx) {
+                    const auto row = (c * kKernel + ky) * kKernel + kx;
+                    for (std::size_t oy = 0; oy < size; ++oy) {
+                        for (std::size_t ox = 0; ox < size; ++ox) {
+                            const auto iy = oy + ky;
+                            const auto ix = ox + kx;
+                            if (iy >= 1 && ix >= 1 && iy <= size && ix <= size) {
+                                fn(row * pixels + oy * size + ox,
+                                   (c * size + iy - 1) * size + ix - 1);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+    const auto im2col = [&](std::size_t n) {
+        std::fill(col.begin(), col.end(), 0.0);
+        const auto* xn = x.data() + n * in_channels * pixels;
+        for_each_tap([&](std::size_t at, std::size_t from) { col[at] = xn[from]; });
+    };
+    const auto baseline_forward = [&] {
+        for (std::size_t n = 0; n < batch; ++n) {
+            im2col(n);
+            fnn::gemm(1.0, {w.data(), out_channels, depth, depth, 1},
+                      {col.data(), depth, pixels, pixels, 1}, 0.0,
+                      {y.data() + n * out_channels * pixels, out_channels, pixels, pixels, 1});
+        }
+    };
+    const auto baseline_backward = [&] {
+        std::fill(dx.begin(), dx.end(), 0.0);
+        for (std::size_t n = 0; n < batch; ++n) {
+            im2col(n);
+            const auto* dyn = dy.data() + n * out_channels * pixels;
+            fnn::gemm(1.0, {dyn, out_channels, pixels, pixels, 1},
+                      {col.data(), pixels, depth, 1, pixels}, 1.0,
+                      {dw.data(), out_channels, depth, depth, 1});
+            fnn::gemm(1.0, {w.data(), depth, out_channels, 1, depth},
+                      {dyn, out_channels, pixels, pixels, 1}, 0.0,
+                      {dcol.data(), depth, pixels, pixels, 1});
+            auto* dxn = dx.data() + n * in_channels * pixels;
+            for_each_tap([&](std::size_t at, std::size_t to) { dxn[to] += dcol[at]; });
+        }
+    };
+
+    const auto flops = 2.0 * static_cast<double>(batch * out_channels * pixels * depth);
+    std::printf("batch %zu, %zu x %zu, %zu -> %zu channels, 3 x 3 kernel, same padding\n",
+                batch, size, size, in_channels, out_channels);
+    std::printf("%22s %10s %10s\n", "", "ms", "GFLOP/s");
+    const auto report = [&](const char* name, double seconds, double pass_flops) {
+        std::printf("%22s %10.2f %10.2f\n", name, seconds * 1e3, pass_flops / seconds * 1e-9);
+    };
+    const auto im2col_fwd = best_time(3, baseline_forward);
+    const auto im2col_bwd = best_time(3, baseline_backward);
+    const auto blocked_fwd = best_time(3, [&] { (void)conv.forward_batch(xb); });
+    const auto blocked_bwd = best_time(3, [&] { (void)conv.backward_batch(dyb); });
+    const auto convert =
+        best_time(3, [&] { (void)fnn::from_nchwc(fnn::to_nchwc(x), in_channels); });
+    report("im2col + gemm forward", im2col_fwd, flops);
+    report("NCHWc forward", blocked_fwd, flops);
+    report("im2col + gemm backward", im2col_bwd, 2.0 * flops);
+    report("NCHWc backward", blocked_bwd, 2.0 * flops);
+    std::printf("NCHW <-> NCHWc round trip of the input: %.2f ms\n", convert * 1e3);
+    return 0;
+}
+
+int bench_predict(int argc, char** argv) {
+    const std::size_t width = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 1024;
+    const std::size_t depth = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4;
+
+    std::printf("%8s %14s %14s %9s\n", "width", "gemm m=1 us", "gemv us", "speedup");
+    for (std::size_t n = 64; n <= width; n *= 2) {
+        fnn::Dense layer(n, n, fnn::CounterRng(1), fnn::ActivationKind::ReLU);
+        layer.set_training(false);
+        const auto& w = layer.weights();
+        const fnn::PackedMatrix packed(fnn::MatrixRef{w.data(), n, n, 1, n});
+        fnn::Vector x(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = static_cast<fnn::Scalar>(i % 11) / 11.0 - 0.5;
+        }
+        fnn::Vector y(n);
+        const int reps = n <= 256 ? 2000 : 200;
+        const auto gemm = best_time(reps, [&] {
+            std::copy(layer.bias().data(), layer.bias().data() + n, y.data());
+            fnn::gemm(1.0, {x.data(), 1, n, n, 1}, packed, 1.0, {y.data(), 1, n, n, 1});
+        });
+        const auto gemv = best_time(reps, [&] { y = layer.forward(x); });
+        std::printf("%8zu %14.2f %14.2f %8.2fx\n", n, gemm * 1e6, gemv * 1e6, gemm / gemv);
+    }
+
+    fnn::Sequential model;
+    for (std::size_t l = 0; l < depth; ++l) {
+        model.add(std::make_unique<fnn::Dense>(width, width, fnn::CounterRng(10 + l),
+                                               fnn::ActivationKind::ReLU));
+    }
+    model.set_training(false);
+    fnn::Vector x(width, 0.25);
+    const auto predict = best_time(200, [&] { x = model.predict(x); });
+    std::printf("Sequential %zu x (%zu -> %zu) predict: %.2f us\n", depth, width, width,
+                predict * 1e6);
+    return 0;
+}
+
+int bench_incremental(int argc, char** argv) {
+    const std::size_t in = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 4096;
+    const std::size_t hidden = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+
+    fnn::Sequential model;
+    model.add(std::make_unique<fnn::Dense>(in, hidden, fnn::CounterRng(1),
+                                           fnn::ActivationKind::ReLU));
+    model.add(std::make_unique<fnn::Dense>(hidden, 16, fnn::CounterRng(2)));
+    model.set_training(false);
+    fnn::Vector x(in, 0.25);
+    const auto full = best_time(50, [&] { (void)model.predict(x); });
+    std::printf("%zu -> %zu -> 16, predict: %.2f us/event\n", in, hidden, full * 1e6);
+    std::printf("%10s %16s %9s\n", "changed", "incremental us", "speedup");
+    // Each timed call takes the next of a chain of events, each `changed`
+    // random features away from the one before, drawn up front so the
+    // timing holds the update alone.
+    constexpr int kReps = 50;
+    const fnn::CounterRng rng(3);
+    std::uint64_t element = 0;
+    for (std::size_t changed = 1; changed <= in; changed *= 2) {
+        std::vector<fnn::Vector> events(kReps + 1, x);
+        for (std::size_t e = 1; e < events.size(); ++e) {
+            events[e] = events[e - 1];
+            for (std::size_t c = 0; c < changed; ++c) {
+                const auto i = static_cast<std::size_t>(rng.uniform(element++) *
+                                                        static_cast<fnn::Scalar>(in));
+                events[e][std::min(i, in - 1)] = rng.uniform(element++);
+            }
+        }
+        (void)model.predict_incremental(events.front());
+        std::size_t next = 0;
+        const auto seconds =
+            best_time(kReps, [&] { (void)model.predict_incremental(events[++next]); });
+        std::printf("%10zu %16.2f %8.2fx\n", changed, seconds * 1e6, full / seconds);
+    }
+    return 0;
+}
+
+int bench_graph(int argc, char** argv) {
+    const std::size_t width = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 512;
+    const std::size_t branches = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4;
+    const std::size_t blocks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+
+    // Each block: `branches` Dense layers reading the block input, summed
+    // with it (a residual connection).
+    fnn::GraphModel model;
+    std::vector<fnn::Dense*> layers;
+    fnn::GraphModel::NodeId x = fnn::GraphModel::kInput;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        std::vector<fnn::GraphModel::NodeId> terms{x};
+        for (std::size_t i = 0; i < branches; ++i) {
+            auto layer = std::make_unique<fnn::Dense>(width, width,
+                                                      fnn::CounterRng(b * branches + i),
+                                                      fnn::ActivationKind::ReLU);
+            layers.push_back(layer.get());
+            terms.push_back(model.add_layer(std::move(layer), x));
+        }
+        x = model.add_sum(terms);
+    }
+    model.set_training(false);
+
+    const fnn::Vector input(width, 0.25);
+    fnn::Vector y;
+    const auto graph = best_time(50, [&] { y = model.predict(input); });
+    const auto serial = best_time(50, [&] {
+        fnn::Vector h = input;
+        for (std::size_t b = 0; b < blocks; ++b) {
+            fnn::Vector sum = h;
+            for (std::size_t i = 0; i < branches; ++i) {
+                const auto out = layers[b * branches + i]->forward(h);
+                for (std::size_t j = 0; j < width; ++j) {
+                    sum[j] += out[j];
+                }
+            }
+            h = std::move(sum);
+        }
+        y = std::move(h);
+    });
+    std::printf("%zu blocks x %zu branches of Dense %zu -> %zu, %zu threads\n", blocks,
+                branches, width, width, fnn::util::ThreadPool::instance().num_threads());
+    std::printf("nodes %zu, levels %zu, buffers %zu\n", model.size(), model.level_count(),
+                model.buffer_count());
+    std::printf("%-10s %10.2f us\n%-10s %10.2f us (%.2fx)\n", "serial", serial * 1e6, "graph",
+                graph * 1e6, serial / graph);
+    return 0;
+}
+
+int bench_moe(int argc, char** argv) {
+    const std::size_t batch = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 256;
+    const std::size_t width = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 512;
+    const std::size_t experts = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16;
+
+    fnn::Tensor2D x(batch, width);
+    fnn::fill_uniform(x, fnn::CounterRng(2), -1.0, 1.0);
+    std::printf("batch %zu, %zu experts of Dense %zu -> %zu\n", batch, experts, width, width);
+    std::printf("%-10s %10s %14s\n", "routing", "ms", "max load");
+    for (const std::size_t k : {1, 2, 4}) {
+        if (k > experts) {
+            break;
+        }
+        fnn::MixtureOfExperts moe(width, width, experts, k, fnn::CounterRng(1),
+                                  fnn::ActivationKind::ReLU);
+        moe.set_training(false);
+        const auto seconds = best_time(10, [&] { (void)moe.forward_batch(x); });
+        const auto load = moe.expert_load();
+        std::printf("top-%-6zu %10.2f %14zu\n", k, seconds * 1e3,
+                    *std::max_element(load.begin(), load.end()));
+    }
+    fnn::MixtureOfExperts moe(width, width, experts, 1, fnn::CounterRng(1),
+                              fnn::ActivationKind::ReLU);
+    moe.set_training(false);
+    const auto dense = best_time(10, [&] {
+        for (std::size_t e = 0; e < experts; ++e) {
+            (void)moe.expert(e).forward_batch(x);
+        }
+    });
+    std::printf("%-10s %10.2f %14zu\n", "all", dense * 1e3, batch);
+    return 0;
+}
+
+int bench_sampled_softmax(int argc, char** argv) {
+    const std::size_t classes = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 200000;
+    const std::size_t hidden = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 128;
+    const std::size_t batch = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 128;
+    const std::size_t samples = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1024;
+
+    fnn::Tensor2D w(classes, hidden);
+    fnn::Tensor2D b(1, classes);
+    fnn::Tensor2D h(batch, hidden);
+    fnn::fill_uniform(w, fnn::CounterRng(1), -0.1, 0.1);
+    fnn::fill_uniform(h, fnn::CounterRng(2), -1.0, 1.0);
+    // Zipf-like labels, as the log-uniform proposal assumes.
+    const fnn::LogUniformSampler sampler(classes);
+    std::vector<std::size_t> labels(batch);
+    sampler.sample(fnn::CounterRng(3), 0, labels);
+
+    std::printf("%zu classes, hidden %zu, batch %zu, %zu samples\n", classes, hidden, batch,
+                samples);
+    fnn::Scalar full = 0.0;
+    const auto full_seconds = best_time(3, [&] {
+        full = fnn::SampledSoftmaxLoss::full_loss(h, labels, w, b);
+    });
+    std::printf("%-28s %10.2f ms  loss %.4f\n", "full softmax (loss only)", full_seconds * 1e3,
+                full);
+    for (const auto mode : {fnn::SampledSoftmaxLoss::Mode::Softmax,
+                            fnn::SampledSoftmaxLoss::Mode::NegativeSampling}) {
+        const fnn::SampledSoftmaxLoss loss(sampler, samples, mode);
+        fnn::Scalar mean = 0.0;
+        std::uint64_t step = 0;
+        const auto seconds = best_time(10, [&] {
+            mean += loss.compute(h, labels, w, b, fnn::CounterRng(4, step++)).loss;
+        });
+        std::printf("%-28s %10.2f ms  loss %.4f (mean of %llu draws)\n",
+                    mode == fnn::SampledSoftmaxLoss::Mode::Softmax ? "sampled softmax + grads"
+                                                                   : "negative sampling + grads",
+                    seconds * 1e3, mean / static_cast<fnn::Scalar>(step),
+                    static_cast<unsigned long long>(step));
+    }
+    return 0;
+}
+
+int bench_hsoftmax(int argc, char** argv) {
+    const std::size_t classes = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 200000;
+    const std::size_t hidden = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 128;
+    const std::size_t batch = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 128;
+
+    // Zipf frequencies; labels drawn from the matching log-uniform proposal.
+    std::vector<fnn::Scalar> frequency(classes);
+    for (std::size_t c = 0; c < classes; ++c) {
+        frequency[c] = 1.0 / static_cast<fnn::Scalar>(c + 1);
+    }
+    fnn::HierarchicalSoftmax tree(hidden, frequency, fnn::CounterRng(1));
+    fnn::Tensor2D w(classes, hidden);
+    fnn::Tensor2D b(1, classes);
+    fnn::Tensor2D h(batch, hidden);
+    fnn::fill_uniform(w, fnn::CounterRng(1), -0.1, 0.1);
+    fnn::fill_uniform(h, fnn::CounterRng(2), -1.0, 1.0);
+    std::vector<std::size_t> labels(batch);
+    fnn::LogUniformSampler(classes).sample(fnn::CounterRng(3), 0, labels);
+
+    std::printf("%zu classes, hidden %zu, batch %zu, depth mean %.2f max %zu\n", classes,
+                hidden, batch, tree.mean_depth(), tree.max_depth());
+    fnn::Scalar full = 0.0;
+    const auto full_seconds = best_time(3, [&] {
+        full = fnn::SampledSoftmaxLoss::full_loss(h, labels, w, b);
+    });
+    fnn::Tensor2D dh(0, 0);
+    fnn::Scalar loss = 0.0;
+    const auto tree_seconds = best_time(10, [&] { loss = tree.loss_backward(h, labels, dh); });
+    std::printf("%-28s %10.3f ms  loss %.4f\n", "full softmax (loss only)", full_seconds * 1e3,
+                full);
+    std::printf("%-28s %10.3f ms  loss %.4f\n", "hierarchical + grads", tree_seconds * 1e3,
+                loss);
+
+    // Decoding: greedy descent vs an argmax over every class logit.
+    const auto argmax_seconds = best_time(3, [&] {
+        for (std::size_t r = 0; r < batch; ++r) {
+            const fnn::Scalar* x = h.data() + r * hidden;
+            std::size_t best = 0;
+            fnn::Scalar best_logit = -std::numeric_limits<fnn::Scalar>::infinity();
+            for (std::size_t c = 0; c < classes; ++c) {
+                const fnn::Scalar* row = w.data() + c * hidden;
+                fnn::Scalar z = b.data()[c];
+                for (std::size_t i = 0; i < hidden; ++i) {
+                    z += row[i] * x[i];
+                }
+                if (z > best_logit) {
+                    best_logit = z;
+                    best = c;
+                }
+            }
+            labels[r] = best;
+        }
+    });
+    const auto greedy_seconds = best_time(10, [&] { (void)tree.predict_batch(h); });
+    std::printf("%-28s %10.3f us/sample\n", "full argmax decode",
+                argmax_seconds * 1e6 / static_cast<double>(batch));
+    std::printf("%-28s %10.3f us/sample\n", "greedy tree decode",
+                greedy_seconds * 1e6 / static_cast<double>(batch));
+    return 0;
+}
+
+int bench_mips(int argc, char** argv) {
+    const std::size_t classes = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 200000;
+    const std::size_t hidden = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 128;
+    const std::size_t queries = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+    constexpr std::size_t k = 10;
+
+    // Output embeddings with some structure: rows scattered around 256
+    // topic directions, as trained class embeddings tend to be.
+    constexpr std::size_t topics = 256;
+    fnn::Tensor2D topic(topics, hidden);
+    fnn::Tensor2D w(classes, hidden);
+    fnn::Tensor2D b(1, classes);
+    fnn::fill_normal(topic, fnn::CounterRng(1), 0.0, 1.0);
+    fnn::fill_normal(w, fnn::CounterRng(2), 0.0, 0.5);
+    fnn::fill_uniform(b, fnn::CounterRng(3), -0.5, 0.5);
+    for (std::size_t c = 0; c < classes; ++c) {
+        const auto t = (c * 2654435761u) % topics;
+        for (std::size_t i = 0; i < hidden; ++i) {
+            w(c, i) += topic(t, i);
+        }
+    }
+    fnn::Dense layer(hidden, classes);
+    layer.set_weights(w, b);
+    layer.set_training(false);
+    fnn::Tensor2D h(queries, hidden);
+    fnn::fill_normal(h, fnn::CounterRng(4), 0.0, 1.0);
+
+    std::printf("%zu classes, hidden %zu, %zu queries, top %zu\n", classes, hidden, queries, k);
+    std::vector<std::vector<fnn::ScoredClass>> exact(queries);
+    const auto dense_seconds = best_time(3, [&] {
+        for (std::size_t q = 0; q < queries; ++q) {
+            const fnn::Vector x(h.data() + q * hidden, h.data() + (q + 1) * hidden);
+            exact[q] = fnn::top_k(layer.forward(x), k);
+        }
+    });
+    const auto sort_seconds = best_time(3, [&] {
+        for (std::size_t q = 0; q < queries; ++q) {
+            const fnn::Vector x(h.data() + q * hidden, h.data() + (q + 1) * hidden);
+            auto y = layer.forward(x);
+            std::vector<std::size_t> order(classes);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(),
+                      [&](std::size_t a, std::size_t c) { return y[a] > y[c]; });
+        }
+    });
+    const auto per_query = [&](double seconds) {
+        return seconds * 1e6 / static_cast<double>(queries);
+    };
+    std::printf("%-24s %12.1f us/query\n", "dense + top_k", per_query(dense_seconds));
+    std::printf("%-24s %12.1f us/query\n", "dense + full sort", per_query(sort_seconds));
+
+    const auto start = std::chrono::steady_clock::now();
+    const fnn::MipsIndex index(layer, fnn::CounterRng(5));
+    const std::chrono::duration<double> build = std::chrono::steady_clock::now() - start;
+    std::printf("index: %zu partitions, built in %.2f s\n", index.partitions(), build.count());
+    std::printf("%-10s %12s %10s\n", "probes", "us/query", "recall");
+    for (std::size_t probes = 1;; probes *= 2) {
+        probes = std::min(probes, index.partitions());
+        std::vector<std::vector<fnn::ScoredClass>> found;
+        const auto seconds = best_time(3, [&] {
+            found.clear();
+            for (std::size_t q = 0; q < queries; ++q) {
+                found.push_back(index.search({h.data() + q * hidden, hidden}, k, probes));
+            }
+        });
+        std::size_t hits = 0;
+        for (std::size_t q = 0; q < queries; ++q) {
+            for (const auto& f : found[q]) {
+                for (const auto& e : exact[q]) {
+                    hits += f.index == e.index ? 1 : 0;
+                }
+            }
+        }
+        std::printf("%-10zu %12.1f %10.3f\n", probes, per_query(seconds),
+                    static_cast<double>(hits) / static_cast<double>(queries * k));
+        if (probes == index.partitions()) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int bench_predict_cache(int argc, char** argv) {
+    const std::size_t width = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 512;
+    const std::size_t distinct = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+    const std::size_t capacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1024;
+    constexpr std::size_t calls = 20000;
+
+    fnn::Sequential model;
+    for (std::uint32_t l = 0; l < 3; ++l) {
+        model.add(std::make_unique<fnn::Dense>(width, width, fnn::CounterRng(1, 0, l),
+                                               fnn::ActivationKind::ReLU));
+    }
+    model.set_training(false);
+    // Requests drawn from `distinct` inputs with Zipf-like popularity.
+    const fnn::LogUniformSampler popularity(distinct);
+    std::vector<std::size_t> request(calls);
+    popularity.sample(fnn::CounterRng(2), 0, request);
+    std::vector<fnn::Vector> inputs(distinct, fnn::Vector(width));
+    for (std::size_t d = 0; d < distinct; ++d) {
+        fnn::CounterRng(3).fill_uniform(inputs[d], d * width, -1.0, 1.0);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto r : request) {
+        (void)model.predict(inputs[r]);
+    }
+    const std::chrono::duration<double> plain = std::chrono::steady_clock::now() - start;
+    fnn::PredictCache cache(model, capacity);
+    const auto cached_start = std::chrono::steady_clock::now();
+    for (const auto r : request) {
+        (void)cache.predict(inputs[r]);
+    }
+    const std::chrono::duration<double> cached =
+        std::chrono::steady_clock::now() - cached_start;
+    const auto stats = cache.stats();
+    std::printf("3 x Dense %zu, %zu calls over %zu inputs, capacity %zu (%zu shards)\n", width,
+                calls, distinct, capacity, cache.shard_count());
+    std::printf("%-10s %10.2f us/call\n", "predict", plain.count() * 1e6 / calls);
+    std::printf("%-10s %10.2f us/call  hit rate %.3f, %llu evictions\n", "cached",
+                cached.count() * 1e6 / calls,
+                static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses),
+                static_cast<unsigned long long>(stats.evictions));
+    return 0;
+}
+
+void usage() {
+    std::fprintf(stderr, "usage: fnn_bench backends [trials] [seed]\n"
+                         "       fnn_bench gemm-tune M N K\n"
+                         "       fnn_bench dense-packed [in] [out]\n"
+                         "       fnn_bench dense-backward [batch] [in] [out]\n"
+                         "       fnn_bench buffer-pool [threads] [iters]\n"
+                         "       fnn_bench huge-pages [gemv_n] [gemm_n]\n"
+                         "       fnn_bench gemm-scaling [M] [N] [K]\n"
+                         "       fnn_bench strassen [n] [depth]\n"
+                         "       fnn_bench conv1d [batch] [length] [out_channels]\n"
+                         "       fnn_bench conv2d [batch] [size] [in_channels] [out_channels]\n"
+                         "       fnn_bench predict [width] [depth]\n"
+                         "       fnn_bench incremental [in] [hidden]\n"
+                         "       fnn_bench graph [width] [branches] [blocks]\n"
+                         "       fnn_bench moe [batch] [width] [experts]\n"
+                         "       fnn_bench sampled-softmax [classes] [hidden] [batch] "
+                         "[samples]\n"
+                         "       fnn_bench hsoftmax [classes] [hidden] [batch]\n"
+                         "       fnn_bench mips [classes] [hidden] [queries]\n"
+                         "       fnn_bench predict-cache [width] [distinct] [capacity]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    if (std::strcmp(argv[1], "backends") == 0) {
+        return bench_backends(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "gemm-tune") == 0) {
+        if (bench_gemm_tune(argc - 2, argv + 2) == 0) {
+            return 0;
+        }
+    }
+    if (std::strcmp(argv[1], "dense-packed") == 0) {
+        return bench_dense_packed(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "dense-backward") == 0) {
+        return bench_dense_backward(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "buffer-pool") == 0) {
+        return bench_buffer_pool(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "huge-pages") == 0) {
+        return bench_huge_pages(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "gemm-scaling") == 0) {
+        return bench_gemm_scaling(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "strassen") == 0) {
+        return bench_strassen(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "conv1d") == 0) {
+        return bench_conv1d(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "conv2d") == 0) {
+        return bench_conv2d(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "predict") == 0) {
+        return bench_predict(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "incremental") == 0) {
+        return bench_incremental(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "graph") == 0) {
+        return bench_graph(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "moe") == 0) {
+        return bench_moe(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "sampled-softmax") == 0) {
+        return bench_sampled_softmax(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "hsoftmax") == 0) {
+        return bench_hsoftmax(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "mips") == 0) {
+        return bench_mips(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "predict-cache") == 0) {
+        return bench_predict_cache(argc - 2, argv + 2);
+    }
+    usage();
+    return 1;
+}
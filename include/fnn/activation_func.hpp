@@ -4,7 +4,6 @@
 
 namespace fnn {
 
-// You can implement concrete activations later (Sigmoid/ReLU/etc.).
 class ActivationFunction {
 public:
     virtual ~ActivationFunction() = default;
@@ -14,6 +13,53 @@ public:
 
     // Compute derivative with respect to input x (common for backprop).
     [[nodiscard]] virtual Scalar derivative(Scalar x) const = 0;
+
+    // Lean backward support (see `Activation::SaveMode::Lean`).
+    //
+    // True if derivative(x) depends only on whether x > 0; backward then only
+    // needs one bit per element, and uses derivative(1) / derivative(-1).
+    [[nodiscard]] virtual bool derivative_from_sign() const noexcept;
+    // True if the derivative can be computed from the output y = forward(x);
+    // backward then keeps the output instead of the input.
+    [[nodiscard]] virtual bool derivative_from_output() const noexcept;
+    // Derivative expressed in terms of the output. Only valid when
+    // derivative_from_output() is true.
+    [[nodiscard]] virtual Scalar derivative_at_output(Scalar y) const;
+};
+
+class ReLU : public ActivationFunction {
+public:
+    [[nodiscard]] Scalar forward(Scalar x) const override;
+    [[nodiscard]] Scalar derivative(Scalar x) const override;
+    [[nodiscard]] bool derivative_from_sign() const noexcept override;
+};
+
+class LeakyReLU : public ActivationFunction {
+public:
+    explicit LeakyReLU(Scalar alpha = 0.01);
+
+    [[nodiscard]] Scalar forward(Scalar x) const override;
+    [[nodiscard]] Scalar derivative(Scalar x) const override;
+    [[nodiscard]] bool derivative_from_sign() const noexcept override;
+
+private:
+    Scalar alpha_;
+};
+
+class Sigmoid : public ActivationFunction {
+public:
+    [[nodiscard]] Scalar forward(Scalar x) const override;
+    [[nodiscard]] Scalar derivative(Scalar x) const override;
+    [[nodiscard]] bool derivative_from_output() const noexcept override;
+    [[nodiscard]] Scalar derivative_at_output(Scalar y) const override;
+};
+
+class Tanh : public ActivationFunction {
+public:
+    [[nodiscard]] Scalar forward(Scalar x) const override;
+    [[nodiscard]] Scalar derivative(Scalar x) const override;
+    [[nodiscard]] bool derivative_from_output() const noexcept override;
+    [[nodiscard]] Scalar derivative_at_output(Scalar y) const override;
 };
 
 } // namespace fnn
@@ -0,0 +1,88 @@
+#pragma once
+
+// Kernel backends.
+//
+// Tensor2D operations (matmul, element-wise arithmetic, reductions,
+// activations) do not run kernels directly: they call the active Backend,
+// so kernels can be swapped without touching layers. Built-in backends:
+// - "reference": plain loops, the ground truth for correctness checks;
+// - "optimized": the blocked GEMM plus vectorized, threaded kernels
+//   (the default);
+// - "blas": GEMM through the system CBLAS, only registered when one was
+//   found at configure time (FNN_HAVE_CBLAS); everything else as "optimized".
+//
+// The active backend is chosen with set_active_backend() or, at startup,
+// the FNN_BACKEND environment variable.
+
+#include "config.hpp"
+#include "gemm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fnn {
+
+enum class BinaryOp : int { Add, Sub, Mul, Div };
+enum class ReduceAxis : int { Rows, Cols };
+enum class ActivationKind : int { Identity, ReLU, LeakyReLU, Sigmoid, Tanh };
+
+class Backend {
+public:
+    virtual ~Backend() = default;
+
+    [[nodiscard]] virtual std::string_view name() const noexcept = 0;
+
+    // True when matmul() is exactly gemm(), so layers may call the blocked
+    // GEMM / GEMV kernels directly (pre-packed weights, per-task tiling)
+    // instead of going through matmul(). Only the built-in "optimized"
+    // backend says so; a backend registered in its place does not.
+    [[nodiscard]] virtual bool prefers_layer_kernels() const noexcept { return false; }
+
+    // C = alpha * A * B + beta * C (see gemm()).
+    virtual void matmul(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                        const MutableMatrixRef& c) const = 0;
+
+    // out[i] = a[i] <op> b[i] for i < n; out may alias a or b.
+    virtual void elementwise(BinaryOp op, const Scalar* a, const Scalar* b, Scalar* out,
+                             std::size_t n) const = 0;
+
+    // Sums of m: over its rows (out has m.cols entries) or over its columns
+    // (out has m.rows entries).
+    virtual void reduce_sum(const MatrixRef& m, ReduceAxis axis, Scalar* out) const = 0;
+
+    // out[i] = f(in[i]) for i < n; `alpha` is the LeakyReLU slope. out may
+    // alias in.
+    virtual void activation(ActivationKind kind, Scalar alpha, const Scalar* in, Scalar* out,
+                            std::size_t n) const = 0;
+};
+
+// Adds a backend, replacing any registered under the same name.
+void register_backend(std::shared_ptr<const Backend> backend);
+// nullptr if no backend has that name.
+[[nodiscard]] std::shared_ptr<const Backend> find_backend(std::string_view name);
+[[nodiscard]] std::vector<std::string> backend_names();
+
+// Throws std::invalid_argument for an unknown name.
+void set_active_backend(std::string_view name);
+[[nodiscard]] const Backend& active_backend();
+
+// Differential check of every registered backend against "reference" on
+// random shapes and data.
+struct BackendComparison {
+    std::string kernel;
+    std::string backend;
+    std::string shape;
+    // Largest |backend - reference| over the output.
+    Scalar max_abs_error{0.0};
+    // Best of three runs.
+    double seconds{0.0};
+};
+
+[[nodiscard]] std::vector<BackendComparison> compare_backends(std::size_t trials,
+                                                              std::uint64_t seed);
+
+} // namespace fnn
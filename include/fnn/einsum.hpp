@@ -0,0 +1,28 @@
+#pragma once
+
+// Two-operand Einstein summation, e.g.
+//   einsum("bij,bjk->bik", a, b)   batched matmul
+//   einsum("bhqd,bhkd->bhqk", q, k) attention scores
+//   einsum("bi,oij->boj", x, w)     bilinear projection
+//
+// Every index is classified as batch (in a, b and the output), free (in one
+// input and the output), or contracted (in both inputs only); indices found
+// in a single input only are summed out up front. The contraction then runs
+// as one batched GEMM over strided views of the operands. An operand is
+// copied into a packed layout only when its indices cannot be expressed as
+// single (batch, row, column) strides.
+//
+// Parsed specs are cached by string, so repeated calls skip parsing.
+
+#include "tensor.hpp"
+
+#include <string_view>
+
+namespace fnn {
+
+// Explicit-output form only ("...->..."); indices are ASCII letters, each
+// appearing at most once per operand. Throws std::invalid_argument on a
+// malformed spec or mismatched extents.
+[[nodiscard]] Tensor einsum(std::string_view spec, const Tensor& a, const Tensor& b);
+
+} // namespace fnn
@@ -6,11 +6,32 @@
 // It should include *public* headers only (no private/internal headers).
 
 #include "activation_func.hpp"
+#include "backend.hpp"
 #include "config.hpp"
+#include "einsum.hpp"
+#include "gemm.hpp"
+#include "gemm_tuner.hpp"
+#include "hierarchical_softmax.hpp"
 #include "layer.hpp"
+#include "layers/activation.hpp"
+#include "layers/conv1d.hpp"
+#include "layers/conv2d.hpp"
+#include "layers/dense.hpp"
+#include "layers/dropout.hpp"
+#include "layers/moe.hpp"
+#include "layers/pooling.hpp"
 #include "loss_func.hpp"
+#include "mips_index.hpp"
 #include "model.hpp"
+#include "predict_cache.hpp"
+#include "random.hpp"
+#include "sampled_softmax.hpp"
+#include "strassen.hpp"
+#include "tensor.hpp"
 #include "tensor2D.hpp"
+#include "tensor_ops.hpp"
+#include "tensor_permute.hpp"
+#include "tensor_reduce.hpp"
 
 namespace fnn {
 
@@ -0,0 +1,139 @@
+#pragma once
+
+// General matrix multiply: C = alpha * A * B + beta * C.
+//
+// Operands are strided views, so transposed or sliced matrices (and
+// sub-tensors of N-d Tensors) are used without copying; the kernel packs
+// blocks of A and B into a contiguous panel layout internally and runs a
+// register-blocked micro-kernel over them. The block sizes are a
+// GemmConfig, which the autotuner (gemm_tuner.hpp) can pick per shape.
+// Large products are split over the thread pool along both M and N.
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace fnn {
+
+// Read-only strided matrix: element (i, j) is data[i * row_stride + j * col_stride].
+struct MatrixRef {
+    const Scalar* data{nullptr};
+    std::size_t rows{0};
+    std::size_t cols{0};
+    std::size_t row_stride{0};
+    std::size_t col_stride{1};
+};
+
+// Writable strided matrix, same addressing as MatrixRef.
+struct MutableMatrixRef {
+    Scalar* data{nullptr};
+    std::size_t rows{0};
+    std::size_t cols{0};
+    std::size_t row_stride{0};
+    std::size_t col_stride{1};
+};
+
+// Blocking and threading of the packed kernel. An mc x kc block of A is
+// meant to stay in L2, a kc x nc panel of B in L3. mc and nc are rounded up
+// to the micro-tile (4 rows, 8 columns).
+struct GemmConfig {
+    std::size_t mc{128};
+    std::size_t kc{256};
+    std::size_t nc{2048};
+    // Upper bound on the threads one product uses; 0 means the whole pool.
+    // Either way a product gets at most one thread per 2^18 multiply-adds,
+    // so small ones stay on the calling thread.
+    std::size_t threads{0};
+
+    friend bool operator==(const GemmConfig&, const GemmConfig&) = default;
+};
+
+// How a product is split over threads: C is cut into rows x cols cells
+// (rows of whole micro-tiles, columns of each nc block), one per thread.
+// All cells share each packed panel of B; every cell packs its own rows
+// of A. The grid only changes the work split, never the result.
+struct GemmGrid {
+    std::size_t rows{1};
+    std::size_t cols{1};
+};
+
+// The grid gemm() would use for an m x k by k x n product under `config`:
+// as many threads as the work allows, then the squarest cells. Products
+// small enough for the direct path get the default 1 x 1 grid. The
+// pre-packed gemm() has no direct path, but at that size the per-thread
+// work floor leaves it on one thread too, so the grid holds for it as well.
+[[nodiscard]] GemmGrid gemm_grid(std::size_t m, std::size_t n, std::size_t k,
+                                 const GemmConfig& config = {});
+
+// C = alpha * A * B + beta * C. When beta == 0, C is not read (so it may
+// hold garbage). Throws std::invalid_argument on mismatched shapes.
+void gemm(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+          const MutableMatrixRef& c);
+
+// As above with explicit blocking; products too small to pack still take
+// the direct path. Throws std::invalid_argument on a zero block size.
+void gemm(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+          const MutableMatrixRef& c, const GemmConfig& config);
+
+// B packed once into the kernel's panel layout, for operands reused across
+// many products with different A (a Dense layer's weights between optimizer
+// steps). Packing is what a plain gemm() redoes on every call.
+class PackedMatrix {
+public:
+    PackedMatrix() = default;
+    // Packs b (k x n) using the kc / nc blocking of `config`; the product
+    // later uses config.mc and config.threads too.
+    explicit PackedMatrix(const MatrixRef& b, const GemmConfig& config = {});
+
+    // Re-packs in place, reusing the buffer when the size is unchanged.
+    void pack(const MatrixRef& b, const GemmConfig& config = {});
+
+    [[nodiscard]] std::size_t rows() const noexcept;
+    [[nodiscard]] std::size_t cols() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] std::size_t bytes() const noexcept;
+    [[nodiscard]] const GemmConfig& config() const noexcept;
+
+    // Packed kc x nc panel starting at (p0, j0); both must be block starts.
+    [[nodiscard]] const Scalar* panel(std::size_t p0, std::size_t j0) const noexcept;
+
+private:
+    [[nodiscard]] std::size_t panel_offset(std::size_t p0, std::size_t j0) const noexcept;
+
+    std::size_t rows_{0};
+    std::size_t cols_{0};
+    GemmConfig config_;
+    std::vector<Scalar> data_;
+};
+
+// Width of the column slivers that packed panels of B are made of.
+inline constexpr std::size_t kGemmPanelWidth = 8;
+
+// Writes the kc x nc block of B at row p0, column j0 to `dst` in the panel
+// layout: ceil(nc / kGemmPanelWidth) slivers back to back, each holding kc
+// rows of kGemmPanelWidth consecutive values, with the columns past nc
+// zero-filled. Calls for disjoint column ranges of one panel may run
+// concurrently.
+using PanelPacker = std::function<void(std::size_t p0, std::size_t j0, std::size_t kc,
+                                       std::size_t nc, Scalar* dst)>;
+
+// C = alpha * A * B + beta * C for a B (a.cols x c.cols) that is never
+// materialized: `pack_b` writes each panel straight into the packed layout
+// when the kernel needs it. For operands built on the fly, such as the
+// im2col matrix of a convolution.
+void gemm_panels(Scalar alpha, const MatrixRef& a, const PanelPacker& pack_b, Scalar beta,
+                 const MutableMatrixRef& c, const GemmConfig& config = {});
+
+// C = alpha * A * B + beta * C with B pre-packed.
+void gemm(Scalar alpha, const MatrixRef& a, const PackedMatrix& b, Scalar beta,
+          const MutableMatrixRef& c);
+
+// `count` independent GEMMs; operand i starts at data + i * <x>_batch_stride.
+// Batches are spread over the thread pool.
+void gemm_batched(Scalar alpha, const MatrixRef& a, std::size_t a_batch_stride,
+                  const MatrixRef& b, std::size_t b_batch_stride, Scalar beta,
+                  const MutableMatrixRef& c, std::size_t c_batch_stride, std::size_t count);
+
+} // namespace fnn
@@ -0,0 +1,52 @@
+#pragma once
+
+// Shape-aware GEMM autotuning.
+//
+// The best GemmConfig depends on the exact (M, N, K) and on the host. With
+// autotuning on, the first gemm() of each shape benchmarks a few candidate
+// configurations; the winner is kept in memory and appended to an on-disk
+// cache keyed by host (CPU model and thread count) and shape, so later runs
+// on the same kind of machine reuse it without tuning again.
+//
+// Autotuning is off by default, and gemm() then always uses GemmConfig{}.
+// Turn it on with set_gemm_autotune(true) or FNN_GEMM_AUTOTUNE=1. The cache
+// file is FNN_GEMM_TUNING_CACHE if set, else
+// $XDG_CACHE_HOME/fnn/gemm_tuning.tsv, else ~/.cache/fnn/gemm_tuning.tsv.
+
+#include "gemm.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fnn {
+
+struct GemmTrial {
+    GemmConfig config;
+    // Best observed time of one product.
+    double seconds{0.0};
+};
+
+void set_gemm_autotune(bool enabled);
+[[nodiscard]] bool gemm_autotune_enabled();
+
+// Configuration gemm() uses for an (m x k) * (k x n) product: the cached
+// winner for this host and shape, a freshly tuned one, or GemmConfig{} when
+// autotuning is off.
+[[nodiscard]] GemmConfig gemm_config_for(std::size_t m, std::size_t n, std::size_t k);
+
+// Times candidate configurations for one shape, fastest first. Neither
+// reads nor writes the cache.
+[[nodiscard]] std::vector<GemmTrial> benchmark_gemm_configs(std::size_t m, std::size_t n,
+                                                            std::size_t k);
+
+// Cache key of this host, e.g. "Intel(R) Xeon(R) ... / 8 threads".
+[[nodiscard]] std::string gemm_host_key();
+
+// An empty path keeps tuning results in memory only. Changing the path
+// drops results loaded from the previous one.
+void set_gemm_tuning_cache_path(std::filesystem::path path);
+[[nodiscard]] std::filesystem::path gemm_tuning_cache_path();
+
+} // namespace fnn
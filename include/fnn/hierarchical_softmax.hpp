@@ -0,0 +1,97 @@
+#pragma once
+
+// Hierarchical softmax over a Huffman tree, an O(log C) output layer for
+// very large class counts.
+//
+// Classes are the leaves of a binary tree built from their frequencies, so
+// frequent classes get short paths. Every inner node n holds a logistic
+// classifier sigmoid(w_n . h + b_n), the probability of taking its right
+// branch, and P(c | h) is the product of the branch probabilities along
+// the path to c. Training touches only the ~log2(C) nodes on the label's
+// path; inference descends greedily, taking the likelier branch at each
+// node (top-1 along the path, not an exact argmax over all classes).
+//
+// Inner nodes are numbered breadth-first from the root, so the top levels
+// every sample visits sit together at the front of the weights; each
+// class's path is stored contiguously in one flat array.
+
+#include "config.hpp"
+#include "tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace fnn {
+
+class CounterRng;
+
+class HierarchicalSoftmax {
+public:
+    // Zero parameters. Throws std::invalid_argument on fewer than two
+    // classes, a zero hidden size, or a frequency that is not positive and
+    // finite. Ties between equal frequencies go to the lower class index.
+    HierarchicalSoftmax(std::size_t hidden, std::span<const Scalar> frequencies);
+    // Node weights drawn uniformly from +-1/sqrt(hidden).
+    HierarchicalSoftmax(std::size_t hidden, std::span<const Scalar> frequencies,
+                        const CounterRng& rng);
+
+    [[nodiscard]] std::size_t classes() const noexcept;
+    [[nodiscard]] std::size_t hidden() const noexcept;
+    // classes() - 1.
+    [[nodiscard]] std::size_t inner_nodes() const noexcept;
+    // Path length (code length) of class c; throws std::out_of_range.
+    [[nodiscard]] std::size_t depth(std::size_t c) const;
+    [[nodiscard]] std::size_t max_depth() const noexcept;
+    // Mean path length weighted by the construction frequencies.
+    [[nodiscard]] Scalar mean_depth() const noexcept;
+
+    // inner_nodes() x hidden and 1 x inner_nodes(), breadth-first order.
+    [[nodiscard]] Tensor2D& weights() noexcept;
+    [[nodiscard]] const Tensor2D& weights() const noexcept;
+    [[nodiscard]] Tensor2D& bias() noexcept;
+    [[nodiscard]] const Tensor2D& bias() const noexcept;
+
+    // log P(c | h) for one sample. Throws std::invalid_argument on a size
+    // mismatch and std::out_of_range on an unknown class.
+    [[nodiscard]] Scalar log_probability(const Vector& h, std::size_t c) const;
+
+    // Mean of -log P(label | h) over the rows of `hidden` (batch x hidden).
+    // Accumulates into weight_grad() / bias_grad() and writes dL/dh into
+    // `d_hidden`, resized to batch x hidden. Throws std::invalid_argument
+    // on mismatched shapes or an unknown label.
+    Scalar loss_backward(const Tensor2D& hidden, std::span<const std::size_t> labels,
+                         Tensor2D& d_hidden);
+
+    [[nodiscard]] const Tensor2D& weight_grad() const noexcept;
+    [[nodiscard]] const Tensor2D& bias_grad() const noexcept;
+    void zero_grad();
+
+    // Greedy top-1 descent. Throws std::invalid_argument on a size mismatch.
+    [[nodiscard]] std::size_t predict(const Vector& h) const;
+    // One class per row, rows split across the thread pool.
+    [[nodiscard]] std::vector<std::size_t> predict_batch(const Tensor2D& hidden) const;
+
+private:
+    [[nodiscard]] std::size_t descend(const Scalar* h) const;
+
+    std::size_t classes_;
+    std::size_t hidden_;
+    Scalar mean_depth_{0.0};
+    Tensor2D weights_;
+    Tensor2D bias_;
+    Tensor2D weight_grad_;
+    Tensor2D bias_grad_;
+
+    // child_[2n + b] is the b branch of inner node n (b = 1: right): an
+    // inner node id below inner_nodes(), or inner_nodes() + class.
+    std::vector<std::size_t> child_;
+    // Path of class c: path_node_ / path_bit_ in
+    // [path_offset_[c], path_offset_[c + 1]), root first.
+    std::vector<std::size_t> path_offset_;
+    std::vector<std::size_t> path_node_;
+    std::vector<std::uint8_t> path_bit_;
+};
+
+} // namespace fnn
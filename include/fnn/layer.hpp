@@ -2,8 +2,19 @@
 
 #include "config.hpp"
 
+#include <cstddef>
+#include <cstdint>
+
 namespace fnn {
 
+// Memory a layer keeps alive between forward and backward.
+struct ActivationMemory {
+    // Bytes actually stored.
+    std::size_t saved_bytes{0};
+    // Bytes a plain implementation would store (one Scalar per element).
+    std::size_t full_bytes{0};
+};
+
 // Interface-only scaffolding (no implementation yet).
 // This is a minimal OO boundary you can evolve as you implement backprop.
 class Layer {
@@ -13,8 +24,26 @@ public:
     // Forward pass.
     [[nodiscard]] virtual Vector forward(const Vector& input) = 0;
 
+    // forward() into `out`, so a caller running the layer repeatedly can
+    // keep one output buffer; out must not alias input. The default assigns
+    // forward()'s result.
+    virtual void forward_into(const Vector& input, Vector& out);
+
     // Backward pass: returns gradient w.r.t. input.
     [[nodiscard]] virtual Vector backward(const Vector& d_output) = 0;
+
+    // Layers that behave differently in training (dropout) or keep state
+    // for backward only when training override this; the default ignores it.
+    virtual void set_training(bool training) noexcept;
+
+    // Memory saved for backward by the last forward pass. Layers without
+    // saved state report zeros.
+    [[nodiscard]] virtual ActivationMemory activation_memory() const;
+
+    // Changes whenever the layer's parameters may have been changed through
+    // its API, so caches of its outputs can tell they are stale. Layers
+    // without parameters report 0.
+    [[nodiscard]] virtual std::uint64_t version() const noexcept;
 };
 
 } // namespace fnn
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "fnn/activation_func.hpp"
+#include "fnn/config.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/util/bit_mask.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace fnn {
+
+class Tensor2D;
+
+// Applies an ActivationFunction element-wise.
+//
+// SaveMode::Full keeps the input as Scalars for backward. SaveMode::Lean keeps
+// only what the derivative needs:
+// - sign-determined activations (ReLU, LeakyReLU): 1 bit per element;
+// - output-determined activations (Sigmoid, Tanh): the output as float;
+// - anything else: the input as float.
+class Activation : public Layer {
+public:
+    enum class SaveMode { Full, Lean };
+
+    explicit Activation(std::unique_ptr<ActivationFunction> fn, SaveMode mode = SaveMode::Full);
+
+    [[nodiscard]] const ActivationFunction& function() const noexcept;
+    [[nodiscard]] SaveMode save_mode() const noexcept;
+
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // Batched versions that overwrite their argument instead of allocating.
+    void forward_inplace(Tensor2D& batch);
+    void backward_inplace(Tensor2D& d_batch) const;
+
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+
+private:
+    enum class Saved { Nothing, Input, SignMask, OutputF32, InputF32 };
+
+    void apply_forward(Scalar* data, std::size_t n);
+    void apply_backward(Scalar* data, std::size_t n) const;
+
+    std::unique_ptr<ActivationFunction> fn_;
+    SaveMode mode_{SaveMode::Full};
+
+    // State of the last forward, consumed by backward.
+    Saved saved_{Saved::Nothing};
+    std::size_t saved_size_{0};
+    Vector input_;
+    std::vector<float> reduced_;
+    util::BitMask sign_;
+};
+
+} // namespace fnn
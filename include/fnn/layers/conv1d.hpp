@@ -0,0 +1,107 @@
+#pragma once
+
+#include "fnn/config.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/tensor.hpp"
+#include "fnn/tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fnn {
+
+class CounterRng;
+
+// 1-D convolution over (batch, channels, length) tensors:
+// y[b, o, t] = bias[o] + sum_{c, k} W[o, c, k] * x[b, c, t * stride + k - padding],
+// with x read as zero outside [0, length).
+//
+// Weights are stored out_channels x (in_channels * kernel_size), row-major,
+// column c * kernel_size + k: the A operand of the lowered product
+// Y_b = W * col(X_b). The im2col matrix col(X_b) is never built; its GEMM
+// panels are written straight from X_b as the kernel consumes them
+// (gemm_panels()). When in_channels * kernel_size is tiny the product is
+// too shallow for packing to pay off, and the forward pass runs a direct
+// loop nest instead.
+class Conv1D : public Layer {
+public:
+    enum class Algorithm {
+        // Direct forward below a small reduction depth, GEMM otherwise.
+        Auto,
+        Gemm,
+        // Direct loops in both passes.
+        Direct,
+    };
+
+    // Zero weights and bias. Throws std::invalid_argument on a zero
+    // channel count, kernel size or stride.
+    Conv1D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_size,
+           std::size_t stride = 1, std::size_t padding = 0);
+    // Glorot-uniform weights drawn from `rng`, zero bias.
+    Conv1D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_size,
+           const CounterRng& rng, std::size_t stride = 1, std::size_t padding = 0);
+
+    [[nodiscard]] std::size_t in_channels() const noexcept;
+    [[nodiscard]] std::size_t out_channels() const noexcept;
+    [[nodiscard]] std::size_t kernel_size() const noexcept;
+    [[nodiscard]] std::size_t stride() const noexcept;
+    [[nodiscard]] std::size_t padding() const noexcept;
+    // Output length for an input of `length`; throws std::invalid_argument
+    // when the padded input is shorter than the kernel.
+    [[nodiscard]] std::size_t output_length(std::size_t length) const;
+
+    void set_algorithm(Algorithm algorithm) noexcept;
+    [[nodiscard]] Algorithm algorithm() const noexcept;
+    // What each pass actually runs (Auto resolved).
+    [[nodiscard]] Algorithm forward_algorithm() const noexcept;
+    [[nodiscard]] Algorithm backward_algorithm() const noexcept;
+
+    // In training mode forward passes keep their input for backward.
+    void set_training(bool training) noexcept override;
+    [[nodiscard]] bool training() const noexcept;
+
+    [[nodiscard]] const Tensor2D& weights() const noexcept;
+    [[nodiscard]] const Tensor2D& bias() const noexcept;
+    // Writable access; bumps version().
+    [[nodiscard]] Tensor2D& mutable_weights() noexcept;
+    [[nodiscard]] Tensor2D& mutable_bias() noexcept;
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+    // One sample of in_channels x length values, channel-major.
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // (batch, in_channels, length) -> (batch, out_channels, output_length).
+    // Throws std::invalid_argument on a shape mismatch.
+    [[nodiscard]] Tensor forward_batch(const Tensor& input);
+    // Takes dL/dy for the last training forward_batch, accumulates into
+    // weight_grad() / bias_grad() and returns dL/dx. Throws
+    // std::logic_error without a saved forward and std::invalid_argument
+    // on a shape mismatch.
+    [[nodiscard]] Tensor backward_batch(const Tensor& d_output);
+
+    [[nodiscard]] const Tensor2D& weight_grad() const noexcept;
+    [[nodiscard]] const Tensor2D& bias_grad() const noexcept;
+    void zero_grad();
+
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+
+private:
+    std::size_t in_channels_;
+    std::size_t kernel_size_;
+    std::size_t stride_;
+    std::size_t padding_;
+    Algorithm algorithm_{Algorithm::Auto};
+    bool training_{true};
+    Tensor2D weights_;
+    Tensor2D bias_;
+    std::uint64_t version_{0};
+    Tensor2D weight_grad_;
+    Tensor2D bias_grad_;
+
+    // State of the last training forward, consumed by backward.
+    bool saved_{false};
+    Tensor input_{Dims{0, 0, 0}};
+};
+
+} // namespace fnn
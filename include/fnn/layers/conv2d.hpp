@@ -0,0 +1,110 @@
+#pragma once
+
+#include "fnn/config.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/tensor.hpp"
+#include "fnn/tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fnn {
+
+class CounterRng;
+
+// 2-D convolution on channel-blocked images (to_nchwc() layout):
+// (N, ceil(in / 8), H, W, 8) -> (N, ceil(out / 8), OH, OW, 8), with the
+// same stride and zero padding along both axes.
+//
+// Weights are kept blocked as (out / 8, in / 8, KH, KW, 8 in, 8 out), so
+// the inner loop of every pass is an 8-wide multiply-add across channels:
+// forward broadcasts one input channel against 8 output channels, and
+// register-tiles 4 output pixels at a time. weights() / set_weights()
+// convert from and to the usual (out, in, KH, KW).
+//
+// Channels past `in` / `out` in the last block stay zero. The single-sample
+// Vector interface takes one image in that same blocked layout,
+// (ceil(in / 8), H, W, 8) flattened, with H and W given once by
+// set_input_size(); a stack of Conv2D / pooling layers in a Sequential then
+// converts with to_nchwc() / from_nchwc() only at its ends.
+class Conv2D : public Layer {
+public:
+    // Zero weights and bias. Throws std::invalid_argument on a zero channel
+    // count, kernel size or stride.
+    Conv2D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_h,
+           std::size_t kernel_w, std::size_t stride = 1, std::size_t padding = 0);
+    // Glorot-uniform weights drawn from `rng`, zero bias.
+    Conv2D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_h,
+           std::size_t kernel_w, const CounterRng& rng, std::size_t stride = 1,
+           std::size_t padding = 0);
+
+    [[nodiscard]] std::size_t in_channels() const noexcept;
+    [[nodiscard]] std::size_t out_channels() const noexcept;
+    [[nodiscard]] std::size_t kernel_h() const noexcept;
+    [[nodiscard]] std::size_t kernel_w() const noexcept;
+    [[nodiscard]] std::size_t stride() const noexcept;
+    [[nodiscard]] std::size_t padding() const noexcept;
+    // Output extent along an axis of `size` with kernel extent `kernel`;
+    // throws std::invalid_argument when the padded input is too small.
+    [[nodiscard]] std::size_t output_size(std::size_t size, std::size_t kernel) const;
+
+    // Image size forward() assumes; until set, forward() throws
+    // std::logic_error. Throws std::invalid_argument on a zero size.
+    void set_input_size(std::size_t height, std::size_t width);
+    [[nodiscard]] std::size_t input_height() const noexcept;
+    [[nodiscard]] std::size_t input_width() const noexcept;
+
+    // In training mode forward passes keep their input for backward.
+    void set_training(bool training) noexcept override;
+    [[nodiscard]] bool training() const noexcept;
+
+    // (out, in, KH, KW) copy of the weights.
+    [[nodiscard]] Tensor weights() const;
+    // Takes (out, in, KH, KW) weights and a 1 x out bias. Throws
+    // std::invalid_argument on a shape mismatch.
+    void set_weights(const Tensor& weights, const Tensor2D& bias);
+    [[nodiscard]] const Tensor2D& bias() const noexcept;
+    // Bumped by set_weights().
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+    // One image through forward_batch / backward_batch. Throw
+    // std::invalid_argument on a size mismatch.
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // Throws std::invalid_argument unless `input` is (N, ceil(in / 8), H, W, 8).
+    [[nodiscard]] Tensor forward_batch(const Tensor& input);
+    // Takes dL/dy for the last training forward_batch, accumulates into the
+    // gradients and returns dL/dx. Throws std::logic_error without a saved
+    // forward and std::invalid_argument on a shape mismatch.
+    [[nodiscard]] Tensor backward_batch(const Tensor& d_output);
+
+    // (out, in, KH, KW) copy of the weight gradient.
+    [[nodiscard]] Tensor weight_grad() const;
+    [[nodiscard]] const Tensor2D& bias_grad() const noexcept;
+    void zero_grad();
+
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+
+private:
+    std::size_t in_channels_;
+    std::size_t out_channels_;
+    std::size_t kernel_h_;
+    std::size_t kernel_w_;
+    std::size_t stride_;
+    std::size_t padding_;
+    std::size_t input_height_{0};
+    std::size_t input_width_{0};
+    bool training_{true};
+    Tensor weights_;
+    Tensor2D bias_;
+    std::uint64_t version_{0};
+    Tensor weight_grad_;
+    Tensor2D bias_grad_;
+
+    // State of the last training forward, consumed by backward.
+    bool saved_{false};
+    Tensor input_{Dims{0, 0, 0, 0, 0}};
+};
+
+} // namespace fnn
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "fnn/backend.hpp"
+#include "fnn/config.hpp"
+#include "fnn/gemm.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace fnn {
+
+class CounterRng;
+
+// Fully connected layer: y = f(x * W^T + b), where f is an optional fused
+// activation (Identity by default).
+//
+// Weights are stored out_features x in_features, row-major (one row per
+// output unit), the bias as 1 x out_features. Forward multiplies by W^T
+// through a copy of the weights pre-packed into the GEMM panel layout, so an
+// inference call pays for the product only, never for packing. The packed
+// copy is rebuilt by pack_weights(): construction and set_weights() do it,
+// training code should call it after each optimizer step, and otherwise the
+// first forward after mutable_weights() was used does it. A batch of one
+// row skips the panels and runs a GEMV straight over the out x in weights,
+// which are already stored in the row-by-row order that kernel streams.
+// Packed panels, the GEMV and per-task thread counts are the built-in
+// "optimized" backend's kernels, so Dense calls them directly only while a
+// backend with prefers_layer_kernels() is active; under any other backend,
+// including one registered under the name "optimized", every product goes
+// through its matmul().
+//
+// Backward is one fused sweep over dY: each tile of dY is read once, scaled
+// by f'(y) (recovered from the saved output), and feeds db, dW and dX while
+// it is still in cache.
+class Dense : public Layer {
+public:
+    // Zero weights and bias.
+    Dense(std::size_t in_features, std::size_t out_features);
+    // Glorot-uniform weights drawn from `rng`, zero bias. `alpha` is the
+    // LeakyReLU slope and must be positive so f' can be read off the output.
+    Dense(std::size_t in_features, std::size_t out_features, const CounterRng& rng,
+          ActivationKind activation = ActivationKind::Identity, Scalar alpha = 0.01);
+
+    [[nodiscard]] std::size_t in_features() const noexcept;
+    [[nodiscard]] std::size_t out_features() const noexcept;
+    [[nodiscard]] ActivationKind activation() const noexcept;
+
+    // In training mode forward passes keep what backward needs; in
+    // inference mode they keep nothing. Defaults to training.
+    void set_training(bool training) noexcept override;
+    [[nodiscard]] bool training() const noexcept;
+
+    [[nodiscard]] const Tensor2D& weights() const noexcept;
+    [[nodiscard]] const Tensor2D& bias() const noexcept;
+    // Writable access; marks the packed weights stale.
+    [[nodiscard]] Tensor2D& mutable_weights() noexcept;
+    [[nodiscard]] Tensor2D& mutable_bias() noexcept;
+    // Copies new parameters and re-packs. Throws std::invalid_argument on a
+    // shape mismatch.
+    void set_weights(const Tensor2D& weights, const Tensor2D& bias);
+
+    void pack_weights();
+    [[nodiscard]] bool weights_packed() const noexcept;
+    // Bumped by mutable_weights(), mutable_bias() and set_weights(), so
+    // caches built from the parameters can tell they are stale.
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+    // f applied in place to pre-activations x * W^T + b, for callers that
+    // maintain those themselves.
+    void activate(std::span<Scalar> z) const;
+
+    // Single sample, treated as a batch of one row.
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    // In inference mode writes straight into out, reusing its storage.
+    void forward_into(const Vector& input, Vector& out) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // batch x in_features -> batch x out_features.
+    [[nodiscard]] Tensor2D forward_batch(const Tensor2D& batch);
+    // Takes dL/dy for the last training forward_batch, accumulates into
+    // weight_grad() / bias_grad() and returns dL/dx. Throws std::logic_error
+    // without a saved forward and std::invalid_argument on a shape mismatch.
+    [[nodiscard]] Tensor2D backward_batch(const Tensor2D& d_output);
+
+    [[nodiscard]] const Tensor2D& weight_grad() const noexcept;
+    [[nodiscard]] const Tensor2D& bias_grad() const noexcept;
+    void zero_grad();
+
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+
+private:
+    // out = f(x * W^T + b) for `rows` contiguous input rows.
+    void affine(const Scalar* x, std::size_t rows, Scalar* out);
+
+    Tensor2D weights_;
+    Tensor2D bias_;
+    Tensor2D weight_grad_;
+    Tensor2D bias_grad_;
+    PackedMatrix packed_;
+    bool packed_valid_{false};
+    std::uint64_t version_{0};
+    ActivationKind activation_{ActivationKind::Identity};
+    Scalar alpha_{0.01};
+    bool training_{true};
+
+    // State of the last training forward, consumed by backward. The output
+    // is only kept when f is not the identity.
+    bool saved_{false};
+    Tensor2D input_{0, 0};
+    Tensor2D output_{0, 0};
+};
+
+} // namespace fnn
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "fnn/config.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/bit_mask.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fnn {
+
+class Tensor2D;
+
+// Inverted dropout: in training, each element is zeroed with probability
+// `rate` and survivors are scaled by 1 / (1 - rate); in inference it is the
+// identity.
+//
+// The keep mask comes from a CounterRng keyed by (seed, step, layer_id,
+// element), so it never needs to be stored as Scalars. Depending on
+// `MaskStorage` it is either kept as a packed bit mask (1 bit per element)
+// or not stored at all and regenerated in backward.
+class Dropout : public Layer {
+public:
+    enum class MaskStorage { Packed, Regenerate };
+
+    Dropout(Scalar rate, std::uint64_t seed, std::uint32_t layer_id,
+            MaskStorage storage = MaskStorage::Packed);
+
+    void set_training(bool training) noexcept override;
+    [[nodiscard]] bool training() const noexcept;
+    [[nodiscard]] Scalar rate() const noexcept;
+    // Number of training forward passes so far; the next one uses this step.
+    [[nodiscard]] std::uint64_t step() const noexcept;
+
+    // Single sample, treated as a batch of one row.
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // Batched versions that overwrite their argument instead of allocating.
+    // backward_inplace must see the same shape as the preceding forward.
+    void forward_inplace(Tensor2D& batch);
+    void backward_inplace(Tensor2D& d_batch) const;
+
+    // Bytes held between forward and backward for the mask.
+    [[nodiscard]] std::size_t mask_bytes() const noexcept;
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+
+private:
+    void apply_forward(Scalar* data, std::size_t n);
+    void apply_backward(Scalar* data, std::size_t n) const;
+
+    Scalar rate_{0.0};
+    Scalar scale_{1.0};
+    CounterRng rng_;
+    MaskStorage storage_{MaskStorage::Packed};
+    bool training_{true};
+    std::uint64_t step_{0};
+
+    // State of the last training forward, consumed by backward.
+    std::uint64_t mask_step_{0};
+    std::size_t mask_size_{0};
+    bool mask_valid_{false};
+    util::BitMask mask_;
+};
+
+} // namespace fnn
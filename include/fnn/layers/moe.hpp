@@ -0,0 +1,100 @@
+#pragma once
+
+#include "fnn/backend.hpp"
+#include "fnn/config.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/layers/dense.hpp"
+#include "fnn/tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fnn {
+
+class CounterRng;
+
+// Mixture of experts with sparse top-k routing:
+// y = sum over the k experts e with the largest gate logits of
+// softmax_k(logits)_e * expert_e(x), where the gate is a Dense layer
+// in -> experts and every expert a Dense layer in -> out.
+//
+// A batch is routed row by row, then the batch * k (row, expert) pairs are
+// grouped per expert with a counting sort, so each expert runs one batched
+// forward over exactly the rows sent to it. Compute grows with k, not with
+// the number of experts. Experts run concurrently on the thread pool, and
+// each output row sums its k contributions in rank order, so results do
+// not depend on the thread count. Ties between logits go to the lower
+// expert index.
+class MixtureOfExperts : public Layer {
+public:
+    // The gate's weights are drawn from `rng` and expert e's from
+    // rng.with_step(rng.step() + 1 + e), so the layer stays on rng's layer
+    // id and neighbouring layers' ids are free. Throws
+    // std::invalid_argument unless 1 <= top_k <= experts.
+    MixtureOfExperts(std::size_t in_features, std::size_t out_features, std::size_t experts,
+                     std::size_t top_k, const CounterRng& rng,
+                     ActivationKind activation = ActivationKind::Identity);
+
+    [[nodiscard]] std::size_t in_features() const noexcept;
+    [[nodiscard]] std::size_t out_features() const noexcept;
+    [[nodiscard]] std::size_t expert_count() const noexcept;
+    [[nodiscard]] std::size_t top_k() const noexcept;
+
+    // Forwarded to the gate and every expert.
+    void set_training(bool training) noexcept override;
+    [[nodiscard]] bool training() const noexcept;
+
+    [[nodiscard]] Dense& gate() noexcept;
+    [[nodiscard]] const Dense& gate() const noexcept;
+    // Throws std::out_of_range past the last expert.
+    [[nodiscard]] Dense& expert(std::size_t index);
+    [[nodiscard]] const Dense& expert(std::size_t index) const;
+
+    // Single sample, treated as a batch of one row.
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // batch x in_features -> batch x out_features. Throws
+    // std::invalid_argument on a shape mismatch.
+    [[nodiscard]] Tensor2D forward_batch(const Tensor2D& batch);
+    // Takes dL/dy for the last training forward_batch, accumulates into the
+    // gate's and experts' gradients and returns dL/dx. Throws
+    // std::logic_error without a saved forward and std::invalid_argument
+    // on a shape mismatch.
+    [[nodiscard]] Tensor2D backward_batch(const Tensor2D& d_output);
+
+    void zero_grad();
+
+    // Rows routed to each expert by the last forward_batch.
+    [[nodiscard]] std::vector<std::size_t> expert_load() const;
+
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+    // Sum of the gate's and experts' versions.
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+private:
+    // Fills route_ / weight_ from the gate logits, then groups the pairs.
+    void route(const Tensor2D& logits);
+
+    std::size_t top_k_;
+    bool training_{true};
+    Dense gate_;
+    std::vector<Dense> experts_;
+
+    // Routing of the last forward, pair a = row * k + rank: expert
+    // route_[a] with gate weight weight_[a]. Pairs of expert e sit at
+    // sorted positions [offset_[e], offset_[e + 1]); order_ maps a sorted
+    // position to its pair and position_ back.
+    std::size_t rows_{0};
+    std::vector<std::size_t> route_;
+    std::vector<Scalar> weight_;
+    std::vector<std::size_t> offset_;
+    std::vector<std::size_t> order_;
+    std::vector<std::size_t> position_;
+    // Expert outputs in sorted order, kept for backward in training.
+    Tensor2D expert_output_{0, 0};
+    bool saved_{false};
+};
+
+} // namespace fnn
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "fnn/config.hpp"
+#include "fnn/layer.hpp"
+#include "fnn/tensor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fnn {
+
+// 2-D pooling over square windows on channel-blocked images (to_nchwc()
+// layout): (N, B, H, W, 8) -> (N, B, OH, OW, 8) with OH = (H - kernel) /
+// stride + 1, no padding. Each window is reduced 8 channels at a time.
+//
+// As with Conv2D, the Vector interface takes one image in the blocked
+// layout, (B, H, W, 8) flattened, with H and W from set_input_size() and B
+// from the input's length.
+
+// Maximum of each window. Training forwards keep the position of the
+// maximum within its window (2 bytes per output element); backward routes
+// each gradient there. Ties go to the first position in row-major order.
+class MaxPool2D : public Layer {
+public:
+    // stride 0 means stride == kernel. Throws std::invalid_argument on a
+    // zero kernel or a window of more than 65536 elements.
+    explicit MaxPool2D(std::size_t kernel, std::size_t stride = 0);
+
+    [[nodiscard]] std::size_t kernel() const noexcept;
+    [[nodiscard]] std::size_t stride() const noexcept;
+
+    // Image size forward() assumes; until set, forward() throws
+    // std::logic_error. Throws std::invalid_argument on a zero size.
+    void set_input_size(std::size_t height, std::size_t width);
+    [[nodiscard]] std::size_t input_height() const noexcept;
+    [[nodiscard]] std::size_t input_width() const noexcept;
+
+    void set_training(bool training) noexcept override;
+    [[nodiscard]] bool training() const noexcept;
+
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    // Throws std::invalid_argument unless 5-D with a last dimension of 8
+    // and at least kernel x kernel pixels.
+    [[nodiscard]] Tensor forward_batch(const Tensor& input);
+    // Throws std::logic_error without a saved forward and
+    // std::invalid_argument on a shape mismatch.
+    [[nodiscard]] Tensor backward_batch(const Tensor& d_output);
+
+    [[nodiscard]] ActivationMemory activation_memory() const override;
+
+private:
+    std::size_t kernel_;
+    std::size_t stride_;
+    std::size_t input_height_{0};
+    std::size_t input_width_{0};
+    bool training_{true};
+
+    // State of the last training forward, consumed by backward.
+    bool saved_{false};
+    Dims input_dims_;
+    std::vector<std::uint16_t> argmax_;
+};
+
+// Mean of each window. Backward only needs the input shape.
+class AvgPool2D : public Layer {
+public:
+    // stride 0 means stride == kernel. Throws std::invalid_argument on a
+    // zero kernel.
+    explicit AvgPool2D(std::size_t kernel, std::size_t stride = 0);
+
+    [[nodiscard]] std::size_t kernel() const noexcept;
+    [[nodiscard]] std::size_t stride() const noexcept;
+
+    // Image size forward() assumes; until set, forward() throws
+    // std::logic_error. Throws std::invalid_argument on a zero size.
+    void set_input_size(std::size_t height, std::size_t width);
+    [[nodiscard]] std::size_t input_height() const noexcept;
+    [[nodiscard]] std::size_t input_width() const noexcept;
+
+    [[nodiscard]] Vector forward(const Vector& input) override;
+    [[nodiscard]] Vector backward(const Vector& d_output) override;
+
+    [[nodiscard]] Tensor forward_batch(const Tensor& input);
+    [[nodiscard]] Tensor backward_batch(const Tensor& d_output);
+
+private:
+    std::size_t kernel_;
+    std::size_t stride_;
+    std::size_t input_height_{0};
+    std::size_t input_width_{0};
+
+    // Shape of the last forward's input; empty before the first.
+    Dims input_dims_;
+};
+
+} // namespace fnn
@@ -0,0 +1,93 @@
+#pragma once
+
+// Top-k selection over very wide output layers.
+//
+// Serving often needs only the best few classes of a final layer with
+// millions of outputs. top_k() selects them from a full logit vector
+// without sorting it. MipsIndex (maximum inner product search) avoids most
+// of the logits: it clusters the layer's weight rows with k-means, and for
+// a query h bounds every row w of a partition by
+//     w . h + b <= c . h + r * |h| + max b
+// (c the centroid, r the largest |w - c| in the partition). Partitions are
+// scanned by descending c . h, up to a probe budget, and the scan stops
+// early once no remaining bound can beat the current k-th score, so a
+// budget of partitions() is exact. (The bound is loose in high dimensions,
+// so in practice the budget, not the bound, ends most scans.)
+//
+// The index copies the weights, grouped by partition, and must be rebuilt
+// when the layer changes. It ranks pre-activation logits, which is the
+// layer's own order for any monotone activation.
+
+#include "config.hpp"
+#include "tensor2D.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace fnn {
+
+class CounterRng;
+class Dense;
+
+struct ScoredClass {
+    std::size_t index{0};
+    Scalar score{0.0};
+
+    friend bool operator==(const ScoredClass&, const ScoredClass&) = default;
+};
+
+// The min(k, scores.size()) largest scores, best first; equal scores go to
+// the lower index. Partial selection: O(n + k log k).
+[[nodiscard]] std::vector<ScoredClass> top_k(std::span<const Scalar> scores, std::size_t k);
+
+struct MipsIndexConfig {
+    // k-means clusters; 0 picks about sqrt(rows).
+    std::size_t partitions{0};
+    // Lloyd iterations, run on a sample of the rows.
+    std::size_t iterations{8};
+    // Training sample size per partition (all rows when fewer).
+    std::size_t sample_per_partition{64};
+};
+
+class MipsIndex {
+public:
+    // Index over the rows of `weights` (classes x dim) with a 1 x classes
+    // bias. The training sample and initial centroids are drawn from `rng`.
+    // Throws std::invalid_argument on an empty or mismatched layer.
+    MipsIndex(const Tensor2D& weights, const Tensor2D& bias, const CounterRng& rng,
+              MipsIndexConfig config = {});
+    MipsIndex(const Dense& layer, const CounterRng& rng, MipsIndexConfig config = {});
+
+    [[nodiscard]] std::size_t classes() const noexcept;
+    [[nodiscard]] std::size_t dim() const noexcept;
+    [[nodiscard]] std::size_t partitions() const noexcept;
+    // Rows assigned to partition p; throws std::out_of_range.
+    [[nodiscard]] std::size_t partition_size(std::size_t p) const;
+
+    // Approximate top k for one query, best first, scanning at most
+    // `probes` partitions (at least one). Throws std::invalid_argument on
+    // a size mismatch.
+    [[nodiscard]] std::vector<ScoredClass> search(std::span<const Scalar> query, std::size_t k,
+                                                  std::size_t probes) const;
+    // One result per row of `queries`, rows split across the thread pool.
+    [[nodiscard]] std::vector<std::vector<ScoredClass>>
+    search_batch(const Tensor2D& queries, std::size_t k, std::size_t probes) const;
+
+private:
+    std::size_t classes_;
+    std::size_t dim_;
+    // partitions() x dim, with each partition's radius and largest bias.
+    Tensor2D centroids_;
+    std::vector<Scalar> radius_;
+    std::vector<Scalar> max_bias_;
+    // Rows of partition p sit at [offset_[p], offset_[p + 1]) of weights_ /
+    // bias_, which hold the layer's rows in partition order; class_ maps
+    // them back to class indices.
+    std::vector<std::size_t> offset_;
+    std::vector<std::size_t> class_;
+    Tensor2D weights_;
+    std::vector<Scalar> bias_;
+};
+
+} // namespace fnn
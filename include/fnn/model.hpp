@@ -1,16 +1,166 @@
 #pragma once
 
 #include "config.hpp"
+#include "layer.hpp"
+#include "tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace fnn {
 
-// Interface-only scaffolding (no implementation yet).
-// Keep this minimal until you have a single end-to-end training path working.
 class Model {
 public:
     virtual ~Model() = default;
 
     [[nodiscard]] virtual Vector predict(const Vector& input) = 0;
+
+    // Changes whenever predict() may start giving different results for
+    // the same input (parameters edited or reloaded, layers added), for
+    // caches in front of the model. The default 0 means "never changes".
+    [[nodiscard]] virtual std::uint64_t version() const noexcept;
+};
+
+// Layers applied one after another. predict() runs each layer's
+// single-sample forward, so Dense layers take their batch-size-1 GEMV path;
+// call set_training(false) first for online scoring so no layer keeps state
+// for backward.
+class Sequential : public Model {
+public:
+    // Takes ownership and returns the added layer. Throws
+    // std::invalid_argument on a null layer.
+    Layer& add(std::unique_ptr<Layer> layer);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    // Throws std::out_of_range past the last layer.
+    [[nodiscard]] Layer& layer(std::size_t index);
+    [[nodiscard]] const Layer& layer(std::size_t index) const;
+
+    // Forwarded to every layer.
+    void set_training(bool training) noexcept;
+    [[nodiscard]] bool training() const noexcept;
+
+    [[nodiscard]] Vector predict(const Vector& input) override;
+    // Layers added plus the sum of the layers' versions.
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+    // predict() for a stream of inputs that each differ from the previous
+    // one in a few features. Layer 0 must be Dense: its pre-activation z
+    // is cached and moved by (x_j - x'_j) * W[:, j] for just the changed
+    // features j, so it costs O(changed x out) rather than O(in x out);
+    // the remaining layers run as in predict(). z is recomputed in full on
+    // the first call, after the Dense layer's version() changes, when over
+    // in / kIncrementalCrossover features changed or a change is not
+    // finite, and every kIncrementalRefresh updates to bound rounding
+    // drift. Keeps a copy of W^T. Throws std::logic_error when layer 0 is
+    // not Dense and std::invalid_argument on an input width mismatch.
+    [[nodiscard]] Vector predict_incremental(const Vector& input);
+    // Drops the cache; the next predict_incremental() starts over.
+    void reset_incremental() noexcept;
+
+    static constexpr std::size_t kIncrementalRefresh = 1024;
+    // Measured with `fnn_bench incremental`: the sparse update stops paying
+    // between a fifth (narrow layers, 64 -> 64) and a half (4096 -> 1024)
+    // of the features changed. The cut-off takes the narrow end, so no
+    // layer width runs the sparse update past its break-even; wide layers
+    // give up some of their range instead.
+    static constexpr std::size_t kIncrementalCrossover = 5;
+
+private:
+    std::vector<std::unique_ptr<Layer>> layers_;
+    bool training_{true};
+
+    // predict_incremental() state: the previous input, layer 0's
+    // pre-activation for it, and W^T (in x out) so each feature's weights
+    // are contiguous, as of layer 0's version() cached_version_.
+    bool cached_{false};
+    std::uint64_t cached_version_{0};
+    std::size_t updates_{0};
+    Vector last_input_;
+    Vector pre_activation_;
+    Tensor2D weights_t_{0, 0};
+};
+
+// Layers wired as a directed acyclic graph, for skip connections and
+// parallel branches. Node 0 is the model input; every add_*() call appends a
+// node reading earlier nodes, so the graph is acyclic by construction and
+// node ids are a topological order.
+//
+// predict() runs the graph level by level, a node's level being one past
+// its deepest input; the nodes of one level are independent and run
+// concurrently on the thread pool. Node values live in a fixed set of
+// buffers planned once per graph: a buffer is handed to a later node as
+// soon as the level holding the last reader of its current value is done.
+class GraphModel : public Model {
+public:
+    using NodeId = std::size_t;
+
+    static constexpr NodeId kInput = 0;
+
+    GraphModel();
+
+    // Applies `layer` to node `input`. Throws std::invalid_argument on a
+    // null layer or an unknown node.
+    NodeId add_layer(std::unique_ptr<Layer> layer, NodeId input);
+    // Element-wise sum of the inputs, which must have equal sizes at
+    // predict() time. Throws std::invalid_argument on an empty list or an
+    // unknown node.
+    NodeId add_sum(const std::vector<NodeId>& inputs);
+    // The inputs one after another. Throws as add_sum().
+    NodeId add_concat(const std::vector<NodeId>& inputs);
+
+    // Node whose value predict() returns; the last added node by default.
+    // Throws std::invalid_argument on an unknown node.
+    void set_output(NodeId node);
+    [[nodiscard]] NodeId output() const noexcept;
+
+    // Number of nodes, the input included.
+    [[nodiscard]] std::size_t size() const noexcept;
+    // Throws std::invalid_argument unless `node` is a layer node.
+    [[nodiscard]] Layer& layer(NodeId node);
+    [[nodiscard]] const Layer& layer(NodeId node) const;
+
+    // Forwarded to every layer.
+    void set_training(bool training) noexcept;
+    [[nodiscard]] bool training() const noexcept;
+
+    // Levels of the schedule (the input's level 0 not counted) and buffers
+    // the plan needs, with fewer buffers than nodes whenever values die
+    // before the output.
+    [[nodiscard]] std::size_t level_count();
+    [[nodiscard]] std::size_t buffer_count();
+
+    // Throws std::invalid_argument when sum inputs differ in size.
+    [[nodiscard]] Vector predict(const Vector& input) override;
+    // Graph edits plus the sum of the layers' versions.
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+private:
+    enum class Op { Input, Layer, Sum, Concat };
+
+    struct Node {
+        Op op;
+        std::vector<NodeId> inputs;
+        std::unique_ptr<Layer> layer;
+    };
+
+    NodeId add_node(Op op, std::vector<NodeId> inputs, std::unique_ptr<Layer> layer);
+    void plan();
+    [[nodiscard]] const Vector& value(NodeId node, const Vector& input) const;
+    void run(NodeId node, const Vector& input);
+
+    std::vector<Node> nodes_;
+    NodeId output_{kInput};
+    bool training_{true};
+    std::uint64_t edits_{0};
+
+    // Schedule and buffer plan; rebuilt by plan() after the graph changes.
+    bool planned_{false};
+    std::vector<std::vector<NodeId>> levels_;
+    std::vector<std::size_t> buffer_of_;
+    std::vector<Vector> buffers_;
 };
 
 } // namespace fnn
@@ -0,0 +1,85 @@
+#pragma once
+
+// Result cache in front of Model::predict() for traffic that repeats exact
+// inputs.
+//
+// Entries are keyed by a 64-bit hash of the input's bytes mixed with the
+// model's version(), and a hit is confirmed against the stored input, so a
+// hash collision costs a miss, never a wrong result. The cache is split
+// into shards picked by the hash, each with its own mutex and LRU list, so
+// concurrent lookups mostly take different locks. When version() changes
+// (weights edited or reloaded, layers added) every entry is dropped on the
+// next call.
+
+#include "config.hpp"
+#include "model.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fnn {
+
+struct CacheStats {
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::uint64_t evictions{0};
+    // Entries currently held.
+    std::size_t size{0};
+};
+
+class PredictCache : public Model {
+public:
+    // Caches up to `capacity` results of `model`, which must outlive the
+    // cache, over min(shards, capacity) shards. Unless `reentrant` says
+    // model.predict() may run on several threads at once, misses call it
+    // one at a time. Throws std::invalid_argument on a zero capacity or
+    // shard count.
+    PredictCache(Model& model, std::size_t capacity, std::size_t shards = 16,
+                 bool reentrant = false);
+
+    [[nodiscard]] std::size_t capacity() const noexcept;
+    [[nodiscard]] std::size_t shard_count() const noexcept;
+
+    // The cached result for `input`, or model.predict(input), stored. Safe
+    // to call from several threads: lookups lock one shard, and misses call
+    // the wrapped model outside the shard locks.
+    [[nodiscard]] Vector predict(const Vector& input) override;
+    // The wrapped model's version().
+    [[nodiscard]] std::uint64_t version() const noexcept override;
+
+    void clear();
+    [[nodiscard]] CacheStats stats() const;
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        Vector input;
+        Vector output;
+    };
+
+    // Most recently used first.
+    struct Shard {
+        mutable std::mutex mutex;
+        std::size_t capacity{0};
+        std::list<Entry> lru;
+        std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+    };
+
+    Model& model_;
+    std::size_t capacity_;
+    std::vector<Shard> shards_;
+    bool reentrant_;
+    // Serializes misses on a model that is not reentrant.
+    std::mutex model_mutex_;
+    std::atomic<std::uint64_t> version_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+};
+
+} // namespace fnn
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace fnn {
+
+class Tensor2D;
+
+// Counter-based random numbers (Philox4x32-10).
+//
+// There is no hidden state: element `i` of the stream identified by
+// (seed, step, layer) is a pure function of those four values. Any thread can
+// therefore produce any slice of a dropout mask or weight initialization, and
+// the result does not depend on how the work was split.
+//
+// Every element consumes 64 random bits, so one Philox block (128 bits)
+// yields two elements. Streams are distinct for steps below 2^48 and hold
+// 2^49 elements.
+class CounterRng {
+public:
+    explicit CounterRng(std::uint64_t seed, std::uint64_t step = 0, std::uint32_t layer = 0);
+
+    [[nodiscard]] std::uint64_t seed() const noexcept;
+    [[nodiscard]] std::uint64_t step() const noexcept;
+    [[nodiscard]] std::uint32_t layer() const noexcept;
+
+    // Same seed and layer, different step (e.g. the next training iteration).
+    [[nodiscard]] CounterRng with_step(std::uint64_t step) const noexcept;
+    // Same seed and step, different layer.
+    [[nodiscard]] CounterRng with_layer(std::uint32_t layer) const noexcept;
+
+    // Raw Philox output for block `index` of this stream.
+    [[nodiscard]] std::array<std::uint32_t, 4> block(std::uint64_t index) const noexcept;
+
+    // Single elements, mainly for tests and scalar code paths.
+    [[nodiscard]] Scalar uniform(std::uint64_t element) const noexcept;
+    [[nodiscard]] Scalar normal(std::uint64_t element) const noexcept;
+
+    // Bulk fills: out[i] receives stream element `first + i`.
+    // Uniform values are in [lo, hi); Bernoulli values are 1.0 with
+    // probability p and 0.0 otherwise.
+    void fill_uniform(std::span<Scalar> out, std::uint64_t first, Scalar lo, Scalar hi) const;
+    void fill_normal(std::span<Scalar> out, std::uint64_t first, Scalar mean,
+                     Scalar stddev) const;
+    void fill_bernoulli(std::span<Scalar> out, std::uint64_t first, Scalar p) const;
+
+private:
+    std::uint64_t seed_{0};
+    std::uint64_t step_{0};
+    std::uint32_t layer_{0};
+};
+
+// Whole-tensor fills, split across the thread pool. Element (r, c) receives
+// stream element r * cols + c, independent of the number of threads.
+void fill_uniform(Tensor2D& out, const CounterRng& rng, Scalar lo, Scalar hi);
+void fill_normal(Tensor2D& out, const CounterRng& rng, Scalar mean, Scalar stddev);
+void fill_bernoulli(Tensor2D& out, const CounterRng& rng, Scalar p);
+
+} // namespace fnn
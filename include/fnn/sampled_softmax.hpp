@@ -0,0 +1,139 @@
+#pragma once
+
+// Sampled softmax and negative sampling for very large output vocabularies.
+//
+// A full output layer costs O(classes) per row for the logits alone.
+// Here each row only scores its true class plus one shared set of
+// candidates drawn per batch from a proposal distribution Q, so the cost
+// scales with the sample count. Sampled logits are corrected by
+// -log(S * Q(c)) (S samples drawn), so their exponentials estimate the
+// softmax denominator over the other classes and the loss tends to the full
+// softmax loss as S grows; a sampled candidate equal to the row's label is
+// dropped from that row (an "accidental hit").
+//
+// The output layer is given as weights (classes x hidden, one row per
+// class, like Dense) and a 1 x classes bias. Gradients come back sparse:
+// only the rows of the classes that were touched.
+
+#include "config.hpp"
+#include "tensor2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace fnn {
+
+class CounterRng;
+
+// Proposal distribution over classes [0, classes()).
+class CandidateSampler {
+public:
+    virtual ~CandidateSampler() = default;
+
+    [[nodiscard]] virtual std::size_t classes() const noexcept = 0;
+    [[nodiscard]] virtual Scalar probability(std::size_t c) const = 0;
+    // out[i] drawn from stream elements first + 2i and first + 2i + 1, with
+    // replacement, so a sample depends only on (rng, first, i).
+    virtual void sample(const CounterRng& rng, std::uint64_t first,
+                        std::span<std::size_t> out) const = 0;
+};
+
+// Zipfian proposal for classes sorted by decreasing frequency:
+// Q(c) = log((c + 2) / (c + 1)) / log(classes + 1), drawn by inverting the
+// CDF in O(1). Throws std::invalid_argument on zero classes.
+class LogUniformSampler : public CandidateSampler {
+public:
+    explicit LogUniformSampler(std::size_t classes);
+
+    [[nodiscard]] std::size_t classes() const noexcept override;
+    [[nodiscard]] Scalar probability(std::size_t c) const override;
+    void sample(const CounterRng& rng, std::uint64_t first,
+                std::span<std::size_t> out) const override;
+
+private:
+    std::size_t classes_;
+    Scalar log_range_;
+};
+
+// Any distribution given by non-negative weights (e.g. unigram counts
+// raised to 0.75), drawn in O(1) from Vose's alias table. Throws
+// std::invalid_argument on no weights, a negative or non-finite weight, or
+// a zero total.
+class AliasSampler : public CandidateSampler {
+public:
+    explicit AliasSampler(std::span<const Scalar> weights);
+
+    [[nodiscard]] std::size_t classes() const noexcept override;
+    [[nodiscard]] Scalar probability(std::size_t c) const override;
+    void sample(const CounterRng& rng, std::uint64_t first,
+                std::span<std::size_t> out) const override;
+
+private:
+    std::vector<Scalar> probability_;
+    // Column i keeps i with probability accept_[i], else yields alias_[i].
+    std::vector<Scalar> accept_;
+    std::vector<std::size_t> alias_;
+};
+
+struct SampledLossResult {
+    // Mean loss over the batch.
+    Scalar loss{0.0};
+    // batch x hidden.
+    Tensor2D d_hidden{0, 0};
+    // Distinct classes touched, ascending, with their gradient rows
+    // (classes.size() x hidden) and bias entries.
+    std::vector<std::size_t> classes;
+    Tensor2D d_weights{0, 0};
+    Vector d_bias;
+};
+
+class SampledSoftmaxLoss {
+public:
+    enum class Mode {
+        // Softmax cross-entropy over {label} + samples, with the log-Q
+        // correction on the samples: an estimate of the full softmax loss.
+        Softmax,
+        // -log sigmoid(label logit) - sum log sigmoid(-sample logit), with
+        // raw logits (word2vec style); not an estimate of the softmax.
+        NegativeSampling,
+    };
+
+    // Keeps a reference to `sampler`, which must outlive the loss. Throws
+    // std::invalid_argument on a zero sample count.
+    SampledSoftmaxLoss(const CandidateSampler& sampler, std::size_t num_sampled,
+                       Mode mode = Mode::Softmax);
+
+    [[nodiscard]] std::size_t num_sampled() const noexcept;
+    [[nodiscard]] Mode mode() const noexcept;
+
+    // Loss and gradients for `hidden` (batch x hidden) with one label per
+    // row, drawing this batch's samples from `rng` (vary its step per
+    // batch). Throws std::invalid_argument on mismatched shapes or a label
+    // outside the sampler's range.
+    [[nodiscard]] SampledLossResult compute(const Tensor2D& hidden,
+                                            std::span<const std::size_t> labels,
+                                            const Tensor2D& weights, const Tensor2D& bias,
+                                            const CounterRng& rng) const;
+
+    // Full-softmax mean cross-entropy over every class, for evaluation and
+    // for checking the estimate; O(classes) per row.
+    [[nodiscard]] static Scalar full_loss(const Tensor2D& hidden,
+                                          std::span<const std::size_t> labels,
+                                          const Tensor2D& weights, const Tensor2D& bias);
+
+private:
+    const CandidateSampler& sampler_;
+    std::size_t num_sampled_;
+    Mode mode_;
+};
+
+// target row classes[i] += scale * rows row i, e.g. to apply a
+// SampledLossResult to a dense gradient, or to the weights as an SGD step
+// with scale = -learning_rate. Throws std::invalid_argument on mismatched
+// shapes or a class past the last target row.
+void scatter_add_rows(std::span<const std::size_t> classes, const Tensor2D& rows,
+                      Scalar scale, Tensor2D& target);
+
+} // namespace fnn
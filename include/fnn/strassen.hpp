@@ -0,0 +1,70 @@
+#pragma once
+
+// Strassen-Winograd matrix multiply for very large products.
+//
+// Each level of recursion splits A, B and C into 2 x 2 blocks and forms the
+// product from 7 half-size products and 15 block additions (Winograd's
+// variant) instead of 8 products, so it does about 12.5% fewer
+// multiply-adds per level. Below the crossover size the blocked gemm() runs
+// as usual. Odd dimensions are handled by peeling the last row / column
+// off into thin gemm() calls.
+//
+// The price is accuracy: the error bound grows by a constant factor per
+// level (the additions mix blocks of different magnitude), so this is an
+// opt-in path for offline scoring with very wide layers, not the default.
+//
+// All temporaries come from one workspace, sized up front by
+// strassen_workspace_size(); no level of the recursion allocates.
+
+#include "gemm.hpp"
+
+#include <cstddef>
+#include <span>
+
+namespace fnn {
+
+class Tensor2D;
+
+struct StrassenConfig {
+    // A level recurses only while M, N and K are all at least this large;
+    // 0 means strassen_crossover().
+    std::size_t crossover{0};
+    // Upper bound on the recursion depth.
+    std::size_t max_depth{4};
+};
+
+// Process-wide default crossover: FNN_STRASSEN_CROSSOVER if set at startup,
+// else 2048 until set_strassen_crossover() or tune_strassen_crossover()
+// changes it. Throws std::invalid_argument on a crossover below 16.
+[[nodiscard]] std::size_t strassen_crossover();
+void set_strassen_crossover(std::size_t crossover);
+
+// Times one level of recursion against gemm() for square sizes n, n/2,
+// n/4, ... down to 256, and sets (and returns) the smallest size from
+// which one level wins at every larger size measured. Returns 0 and keeps
+// the current value when no size wins.
+std::size_t tune_strassen_crossover(std::size_t n);
+
+// Scalars of workspace gemm_strassen() needs for this product. Includes an
+// m x n result buffer unless alpha == 1 and beta == 0.
+[[nodiscard]] std::size_t strassen_workspace_size(std::size_t m, std::size_t n, std::size_t k,
+                                                  Scalar alpha, Scalar beta,
+                                                  const StrassenConfig& config = {});
+
+// C = alpha * A * B + beta * C, as gemm(). Throws std::invalid_argument on
+// mismatched shapes and std::length_error if `workspace` is smaller than
+// strassen_workspace_size().
+void gemm_strassen(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                   const MutableMatrixRef& c, std::span<Scalar> workspace,
+                   const StrassenConfig& config = {});
+
+// As above with a workspace owned by the calling thread, grown when needed
+// and kept for later calls.
+void gemm_strassen(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                   const MutableMatrixRef& c, const StrassenConfig& config = {});
+
+// matmul() through gemm_strassen().
+[[nodiscard]] Tensor2D matmul_strassen(const Tensor2D& a, const Tensor2D& b,
+                                       const StrassenConfig& config = {});
+
+} // namespace fnn
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.hpp"
+#include "util/buffer_pool.hpp"
 
 #include <cstddef>
 #include <vector>
@@ -12,16 +13,23 @@ class Tensor {
     Tensor(Dims dims);
 
     // returns number of elements in the tensor
-    [[nodiscard]] size_t numel();
+    [[nodiscard]] size_t numel() const;
     // returns shape dimensionality
-    [[nodiscard]] Dims shape();
+    [[nodiscard]] Dims shape() const;
+    // Shape without a copy, for kernels.
+    [[nodiscard]] const Dims& dims() const noexcept;
     // Reshape to a new set of dimensions.
     void reshape(Dims dims);
 
+    // Raw access to the contiguous row-major buffer, for kernels.
+    [[nodiscard]] Scalar* data() noexcept;
+    [[nodiscard]] const Scalar* data() const noexcept;
+
   private:
     Dims dims_;
     // Store elements in a single contiguous buffer of length product(dims_).
-    Vector data_;
+    // Allocated from the tensor buffer pool (util/buffer_pool.hpp).
+    Buffer data_;
 };
 
 } // namespace fnn
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.hpp"
+#include "util/buffer_pool.hpp"
 
 #include <cstddef>
 
@@ -12,6 +13,9 @@ namespace fnn {
 // - Put definitions in a corresponding `.cpp` to reduce rebuild impact.
 //   See `src/tensor2D.cpp`.
 
+// Defined in backend.hpp.
+enum class ActivationKind : int;
+
 struct Shape {
     std::size_t rows{};
     std::size_t cols{};
@@ -27,6 +31,17 @@ public:
     void reshape(std::size_t new_rows, std::size_t new_cols);
     // Shape itself
     [[nodiscard]] Shape shape() const noexcept;
+    [[nodiscard]] std::size_t rows() const noexcept;
+    [[nodiscard]] std::size_t cols() const noexcept;
+    // Number of elements (rows * cols).
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    // Element access, row-major.
+    [[nodiscard]] Scalar& operator()(std::size_t row, std::size_t col);
+    [[nodiscard]] Scalar operator()(std::size_t row, std::size_t col) const;
+    // Raw access to the contiguous buffer, for kernels.
+    [[nodiscard]] Scalar* data() noexcept;
+    [[nodiscard]] const Scalar* data() const noexcept;
 
 private:
     std::size_t rows_{0};
@@ -34,7 +49,24 @@ private:
 
     // Store elements in a single contiguous buffer of length rows_*cols_.
     // This is typically more cache-friendly than `vector<vector<...>>`.
-    Vector data_;
+    // Allocated from the tensor buffer pool (util/buffer_pool.hpp).
+    Buffer data_;
 };
 
+// Operations below run on the active kernel Backend (see backend.hpp).
+// Shape mismatches throw std::invalid_argument; broadcasting lives on Tensor.
+
+// Matrix product a * b.
+[[nodiscard]] Tensor2D matmul(const Tensor2D& a, const Tensor2D& b);
+// Element-wise arithmetic on same-shaped matrices.
+[[nodiscard]] Tensor2D add(const Tensor2D& a, const Tensor2D& b);
+[[nodiscard]] Tensor2D sub(const Tensor2D& a, const Tensor2D& b);
+[[nodiscard]] Tensor2D mul(const Tensor2D& a, const Tensor2D& b);
+// Sum of each column as a 1 x cols matrix (e.g. a bias gradient over a batch).
+[[nodiscard]] Tensor2D column_sums(const Tensor2D& m);
+// Sum of each row as a rows x 1 matrix.
+[[nodiscard]] Tensor2D row_sums(const Tensor2D& m);
+// Element-wise activation; `alpha` is the LeakyReLU slope.
+[[nodiscard]] Tensor2D activate(const Tensor2D& m, ActivationKind kind, Scalar alpha = 0.01);
+
 } // namespace fnn
@@ -0,0 +1,208 @@
+#pragma once
+
+// Element-wise operations on N-d Tensors with NumPy-style broadcasting:
+// shapes are aligned on the right, and each dimension must either match or
+// be 1 (a size-1 dimension is repeated along the other operand).
+//
+// The generic entry points (unary/binary/ternary) are templates so the
+// functor inlines into the inner loop; that is why their bodies live in this
+// header. Shape handling is not templated and lives in `src/tensor_ops.cpp`.
+
+#include "config.hpp"
+#include "tensor.hpp"
+#include "util/thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace fnn {
+
+namespace detail {
+
+inline constexpr std::size_t kMaxBroadcastInputs = 3;
+
+// Elements per thread-pool chunk.
+inline constexpr std::size_t kElementwiseGrain = std::size_t{1} << 15;
+
+// Loop nest for one broadcast op, computed once per call.
+//
+// `loop` is the output shape with size-1 dimensions dropped and adjacent
+// dimensions merged wherever every operand is contiguous across them, so a
+// bias add over (batch, features) runs as a single flat loop. The innermost
+// input stride is always 0 (broadcast) or 1 (contiguous).
+struct BroadcastPlan {
+    // Broadcast result shape (uncollapsed).
+    Dims out_shape;
+    // Collapsed loop extents, innermost last; never empty.
+    Dims loop;
+    // Per input, the element stride along each entry of `loop`.
+    std::array<std::vector<std::size_t>, kMaxBroadcastInputs> strides;
+    std::size_t num_inputs{0};
+    // Product of all loop extents but the last, and the last one.
+    std::size_t rows{1};
+    std::size_t row_length{1};
+};
+
+[[nodiscard]] BroadcastPlan make_broadcast_plan(std::initializer_list<const Dims*> inputs);
+
+// Throws if an in-place op would need to grow its destination.
+void check_inplace_shape(const BroadcastPlan& plan, const Dims& dest, const char* what);
+
+// Mode 0: contiguous operand, mode 1: operand broadcast along the row.
+template <int Mode>
+inline Scalar load(const Scalar* p, std::size_t i) {
+    if constexpr (Mode == 0) {
+        return p[i];
+    } else {
+        return p[0];
+    }
+}
+
+template <int... Modes, typename F, std::size_t N, std::size_t... I>
+void row_kernel(Scalar* out, const std::array<const Scalar*, N>& in, std::size_t len, F& f,
+                std::index_sequence<I...>) {
+    for (std::size_t i = 0; i < len; ++i) {
+        out[i] = f(load<Modes>(in[I], i)...);
+    }
+}
+
+// Picks the row kernel specialised for each input's inner stride, so the
+// compiler sees unit-stride or loop-invariant loads and can vectorize.
+template <typename F, std::size_t N, int... Modes>
+void dispatch_row(Scalar* out, const std::array<const Scalar*, N>& in,
+                  const std::array<std::size_t, N>& inner, std::size_t len, F& f) {
+    constexpr std::size_t k = sizeof...(Modes);
+    if constexpr (k == N) {
+        row_kernel<Modes...>(out, in, len, f, std::make_index_sequence<N>{});
+    } else if (inner[k] == 0) {
+        dispatch_row<F, N, Modes..., 1>(out, in, inner, len, f);
+    } else {
+        dispatch_row<F, N, Modes..., 0>(out, in, inner, len, f);
+    }
+}
+
+// Runs `f` over the plan: the innermost loop goes through dispatch_row, the
+// outer loops are flattened into rows and split across the thread pool.
+template <std::size_t N, typename F>
+void run_plan(const BroadcastPlan& plan, Scalar* out, const std::array<const Scalar*, N>& in,
+              F& f) {
+    const auto len = plan.row_length;
+    const auto rows = plan.rows;
+    std::array<std::size_t, N> inner{};
+    for (std::size_t k = 0; k < N; ++k) {
+        inner[k] = plan.strides[k].back();
+    }
+
+    if (rows == 1) {
+        util::parallel_for(0, len, kElementwiseGrain, [&](std::size_t lo, std::size_t hi) {
+            std::array<const Scalar*, N> p{};
+            for (std::size_t k = 0; k < N; ++k) {
+                p[k] = in[k] + lo * inner[k];
+            }
+            dispatch_row<F, N>(out + lo, p, inner, hi - lo, f);
+        });
+        return;
+    }
+
+    const auto outer = plan.loop.size() - 1;
+    const auto grain = std::max<std::size_t>(1, kElementwiseGrain / std::max<std::size_t>(len, 1));
+    util::parallel_for(0, rows, grain, [&](std::size_t lo, std::size_t hi) {
+        // Decompose the first row index once, then step it like an odometer.
+        std::vector<std::size_t> idx(outer);
+        std::array<std::size_t, N> off{};
+        auto r = lo;
+        for (std::size_t d = outer; d-- > 0;) {
+            idx[d] = r % plan.loop[d];
+            r /= plan.loop[d];
+            for (std::size_t k = 0; k < N; ++k) {
+                off[k] += idx[d] * plan.strides[k][d];
+            }
+        }
+
+        std::array<const Scalar*, N> p{};
+        for (auto row = lo; row < hi; ++row) {
+            for (std::size_t k = 0; k < N; ++k) {
+                p[k] = in[k] + off[k];
+            }
+            dispatch_row<F, N>(out + row * len, p, inner, len, f);
+
+            for (std::size_t d = outer; d-- > 0;) {
+                ++idx[d];
+                for (std::size_t k = 0; k < N; ++k) {
+                    off[k] += plan.strides[k][d];
+                }
+                if (idx[d] < plan.loop[d]) {
+                    break;
+                }
+                for (std::size_t k = 0; k < N; ++k) {
+                    off[k] -= plan.strides[k][d] * plan.loop[d];
+                }
+                idx[d] = 0;
+            }
+        }
+    });
+}
+
+} // namespace detail
+
+// out = f(a), element-wise.
+template <typename F>
+[[nodiscard]] Tensor unary(const Tensor& a, F f) {
+    const auto plan = detail::make_broadcast_plan({&a.dims()});
+    Tensor out(plan.out_shape);
+    detail::run_plan<1>(plan, out.data(), {a.data()}, f);
+    return out;
+}
+
+// out = f(a, b), broadcasting a and b against each other.
+template <typename F>
+[[nodiscard]] Tensor binary(const Tensor& a, const Tensor& b, F f) {
+    const auto plan = detail::make_broadcast_plan({&a.dims(), &b.dims()});
+    Tensor out(plan.out_shape);
+    detail::run_plan<2>(plan, out.data(), {a.data(), b.data()}, f);
+    return out;
+}
+
+// out = f(a, b, c), broadcasting all three against each other.
+template <typename F>
+[[nodiscard]] Tensor ternary(const Tensor& a, const Tensor& b, const Tensor& c, F f) {
+    const auto plan = detail::make_broadcast_plan({&a.dims(), &b.dims(), &c.dims()});
+    Tensor out(plan.out_shape);
+    detail::run_plan<3>(plan, out.data(), {a.data(), b.data(), c.data()}, f);
+    return out;
+}
+
+// a = f(a), in place.
+template <typename F>
+void unary_inplace(Tensor& a, F f) {
+    const auto plan = detail::make_broadcast_plan({&a.dims()});
+    detail::run_plan<1>(plan, a.data(), {a.data()}, f);
+}
+
+// a = f(a, b) in place; b is broadcast to a's shape (a never grows).
+template <typename F>
+void binary_inplace(Tensor& a, const Tensor& b, F f) {
+    const auto plan = detail::make_broadcast_plan({&a.dims(), &b.dims()});
+    detail::check_inplace_shape(plan, a.dims(), "binary_inplace: result shape differs from a");
+    detail::run_plan<2>(plan, a.data(), {a.data(), b.data()}, f);
+}
+
+// Common arithmetic, all broadcasting.
+[[nodiscard]] Tensor add(const Tensor& a, const Tensor& b);
+[[nodiscard]] Tensor sub(const Tensor& a, const Tensor& b);
+[[nodiscard]] Tensor mul(const Tensor& a, const Tensor& b);
+[[nodiscard]] Tensor div(const Tensor& a, const Tensor& b);
+[[nodiscard]] Tensor maximum(const Tensor& a, const Tensor& b);
+// a * b + c
+[[nodiscard]] Tensor fma(const Tensor& a, const Tensor& b, const Tensor& c);
+
+// In-place forms, e.g. add_inplace(activations, bias) or
+// mul_inplace(features, per_feature_scale).
+void add_inplace(Tensor& a, const Tensor& b);
+void mul_inplace(Tensor& a, const Tensor& b);
+
+} // namespace fnn
@@ -0,0 +1,47 @@
+#pragma once
+
+// Layout changes that move data: N-d permute, 2-D transpose and the
+// channel-blocked image layout.
+//
+// Both run on a cache-tiled transpose kernel (4x4 in-register transposes
+// with AVX), and dimensions that stay adjacent are merged first, so e.g.
+// (batch, features) -> (features, batch) is one 2-D transpose and a permute
+// that keeps the innermost dimension is a series of contiguous copies.
+
+#include "config.hpp"
+#include "tensor.hpp"
+#include "tensor2D.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace fnn {
+
+// out.shape()[i] == t.shape()[perm[i]].
+[[nodiscard]] Tensor permute(const Tensor& t, const std::vector<std::size_t>& perm);
+
+// Rows become columns.
+[[nodiscard]] Tensor2D transpose(const Tensor2D& m);
+
+// Channels per block of the NCHWc layout: 8 doubles, one cache line and
+// one AVX-512 (two AVX2) registers.
+inline constexpr std::size_t kChannelBlock = 8;
+
+// (N, C, H, W) -> (N, ceil(C / 8), H, W, 8): image planes with each group
+// of 8 channels interleaved per pixel, so kernels can run SIMD lanes over
+// channels. Channels past C in the last block are zero. The 2-D layers
+// (Conv2D, MaxPool2D, AvgPool2D) take and return this layout; convert at
+// the model's edges only. Throws std::invalid_argument unless 4-D.
+[[nodiscard]] Tensor to_nchwc(const Tensor& nchw);
+// Inverse of to_nchwc; `channels` is the C to keep. Throws
+// std::invalid_argument unless 5-D with a last dimension of 8 and enough
+// blocks for `channels`.
+[[nodiscard]] Tensor from_nchwc(const Tensor& blocked, std::size_t channels);
+
+// dst[j * dst_ld + i] = src[i * src_ld + j] for i < rows, j < cols.
+// The building block of the two functions above, exposed for kernels that
+// need to transpose a strided sub-matrix.
+void transpose_strided(const Scalar* src, std::size_t src_ld, Scalar* dst, std::size_t dst_ld,
+                       std::size_t rows, std::size_t cols);
+
+} // namespace fnn
@@ -0,0 +1,25 @@
+#pragma once
+
+// Reductions over arbitrary axes of an N-d Tensor.
+//
+// `axes` lists the dimensions to reduce (any order, no duplicates); an empty
+// list reduces over every dimension. With keepdims the reduced dimensions
+// stay in the result with extent 1, so the result broadcasts against the
+// input (see tensor_ops.hpp).
+
+#include "config.hpp"
+#include "tensor.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace fnn {
+
+using Axes = std::vector<std::size_t>;
+
+[[nodiscard]] Tensor sum(const Tensor& t, const Axes& axes, bool keepdims = false);
+[[nodiscard]] Tensor mean(const Tensor& t, const Axes& axes, bool keepdims = false);
+// Reducing an empty extent gives -infinity.
+[[nodiscard]] Tensor max(const Tensor& t, const Axes& axes, bool keepdims = false);
+
+} // namespace fnn
@@ -0,0 +1,49 @@
+// `fnn::util::BitMask` - one bit per element, packed into 64-bit words.
+//
+// Used where backward only needs a yes/no per activation (dropout keep
+// masks, ReLU signs): 64x smaller than storing a Scalar per element.
+
+#pragma once
+
+#include "fnn/config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fnn::util {
+
+class BitMask {
+public:
+    BitMask() = default;
+    explicit BitMask(std::size_t size);
+
+    // Resize to `size` bits; all bits are cleared.
+    void resize(std::size_t size);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    // Storage footprint in bytes.
+    [[nodiscard]] std::size_t bytes() const noexcept;
+
+    [[nodiscard]] bool test(std::size_t i) const;
+    void set(std::size_t i, bool value);
+
+    // Word-level access for kernels; bit i lives in word i / 64, bit i % 64.
+    [[nodiscard]] std::size_t num_words() const noexcept;
+    [[nodiscard]] std::uint64_t* words() noexcept;
+    [[nodiscard]] const std::uint64_t* words() const noexcept;
+
+private:
+    std::size_t size_{0};
+    std::vector<std::uint64_t> words_;
+};
+
+// mask bit i = (x[i] > 0) for the first mask.size() elements of x.
+// Packs with SIMD compare + movemask where available.
+void pack_positive(const Scalar* x, BitMask& mask);
+
+// data[i] *= (mask bit i ? if_set : if_clear) for the first mask.size()
+// elements of data.
+void scale_by_mask(const BitMask& mask, Scalar if_set, Scalar if_clear, Scalar* data);
+
+} // namespace fnn::util
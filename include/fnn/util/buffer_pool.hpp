@@ -0,0 +1,119 @@
+// `fnn::util` buffer pool - recycled storage for tensor buffers.
+//
+// Training creates and drops many same-sized temporaries, and with many
+// threads the system allocator contends on them. Requests are rounded up to
+// a power-of-two size class (64 B .. 64 MiB; larger ones go to the system
+// directly). Each thread keeps a short free list per class; an overflowing
+// list hands half of its blocks to a global depot (one lock per class), and
+// an empty one refills from the depot before asking the system. Blocks are
+// 64-byte aligned.
+//
+// Tensor and Tensor2D allocate through fnn::Buffer, declared below.
+//
+// The pool is on by default; FNN_BUFFER_POOL=0 at startup routes every
+// request to the system allocator instead.
+//
+// Whatever the pool takes from the system at or above a size threshold
+// (4 MiB by default) is mapped 2 MiB-aligned with mmap and madvise'd for
+// transparent huge pages, so streaming a large weight matrix touches 512x
+// fewer TLB entries. The policy can also try MAP_HUGETLB (reserved huge
+// pages) first. Any failure falls back to the next option and finally to
+// operator new. Set at startup with FNN_HUGE_PAGES=off|advise|hugetlb and
+// FNN_HUGE_PAGE_THRESHOLD=<bytes>, or with set_huge_page_policy(). Only
+// Linux maps huge pages; elsewhere the policy is ignored.
+
+#pragma once
+
+#include "fnn/config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fnn::util {
+
+[[nodiscard]] void* pool_allocate(std::size_t bytes);
+// `bytes` must be the size passed to pool_allocate.
+void pool_deallocate(void* p, std::size_t bytes) noexcept;
+
+enum class HugePages : int {
+    Off,
+    // mmap + madvise(MADV_HUGEPAGE).
+    Advise,
+    // MAP_HUGETLB first, then as Advise.
+    HugeTlb,
+};
+
+struct HugePagePolicy {
+    HugePages mode{HugePages::Advise};
+    // Smallest request mapped with huge pages; raised to 2 MiB if lower.
+    std::size_t threshold{std::size_t{4} << 20};
+};
+
+// Affects later system allocations only; blocks already cached by the pool
+// keep their backing until trim_buffer_pool() drops them.
+void set_huge_page_policy(const HugePagePolicy& policy);
+[[nodiscard]] HugePagePolicy huge_page_policy();
+
+struct BufferPoolStats {
+    std::uint64_t allocations{0};
+    // Served from the calling thread's free list.
+    std::uint64_t thread_hits{0};
+    // Served from the global depot.
+    std::uint64_t depot_hits{0};
+    // Served by the system (pool misses and oversized requests).
+    std::uint64_t system_allocations{0};
+    std::uint64_t deallocations{0};
+    // System allocations that got a huge-page mapping, and those that asked
+    // for one but fell back to operator new.
+    std::uint64_t huge_page_allocations{0};
+    std::uint64_t huge_page_fallbacks{0};
+
+    // Fraction of allocations that did not reach the system allocator.
+    [[nodiscard]] double hit_rate() const noexcept;
+};
+
+// Counters are gathered per thread and published in batches, so the most
+// recent events of other running threads may be missing.
+[[nodiscard]] BufferPoolStats buffer_pool_stats();
+void reset_buffer_pool_stats();
+// Returns the depot's blocks and the calling thread's cached blocks to the
+// system. Other threads keep their lists.
+void trim_buffer_pool();
+
+} // namespace fnn::util
+
+namespace fnn {
+
+// Zero-initialized, contiguous Scalar storage taken from the pool: the
+// element storage of Tensor and Tensor2D. (A std::vector with a pool
+// allocator would do, but libstdc++ then value-initializes element by
+// element instead of with memset, which costs more than the pool saves.)
+class Buffer {
+public:
+    Buffer() noexcept = default;
+    explicit Buffer(std::size_t size);
+    Buffer(const Buffer& other);
+    Buffer(Buffer&& other) noexcept;
+    // Reuses the storage when the sizes match.
+    Buffer& operator=(const Buffer& other);
+    Buffer& operator=(Buffer&& other) noexcept;
+    ~Buffer();
+
+    // Keeps the first min(size(), size) elements; new ones are zero.
+    void resize(std::size_t size);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] Scalar* data() noexcept;
+    [[nodiscard]] const Scalar* data() const noexcept;
+    [[nodiscard]] Scalar* begin() noexcept;
+    [[nodiscard]] Scalar* end() noexcept;
+    [[nodiscard]] const Scalar* begin() const noexcept;
+    [[nodiscard]] const Scalar* end() const noexcept;
+
+private:
+    Scalar* data_{nullptr};
+    std::size_t size_{0};
+};
+
+} // namespace fnn
@@ -1,20 +1,43 @@
+// `fnn::util` linear algebra - BLAS level-1 and level-2 routines.
+//
+// Optimizer updates and single-sample backprop are built from these. All
+// routines take spans (sizes are checked, std::invalid_argument on
+// mismatch), use several independent accumulators so the loops vectorize,
+// and split work across the thread pool once the problem is large enough
+// to pay for it. Reductions combine fixed-size partial results in a fixed
+// order, so results do not depend on the thread count.
+//
+// Level-3 (matrix-matrix) lives in `fnn/gemm.hpp`.
 
 #pragma once
 
 #include "fnn/config.hpp"
+#include "fnn/gemm.hpp"
+
 #include <cstddef>
-#include <vector>
+#include <span>
 
 namespace fnn::util {
 
-[[nodiscard]] std::size_t multiply(std::size_t a, std::size_t b, const char* what);
-[[nodiscard]] int multiply(int a, int b, const char* what);
-// product for size_t, int, double vectors
-[[nodiscard]] std::size_t product(const std::vector<std::size_t> vec, const char* what);
-[[nodiscard]] std::size_t product(const std::vector<int>& vec, const char* what);
-[[nodiscard]] Scalar product(const Vector vec, const char* what);
-// dot and cross product
-[[nodiscard]] Scalar dot_product(const Vector vec1, const Vector vec2, const char* what);
-[[nodiscard]] Vector cross_product(const Vector vec1, const Vector vec2, const char* what);
+// y += alpha * x
+void axpy(Scalar alpha, std::span<const Scalar> x, std::span<Scalar> y);
+// x *= alpha
+void scal(Scalar alpha, std::span<Scalar> x);
+// sum_i x[i] * y[i]
+[[nodiscard]] Scalar dot(std::span<const Scalar> x, std::span<const Scalar> y);
+// Euclidean norm; does not overflow/underflow for extreme magnitudes.
+[[nodiscard]] Scalar nrm2(std::span<const Scalar> x);
+// sum_i |x[i]|
+[[nodiscard]] Scalar asum(std::span<const Scalar> x);
+// Index of the first element with the largest |x[i]|; x must be non-empty.
+[[nodiscard]] std::size_t iamax(std::span<const Scalar> x);
+
+// y = alpha * A * x + beta * y. A is any strided view (pass a transposed
+// view for A^T * x). When beta == 0, y is not read.
+void gemv(Scalar alpha, const MatrixRef& a, std::span<const Scalar> x, Scalar beta,
+          std::span<Scalar> y);
+// Rank-1 update: A += alpha * x * y^T.
+void ger(Scalar alpha, std::span<const Scalar> x, std::span<const Scalar> y,
+         const MutableMatrixRef& a);
 
 } // namespace fnn::util
@@ -3,6 +3,7 @@
 // Goal: keep neural-network logic out of here. This is "plumbing":
 // - safe size computations (overflow-checked)
 // - element-count (numel) helpers for tensor shapes
+// - scalar functions shared by the loss code (softplus, sigmoid)
 //
 // Policy B note:
 // - This repo prefers declaration-only headers.
@@ -26,4 +27,9 @@ namespace fnn::util {
 [[nodiscard]] Scalar dot_product(const Vector vec1, const Vector vec2, const char* what);
 [[nodiscard]] Vector cross_product(const Vector vec1, const Vector vec2, const char* what);
 
+// log(1 + exp(x)) without overflow.
+[[nodiscard]] Scalar softplus(Scalar x);
+// 1 / (1 + exp(-x)).
+[[nodiscard]] Scalar sigmoid(Scalar x);
+
 } // namespace fnn::util
@@ -0,0 +1,54 @@
+// `fnn::util` thread pool - a single process-wide pool of worker threads.
+//
+// Kernels split their work with `parallel_for`; the calling thread always
+// takes part, so nested calls cannot deadlock (an inner loop simply runs on
+// whichever threads are free, in the worst case only the caller).
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fnn::util {
+
+class ThreadPool {
+public:
+    // Process-wide pool. The thread count defaults to the hardware
+    // concurrency, or to `FNN_NUM_THREADS` when that is set.
+    [[nodiscard]] static ThreadPool& instance();
+
+    explicit ThreadPool(std::size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that execute work, including the calling thread.
+    [[nodiscard]] std::size_t num_threads() const noexcept;
+
+    // Split [begin, end) into chunks of at least `grain` indices and call
+    // `fn(chunk_begin, chunk_end)` for each chunk. Blocks until all chunks
+    // are done; the first exception thrown by `fn` is rethrown here.
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                      const std::function<void(std::size_t, std::size_t)>& fn);
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+};
+
+// Shorthand for `ThreadPool::instance().parallel_for(...)`.
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& fn);
+
+} // namespace fnn::util
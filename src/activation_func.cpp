@@ -1,4 +1,46 @@
 #include "fnn/activation_func.hpp"
 
-// Intentionally empty for now.
-// TODO: Add concrete activation implementations (e.g., Sigmoid/ReLU) later.
+#include <cmath>
+#include <stdexcept>
+
+namespace fnn {
+
+bool ActivationFunction::derivative_from_sign() const noexcept { return false; }
+
+bool ActivationFunction::derivative_from_output() const noexcept { return false; }
+
+Scalar ActivationFunction::derivative_at_output(Scalar /*y*/) const {
+    throw std::logic_error("ActivationFunction: derivative is not a function of the output");
+}
+
+Scalar ReLU::forward(Scalar x) const { return x > 0.0 ? x : 0.0; }
+
+Scalar ReLU::derivative(Scalar x) const { return x > 0.0 ? 1.0 : 0.0; }
+
+bool ReLU::derivative_from_sign() const noexcept { return true; }
+
+LeakyReLU::LeakyReLU(Scalar alpha) : alpha_(alpha) {}
+
+Scalar LeakyReLU::forward(Scalar x) const { return x > 0.0 ? x : alpha_ * x; }
+
+Scalar LeakyReLU::derivative(Scalar x) const { return x > 0.0 ? 1.0 : alpha_; }
+
+bool LeakyReLU::derivative_from_sign() const noexcept { return true; }
+
+Scalar Sigmoid::forward(Scalar x) const { return 1.0 / (1.0 + std::exp(-x)); }
+
+Scalar Sigmoid::derivative(Scalar x) const { return derivative_at_output(forward(x)); }
+
+bool Sigmoid::derivative_from_output() const noexcept { return true; }
+
+Scalar Sigmoid::derivative_at_output(Scalar y) const { return y * (1.0 - y); }
+
+Scalar Tanh::forward(Scalar x) const { return std::tanh(x); }
+
+Scalar Tanh::derivative(Scalar x) const { return derivative_at_output(forward(x)); }
+
+bool Tanh::derivative_from_output() const noexcept { return true; }
+
+Scalar Tanh::derivative_at_output(Scalar y) const { return 1.0 - y * y; }
+
+} // namespace fnn
@@ -0,0 +1,217 @@
+#include "fnn/backend.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+
+#include "backends/backends.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<const Backend>> backends;
+    // Replaced backends stay alive: another thread may still be running a
+    // kernel through a pointer it read from `active`.
+    std::vector<std::shared_ptr<const Backend>> retired;
+    std::atomic<const Backend*> active{nullptr};
+
+    Registry() {
+        backends.push_back(backends::make_reference());
+        backends.push_back(backends::make_optimized());
+        if (auto blas = backends::make_blas()) {
+            backends.push_back(std::move(blas));
+        }
+        const Backend* initial = backends[1].get();
+        if (const char* env = std::getenv("FNN_BACKEND")) {
+            for (const auto& b : backends) {
+                if (b->name() == env) {
+                    initial = b.get();
+                }
+            }
+        }
+        active.store(initial);
+    }
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+double best_of_three(const std::function<void()>& run) {
+    double best = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        best = i == 0 ? took.count() : std::min(best, took.count());
+    }
+    return best;
+}
+
+Scalar max_abs_diff(const Tensor2D& a, const Tensor2D& b) {
+    Scalar e = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        e = std::max(e, std::fabs(a.data()[i] - b.data()[i]));
+    }
+    return e;
+}
+
+MatrixRef view(const Tensor2D& m) { return {m.data(), m.rows(), m.cols(), m.cols(), 1}; }
+
+MutableMatrixRef output_view(Tensor2D& m) { return {m.data(), m.rows(), m.cols(), m.cols(), 1}; }
+
+} // namespace
+
+void register_backend(std::shared_ptr<const Backend> backend) {
+    if (!backend) {
+        throw std::invalid_argument("register_backend: backend must not be null");
+    }
+    auto& r = registry();
+    std::lock_guard lock(r.mutex);
+    for (auto& b : r.backends) {
+        if (b->name() == backend->name()) {
+            if (r.active.load() == b.get()) {
+                r.active.store(backend.get());
+            }
+            r.retired.push_back(std::move(b));
+            b = std::move(backend);
+            return;
+        }
+    }
+    r.backends.push_back(std::move(backend));
+}
+
+std::shared_ptr<const Backend> find_backend(std::string_view name) {
+    auto& r = registry();
+    std::lock_guard lock(r.mutex);
+    for (const auto& b : r.backends) {
+        if (b->name() == name) {
+            return b;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> backend_names() {
+    auto& r = registry();
+    std::lock_guard lock(r.mutex);
+    std::vector<std::string> names;
+    for (const auto& b : r.backends) {
+        names.emplace_back(b->name());
+    }
+    return names;
+}
+
+void set_active_backend(std::string_view name) {
+    const auto backend = find_backend(name);
+    if (!backend) {
+        throw std::invalid_argument("set_active_backend: unknown backend");
+    }
+    registry().active.store(backend.get());
+}
+
+const Backend& active_backend() { return *registry().active.load(); }
+
+std::vector<BackendComparison> compare_backends(std::size_t trials, std::uint64_t seed) {
+    const auto reference = find_backend("reference");
+    std::vector<std::shared_ptr<const Backend>> backends;
+    for (const auto& name : backend_names()) {
+        backends.push_back(find_backend(name));
+    }
+
+    std::vector<BackendComparison> results;
+    for (std::size_t t = 0; t < trials; ++t) {
+        // Shapes in [1, 257) from the counter RNG, so runs are reproducible.
+        const CounterRng rng(seed, t, 0);
+        const auto dim = [&](std::uint64_t i) {
+            return 1 + static_cast<std::size_t>(rng.uniform(i) * 256.0);
+        };
+        const auto m = dim(0);
+        const auto n = dim(1);
+        const auto k = dim(2);
+        Tensor2D a(m, k);
+        Tensor2D b(k, n);
+        Tensor2D bt(n, k);
+        Tensor2D x(m, n);
+        Tensor2D y(m, n);
+        fill_uniform(a, rng.with_layer(1), -1.0, 1.0);
+        fill_uniform(b, rng.with_layer(2), -1.0, 1.0);
+        fill_uniform(bt, rng.with_layer(3), -1.0, 1.0);
+        fill_uniform(x, rng.with_layer(4), -4.0, 4.0);
+        fill_uniform(y, rng.with_layer(5), 0.5, 2.0);
+        const auto mnk = std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k);
+        const auto mn = std::to_string(m) + "x" + std::to_string(n);
+
+        struct Case {
+            std::string kernel;
+            std::string shape;
+            std::size_t rows;
+            std::size_t cols;
+            std::function<void(const Backend&, Tensor2D&)> run;
+        };
+        const std::vector<Case> cases = {
+            {"matmul", mnk, m, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.matmul(1.0, view(a), view(b), 0.0, output_view(out));
+             }},
+            {"matmul_bt", mnk, m, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 // B given transposed, as a Dense layer's (out x in) weights are.
+                 be.matmul(1.0, view(a), {bt.data(), k, n, 1, k}, 0.0, output_view(out));
+             }},
+            {"add", mn, m, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.elementwise(BinaryOp::Add, x.data(), y.data(), out.data(), out.size());
+             }},
+            {"div", mn, m, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.elementwise(BinaryOp::Div, x.data(), y.data(), out.data(), out.size());
+             }},
+            {"column_sums", mn, 1, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.reduce_sum(view(x), ReduceAxis::Rows, out.data());
+             }},
+            {"row_sums", mn, m, 1,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.reduce_sum(view(x), ReduceAxis::Cols, out.data());
+             }},
+            {"relu", mn, m, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.activation(ActivationKind::ReLU, 0.0, x.data(), out.data(), out.size());
+             }},
+            {"sigmoid", mn, m, n,
+             [&](const Backend& be, Tensor2D& out) {
+                 be.activation(ActivationKind::Sigmoid, 0.0, x.data(), out.data(), out.size());
+             }},
+        };
+
+        for (const auto& c : cases) {
+            Tensor2D expected(c.rows, c.cols);
+            c.run(*reference, expected);
+            for (const auto& be : backends) {
+                Tensor2D out(c.rows, c.cols);
+                BackendComparison r;
+                r.kernel = c.kernel;
+                r.backend = std::string(be->name());
+                r.shape = c.shape;
+                r.seconds = best_of_three([&] { c.run(*be, out); });
+                r.max_abs_error = max_abs_diff(out, expected);
+                results.push_back(std::move(r));
+            }
+        }
+    }
+    return results;
+}
+
+} // namespace fnn
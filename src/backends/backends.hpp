@@ -0,0 +1,17 @@
+#pragma once
+
+// Private: factories for the built-in backends, used by the registry in
+// src/backend.cpp.
+
+#include "fnn/backend.hpp"
+
+#include <memory>
+
+namespace fnn::backends {
+
+[[nodiscard]] std::shared_ptr<const Backend> make_reference();
+[[nodiscard]] std::shared_ptr<const Backend> make_optimized();
+// nullptr when the library was built without CBLAS.
+[[nodiscard]] std::shared_ptr<const Backend> make_blas();
+
+} // namespace fnn::backends
@@ -0,0 +1,81 @@
+#include "backends.hpp"
+
+#if defined(FNN_HAVE_CBLAS)
+#include <algorithm>
+
+#include <cblas.h>
+#endif
+
+namespace fnn::backends {
+
+#if defined(FNN_HAVE_CBLAS)
+
+namespace {
+
+// How a strided view maps onto a row-major CBLAS operand.
+struct BlasOperand {
+    bool ok{false};
+    CBLAS_TRANSPOSE trans{CblasNoTrans};
+    int ld{0};
+};
+
+BlasOperand as_blas(std::size_t rows, std::size_t cols, std::size_t rs, std::size_t cs) {
+    if (cs == 1 && rs >= std::max<std::size_t>(cols, 1)) {
+        return {true, CblasNoTrans, static_cast<int>(rs)};
+    }
+    if (rs == 1 && cs >= std::max<std::size_t>(rows, 1)) {
+        return {true, CblasTrans, static_cast<int>(cs)};
+    }
+    return {};
+}
+
+// GEMM through the system BLAS; everything else, and GEMMs on views CBLAS
+// cannot express (broadcast strides, non-unit column stride in C), go to
+// the optimized backend.
+class BlasBackend final : public Backend {
+public:
+    [[nodiscard]] std::string_view name() const noexcept override { return "blas"; }
+
+    void matmul(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                const MutableMatrixRef& c) const override {
+        const auto ba = as_blas(a.rows, a.cols, a.row_stride, a.col_stride);
+        const auto bb = as_blas(b.rows, b.cols, b.row_stride, b.col_stride);
+        if (!ba.ok || !bb.ok || c.col_stride != 1 || c.row_stride < c.cols || c.rows == 0 ||
+            c.cols == 0 || a.cols == 0) {
+            fallback_->matmul(alpha, a, b, beta, c);
+            return;
+        }
+        cblas_dgemm(CblasRowMajor, ba.trans, bb.trans, static_cast<int>(c.rows),
+                    static_cast<int>(c.cols), static_cast<int>(a.cols), alpha, a.data, ba.ld,
+                    b.data, bb.ld, beta, c.data, static_cast<int>(c.row_stride));
+    }
+
+    void elementwise(BinaryOp op, const Scalar* a, const Scalar* b, Scalar* out,
+                     std::size_t n) const override {
+        fallback_->elementwise(op, a, b, out, n);
+    }
+
+    void reduce_sum(const MatrixRef& m, ReduceAxis axis, Scalar* out) const override {
+        fallback_->reduce_sum(m, axis, out);
+    }
+
+    void activation(ActivationKind kind, Scalar alpha, const Scalar* in, Scalar* out,
+                    std::size_t n) const override {
+        fallback_->activation(kind, alpha, in, out, n);
+    }
+
+private:
+    std::shared_ptr<const Backend> fallback_ = make_optimized();
+};
+
+} // namespace
+
+std::shared_ptr<const Backend> make_blas() { return std::make_shared<BlasBackend>(); }
+
+#else
+
+std::shared_ptr<const Backend> make_blas() { return nullptr; }
+
+#endif
+
+} // namespace fnn::backends
@@ -0,0 +1,224 @@
+#include "backends.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace fnn::backends {
+
+namespace {
+
+// Elements per thread-pool chunk for streaming kernels.
+constexpr std::size_t kGrain = std::size_t{1} << 15;
+// Output columns owned by one task when summing over rows.
+constexpr std::size_t kColumnBlock = 256;
+
+// Element-wise operations: a scalar form for the tails and, where AVX2 is
+// available, an explicit four-lane form for the body. Without AVX2 the
+// scalar loop is left to the compiler's auto-vectorizer.
+template <BinaryOp Op>
+Scalar apply(Scalar x, Scalar y) {
+    if constexpr (Op == BinaryOp::Add) {
+        return x + y;
+    } else if constexpr (Op == BinaryOp::Sub) {
+        return x - y;
+    } else if constexpr (Op == BinaryOp::Mul) {
+        return x * y;
+    } else {
+        return x / y;
+    }
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+template <BinaryOp Op>
+__m256d apply(__m256d x, __m256d y) {
+    if constexpr (Op == BinaryOp::Add) {
+        return _mm256_add_pd(x, y);
+    } else if constexpr (Op == BinaryOp::Sub) {
+        return _mm256_sub_pd(x, y);
+    } else if constexpr (Op == BinaryOp::Mul) {
+        return _mm256_mul_pd(x, y);
+    } else {
+        return _mm256_div_pd(x, y);
+    }
+}
+#endif
+
+template <BinaryOp Op>
+void binary(const Scalar* a, const Scalar* b, Scalar* out, std::size_t n) {
+    util::parallel_for(0, n, kGrain, [&](std::size_t lo, std::size_t hi) {
+        auto i = lo;
+#if defined(__AVX2__) && defined(__FMA__)
+        for (; i + 4 <= hi; i += 4) {
+            _mm256_storeu_pd(out + i,
+                             apply<Op>(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+#endif
+        for (; i < hi; ++i) {
+            out[i] = apply<Op>(a[i], b[i]);
+        }
+    });
+}
+
+// x for x > 0, else 0 (ReLU) or slope * x (LeakyReLU). NaN takes the else
+// branch, as in the reference backend.
+template <bool Leaky>
+void rectify(const Scalar* in, Scalar* out, std::size_t n, Scalar slope) {
+    util::parallel_for(0, n, kGrain, [&](std::size_t lo, std::size_t hi) {
+        auto i = lo;
+#if defined(__AVX2__) && defined(__FMA__)
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d s = _mm256_set1_pd(slope);
+        for (; i + 4 <= hi; i += 4) {
+            const __m256d x = _mm256_loadu_pd(in + i);
+            const __m256d positive = _mm256_cmp_pd(x, zero, _CMP_GT_OQ);
+            const __m256d other = Leaky ? _mm256_mul_pd(s, x) : zero;
+            _mm256_storeu_pd(out + i, _mm256_blendv_pd(other, x, positive));
+        }
+#endif
+        for (; i < hi; ++i) {
+            out[i] = in[i] > 0.0 ? in[i] : (Leaky ? slope * in[i] : 0.0);
+        }
+    });
+}
+
+// Scalar per-element loop for the transcendental activations.
+template <typename F>
+void stream(const Scalar* in, Scalar* out, std::size_t n, std::size_t grain, F f) {
+    util::parallel_for(0, n, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            out[i] = f(in[i]);
+        }
+    });
+}
+
+Scalar sum_contiguous(const Scalar* p, std::size_t n) {
+    Scalar acc[4] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += p[i];
+        acc[1] += p[i + 1];
+        acc[2] += p[i + 2];
+        acc[3] += p[i + 3];
+    }
+    for (; i < n; ++i) {
+        acc[0] += p[i];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+class OptimizedBackend final : public Backend {
+public:
+    [[nodiscard]] std::string_view name() const noexcept override { return "optimized"; }
+
+    [[nodiscard]] bool prefers_layer_kernels() const noexcept override { return true; }
+
+    void matmul(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                const MutableMatrixRef& c) const override {
+        gemm(alpha, a, b, beta, c);
+    }
+
+    void elementwise(BinaryOp op, const Scalar* a, const Scalar* b, Scalar* out,
+                     std::size_t n) const override {
+        switch (op) {
+        case BinaryOp::Add:
+            binary<BinaryOp::Add>(a, b, out, n);
+            break;
+        case BinaryOp::Sub:
+            binary<BinaryOp::Sub>(a, b, out, n);
+            break;
+        case BinaryOp::Mul:
+            binary<BinaryOp::Mul>(a, b, out, n);
+            break;
+        case BinaryOp::Div:
+            binary<BinaryOp::Div>(a, b, out, n);
+            break;
+        }
+    }
+
+    void reduce_sum(const MatrixRef& m, ReduceAxis axis, Scalar* out) const override {
+        if (axis == ReduceAxis::Cols && m.col_stride == 1) {
+            // One contiguous sum per row.
+            const auto grain = std::max<std::size_t>(1, kGrain / std::max<std::size_t>(m.cols, 1));
+            util::parallel_for(0, m.rows, grain, [&](std::size_t lo, std::size_t hi) {
+                for (auto i = lo; i < hi; ++i) {
+                    out[i] = sum_contiguous(m.data + i * m.row_stride, m.cols);
+                }
+            });
+            return;
+        }
+        if (axis == ReduceAxis::Rows && m.col_stride == 1) {
+            // Accumulate whole rows into a block of output columns.
+            const auto blocks = (m.cols + kColumnBlock - 1) / kColumnBlock;
+            util::parallel_for(0, blocks, 1, [&](std::size_t lo, std::size_t hi) {
+                for (auto blk = lo; blk < hi; ++blk) {
+                    const auto j0 = blk * kColumnBlock;
+                    const auto j1 = std::min(m.cols, j0 + kColumnBlock);
+                    std::fill(out + j0, out + j1, 0.0);
+                    for (std::size_t i = 0; i < m.rows; ++i) {
+                        const Scalar* row = m.data + i * m.row_stride;
+                        for (auto j = j0; j < j1; ++j) {
+                            out[j] += row[j];
+                        }
+                    }
+                }
+            });
+            return;
+        }
+        // Other layouts: the same problem on the transposed view.
+        const MatrixRef t{m.data, m.cols, m.rows, m.col_stride, m.row_stride};
+        if (t.col_stride == 1) {
+            reduce_sum(t, axis == ReduceAxis::Rows ? ReduceAxis::Cols : ReduceAxis::Rows, out);
+            return;
+        }
+        const auto outer = axis == ReduceAxis::Rows ? m.cols : m.rows;
+        const auto inner = axis == ReduceAxis::Rows ? m.rows : m.cols;
+        const auto outer_stride = axis == ReduceAxis::Rows ? m.col_stride : m.row_stride;
+        const auto inner_stride = axis == ReduceAxis::Rows ? m.row_stride : m.col_stride;
+        for (std::size_t o = 0; o < outer; ++o) {
+            Scalar acc = 0.0;
+            for (std::size_t i = 0; i < inner; ++i) {
+                acc += m.data[o * outer_stride + i * inner_stride];
+            }
+            out[o] = acc;
+        }
+    }
+
+    void activation(ActivationKind kind, Scalar alpha, const Scalar* in, Scalar* out,
+                    std::size_t n) const override {
+        // Transcendentals cost far more per element than a load, so they
+        // are split into smaller chunks. They stay scalar libm calls: there
+        // is no vector exp / tanh to call without a math library.
+        constexpr std::size_t kTranscendentalGrain = std::size_t{1} << 12;
+        switch (kind) {
+        case ActivationKind::Identity:
+            if (in != out) {
+                std::copy(in, in + n, out);
+            }
+            break;
+        case ActivationKind::ReLU:
+            rectify<false>(in, out, n, 0.0);
+            break;
+        case ActivationKind::LeakyReLU:
+            rectify<true>(in, out, n, alpha);
+            break;
+        case ActivationKind::Sigmoid:
+            stream(in, out, n, kTranscendentalGrain,
+                   [](Scalar x) { return 1.0 / (1.0 + std::exp(-x)); });
+            break;
+        case ActivationKind::Tanh:
+            stream(in, out, n, kTranscendentalGrain, [](Scalar x) { return std::tanh(x); });
+            break;
+        }
+    }
+};
+
+} // namespace
+
+std::shared_ptr<const Backend> make_optimized() { return std::make_shared<OptimizedBackend>(); }
+
+} // namespace fnn::backends
@@ -0,0 +1,92 @@
+#include "backends.hpp"
+
+#include <cmath>
+
+namespace fnn::backends {
+
+namespace {
+
+// Straightforward loops with no blocking, vectorization or threading: slow,
+// but easy to check by eye, which is what the differential harness needs.
+class ReferenceBackend final : public Backend {
+public:
+    [[nodiscard]] std::string_view name() const noexcept override { return "reference"; }
+
+    void matmul(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                const MutableMatrixRef& c) const override {
+        for (std::size_t i = 0; i < c.rows; ++i) {
+            for (std::size_t j = 0; j < c.cols; ++j) {
+                Scalar acc = 0.0;
+                for (std::size_t p = 0; p < a.cols; ++p) {
+                    acc += a.data[i * a.row_stride + p * a.col_stride] *
+                           b.data[p * b.row_stride + j * b.col_stride];
+                }
+                Scalar& dst = c.data[i * c.row_stride + j * c.col_stride];
+                dst = beta == 0.0 ? alpha * acc : alpha * acc + beta * dst;
+            }
+        }
+    }
+
+    void elementwise(BinaryOp op, const Scalar* a, const Scalar* b, Scalar* out,
+                     std::size_t n) const override {
+        for (std::size_t i = 0; i < n; ++i) {
+            switch (op) {
+            case BinaryOp::Add:
+                out[i] = a[i] + b[i];
+                break;
+            case BinaryOp::Sub:
+                out[i] = a[i] - b[i];
+                break;
+            case BinaryOp::Mul:
+                out[i] = a[i] * b[i];
+                break;
+            case BinaryOp::Div:
+                out[i] = a[i] / b[i];
+                break;
+            }
+        }
+    }
+
+    void reduce_sum(const MatrixRef& m, ReduceAxis axis, Scalar* out) const override {
+        const auto outer = axis == ReduceAxis::Rows ? m.cols : m.rows;
+        const auto inner = axis == ReduceAxis::Rows ? m.rows : m.cols;
+        for (std::size_t o = 0; o < outer; ++o) {
+            Scalar acc = 0.0;
+            for (std::size_t i = 0; i < inner; ++i) {
+                acc += axis == ReduceAxis::Rows ? m.data[i * m.row_stride + o * m.col_stride]
+                                                : m.data[o * m.row_stride + i * m.col_stride];
+            }
+            out[o] = acc;
+        }
+    }
+
+    void activation(ActivationKind kind, Scalar alpha, const Scalar* in, Scalar* out,
+                    std::size_t n) const override {
+        for (std::size_t i = 0; i < n; ++i) {
+            const Scalar x = in[i];
+            switch (kind) {
+            case ActivationKind::Identity:
+                out[i] = x;
+                break;
+            case ActivationKind::ReLU:
+                out[i] = x > 0.0 ? x : 0.0;
+                break;
+            case ActivationKind::LeakyReLU:
+                out[i] = x > 0.0 ? x : alpha * x;
+                break;
+            case ActivationKind::Sigmoid:
+                out[i] = 1.0 / (1.0 + std::exp(-x));
+                break;
+            case ActivationKind::Tanh:
+                out[i] = std::tanh(x);
+                break;
+            }
+        }
+    }
+};
+
+} // namespace
+
+std::shared_ptr<const Backend> make_reference() { return std::make_shared<ReferenceBackend>(); }
+
+} // namespace fnn::backends
@@ -0,0 +1,345 @@
+#include "fnn/einsum.hpp"
+#include "fnn/gemm.hpp"
+#include "fnn/tensor_permute.hpp"
+#include "fnn/tensor_reduce.hpp"
+
+#include <array>
+#include <cctype>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fnn {
+
+namespace {
+
+// Index groups in GEMM terms: C[batch][m][n] = sum_k A[batch][m][k] * B[batch][k][n].
+enum Group { kBatch = 0, kM = 1, kN = 2, kK = 3, kNumGroups = 4 };
+
+struct ParsedSpec {
+    std::string a;
+    std::string b;
+    std::string out;
+    // Indices summed out of a single input before the contraction.
+    std::string a_summed;
+    std::string b_summed;
+    // For each group, the candidate index orders: the order in which the
+    // group's indices appear in each operand that holds them.
+    std::array<std::vector<std::string>, kNumGroups> candidates;
+};
+
+void add_candidate(std::vector<std::string>& list, const std::string& order) {
+    for (const auto& c : list) {
+        if (c == order) {
+            return;
+        }
+    }
+    list.push_back(order);
+}
+
+// Letters of `operand` that belong to `group`, in operand order.
+std::string restrict_to(const std::string& operand, const std::string& group) {
+    std::string out;
+    for (const char c : operand) {
+        if (group.find(c) != std::string::npos) {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+std::string check_operand(std::string_view s, const char* what) {
+    std::string out;
+    for (const char c : s) {
+        if (!std::isalpha(static_cast<unsigned char>(c))) {
+            throw std::invalid_argument(what);
+        }
+        if (out.find(c) != std::string::npos) {
+            throw std::invalid_argument(
+                "einsum: repeated index within one operand is not supported");
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+std::shared_ptr<const ParsedSpec> parse(std::string_view raw) {
+    std::string spec;
+    for (const char c : raw) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            spec.push_back(c);
+        }
+    }
+    const auto arrow = spec.find("->");
+    const auto comma = spec.find(',');
+    if (arrow == std::string::npos || comma == std::string::npos || comma > arrow ||
+        spec.find(',', comma + 1) != std::string::npos) {
+        throw std::invalid_argument("einsum: spec must look like \"ab,bc->ac\"");
+    }
+
+    auto parsed = std::make_shared<ParsedSpec>();
+    const auto view = std::string_view(spec);
+    parsed->a = check_operand(view.substr(0, comma), "einsum: invalid index in first operand");
+    parsed->b = check_operand(view.substr(comma + 1, arrow - comma - 1),
+                              "einsum: invalid index in second operand");
+    parsed->out = check_operand(view.substr(arrow + 2), "einsum: invalid index in output");
+
+    std::array<std::string, kNumGroups> groups;
+    for (const char c : parsed->out) {
+        const bool in_a = parsed->a.find(c) != std::string::npos;
+        const bool in_b = parsed->b.find(c) != std::string::npos;
+        if (!in_a && !in_b) {
+            throw std::invalid_argument("einsum: output index missing from both inputs");
+        }
+        groups[in_a && in_b ? kBatch : (in_a ? kM : kN)].push_back(c);
+    }
+    for (const char c : parsed->a) {
+        if (parsed->out.find(c) != std::string::npos) {
+            continue;
+        }
+        if (parsed->b.find(c) != std::string::npos) {
+            groups[kK].push_back(c);
+        } else {
+            parsed->a_summed.push_back(c);
+        }
+    }
+    for (const char c : parsed->b) {
+        if (parsed->out.find(c) == std::string::npos && parsed->a.find(c) == std::string::npos) {
+            parsed->b_summed.push_back(c);
+        }
+    }
+
+    // Candidate orders come from every operand holding the group.
+    const std::array<const std::string*, 3> holders = {&parsed->a, &parsed->b, &parsed->out};
+    for (int g = 0; g < kNumGroups; ++g) {
+        for (const auto* operand : holders) {
+            const auto order = restrict_to(*operand, groups[g]);
+            if (order.size() == groups[g].size()) {
+                add_candidate(parsed->candidates[g], order);
+            }
+        }
+    }
+    return parsed;
+}
+
+std::shared_ptr<const ParsedSpec> parse_cached(std::string_view spec) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const ParsedSpec>> cache;
+
+    std::string key(spec);
+    {
+        std::lock_guard lock(mutex);
+        if (const auto it = cache.find(key); it != cache.end()) {
+            return it->second;
+        }
+    }
+    auto parsed = parse(spec);
+    std::lock_guard lock(mutex);
+    return cache.emplace(std::move(key), std::move(parsed)).first->second;
+}
+
+// A tensor together with the index letter of each of its dimensions. Inputs
+// are referenced in place; `owned` keeps a packed or reduced copy alive.
+struct Operand {
+    const Tensor* tensor{nullptr};
+    std::string letters;
+    std::shared_ptr<const Tensor> owned;
+
+    [[nodiscard]] std::size_t extent(char c) const {
+        return tensor->dims()[letters.find(c)];
+    }
+
+    [[nodiscard]] std::size_t stride(char c) const {
+        const auto& dims = tensor->dims();
+        std::size_t s = 1;
+        for (auto i = letters.find(c) + 1; i < dims.size(); ++i) {
+            s *= dims[i];
+        }
+        return s;
+    }
+};
+
+Operand own(Tensor t, std::string letters) {
+    auto owned = std::make_shared<const Tensor>(std::move(t));
+    const Tensor* ptr = owned.get();
+    return {ptr, std::move(letters), std::move(owned)};
+}
+
+// A group of indices flattened to one (extent, stride) pair.
+struct Flat {
+    std::size_t extent{1};
+    std::size_t stride{0};
+    bool ok{true};
+};
+
+// Flattens `order` within `op`: possible without a copy iff the indices
+// (ignoring extent-1 ones) are nested contiguously in that order.
+Flat flatten(const Operand& op, const std::string& order) {
+    Flat f;
+    bool first = true;
+    for (const char c : order) {
+        const auto e = op.extent(c);
+        f.extent *= e;
+        if (e == 1) {
+            continue;
+        }
+        const auto s = op.stride(c);
+        if (!first && f.stride != s * e) {
+            f.ok = false;
+        }
+        f.stride = s;
+        first = false;
+    }
+    return f;
+}
+
+// Permutes op so its indices come in `order`, making every group contiguous.
+Operand pack(const Operand& op, const std::string& order) {
+    std::vector<std::size_t> perm;
+    perm.reserve(order.size());
+    for (const char c : order) {
+        perm.push_back(op.letters.find(c));
+    }
+    return own(permute(*op.tensor, perm), order);
+}
+
+Operand sum_out(Operand op, const std::string& summed) {
+    if (summed.empty()) {
+        return op;
+    }
+    Axes axes;
+    std::string kept;
+    for (std::size_t i = 0; i < op.letters.size(); ++i) {
+        if (summed.find(op.letters[i]) != std::string::npos) {
+            axes.push_back(i);
+        } else {
+            kept.push_back(op.letters[i]);
+        }
+    }
+    return own(sum(*op.tensor, axes), kept);
+}
+
+} // namespace
+
+Tensor einsum(std::string_view spec, const Tensor& a, const Tensor& b) {
+    const auto parsed = parse_cached(spec);
+    if (a.dims().size() != parsed->a.size() || b.dims().size() != parsed->b.size()) {
+        throw std::invalid_argument("einsum: operand rank does not match spec");
+    }
+
+    // Every index must have one extent across operands.
+    std::unordered_map<char, std::size_t> extent;
+    const auto record = [&](const std::string& letters, const Dims& dims) {
+        for (std::size_t i = 0; i < letters.size(); ++i) {
+            const auto [it, inserted] = extent.emplace(letters[i], dims[i]);
+            if (!inserted && it->second != dims[i]) {
+                throw std::invalid_argument("einsum: index extents disagree between operands");
+            }
+        }
+    };
+    record(parsed->a, a.dims());
+    record(parsed->b, b.dims());
+
+    Dims out_dims;
+    for (const char c : parsed->out) {
+        out_dims.push_back(extent.at(c));
+    }
+    const Operand lhs = sum_out({&a, parsed->a, nullptr}, parsed->a_summed);
+    const Operand rhs = sum_out({&b, parsed->b, nullptr}, parsed->b_summed);
+    Tensor out(out_dims);
+    const Operand result{&out, parsed->out, nullptr};
+
+    // Pick the index order of each group that minimises the number of
+    // elements that must be copied into a packed layout.
+    const auto& cand = parsed->candidates;
+    const auto count_of = [](const auto& list) { return std::max<std::size_t>(1, list.size()); };
+    const auto pick = [](const auto& list, std::size_t i) {
+        return list.empty() ? std::string() : list[i];
+    };
+    std::array<std::string, kNumGroups> best;
+    auto best_cost = std::numeric_limits<std::size_t>::max();
+    for (std::size_t ib = 0; ib < count_of(cand[kBatch]); ++ib) {
+        for (std::size_t im = 0; im < count_of(cand[kM]); ++im) {
+            for (std::size_t in = 0; in < count_of(cand[kN]); ++in) {
+                for (std::size_t ik = 0; ik < count_of(cand[kK]); ++ik) {
+                    const std::array<std::string, kNumGroups> g = {
+                        pick(cand[kBatch], ib), pick(cand[kM], im), pick(cand[kN], in),
+                        pick(cand[kK], ik)};
+                    std::size_t cost = 0;
+                    if (!flatten(lhs, g[kBatch]).ok || !flatten(lhs, g[kM]).ok ||
+                        !flatten(lhs, g[kK]).ok) {
+                        cost += lhs.tensor->numel();
+                    }
+                    if (!flatten(rhs, g[kBatch]).ok || !flatten(rhs, g[kK]).ok ||
+                        !flatten(rhs, g[kN]).ok) {
+                        cost += rhs.tensor->numel();
+                    }
+                    if (!flatten(result, g[kBatch]).ok || !flatten(result, g[kM]).ok ||
+                        !flatten(result, g[kN]).ok) {
+                        cost += out.numel();
+                    }
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best = g;
+                    }
+                }
+            }
+        }
+    }
+
+    // Fall back to packing only the operands that need it.
+    const auto& [batch, m, n, k] = best;
+    Operand pa = lhs;
+    if (!flatten(pa, batch).ok || !flatten(pa, m).ok || !flatten(pa, k).ok) {
+        pa = pack(pa, batch + m + k);
+    }
+    Operand pb = rhs;
+    if (!flatten(pb, batch).ok || !flatten(pb, k).ok || !flatten(pb, n).ok) {
+        pb = pack(pb, batch + k + n);
+    }
+    const bool direct_out =
+        flatten(result, batch).ok && flatten(result, m).ok && flatten(result, n).ok;
+    Tensor staging({});
+    Operand pc = result;
+    Scalar* c_data = out.data();
+    if (!direct_out) {
+        // Compute in (batch, m, n) order, then permute into the output.
+        pc.letters = batch + m + n;
+        Dims dims;
+        for (const char c : pc.letters) {
+            dims.push_back(extent.at(c));
+        }
+        staging = Tensor(dims);
+        pc.tensor = &staging;
+        c_data = staging.data();
+    }
+
+    const auto ab = flatten(pa, batch);
+    const auto am = flatten(pa, m);
+    const auto ak = flatten(pa, k);
+    const auto bb = flatten(pb, batch);
+    const auto bk = flatten(pb, k);
+    const auto bn = flatten(pb, n);
+    const auto cb = flatten(pc, batch);
+    const auto cm = flatten(pc, m);
+    const auto cn = flatten(pc, n);
+
+    gemm_batched(1.0, {pa.tensor->data(), am.extent, ak.extent, am.stride, ak.stride}, ab.stride,
+                 {pb.tensor->data(), bk.extent, bn.extent, bk.stride, bn.stride}, bb.stride, 0.0,
+                 {c_data, cm.extent, cn.extent, cm.stride, cn.stride}, cb.stride, cb.extent);
+
+    if (direct_out) {
+        return out;
+    }
+    std::vector<std::size_t> perm;
+    for (const char c : parsed->out) {
+        perm.push_back(pc.letters.find(c));
+    }
+    return permute(staging, perm);
+}
+
+} // namespace fnn
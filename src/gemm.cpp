@@ -0,0 +1,491 @@
+#include "fnn/gemm.hpp"
+#include "fnn/gemm_tuner.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace fnn {
+
+namespace {
+
+// Micro-kernel tile: MR rows of A times NR columns of B, held in registers
+// (4x8 doubles = eight AVX registers of accumulators).
+constexpr std::size_t kMR = 4;
+constexpr std::size_t kNR = kGemmPanelWidth;
+
+// Below this many multiply-adds, packing costs more than it saves.
+constexpr std::size_t kSmallGemm = 32 * 32 * 32;
+
+// A block packed as row slivers of kMR: sliver s holds rows s*kMR.., stored
+// k-major so the micro-kernel reads kMR consecutive values per k.
+void pack_a(const MatrixRef& a, std::size_t i0, std::size_t p0, std::size_t mc, std::size_t kc,
+            Scalar* dst) {
+    for (std::size_t ir = 0; ir < mc; ir += kMR) {
+        const auto rows = std::min(kMR, mc - ir);
+        for (std::size_t p = 0; p < kc; ++p) {
+            const Scalar* src = a.data + (i0 + ir) * a.row_stride + (p0 + p) * a.col_stride;
+            std::size_t r = 0;
+            for (; r < rows; ++r) {
+                dst[r] = src[r * a.row_stride];
+            }
+            for (; r < kMR; ++r) {
+                dst[r] = 0.0;
+            }
+            dst += kMR;
+        }
+    }
+}
+
+// B panel packed as column slivers of kNR, k-major.
+void pack_b(const MatrixRef& b, std::size_t p0, std::size_t j0, std::size_t kc, std::size_t nc,
+            Scalar* dst) {
+    for (std::size_t jr = 0; jr < nc; jr += kNR) {
+        const auto cols = std::min(kNR, nc - jr);
+        for (std::size_t p = 0; p < kc; ++p) {
+            const Scalar* src = b.data + (p0 + p) * b.row_stride + (j0 + jr) * b.col_stride;
+            std::size_t c = 0;
+            for (; c < cols; ++c) {
+                dst[c] = src[c * b.col_stride];
+            }
+            for (; c < kNR; ++c) {
+                dst[c] = 0.0;
+            }
+            dst += kNR;
+        }
+    }
+}
+
+// acc = A_sliver * B_sliver over kc.
+void micro_kernel(std::size_t kc, const Scalar* a, const Scalar* b, Scalar acc[kMR][kNR]) {
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256d c00 = _mm256_setzero_pd();
+    __m256d c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd();
+    __m256d c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd();
+    __m256d c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd();
+    __m256d c31 = _mm256_setzero_pd();
+    for (std::size_t p = 0; p < kc; ++p) {
+        const __m256d b0 = _mm256_loadu_pd(b);
+        const __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d ai = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(ai, b0, c00);
+        c01 = _mm256_fmadd_pd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(ai, b0, c10);
+        c11 = _mm256_fmadd_pd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(ai, b0, c20);
+        c21 = _mm256_fmadd_pd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(ai, b0, c30);
+        c31 = _mm256_fmadd_pd(ai, b1, c31);
+        a += kMR;
+        b += kNR;
+    }
+    _mm256_storeu_pd(acc[0], c00);
+    _mm256_storeu_pd(acc[0] + 4, c01);
+    _mm256_storeu_pd(acc[1], c10);
+    _mm256_storeu_pd(acc[1] + 4, c11);
+    _mm256_storeu_pd(acc[2], c20);
+    _mm256_storeu_pd(acc[2] + 4, c21);
+    _mm256_storeu_pd(acc[3], c30);
+    _mm256_storeu_pd(acc[3] + 4, c31);
+#else
+    for (std::size_t i = 0; i < kMR; ++i) {
+        for (std::size_t j = 0; j < kNR; ++j) {
+            acc[i][j] = 0.0;
+        }
+    }
+    for (std::size_t p = 0; p < kc; ++p) {
+        for (std::size_t i = 0; i < kMR; ++i) {
+            const Scalar ai = a[i];
+            for (std::size_t j = 0; j < kNR; ++j) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += kMR;
+        b += kNR;
+    }
+#endif
+}
+
+// C tile = alpha * acc + beta * C tile, clipped to rows x cols.
+void store_tile(const Scalar acc[kMR][kNR], Scalar alpha, Scalar beta, Scalar* c,
+                std::size_t rs, std::size_t cs, std::size_t rows, std::size_t cols) {
+    for (std::size_t i = 0; i < rows; ++i) {
+        Scalar* row = c + i * rs;
+        if (beta == 0.0) {
+            for (std::size_t j = 0; j < cols; ++j) {
+                row[j * cs] = alpha * acc[i][j];
+            }
+        } else {
+            for (std::size_t j = 0; j < cols; ++j) {
+                row[j * cs] = alpha * acc[i][j] + beta * row[j * cs];
+            }
+        }
+    }
+}
+
+// Direct triple loop for small products.
+void gemm_small(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                const MutableMatrixRef& c) {
+    for (std::size_t i = 0; i < c.rows; ++i) {
+        for (std::size_t j = 0; j < c.cols; ++j) {
+            Scalar acc = 0.0;
+            for (std::size_t p = 0; p < a.cols; ++p) {
+                acc += a.data[i * a.row_stride + p * a.col_stride] *
+                       b.data[p * b.row_stride + j * b.col_stride];
+            }
+            Scalar& dst = c.data[i * c.row_stride + j * c.col_stride];
+            dst = beta == 0.0 ? alpha * acc : alpha * acc + beta * dst;
+        }
+    }
+}
+
+void scale_c(Scalar beta, const MutableMatrixRef& c) {
+    for (std::size_t i = 0; i < c.rows; ++i) {
+        for (std::size_t j = 0; j < c.cols; ++j) {
+            Scalar& dst = c.data[i * c.row_stride + j * c.col_stride];
+            dst = beta == 0.0 ? 0.0 : beta * dst;
+        }
+    }
+}
+
+std::size_t round_up(std::size_t x, std::size_t multiple) {
+    return (x + multiple - 1) / multiple * multiple;
+}
+
+// Below this many multiply-adds per thread, waking another thread costs
+// more than it saves.
+constexpr std::size_t kMinThreadWork = std::size_t{1} << 18;
+// gemm_grid() reports 1 x 1 below kSmallGemm for pre-packed products too.
+static_assert(kSmallGemm < kMinThreadWork);
+
+// [lo, hi) of part `index` when `units` units are split into `parts`.
+std::size_t split_begin(std::size_t units, std::size_t parts, std::size_t index) {
+    return units * index / parts;
+}
+
+// One thread's share of a product with a packed kc x nc panel of B (at
+// k offset p0, column offset j0 of C): rows [i_begin, i_end) of C and panel
+// columns [jr_begin, jr_end), where jr_begin is a multiple of kNR. The A
+// blocks are packed into a buffer private to the thread.
+void macro_kernel(Scalar alpha, const MatrixRef& a, Scalar beta, const MutableMatrixRef& c,
+                  std::size_t block_m, std::size_t p0, std::size_t kc, std::size_t j0,
+                  const Scalar* b_panel, std::size_t i_begin, std::size_t i_end,
+                  std::size_t jr_begin, std::size_t jr_end) {
+    // Reused across calls on the same thread.
+    thread_local std::vector<Scalar> a_pack;
+    a_pack.resize(std::max(a_pack.size(), block_m * kc));
+
+    Scalar acc[kMR][kNR];
+    for (auto i0 = i_begin; i0 < i_end; i0 += block_m) {
+        const auto mc = std::min(block_m, i_end - i0);
+        pack_a(a, i0, p0, mc, kc, a_pack.data());
+        for (auto jr = jr_begin; jr < jr_end; jr += kNR) {
+            const Scalar* bp = b_panel + (jr / kNR) * kc * kNR;
+            for (std::size_t ir = 0; ir < mc; ir += kMR) {
+                const Scalar* ap = a_pack.data() + (ir / kMR) * kc * kMR;
+                micro_kernel(kc, ap, bp, acc);
+                store_tile(acc, alpha, beta,
+                           c.data + (i0 + ir) * c.row_stride + (j0 + jr) * c.col_stride,
+                           c.row_stride, c.col_stride, std::min(kMR, mc - ir),
+                           std::min(kNR, jr_end - jr));
+            }
+        }
+    }
+}
+
+// Blocked product over a grid of threads; mc/nc are already multiples of
+// kMR/kNR. `panel_b(p0, j0, kc, nc)` returns the packed kc x nc panel of B
+// at (p0, j0). It runs on the calling thread between parallel phases, so
+// one panel is shared by every thread. Each cell of the grid owns a fixed
+// rectangle of every nc block of C and sums over k in the same order as a
+// single thread would, so the result does not depend on the grid.
+template <typename PanelB>
+void gemm_blocked(Scalar alpha, const MatrixRef& a, Scalar beta, const MutableMatrixRef& c,
+                  std::size_t block_m, std::size_t block_k, std::size_t block_n,
+                  const GemmGrid& grid, PanelB&& panel_b) {
+    const auto m = c.rows;
+    const auto n = c.cols;
+    const auto k = a.cols;
+    const auto cells = grid.rows * grid.cols;
+    const auto row_units = (m + kMR - 1) / kMR;
+
+    for (std::size_t j0 = 0; j0 < n; j0 += block_n) {
+        const auto nc = std::min(block_n, n - j0);
+        const auto col_units = (nc + kNR - 1) / kNR;
+        for (std::size_t p0 = 0; p0 < k; p0 += block_k) {
+            const auto kc = std::min(block_k, k - p0);
+            // Later k-blocks accumulate onto the first one's result.
+            const Scalar beta_block = p0 == 0 ? beta : 1.0;
+            const Scalar* b_panel = panel_b(p0, j0, kc, nc);
+            if (cells == 1) {
+                macro_kernel(alpha, a, beta_block, c, block_m, p0, kc, j0, b_panel, 0, m, 0, nc);
+                continue;
+            }
+            util::parallel_for(0, cells, 1, [&](std::size_t lo, std::size_t hi) {
+                for (auto cell = lo; cell < hi; ++cell) {
+                    const auto r = cell / grid.cols;
+                    const auto q = cell % grid.cols;
+                    const auto i_begin = split_begin(row_units, grid.rows, r) * kMR;
+                    const auto i_end =
+                        std::min(m, split_begin(row_units, grid.rows, r + 1) * kMR);
+                    const auto jr_begin = split_begin(col_units, grid.cols, q) * kNR;
+                    const auto jr_end =
+                        std::min(nc, split_begin(col_units, grid.cols, q + 1) * kNR);
+                    if (i_begin < i_end && jr_begin < jr_end) {
+                        macro_kernel(alpha, a, beta_block, c, block_m, p0, kc, j0, b_panel,
+                                     i_begin, i_end, jr_begin, jr_end);
+                    }
+                }
+            });
+        }
+    }
+}
+
+GemmGrid choose_grid(std::size_t m, std::size_t n, std::size_t k, std::size_t block_n,
+                     std::size_t threads) {
+    const auto pool = util::ThreadPool::instance().num_threads();
+    threads = threads == 0 ? pool : threads;
+    threads = std::min(threads, std::max<std::size_t>(1, m * n * k / kMinThreadWork));
+    // A cell is at least one micro-tile.
+    const auto row_units = (m + kMR - 1) / kMR;
+    const auto col_units = (std::min(n, block_n) + kNR - 1) / kNR;
+    // Use as many threads as possible, then prefer the squarest cells: each
+    // cell reads (rows + cols) x kc of packed data per k block, so a small
+    // perimeter means less traffic per multiply-add.
+    GemmGrid best;
+    std::size_t best_used = 0;
+    double best_perimeter = 0.0;
+    for (std::size_t rows = 1; rows <= std::min(threads, row_units); ++rows) {
+        const auto cols = std::max<std::size_t>(1, std::min(threads / rows, col_units));
+        const auto used = rows * cols;
+        const auto perimeter = static_cast<double>(m) / static_cast<double>(rows) +
+                               static_cast<double>(std::min(n, block_n)) /
+                                   static_cast<double>(cols);
+        if (used > best_used || (used == best_used && perimeter < best_perimeter)) {
+            best = {rows, cols};
+            best_used = used;
+            best_perimeter = perimeter;
+        }
+    }
+    return best;
+}
+
+// Packs one panel with all `threads` threads, split by slivers;
+// pack(p0, j0, kc, nc, dst) packs a column range.
+template <typename Pack>
+void pack_b_shared(std::size_t p0, std::size_t j0, std::size_t kc, std::size_t nc, Scalar* dst,
+                   std::size_t threads, Pack&& pack) {
+    const auto slivers = (nc + kNR - 1) / kNR;
+    if (threads <= 1) {
+        pack(p0, j0, kc, nc, dst);
+        return;
+    }
+    util::parallel_for(0, slivers, (slivers + threads - 1) / threads,
+                       [&](std::size_t lo, std::size_t hi) {
+                           const auto jr = lo * kNR;
+                           pack(p0, j0 + jr, kc, std::min(hi * kNR, nc) - jr,
+                                dst + lo * kc * kNR);
+                       });
+}
+
+// Blocked product with each panel of B written by `pack` into one buffer
+// shared by all threads.
+template <typename Pack>
+void gemm_shared_panels(Scalar alpha, const MatrixRef& a, Scalar beta, const MutableMatrixRef& c,
+                        const GemmConfig& config, Pack&& pack) {
+    const auto block_m = round_up(config.mc, kMR);
+    const auto block_n = round_up(config.nc, kNR);
+    const auto block_k = config.kc;
+    const auto grid = choose_grid(c.rows, c.cols, a.cols, block_n, config.threads);
+    thread_local std::vector<Scalar> b_pack;
+    b_pack.resize(std::max(b_pack.size(), block_k * block_n));
+    gemm_blocked(alpha, a, beta, c, block_m, block_k, block_n, grid,
+                 [&](std::size_t p0, std::size_t j0, std::size_t kc, std::size_t nc) {
+                     pack_b_shared(p0, j0, kc, nc, b_pack.data(), grid.rows * grid.cols, pack);
+                     return static_cast<const Scalar*>(b_pack.data());
+                 });
+}
+
+void gemm_packed(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                 const MutableMatrixRef& c, const GemmConfig& config) {
+    gemm_shared_panels(alpha, a, beta, c, config,
+                       [&](std::size_t p0, std::size_t j0, std::size_t kc, std::size_t nc,
+                           Scalar* dst) { pack_b(b, p0, j0, kc, nc, dst); });
+}
+
+void check_shapes(const MatrixRef& a, const MatrixRef& b, const MutableMatrixRef& c) {
+    if (a.cols != b.rows || a.rows != c.rows || b.cols != c.cols) {
+        throw std::invalid_argument("gemm: shape mismatch");
+    }
+}
+
+void check_config(const GemmConfig& config) {
+    if (config.mc == 0 || config.kc == 0 || config.nc == 0) {
+        throw std::invalid_argument("gemm: block sizes must be positive");
+    }
+}
+
+// Handles the degenerate and small cases; true when nothing is left to do.
+bool gemm_trivial(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                  const MutableMatrixRef& c) {
+    check_shapes(a, b, c);
+    if (c.rows == 0 || c.cols == 0) {
+        return true;
+    }
+    if (a.cols == 0 || alpha == 0.0) {
+        scale_c(beta, c);
+        return true;
+    }
+    if (c.rows * c.cols * a.cols <= kSmallGemm) {
+        gemm_small(alpha, a, b, beta, c);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void gemm(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+          const MutableMatrixRef& c) {
+    if (gemm_trivial(alpha, a, b, beta, c)) {
+        return;
+    }
+    gemm_packed(alpha, a, b, beta, c, gemm_config_for(c.rows, c.cols, a.cols));
+}
+
+void gemm(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+          const MutableMatrixRef& c, const GemmConfig& config) {
+    check_config(config);
+    if (gemm_trivial(alpha, a, b, beta, c)) {
+        return;
+    }
+    gemm_packed(alpha, a, b, beta, c, config);
+}
+
+void gemm_panels(Scalar alpha, const MatrixRef& a, const PanelPacker& pack_b, Scalar beta,
+                 const MutableMatrixRef& c, const GemmConfig& config) {
+    check_config(config);
+    if (a.rows != c.rows) {
+        throw std::invalid_argument("gemm: shape mismatch");
+    }
+    if (c.rows == 0 || c.cols == 0) {
+        return;
+    }
+    if (a.cols == 0 || alpha == 0.0) {
+        scale_c(beta, c);
+        return;
+    }
+    gemm_shared_panels(alpha, a, beta, c, config, pack_b);
+}
+
+GemmGrid gemm_grid(std::size_t m, std::size_t n, std::size_t k, const GemmConfig& config) {
+    check_config(config);
+    if (m == 0 || n == 0 || k == 0 || m * n * k <= kSmallGemm) {
+        return {};
+    }
+    return choose_grid(m, n, k, round_up(config.nc, kNR), config.threads);
+}
+
+PackedMatrix::PackedMatrix(const MatrixRef& b, const GemmConfig& config) { pack(b, config); }
+
+void PackedMatrix::pack(const MatrixRef& b, const GemmConfig& config) {
+    check_config(config);
+    rows_ = b.rows;
+    cols_ = b.cols;
+    config_ = config;
+    config_.mc = round_up(config.mc, kMR);
+    config_.nc = round_up(config.nc, kNR);
+    // Column block j0 starts at k * j0 (j0 is a multiple of kNR) and holds
+    // its k-blocks back to back, each kc x round_up(nc, kNR).
+    data_.resize(rows_ * round_up(cols_, kNR));
+    const auto blocks = (cols_ + config_.nc - 1) / config_.nc;
+    util::parallel_for(0, blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto blk = lo; blk < hi; ++blk) {
+            const auto j0 = blk * config_.nc;
+            const auto nc = std::min(config_.nc, cols_ - j0);
+            for (std::size_t p0 = 0; p0 < rows_; p0 += config_.kc) {
+                const auto kc = std::min(config_.kc, rows_ - p0);
+                pack_b(b, p0, j0, kc, nc, data_.data() + panel_offset(p0, j0));
+            }
+        }
+    });
+}
+
+std::size_t PackedMatrix::rows() const noexcept { return rows_; }
+
+std::size_t PackedMatrix::cols() const noexcept { return cols_; }
+
+bool PackedMatrix::empty() const noexcept { return data_.empty(); }
+
+std::size_t PackedMatrix::bytes() const noexcept { return data_.size() * sizeof(Scalar); }
+
+const GemmConfig& PackedMatrix::config() const noexcept { return config_; }
+
+std::size_t PackedMatrix::panel_offset(std::size_t p0, std::size_t j0) const noexcept {
+    const auto nc = std::min(config_.nc, cols_ - j0);
+    return rows_ * j0 + p0 * round_up(nc, kNR);
+}
+
+const Scalar* PackedMatrix::panel(std::size_t p0, std::size_t j0) const noexcept {
+    return data_.data() + panel_offset(p0, j0);
+}
+
+void gemm(Scalar alpha, const MatrixRef& a, const PackedMatrix& b, Scalar beta,
+          const MutableMatrixRef& c) {
+    if (a.cols != b.rows() || a.rows != c.rows || b.cols() != c.cols) {
+        throw std::invalid_argument("gemm: shape mismatch");
+    }
+    if (c.rows == 0 || c.cols == 0) {
+        return;
+    }
+    if (a.cols == 0 || alpha == 0.0) {
+        scale_c(beta, c);
+        return;
+    }
+    // No small-product shortcut: with B already packed, the micro-kernel
+    // wins even for a single row of A.
+    const auto& config = b.config();
+    gemm_blocked(alpha, a, beta, c, config.mc, config.kc, config.nc,
+                 choose_grid(c.rows, c.cols, a.cols, config.nc, config.threads),
+                 [&](std::size_t p0, std::size_t j0, std::size_t, std::size_t) {
+                     return b.panel(p0, j0);
+                 });
+}
+
+void gemm_batched(Scalar alpha, const MatrixRef& a, std::size_t a_batch_stride,
+                  const MatrixRef& b, std::size_t b_batch_stride, Scalar beta,
+                  const MutableMatrixRef& c, std::size_t c_batch_stride, std::size_t count) {
+    check_shapes(a, b, c);
+    const auto work = std::max<std::size_t>(1, c.rows * c.cols * a.cols);
+    const auto grain = std::max<std::size_t>(1, kSmallGemm / work);
+    // The batches are already spread over the pool; each product runs on
+    // one thread unless there is only one.
+    auto config = gemm_config_for(c.rows, c.cols, a.cols);
+    if (count > 1) {
+        config.threads = 1;
+    }
+    util::parallel_for(0, count, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            MatrixRef ai = a;
+            MatrixRef bi = b;
+            MutableMatrixRef ci = c;
+            ai.data += i * a_batch_stride;
+            bi.data += i * b_batch_stride;
+            ci.data += i * c_batch_stride;
+            gemm(alpha, ai, bi, beta, ci, config);
+        }
+    });
+}
+
+} // namespace fnn
@@ -0,0 +1,273 @@
+#include "fnn/gemm_tuner.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+namespace fnn {
+
+namespace {
+
+using ShapeKey = std::tuple<std::size_t, std::size_t, std::size_t>;
+
+// Stop repeating a candidate once this much time was spent on it.
+constexpr double kTrialBudgetSeconds = 0.05;
+constexpr int kMaxSamples = 5;
+
+bool env_flag(const char* name) {
+    const char* env = std::getenv(name);
+    if (env == nullptr) {
+        return false;
+    }
+    const std::string_view v(env);
+    return v == "1" || v == "on" || v == "true" || v == "yes";
+}
+
+std::filesystem::path default_cache_path() {
+    if (const char* env = std::getenv("FNN_GEMM_TUNING_CACHE")) {
+        return env;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0') {
+        return std::filesystem::path(xdg) / "fnn" / "gemm_tuning.tsv";
+    }
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+        return std::filesystem::path(home) / ".cache" / "fnn" / "gemm_tuning.tsv";
+    }
+    return {};
+}
+
+std::string cpu_model() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            const auto colon = line.find(':');
+            if (colon != std::string::npos) {
+                auto model = line.substr(line.find_first_not_of(" \t", colon + 1));
+                // Tabs separate the cache file's fields.
+                std::replace(model.begin(), model.end(), '\t', ' ');
+                return model;
+            }
+        }
+    }
+    return "unknown cpu";
+}
+
+struct Tuner {
+    std::atomic<bool> enabled{env_flag("FNN_GEMM_AUTOTUNE")};
+    std::mutex mutex;
+    std::filesystem::path path = default_cache_path();
+    bool loaded{false};
+    std::map<ShapeKey, GemmConfig> configs;
+    // Held while benchmarking so concurrent tunings do not skew each other.
+    std::mutex tuning;
+};
+
+Tuner& tuner() {
+    static Tuner t;
+    return t;
+}
+
+// Reads this host's entries; later lines win. Caller holds t.mutex.
+void load_cache(Tuner& t, const std::string& host) {
+    t.loaded = true;
+    if (t.path.empty()) {
+        return;
+    }
+    std::ifstream in(t.path);
+    std::string line;
+    while (std::getline(in, line)) {
+        const auto tab = line.find('\t');
+        if (tab == std::string::npos || line.compare(0, tab, host) != 0 || tab != host.size()) {
+            continue;
+        }
+        std::istringstream fields(line.substr(tab + 1));
+        std::size_t m = 0;
+        std::size_t n = 0;
+        std::size_t k = 0;
+        GemmConfig c;
+        if (fields >> m >> n >> k >> c.mc >> c.kc >> c.nc >> c.threads && c.mc > 0 &&
+            c.kc > 0 && c.nc > 0) {
+            t.configs[{m, n, k}] = c;
+        }
+    }
+}
+
+// Best effort: a read-only or missing cache directory only costs a re-tune
+// on the next run. Caller holds t.mutex.
+void append_cache(const Tuner& t, const std::string& host, const ShapeKey& shape,
+                  const GemmConfig& c) {
+    if (t.path.empty()) {
+        return;
+    }
+    std::error_code ec;
+    if (t.path.has_parent_path()) {
+        std::filesystem::create_directories(t.path.parent_path(), ec);
+    }
+    std::ofstream out(t.path, std::ios::app);
+    out << host << '\t' << std::get<0>(shape) << '\t' << std::get<1>(shape) << '\t'
+        << std::get<2>(shape) << '\t' << c.mc << '\t' << c.kc << '\t' << c.nc << '\t'
+        << c.threads << '\n';
+}
+
+double time_config(const GemmConfig& config, const MatrixRef& a, const MatrixRef& b,
+                   const MutableMatrixRef& c) {
+    double best = 0.0;
+    double spent = 0.0;
+    // The first sample is cold (page faults, packing buffers), so always
+    // take at least two.
+    for (int s = 0; s < kMaxSamples && (s < 2 || spent < kTrialBudgetSeconds); ++s) {
+        const auto start = std::chrono::steady_clock::now();
+        gemm(1.0, a, b, 0.0, c, config);
+        const std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        best = s == 0 ? took.count() : std::min(best, took.count());
+        spent += took.count();
+    }
+    return best;
+}
+
+// Values tried for one parameter, clamped to the problem so that
+// candidates which would behave identically collapse into one.
+std::vector<std::size_t> clamp_candidates(std::initializer_list<std::size_t> values,
+                                          std::size_t limit) {
+    std::vector<std::size_t> out;
+    for (const auto v : values) {
+        const auto c = std::min(v, limit);
+        if (std::find(out.begin(), out.end(), c) == out.end()) {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+void set_gemm_autotune(bool enabled) { tuner().enabled.store(enabled); }
+
+bool gemm_autotune_enabled() { return tuner().enabled.load(); }
+
+std::string gemm_host_key() {
+    static const std::string model = cpu_model();
+    const auto threads = util::ThreadPool::instance().num_threads();
+    return model + " / " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+}
+
+void set_gemm_tuning_cache_path(std::filesystem::path path) {
+    auto& t = tuner();
+    std::lock_guard lock(t.mutex);
+    t.path = std::move(path);
+    t.loaded = false;
+    t.configs.clear();
+}
+
+std::filesystem::path gemm_tuning_cache_path() {
+    auto& t = tuner();
+    std::lock_guard lock(t.mutex);
+    return t.path;
+}
+
+std::vector<GemmTrial> benchmark_gemm_configs(std::size_t m, std::size_t n, std::size_t k) {
+    if (m == 0 || n == 0 || k == 0) {
+        return {GemmTrial{}};
+    }
+    std::vector<Scalar> a(m * k);
+    std::vector<Scalar> b(k * n);
+    std::vector<Scalar> c(m * n);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<Scalar>(i % 7) - 3.0;
+    }
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        b[i] = static_cast<Scalar>(i % 5) - 2.0;
+    }
+    const MatrixRef av{a.data(), m, k, k, 1};
+    const MatrixRef bv{b.data(), k, n, n, 1};
+    const MutableMatrixRef cv{c.data(), m, n, n, 1};
+
+    std::vector<GemmTrial> trials;
+    const auto measure = [&](const GemmConfig& config) {
+        for (const auto& t : trials) {
+            if (t.config == config) {
+                return t.seconds;
+            }
+        }
+        trials.push_back({config, time_config(config, av, bv, cv)});
+        return trials.back().seconds;
+    };
+    // Coordinate descent from the defaults: tune kc, then mc, then nc, then
+    // the thread split, each with the others held at their best so far.
+    // About ten candidates instead of the full cross product.
+    GemmConfig best;
+    const auto pick = [&](std::size_t GemmConfig::*field, const std::vector<std::size_t>& values) {
+        auto best_seconds = measure(best);
+        for (const auto v : values) {
+            auto candidate = best;
+            candidate.*field = v;
+            const auto s = measure(candidate);
+            if (s < best_seconds) {
+                best = candidate;
+                best_seconds = s;
+            }
+        }
+    };
+    best.kc = std::min(best.kc, k);
+    best.mc = std::min(best.mc, m);
+    best.nc = std::min(best.nc, n);
+    pick(&GemmConfig::kc, clamp_candidates({128, 256, 512}, k));
+    pick(&GemmConfig::mc, clamp_candidates({64, 128, 256}, m));
+    pick(&GemmConfig::nc, clamp_candidates({512, 2048, 8192}, n));
+    const auto pool = util::ThreadPool::instance().num_threads();
+    if (pool > 1) {
+        // The default already uses the whole pool; memory-bound shapes can
+        // do better on fewer threads.
+        pick(&GemmConfig::threads, clamp_candidates({1, 2, std::max<std::size_t>(pool / 2, 1)},
+                                                    pool));
+    }
+
+    std::sort(trials.begin(), trials.end(),
+              [](const GemmTrial& x, const GemmTrial& y) { return x.seconds < y.seconds; });
+    return trials;
+}
+
+GemmConfig gemm_config_for(std::size_t m, std::size_t n, std::size_t k) {
+    auto& t = tuner();
+    if (!t.enabled.load(std::memory_order_relaxed)) {
+        return {};
+    }
+    const ShapeKey shape{m, n, k};
+    const auto host = gemm_host_key();
+    {
+        std::lock_guard lock(t.mutex);
+        if (!t.loaded) {
+            load_cache(t, host);
+        }
+        if (const auto it = t.configs.find(shape); it != t.configs.end()) {
+            return it->second;
+        }
+    }
+
+    std::lock_guard tuning(t.tuning);
+    {
+        // Another thread may have tuned this shape while we waited.
+        std::lock_guard lock(t.mutex);
+        if (const auto it = t.configs.find(shape); it != t.configs.end()) {
+            return it->second;
+        }
+    }
+    const auto winner = benchmark_gemm_configs(m, n, k).front().config;
+    std::lock_guard lock(t.mutex);
+    t.configs[shape] = winner;
+    append_cache(t, host, shape, winner);
+    return winner;
+}
+
+} // namespace fnn
@@ -0,0 +1,262 @@
+#include "fnn/hierarchical_softmax.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/math.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace fnn {
+
+namespace {
+
+std::size_t checked_classes(std::size_t hidden, std::span<const Scalar> frequencies) {
+    if (frequencies.size() < 2 || hidden == 0) {
+        throw std::invalid_argument(
+            "HierarchicalSoftmax: need at least two classes and a hidden size");
+    }
+    for (const auto f : frequencies) {
+        if (!(f > 0.0) || !std::isfinite(f)) {
+            throw std::invalid_argument("HierarchicalSoftmax: frequencies must be positive");
+        }
+    }
+    return frequencies.size();
+}
+
+} // namespace
+
+HierarchicalSoftmax::HierarchicalSoftmax(std::size_t hidden, std::span<const Scalar> frequencies)
+    : classes_(checked_classes(hidden, frequencies)), hidden_(hidden),
+      weights_(classes_ - 1, hidden), bias_(1, classes_ - 1), weight_grad_(classes_ - 1, hidden),
+      bias_grad_(1, classes_ - 1) {
+    const auto inner = classes_ - 1;
+
+    // Huffman merge on (frequency, id): leaves are ids [0, C), merged nodes
+    // [C, 2C - 1) in creation order, and equal frequencies resolve to the
+    // lower id, so the tree is a function of the frequencies alone.
+    using Entry = std::pair<Scalar, std::size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+    for (std::size_t c = 0; c < classes_; ++c) {
+        queue.emplace(frequencies[c], c);
+    }
+    std::vector<std::size_t> merged(2 * inner);
+    for (std::size_t m = 0; m < inner; ++m) {
+        const auto left = queue.top();
+        queue.pop();
+        const auto right = queue.top();
+        queue.pop();
+        merged[2 * m] = left.second;
+        merged[2 * m + 1] = right.second;
+        queue.emplace(left.first + right.first, classes_ + m);
+    }
+
+    // Breadth-first renumbering from the root (the last merge), recording
+    // each node's parent and branch for the path walk below.
+    child_.resize(2 * inner);
+    std::vector<std::size_t> parent(classes_ + inner);
+    std::vector<std::uint8_t> branch(classes_ + inner);
+    std::vector<std::size_t> order{classes_ + inner - 1};
+    for (std::size_t n = 0; n < order.size(); ++n) {
+        const auto merge = order[n] - classes_;
+        for (std::uint8_t b = 0; b < 2; ++b) {
+            const auto kid = merged[2 * merge + b];
+            if (kid < classes_) {
+                child_[2 * n + b] = inner + kid;
+                parent[kid] = n;
+                branch[kid] = b;
+            } else {
+                child_[2 * n + b] = order.size();
+                parent[classes_ + order.size()] = n;
+                branch[classes_ + order.size()] = b;
+                order.push_back(kid);
+            }
+        }
+    }
+
+    // Paths, root first. parent[] of inner node k (new id) sits at C + k.
+    path_offset_.assign(classes_ + 1, 0);
+    Scalar total = 0.0;
+    Scalar weighted = 0.0;
+    for (std::size_t c = 0; c < classes_; ++c) {
+        const auto start = path_node_.size();
+        std::size_t at = c;
+        for (;;) {
+            path_node_.push_back(parent[at]);
+            path_bit_.push_back(branch[at]);
+            if (parent[at] == 0) {
+                break;
+            }
+            at = classes_ + parent[at];
+        }
+        std::reverse(path_node_.begin() + static_cast<std::ptrdiff_t>(start), path_node_.end());
+        std::reverse(path_bit_.begin() + static_cast<std::ptrdiff_t>(start), path_bit_.end());
+        path_offset_[c + 1] = path_node_.size();
+        total += frequencies[c];
+        weighted += frequencies[c] * static_cast<Scalar>(path_node_.size() - start);
+    }
+    mean_depth_ = weighted / total;
+}
+
+HierarchicalSoftmax::HierarchicalSoftmax(std::size_t hidden, std::span<const Scalar> frequencies,
+                                         const CounterRng& rng)
+    : HierarchicalSoftmax(hidden, frequencies) {
+    const Scalar limit = 1.0 / std::sqrt(static_cast<Scalar>(hidden));
+    fill_uniform(weights_, rng, -limit, limit);
+}
+
+std::size_t HierarchicalSoftmax::classes() const noexcept { return classes_; }
+
+std::size_t HierarchicalSoftmax::hidden() const noexcept { return hidden_; }
+
+std::size_t HierarchicalSoftmax::inner_nodes() const noexcept { return classes_ - 1; }
+
+std::size_t HierarchicalSoftmax::depth(std::size_t c) const {
+    if (c >= classes_) {
+        throw std::out_of_range("HierarchicalSoftmax::depth: unknown class");
+    }
+    return path_offset_[c + 1] - path_offset_[c];
+}
+
+std::size_t HierarchicalSoftmax::max_depth() const noexcept {
+    std::size_t deepest = 0;
+    for (std::size_t c = 0; c < classes_; ++c) {
+        deepest = std::max(deepest, path_offset_[c + 1] - path_offset_[c]);
+    }
+    return deepest;
+}
+
+Scalar HierarchicalSoftmax::mean_depth() const noexcept { return mean_depth_; }
+
+Tensor2D& HierarchicalSoftmax::weights() noexcept { return weights_; }
+
+const Tensor2D& HierarchicalSoftmax::weights() const noexcept { return weights_; }
+
+Tensor2D& HierarchicalSoftmax::bias() noexcept { return bias_; }
+
+const Tensor2D& HierarchicalSoftmax::bias() const noexcept { return bias_; }
+
+Scalar HierarchicalSoftmax::log_probability(const Vector& h, std::size_t c) const {
+    if (h.size() != hidden_) {
+        throw std::invalid_argument("HierarchicalSoftmax::log_probability: size mismatch");
+    }
+    if (c >= classes_) {
+        throw std::out_of_range("HierarchicalSoftmax::log_probability: unknown class");
+    }
+    Scalar log_p = 0.0;
+    for (auto p = path_offset_[c]; p < path_offset_[c + 1]; ++p) {
+        const auto n = path_node_[p];
+        const Scalar z = util::dot({weights_.data() + n * hidden_, hidden_}, h) + bias_.data()[n];
+        // log sigmoid(z) for the right branch, log sigmoid(-z) for the left.
+        log_p -= util::softplus(path_bit_[p] ? -z : z);
+    }
+    return log_p;
+}
+
+Scalar HierarchicalSoftmax::loss_backward(const Tensor2D& hidden,
+                                          std::span<const std::size_t> labels,
+                                          Tensor2D& d_hidden) {
+    const auto batch = hidden.rows();
+    if (hidden.cols() != hidden_ || labels.size() != batch) {
+        throw std::invalid_argument("HierarchicalSoftmax::loss_backward: shape mismatch");
+    }
+    // Row r's path steps land at [first[r], first[r + 1]) of `grad`.
+    std::vector<std::size_t> first(batch + 1, 0);
+    for (std::size_t r = 0; r < batch; ++r) {
+        if (labels[r] >= classes_) {
+            throw std::invalid_argument("HierarchicalSoftmax::loss_backward: unknown label");
+        }
+        first[r + 1] = first[r] + depth(labels[r]);
+    }
+    std::vector<Scalar> grad(first[batch]);
+    std::vector<Scalar> row_loss(batch);
+    d_hidden = Tensor2D(batch, hidden_);
+    const Scalar inv_batch = 1.0 / static_cast<Scalar>(batch);
+
+    // Rows are independent up to the node gradients, which are shared and
+    // summed afterwards in row order.
+    util::parallel_for(0, batch, 16, [&](std::size_t lo, std::size_t hi) {
+        for (auto r = lo; r < hi; ++r) {
+            const Scalar* h = hidden.data() + r * hidden_;
+            Scalar* dh = d_hidden.data() + r * hidden_;
+            const auto c = labels[r];
+            Scalar loss = 0.0;
+            for (auto p = path_offset_[c]; p < path_offset_[c + 1]; ++p) {
+                const auto n = path_node_[p];
+                const Scalar* w = weights_.data() + n * hidden_;
+                const Scalar z = util::dot({w, hidden_}, {h, hidden_}) + bias_.data()[n];
+                const Scalar bit = path_bit_[p];
+                loss += util::softplus(bit != 0.0 ? -z : z);
+                const Scalar g = (util::sigmoid(z) - bit) * inv_batch;
+                grad[first[r] + p - path_offset_[c]] = g;
+                for (std::size_t i = 0; i < hidden_; ++i) {
+                    dh[i] += g * w[i];
+                }
+            }
+            row_loss[r] = loss;
+        }
+    });
+
+    Scalar total = 0.0;
+    for (std::size_t r = 0; r < batch; ++r) {
+        total += row_loss[r];
+        const Scalar* h = hidden.data() + r * hidden_;
+        const auto c = labels[r];
+        for (auto p = path_offset_[c]; p < path_offset_[c + 1]; ++p) {
+            const auto n = path_node_[p];
+            const Scalar g = grad[first[r] + p - path_offset_[c]];
+            Scalar* dw = weight_grad_.data() + n * hidden_;
+            for (std::size_t i = 0; i < hidden_; ++i) {
+                dw[i] += g * h[i];
+            }
+            bias_grad_.data()[n] += g;
+        }
+    }
+    return total * inv_batch;
+}
+
+const Tensor2D& HierarchicalSoftmax::weight_grad() const noexcept { return weight_grad_; }
+
+const Tensor2D& HierarchicalSoftmax::bias_grad() const noexcept { return bias_grad_; }
+
+void HierarchicalSoftmax::zero_grad() {
+    weight_grad_.zero_fill();
+    bias_grad_.zero_fill();
+}
+
+std::size_t HierarchicalSoftmax::descend(const Scalar* h) const {
+    const auto inner = inner_nodes();
+    std::size_t n = 0;
+    while (n < inner) {
+        const Scalar z =
+            util::dot({weights_.data() + n * hidden_, hidden_}, {h, hidden_}) + bias_.data()[n];
+        n = child_[2 * n + (z > 0.0 ? 1 : 0)];
+    }
+    return n - inner;
+}
+
+std::size_t HierarchicalSoftmax::predict(const Vector& h) const {
+    if (h.size() != hidden_) {
+        throw std::invalid_argument("HierarchicalSoftmax::predict: size mismatch");
+    }
+    return descend(h.data());
+}
+
+std::vector<std::size_t> HierarchicalSoftmax::predict_batch(const Tensor2D& hidden) const {
+    if (hidden.cols() != hidden_) {
+        throw std::invalid_argument("HierarchicalSoftmax::predict_batch: size mismatch");
+    }
+    std::vector<std::size_t> out(hidden.rows());
+    util::parallel_for(0, hidden.rows(), 64, [&](std::size_t lo, std::size_t hi) {
+        for (auto r = lo; r < hi; ++r) {
+            out[r] = descend(hidden.data() + r * hidden_);
+        }
+    });
+    return out;
+}
+
+} // namespace fnn
@@ -1,4 +1,13 @@
 #include "fnn/layer.hpp"
 
-// Intentionally empty for now.
-// TODO: Add concrete layers (e.g., Dense) later.
+namespace fnn {
+
+void Layer::forward_into(const Vector& input, Vector& out) { out = forward(input); }
+
+void Layer::set_training(bool /*training*/) noexcept {}
+
+ActivationMemory Layer::activation_memory() const { return {}; }
+
+std::uint64_t Layer::version() const noexcept { return 0; }
+
+} // namespace fnn
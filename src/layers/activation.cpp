@@ -0,0 +1,135 @@
+#include "fnn/layers/activation.hpp"
+#include "fnn/tensor2D.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// Elements per thread-pool chunk.
+constexpr std::size_t kGrain = 4096;
+
+} // namespace
+
+Activation::Activation(std::unique_ptr<ActivationFunction> fn, SaveMode mode)
+    : fn_(std::move(fn)), mode_(mode) {
+    if (!fn_) {
+        throw std::invalid_argument("Activation: function must not be null");
+    }
+}
+
+const ActivationFunction& Activation::function() const noexcept { return *fn_; }
+
+Activation::SaveMode Activation::save_mode() const noexcept { return mode_; }
+
+Vector Activation::forward(const Vector& input) {
+    Vector out = input;
+    apply_forward(out.data(), out.size());
+    return out;
+}
+
+Vector Activation::backward(const Vector& d_output) {
+    Vector out = d_output;
+    apply_backward(out.data(), out.size());
+    return out;
+}
+
+void Activation::forward_inplace(Tensor2D& batch) { apply_forward(batch.data(), batch.size()); }
+
+void Activation::backward_inplace(Tensor2D& d_batch) const {
+    apply_backward(d_batch.data(), d_batch.size());
+}
+
+ActivationMemory Activation::activation_memory() const {
+    const auto full = saved_size_ * sizeof(Scalar);
+    switch (saved_) {
+    case Saved::Nothing:
+        return {};
+    case Saved::Input:
+        return {input_.size() * sizeof(Scalar), full};
+    case Saved::SignMask:
+        return {sign_.bytes(), full};
+    case Saved::OutputF32:
+    case Saved::InputF32:
+        return {reduced_.size() * sizeof(float), full};
+    }
+    return {};
+}
+
+void Activation::apply_forward(Scalar* data, std::size_t n) {
+    const ActivationFunction& f = *fn_;
+    saved_size_ = n;
+
+    // Inputs are needed after `data` is overwritten, so capture them first.
+    if (mode_ == SaveMode::Full) {
+        saved_ = Saved::Input;
+        input_.assign(data, data + n);
+        reduced_ = {};
+        sign_.resize(0);
+    } else if (f.derivative_from_sign()) {
+        saved_ = Saved::SignMask;
+        sign_.resize(n);
+        util::pack_positive(data, sign_);
+        input_ = {};
+        reduced_ = {};
+    } else {
+        saved_ = f.derivative_from_output() ? Saved::OutputF32 : Saved::InputF32;
+        reduced_.resize(n);
+        input_ = {};
+        sign_.resize(0);
+    }
+
+    const bool keep_input_f32 = saved_ == Saved::InputF32;
+    const bool keep_output_f32 = saved_ == Saved::OutputF32;
+    float* reduced = reduced_.data();
+    util::parallel_for(0, n, kGrain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            if (keep_input_f32) {
+                reduced[i] = static_cast<float>(data[i]);
+            }
+            data[i] = f.forward(data[i]);
+            if (keep_output_f32) {
+                reduced[i] = static_cast<float>(data[i]);
+            }
+        }
+    });
+}
+
+void Activation::apply_backward(Scalar* data, std::size_t n) const {
+    if (saved_ == Saved::Nothing) {
+        throw std::logic_error("Activation::backward: no forward pass to differentiate");
+    }
+    if (n != saved_size_) {
+        throw std::invalid_argument("Activation::backward: gradient size does not match forward");
+    }
+
+    const ActivationFunction& f = *fn_;
+    if (saved_ == Saved::SignMask) {
+        util::scale_by_mask(sign_, f.derivative(1.0), f.derivative(-1.0), data);
+        return;
+    }
+
+    const Saved saved = saved_;
+    const Scalar* input = input_.data();
+    const float* reduced = reduced_.data();
+    util::parallel_for(0, n, kGrain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            switch (saved) {
+            case Saved::Input:
+                data[i] *= f.derivative(input[i]);
+                break;
+            case Saved::OutputF32:
+                data[i] *= f.derivative_at_output(reduced[i]);
+                break;
+            default:
+                data[i] *= f.derivative(reduced[i]);
+                break;
+            }
+        }
+    });
+}
+
+} // namespace fnn
@@ -0,0 +1,426 @@
+#include "fnn/layers/conv1d.hpp"
+#include "fnn/gemm.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace fnn {
+
+namespace {
+
+// Auto runs the direct forward while in_channels * kernel_size is at most
+// this: a shallower product spends more time packing than multiplying
+// (fnn_bench conv1d).
+constexpr std::size_t kDirectMaxDepth = 4;
+
+constexpr std::size_t kW = kGemmPanelWidth;
+
+struct Geometry {
+    std::size_t batch;
+    std::size_t in_channels;
+    std::size_t length;
+    std::size_t out_channels;
+    std::size_t kernel;
+    std::size_t stride;
+    std::size_t padding;
+    std::size_t out_length;
+
+    [[nodiscard]] std::size_t depth() const { return in_channels * kernel; }
+};
+
+// Output positions t whose tap k reads inside the input: [lo, hi).
+void valid_range(const Geometry& g, std::size_t k, std::size_t& lo, std::size_t& hi) {
+    if (g.length + g.padding <= k) {
+        lo = hi = 0;
+        return;
+    }
+    lo = k >= g.padding ? 0 : (g.padding - k + g.stride - 1) / g.stride;
+    hi = std::min(g.out_length, (g.length - 1 + g.padding - k) / g.stride + 1);
+    lo = std::min(lo, hi);
+}
+
+// Panel of col(X) for one sample: row p = c * kernel + k, column t holds
+// x[c, t * stride + k - padding].
+void pack_im2col(const Geometry& g, const Scalar* x, std::size_t p0, std::size_t j0,
+                 std::size_t kc, std::size_t nc, Scalar* dst) {
+    for (std::size_t jr = 0; jr < nc; jr += kW) {
+        const auto cols = std::min(kW, nc - jr);
+        for (std::size_t p = 0; p < kc; ++p) {
+            const auto c = (p0 + p) / g.kernel;
+            const auto k = (p0 + p) % g.kernel;
+            const Scalar* xc = x + c * g.length;
+            // Padded position of the sliver's first column.
+            const auto first = (j0 + jr) * g.stride + k;
+            std::size_t i = 0;
+            if (g.stride == 1 && first >= g.padding && first - g.padding + cols <= g.length) {
+                std::copy_n(xc + (first - g.padding), cols, dst);
+                i = cols;
+            }
+            for (; i < cols; ++i) {
+                const auto pos = first + i * g.stride;
+                dst[i] = pos >= g.padding && pos - g.padding < g.length ? xc[pos - g.padding]
+                                                                         : 0.0;
+            }
+            std::fill(dst + cols, dst + kW, 0.0);
+            dst += kW;
+        }
+    }
+}
+
+// Panel of col(X)^T for one sample: row t, column q = c * kernel + k.
+void pack_im2col_t(const Geometry& g, const Scalar* x, std::size_t p0, std::size_t j0,
+                   std::size_t kc, std::size_t nc, Scalar* dst) {
+    for (std::size_t jr = 0; jr < nc; jr += kW) {
+        const auto cols = std::min(kW, nc - jr);
+        std::size_t channel_offset[kW];
+        std::size_t tap[kW];
+        for (std::size_t i = 0; i < cols; ++i) {
+            channel_offset[i] = (j0 + jr + i) / g.kernel * g.length;
+            tap[i] = (j0 + jr + i) % g.kernel;
+        }
+        for (std::size_t p = 0; p < kc; ++p) {
+            const auto base = (p0 + p) * g.stride;
+            for (std::size_t i = 0; i < cols; ++i) {
+                const auto pos = base + tap[i];
+                dst[i] = pos >= g.padding && pos - g.padding < g.length
+                             ? x[channel_offset[i] + pos - g.padding]
+                             : 0.0;
+            }
+            std::fill(dst + cols, dst + kW, 0.0);
+            dst += kW;
+        }
+    }
+}
+
+// Products of one sample run on one thread when the batch alone fills the
+// pool, and may use the whole pool otherwise.
+GemmConfig per_sample_config(std::size_t batch) {
+    GemmConfig config;
+    config.threads = batch >= util::ThreadPool::instance().num_threads() ? 1 : 0;
+    return config;
+}
+
+void forward_gemm(const Geometry& g, const Tensor2D& w, const Tensor2D& bias, const Scalar* x,
+                  Scalar* y) {
+    const auto config = per_sample_config(g.batch);
+    const MatrixRef a{w.data(), g.out_channels, g.depth(), g.depth(), 1};
+    util::parallel_for(0, g.batch, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto b = lo; b < hi; ++b) {
+            const Scalar* xb = x + b * g.in_channels * g.length;
+            Scalar* yb = y + b * g.out_channels * g.out_length;
+            for (std::size_t o = 0; o < g.out_channels; ++o) {
+                std::fill_n(yb + o * g.out_length, g.out_length, bias.data()[o]);
+            }
+            gemm_panels(
+                1.0, a,
+                [&](std::size_t p0, std::size_t j0, std::size_t kc, std::size_t nc, Scalar* dst) {
+                    pack_im2col(g, xb, p0, j0, kc, nc, dst);
+                },
+                1.0, {yb, g.out_channels, g.out_length, g.out_length, 1}, config);
+        }
+    });
+}
+
+void forward_direct(const Geometry& g, const Tensor2D& w, const Tensor2D& bias, const Scalar* x,
+                    Scalar* y) {
+    util::parallel_for(0, g.batch * g.out_channels, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto row = lo; row < hi; ++row) {
+            const auto b = row / g.out_channels;
+            const auto o = row % g.out_channels;
+            Scalar* yr = y + row * g.out_length;
+            std::fill_n(yr, g.out_length, bias.data()[o]);
+            const Scalar* wr = w.data() + o * g.depth();
+            for (std::size_t c = 0; c < g.in_channels; ++c) {
+                const Scalar* xc = x + (b * g.in_channels + c) * g.length;
+                for (std::size_t k = 0; k < g.kernel; ++k) {
+                    const Scalar wk = wr[c * g.kernel + k];
+                    std::size_t t_lo = 0;
+                    std::size_t t_hi = 0;
+                    valid_range(g, k, t_lo, t_hi);
+                    // In range for t in [t_lo, t_hi), so the unsigned
+                    // arithmetic cannot wrap.
+                    if (g.stride == 1) {
+                        // Unit stride vectorizes.
+                        const Scalar* xs = xc + (t_lo + k - g.padding);
+                        for (auto t = t_lo; t < t_hi; ++t) {
+                            yr[t] += wk * xs[t - t_lo];
+                        }
+                    } else {
+                        for (auto t = t_lo; t < t_hi; ++t) {
+                            yr[t] += wk * xc[t * g.stride + k - g.padding];
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+void bias_backward(const Geometry& g, const Scalar* dy, Scalar* db) {
+    util::parallel_for(0, g.out_channels, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto o = lo; o < hi; ++o) {
+            Scalar sum = 0.0;
+            for (std::size_t b = 0; b < g.batch; ++b) {
+                const Scalar* r = dy + (b * g.out_channels + o) * g.out_length;
+                for (std::size_t t = 0; t < g.out_length; ++t) {
+                    sum += r[t];
+                }
+            }
+            db[o] += sum;
+        }
+    });
+}
+
+void backward_gemm(const Geometry& g, const Tensor2D& w, const Scalar* x, const Scalar* dy,
+                   Scalar* dw, Scalar* dx) {
+    // dW += dY_b * col(X_b)^T, one sample after another so the sum has a
+    // fixed order; each product is threaded.
+    for (std::size_t b = 0; b < g.batch; ++b) {
+        const Scalar* xb = x + b * g.in_channels * g.length;
+        gemm_panels(
+            1.0, {dy + b * g.out_channels * g.out_length, g.out_channels, g.out_length,
+                  g.out_length, 1},
+            [&](std::size_t p0, std::size_t j0, std::size_t kc, std::size_t nc, Scalar* dst) {
+                pack_im2col_t(g, xb, p0, j0, kc, nc, dst);
+            },
+            1.0, {dw, g.out_channels, g.depth(), g.depth(), 1});
+    }
+
+    // dX_b = col2im(W^T * dY_b). Samples are independent.
+    const auto config = per_sample_config(g.batch);
+    const MatrixRef wt{w.data(), g.depth(), g.out_channels, 1, g.depth()};
+    util::parallel_for(0, g.batch, 1, [&](std::size_t lo, std::size_t hi) {
+        std::vector<Scalar> dcol(g.depth() * g.out_length);
+        for (auto b = lo; b < hi; ++b) {
+            gemm(1.0, wt,
+                 {dy + b * g.out_channels * g.out_length, g.out_channels, g.out_length,
+                  g.out_length, 1},
+                 0.0, {dcol.data(), g.depth(), g.out_length, g.out_length, 1}, config);
+            Scalar* dxb = dx + b * g.in_channels * g.length;
+            for (std::size_t c = 0; c < g.in_channels; ++c) {
+                for (std::size_t k = 0; k < g.kernel; ++k) {
+                    std::size_t t_lo = 0;
+                    std::size_t t_hi = 0;
+                    valid_range(g, k, t_lo, t_hi);
+                    const Scalar* src = dcol.data() + (c * g.kernel + k) * g.out_length;
+                    Scalar* dxc = dxb + c * g.length;
+                    for (auto t = t_lo; t < t_hi; ++t) {
+                        dxc[t * g.stride + k - g.padding] += src[t];
+                    }
+                }
+            }
+        }
+    });
+}
+
+void backward_direct(const Geometry& g, const Tensor2D& w, const Scalar* x, const Scalar* dy,
+                     Scalar* dw, Scalar* dx) {
+    // Each output channel owns its row of dW.
+    util::parallel_for(0, g.out_channels, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto o = lo; o < hi; ++o) {
+            Scalar* dwr = dw + o * g.depth();
+            for (std::size_t c = 0; c < g.in_channels; ++c) {
+                for (std::size_t k = 0; k < g.kernel; ++k) {
+                    std::size_t t_lo = 0;
+                    std::size_t t_hi = 0;
+                    valid_range(g, k, t_lo, t_hi);
+                    Scalar sum = 0.0;
+                    for (std::size_t b = 0; b < g.batch; ++b) {
+                        const Scalar* dyr = dy + (b * g.out_channels + o) * g.out_length;
+                        const Scalar* xc = x + (b * g.in_channels + c) * g.length;
+                        for (auto t = t_lo; t < t_hi; ++t) {
+                            sum += dyr[t] * xc[t * g.stride + k - g.padding];
+                        }
+                    }
+                    dwr[c * g.kernel + k] += sum;
+                }
+            }
+        }
+    });
+    // Each sample owns its dX.
+    util::parallel_for(0, g.batch, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto b = lo; b < hi; ++b) {
+            for (std::size_t o = 0; o < g.out_channels; ++o) {
+                const Scalar* dyr = dy + (b * g.out_channels + o) * g.out_length;
+                const Scalar* wr = w.data() + o * g.depth();
+                for (std::size_t c = 0; c < g.in_channels; ++c) {
+                    for (std::size_t k = 0; k < g.kernel; ++k) {
+                        const Scalar wk = wr[c * g.kernel + k];
+                        std::size_t t_lo = 0;
+                        std::size_t t_hi = 0;
+                        valid_range(g, k, t_lo, t_hi);
+                        Scalar* dxc = dx + (b * g.in_channels + c) * g.length;
+                        for (auto t = t_lo; t < t_hi; ++t) {
+                            dxc[t * g.stride + k - g.padding] += wk * dyr[t];
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+Conv1D::Conv1D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_size,
+               std::size_t stride, std::size_t padding)
+    : in_channels_(in_channels), kernel_size_(kernel_size), stride_(stride), padding_(padding),
+      weights_(out_channels, in_channels * kernel_size), bias_(1, out_channels),
+      weight_grad_(out_channels, in_channels * kernel_size), bias_grad_(1, out_channels) {
+    if (in_channels == 0 || out_channels == 0 || kernel_size == 0 || stride == 0) {
+        throw std::invalid_argument(
+            "Conv1D: channels, kernel size and stride must be positive");
+    }
+}
+
+Conv1D::Conv1D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_size,
+               const CounterRng& rng, std::size_t stride, std::size_t padding)
+    : Conv1D(in_channels, out_channels, kernel_size, stride, padding) {
+    const auto fan = static_cast<Scalar>((in_channels + out_channels) * kernel_size);
+    const Scalar limit = std::sqrt(6.0 / fan);
+    fill_uniform(weights_, rng, -limit, limit);
+}
+
+std::size_t Conv1D::in_channels() const noexcept { return in_channels_; }
+
+std::size_t Conv1D::out_channels() const noexcept { return weights_.rows(); }
+
+std::size_t Conv1D::kernel_size() const noexcept { return kernel_size_; }
+
+std::size_t Conv1D::stride() const noexcept { return stride_; }
+
+std::size_t Conv1D::padding() const noexcept { return padding_; }
+
+std::size_t Conv1D::output_length(std::size_t length) const {
+    const auto padded = length + 2 * padding_;
+    if (padded < kernel_size_) {
+        throw std::invalid_argument("Conv1D: input shorter than the kernel");
+    }
+    return (padded - kernel_size_) / stride_ + 1;
+}
+
+void Conv1D::set_algorithm(Algorithm algorithm) noexcept { algorithm_ = algorithm; }
+
+Conv1D::Algorithm Conv1D::algorithm() const noexcept { return algorithm_; }
+
+Conv1D::Algorithm Conv1D::forward_algorithm() const noexcept {
+    if (algorithm_ != Algorithm::Auto) {
+        return algorithm_;
+    }
+    return in_channels_ * kernel_size_ <= kDirectMaxDepth ? Algorithm::Direct : Algorithm::Gemm;
+}
+
+Conv1D::Algorithm Conv1D::backward_algorithm() const noexcept {
+    return algorithm_ == Algorithm::Direct ? Algorithm::Direct : Algorithm::Gemm;
+}
+
+void Conv1D::set_training(bool training) noexcept {
+    training_ = training;
+    if (!training) {
+        saved_ = false;
+    }
+}
+
+bool Conv1D::training() const noexcept { return training_; }
+
+const Tensor2D& Conv1D::weights() const noexcept { return weights_; }
+
+const Tensor2D& Conv1D::bias() const noexcept { return bias_; }
+
+Tensor2D& Conv1D::mutable_weights() noexcept {
+    ++version_;
+    return weights_;
+}
+
+Tensor2D& Conv1D::mutable_bias() noexcept {
+    ++version_;
+    return bias_;
+}
+
+std::uint64_t Conv1D::version() const noexcept { return version_; }
+
+Vector Conv1D::forward(const Vector& input) {
+    if (input.size() % in_channels_ != 0) {
+        throw std::invalid_argument("Conv1D::forward: input size is not a multiple of channels");
+    }
+    Tensor x({1, in_channels_, input.size() / in_channels_});
+    std::copy(input.begin(), input.end(), x.data());
+    const auto y = forward_batch(x);
+    return Vector(y.data(), y.data() + y.numel());
+}
+
+Vector Conv1D::backward(const Vector& d_output) {
+    const auto& dims = input_.dims();
+    Tensor dy({1, out_channels(), output_length(dims[2])});
+    if (d_output.size() != dy.numel()) {
+        throw std::invalid_argument("Conv1D::backward: gradient size mismatch");
+    }
+    std::copy(d_output.begin(), d_output.end(), dy.data());
+    const auto dx = backward_batch(dy);
+    return Vector(dx.data(), dx.data() + dx.numel());
+}
+
+Tensor Conv1D::forward_batch(const Tensor& input) {
+    const auto& dims = input.dims();
+    if (dims.size() != 3 || dims[1] != in_channels_) {
+        throw std::invalid_argument("Conv1D::forward_batch: expected (batch, in_channels, length)");
+    }
+    const Geometry g{dims[0], in_channels_, dims[2], out_channels(), kernel_size_,
+                     stride_, padding_,     output_length(dims[2])};
+    Tensor out({g.batch, g.out_channels, g.out_length});
+    if (forward_algorithm() == Algorithm::Direct) {
+        forward_direct(g, weights_, bias_, input.data(), out.data());
+    } else {
+        forward_gemm(g, weights_, bias_, input.data(), out.data());
+    }
+    if (training_) {
+        input_ = input;
+        saved_ = true;
+    }
+    return out;
+}
+
+Tensor Conv1D::backward_batch(const Tensor& d_output) {
+    if (!saved_) {
+        throw std::logic_error("Conv1D::backward_batch: no training forward to differentiate");
+    }
+    const auto& dims = input_.dims();
+    const Geometry g{dims[0], in_channels_, dims[2], out_channels(), kernel_size_,
+                     stride_, padding_,     output_length(dims[2])};
+    if (d_output.dims() != Dims{g.batch, g.out_channels, g.out_length}) {
+        throw std::invalid_argument("Conv1D::backward_batch: gradient shape mismatch");
+    }
+    Tensor d_input({g.batch, g.in_channels, g.length});
+    bias_backward(g, d_output.data(), bias_grad_.data());
+    if (backward_algorithm() == Algorithm::Direct) {
+        backward_direct(g, weights_, input_.data(), d_output.data(), weight_grad_.data(),
+                        d_input.data());
+    } else {
+        backward_gemm(g, weights_, input_.data(), d_output.data(), weight_grad_.data(),
+                      d_input.data());
+    }
+    return d_input;
+}
+
+const Tensor2D& Conv1D::weight_grad() const noexcept { return weight_grad_; }
+
+const Tensor2D& Conv1D::bias_grad() const noexcept { return bias_grad_; }
+
+void Conv1D::zero_grad() {
+    weight_grad_.zero_fill();
+    bias_grad_.zero_fill();
+}
+
+ActivationMemory Conv1D::activation_memory() const {
+    if (!saved_) {
+        return {};
+    }
+    const auto bytes = input_.numel() * sizeof(Scalar);
+    return {bytes, bytes};
+}
+
+} // namespace fnn
@@ -0,0 +1,644 @@
+#include "fnn/layers/conv2d.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor_permute.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace fnn {
+
+namespace {
+
+constexpr std::size_t kC = kChannelBlock;
+// Output pixels per register tile: 4 x 8 accumulators.
+constexpr std::size_t kTileW = 4;
+
+struct Geometry {
+    std::size_t batch;
+    std::size_t in_blocks;
+    std::size_t height;
+    std::size_t width;
+    std::size_t out_blocks;
+    std::size_t kernel_h;
+    std::size_t kernel_w;
+    std::size_t stride;
+    std::size_t padding;
+    std::size_t out_h;
+    std::size_t out_w;
+
+    // Offsets in elements of pixel (y, x) of block b of image n.
+    [[nodiscard]] std::size_t in_at(std::size_t n, std::size_t b, std::size_t y,
+                                    std::size_t x) const {
+        return (((n * in_blocks + b) * height + y) * width + x) * kC;
+    }
+    [[nodiscard]] std::size_t out_at(std::size_t n, std::size_t b, std::size_t y,
+                                     std::size_t x) const {
+        return (((n * out_blocks + b) * out_h + y) * out_w + x) * kC;
+    }
+    // Offset of the 8 x 8 weight block (ob, ib, ky, kx).
+    [[nodiscard]] std::size_t weight_at(std::size_t ob, std::size_t ib, std::size_t ky,
+                                        std::size_t kx) const {
+        return (((ob * in_blocks + ib) * kernel_h + ky) * kernel_w + kx) * kC * kC;
+    }
+    // Input coordinate read by output coordinate `o` at tap `k`, or false in
+    // the padding.
+    [[nodiscard]] bool input_coord(std::size_t o, std::size_t k, std::size_t size,
+                                   std::size_t& i) const {
+        const auto padded = o * stride + k;
+        if (padded < padding || padded - padding >= size) {
+            return false;
+        }
+        i = padded - padding;
+        return true;
+    }
+};
+
+std::size_t blocks_of(std::size_t channels) { return (channels + kC - 1) / kC; }
+
+// Index in the blocked weights (ob, ib, ky, kx, ci, co) of (o, i, tap), where
+// tap = ky * KW + kx and `in_blocks` is the second blocked dimension.
+std::size_t blocked_index(std::size_t in_blocks, std::size_t taps, std::size_t o, std::size_t i,
+                          std::size_t tap) {
+    return (((o / kC) * in_blocks + i / kC) * taps + tap) * kC * kC + (i % kC) * kC + o % kC;
+}
+
+void unblock_weights(const Tensor& blocked, std::size_t out, std::size_t in, Tensor& oihw) {
+    const auto& d = blocked.dims();
+    const auto taps = d[2] * d[3];
+    for (std::size_t o = 0; o < out; ++o) {
+        for (std::size_t i = 0; i < in; ++i) {
+            for (std::size_t t = 0; t < taps; ++t) {
+                oihw.data()[(o * in + i) * taps + t] =
+                    blocked.data()[blocked_index(d[1], taps, o, i, t)];
+            }
+        }
+    }
+}
+
+// Output columns [begin, end) whose taps all land inside the input row, so
+// their loops need no bounds checks. Empty when every column touches padding.
+void interior_columns(const Geometry& g, std::size_t& begin, std::size_t& end) {
+    begin = std::min((g.padding + g.stride - 1) / g.stride, g.out_w);
+    end = begin;
+    if (g.width + g.padding >= g.kernel_w) {
+        end = std::clamp((g.width + g.padding - g.kernel_w) / g.stride + 1, begin, g.out_w);
+    }
+}
+
+// out[i] = bias + sum over (ib, ky, kx) of x[i] * W for kTileW interior
+// output pixels from column `ox` of row (n, ob, oy), input pixel i being
+// `stride` pixels after pixel i - 1. The tile stays in registers throughout.
+void forward_tile(const Geometry& g, const Scalar* x, const Scalar* w, const Scalar* bias,
+                  Scalar* out, std::size_t n, std::size_t ob, std::size_t oy, std::size_t ox) {
+    static_assert(kTileW == 4 && kC == 8, "tile kernels assume 4 pixels x 8 channels");
+    const auto step = g.stride * kC;
+    const Scalar* b = bias + ob * kC;
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256d c00 = _mm256_loadu_pd(b);
+    __m256d c01 = _mm256_loadu_pd(b + 4);
+    __m256d c10 = c00;
+    __m256d c11 = c01;
+    __m256d c20 = c00;
+    __m256d c21 = c01;
+    __m256d c30 = c00;
+    __m256d c31 = c01;
+#else
+    Scalar acc[kTileW][kC];
+    for (std::size_t i = 0; i < kTileW; ++i) {
+        std::copy_n(b, kC, acc[i]);
+    }
+#endif
+    for (std::size_t ib = 0; ib < g.in_blocks; ++ib) {
+        for (std::size_t ky = 0; ky < g.kernel_h; ++ky) {
+            std::size_t iy = 0;
+            if (!g.input_coord(oy, ky, g.height, iy)) {
+                continue;
+            }
+            const Scalar* row = x + g.in_at(n, ib, iy, ox * g.stride - g.padding);
+            for (std::size_t kx = 0; kx < g.kernel_w; ++kx) {
+                const Scalar* xp = row + kx * kC;
+                const Scalar* wp = w + g.weight_at(ob, ib, ky, kx);
+                for (std::size_t ci = 0; ci < kC; ++ci, wp += kC) {
+#if defined(__AVX2__) && defined(__FMA__)
+                    const __m256d w0 = _mm256_loadu_pd(wp);
+                    const __m256d w1 = _mm256_loadu_pd(wp + 4);
+                    __m256d xi = _mm256_broadcast_sd(xp + ci);
+                    c00 = _mm256_fmadd_pd(xi, w0, c00);
+                    c01 = _mm256_fmadd_pd(xi, w1, c01);
+                    xi = _mm256_broadcast_sd(xp + step + ci);
+                    c10 = _mm256_fmadd_pd(xi, w0, c10);
+                    c11 = _mm256_fmadd_pd(xi, w1, c11);
+                    xi = _mm256_broadcast_sd(xp + 2 * step + ci);
+                    c20 = _mm256_fmadd_pd(xi, w0, c20);
+                    c21 = _mm256_fmadd_pd(xi, w1, c21);
+                    xi = _mm256_broadcast_sd(xp + 3 * step + ci);
+                    c30 = _mm256_fmadd_pd(xi, w0, c30);
+                    c31 = _mm256_fmadd_pd(xi, w1, c31);
+#else
+                    for (std::size_t i = 0; i < kTileW; ++i) {
+                        const Scalar xv = xp[i * step + ci];
+                        for (std::size_t co = 0; co < kC; ++co) {
+                            acc[i][co] += xv * wp[co];
+                        }
+                    }
+#endif
+                }
+            }
+        }
+    }
+    Scalar* o = out + g.out_at(n, ob, oy, ox);
+#if defined(__AVX2__) && defined(__FMA__)
+    _mm256_storeu_pd(o, c00);
+    _mm256_storeu_pd(o + 4, c01);
+    _mm256_storeu_pd(o + 8, c10);
+    _mm256_storeu_pd(o + 12, c11);
+    _mm256_storeu_pd(o + 16, c20);
+    _mm256_storeu_pd(o + 20, c21);
+    _mm256_storeu_pd(o + 24, c30);
+    _mm256_storeu_pd(o + 28, c31);
+#else
+    for (std::size_t i = 0; i < kTileW; ++i) {
+        std::copy_n(acc[i], kC, o + i * kC);
+    }
+#endif
+}
+
+// d[i * d_step + c] += sum_k v[i * kC + k] * m[k * kC + c] for kTileW pixels:
+// one 8 x 8 block applied to a tile, accumulating in place.
+void tile_block_add(const Scalar* v, const Scalar* m, Scalar* d, std::size_t d_step) {
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256d c00 = _mm256_loadu_pd(d);
+    __m256d c01 = _mm256_loadu_pd(d + 4);
+    __m256d c10 = _mm256_loadu_pd(d + d_step);
+    __m256d c11 = _mm256_loadu_pd(d + d_step + 4);
+    __m256d c20 = _mm256_loadu_pd(d + 2 * d_step);
+    __m256d c21 = _mm256_loadu_pd(d + 2 * d_step + 4);
+    __m256d c30 = _mm256_loadu_pd(d + 3 * d_step);
+    __m256d c31 = _mm256_loadu_pd(d + 3 * d_step + 4);
+    for (std::size_t k = 0; k < kC; ++k, m += kC) {
+        const __m256d m0 = _mm256_loadu_pd(m);
+        const __m256d m1 = _mm256_loadu_pd(m + 4);
+        __m256d vi = _mm256_broadcast_sd(v + k);
+        c00 = _mm256_fmadd_pd(vi, m0, c00);
+        c01 = _mm256_fmadd_pd(vi, m1, c01);
+        vi = _mm256_broadcast_sd(v + kC + k);
+        c10 = _mm256_fmadd_pd(vi, m0, c10);
+        c11 = _mm256_fmadd_pd(vi, m1, c11);
+        vi = _mm256_broadcast_sd(v + 2 * kC + k);
+        c20 = _mm256_fmadd_pd(vi, m0, c20);
+        c21 = _mm256_fmadd_pd(vi, m1, c21);
+        vi = _mm256_broadcast_sd(v + 3 * kC + k);
+        c30 = _mm256_fmadd_pd(vi, m0, c30);
+        c31 = _mm256_fmadd_pd(vi, m1, c31);
+    }
+    _mm256_storeu_pd(d, c00);
+    _mm256_storeu_pd(d + 4, c01);
+    _mm256_storeu_pd(d + d_step, c10);
+    _mm256_storeu_pd(d + d_step + 4, c11);
+    _mm256_storeu_pd(d + 2 * d_step, c20);
+    _mm256_storeu_pd(d + 2 * d_step + 4, c21);
+    _mm256_storeu_pd(d + 3 * d_step, c30);
+    _mm256_storeu_pd(d + 3 * d_step + 4, c31);
+#else
+    // Pixel pairs, so each row of m is loaded once per pair.
+    for (std::size_t i = 0; i < kTileW; i += 2) {
+        Scalar acc[2][kC];
+        std::copy_n(d + i * d_step, kC, acc[0]);
+        std::copy_n(d + (i + 1) * d_step, kC, acc[1]);
+        for (std::size_t k = 0; k < kC; ++k) {
+            const Scalar v0 = v[i * kC + k];
+            const Scalar v1 = v[(i + 1) * kC + k];
+            for (std::size_t c = 0; c < kC; ++c) {
+                acc[0][c] += v0 * m[k * kC + c];
+                acc[1][c] += v1 * m[k * kC + c];
+            }
+        }
+        std::copy_n(acc[0], kC, d + i * d_step);
+        std::copy_n(acc[1], kC, d + (i + 1) * d_step);
+    }
+#endif
+}
+
+// d[c] += sum_k v[k] * m[k * kC + c]: one pixel through one 8 x 8 block.
+void pixel_block_add(const Scalar* v, const Scalar* m, Scalar* d) {
+    for (std::size_t k = 0; k < kC; ++k) {
+        for (std::size_t c = 0; c < kC; ++c) {
+            d[c] += v[k] * m[k * kC + c];
+        }
+    }
+}
+
+// dw[ci][co] += sum_p x[p * x_step + ci] * dy[p * kC + co] over `count`
+// pixels: the outer products for one weight block, in registers.
+void weight_block_add(const Scalar* x, std::size_t x_step, const Scalar* dy, std::size_t count,
+                      Scalar* dw) {
+#if defined(__AVX2__) && defined(__FMA__)
+    // Input channels four at a time: 4 x 8 accumulators per half.
+    for (std::size_t half = 0; half < kC; half += 4) {
+        Scalar* d = dw + half * kC;
+        __m256d c00 = _mm256_loadu_pd(d);
+        __m256d c01 = _mm256_loadu_pd(d + 4);
+        __m256d c10 = _mm256_loadu_pd(d + 8);
+        __m256d c11 = _mm256_loadu_pd(d + 12);
+        __m256d c20 = _mm256_loadu_pd(d + 16);
+        __m256d c21 = _mm256_loadu_pd(d + 20);
+        __m256d c30 = _mm256_loadu_pd(d + 24);
+        __m256d c31 = _mm256_loadu_pd(d + 28);
+        const Scalar* xp = x + half;
+        const Scalar* dp = dy;
+        for (std::size_t p = 0; p < count; ++p, xp += x_step, dp += kC) {
+            const __m256d d0 = _mm256_loadu_pd(dp);
+            const __m256d d1 = _mm256_loadu_pd(dp + 4);
+            __m256d xi = _mm256_broadcast_sd(xp);
+            c00 = _mm256_fmadd_pd(xi, d0, c00);
+            c01 = _mm256_fmadd_pd(xi, d1, c01);
+            xi = _mm256_broadcast_sd(xp + 1);
+            c10 = _mm256_fmadd_pd(xi, d0, c10);
+            c11 = _mm256_fmadd_pd(xi, d1, c11);
+            xi = _mm256_broadcast_sd(xp + 2);
+            c20 = _mm256_fmadd_pd(xi, d0, c20);
+            c21 = _mm256_fmadd_pd(xi, d1, c21);
+            xi = _mm256_broadcast_sd(xp + 3);
+            c30 = _mm256_fmadd_pd(xi, d0, c30);
+            c31 = _mm256_fmadd_pd(xi, d1, c31);
+        }
+        _mm256_storeu_pd(d, c00);
+        _mm256_storeu_pd(d + 4, c01);
+        _mm256_storeu_pd(d + 8, c10);
+        _mm256_storeu_pd(d + 12, c11);
+        _mm256_storeu_pd(d + 16, c20);
+        _mm256_storeu_pd(d + 20, c21);
+        _mm256_storeu_pd(d + 24, c30);
+        _mm256_storeu_pd(d + 28, c31);
+    }
+#else
+    // Input channel pairs, so each dy pixel is loaded once per pair.
+    for (std::size_t ci = 0; ci < kC; ci += 2) {
+        Scalar acc[2][kC];
+        std::copy_n(dw + ci * kC, 2 * kC, acc[0]);
+        for (std::size_t p = 0; p < count; ++p) {
+            const Scalar x0 = x[p * x_step + ci];
+            const Scalar x1 = x[p * x_step + ci + 1];
+            for (std::size_t co = 0; co < kC; ++co) {
+                acc[0][co] += x0 * dy[p * kC + co];
+                acc[1][co] += x1 * dy[p * kC + co];
+            }
+        }
+        std::copy_n(acc[0], 2 * kC, dw + ci * kC);
+    }
+#endif
+}
+
+// Output row (n, ob, oy): interior tiles of kTileW pixels without bounds
+// checks, then the border pixels one at a time.
+void forward_row(const Geometry& g, const Scalar* x, const Scalar* w, const Scalar* bias,
+                 Scalar* y, std::size_t n, std::size_t ob, std::size_t oy) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    interior_columns(g, begin, end);
+    std::size_t ox = begin;
+    for (; ox + kTileW <= end; ox += kTileW) {
+        forward_tile(g, x, w, bias, y, n, ob, oy, ox);
+    }
+    const auto border = [&](std::size_t col) {
+        Scalar* out = y + g.out_at(n, ob, oy, col);
+        std::copy_n(bias + ob * kC, kC, out);
+        for (std::size_t ib = 0; ib < g.in_blocks; ++ib) {
+            for (std::size_t ky = 0; ky < g.kernel_h; ++ky) {
+                std::size_t iy = 0;
+                if (!g.input_coord(oy, ky, g.height, iy)) {
+                    continue;
+                }
+                for (std::size_t kx = 0; kx < g.kernel_w; ++kx) {
+                    std::size_t ix = 0;
+                    if (g.input_coord(col, kx, g.width, ix)) {
+                        pixel_block_add(x + g.in_at(n, ib, iy, ix),
+                                        w + g.weight_at(ob, ib, ky, kx), out);
+                    }
+                }
+            }
+        }
+    };
+    for (std::size_t col = 0; col < begin; ++col) {
+        border(col);
+    }
+    for (std::size_t col = ox; col < g.out_w; ++col) {
+        border(col);
+    }
+}
+
+// dX of block (n, ib): every output pixel scatters W^T * dy into the input
+// pixels it read. `wt` holds each 8 x 8 weight block transposed ([out][in]).
+void backward_input_plane(const Geometry& g, const Scalar* wt, const Scalar* dy, Scalar* dx,
+                          std::size_t n, std::size_t ib) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    interior_columns(g, begin, end);
+    for (std::size_t ob = 0; ob < g.out_blocks; ++ob) {
+        for (std::size_t oy = 0; oy < g.out_h; ++oy) {
+            for (std::size_t ky = 0; ky < g.kernel_h; ++ky) {
+                std::size_t iy = 0;
+                if (!g.input_coord(oy, ky, g.height, iy)) {
+                    continue;
+                }
+                const Scalar* dy_row = dy + g.out_at(n, ob, oy, 0);
+                Scalar* dx_row = dx + g.in_at(n, ib, iy, 0);
+                for (std::size_t kx = 0; kx < g.kernel_w; ++kx) {
+                    const Scalar* wp = wt + g.weight_at(ob, ib, ky, kx);
+                    std::size_t ox = begin;
+                    for (; ox + kTileW <= end; ox += kTileW) {
+                        tile_block_add(dy_row + ox * kC, wp,
+                                       dx_row + (ox * g.stride + kx - g.padding) * kC,
+                                       g.stride * kC);
+                    }
+                    const auto border = [&](std::size_t col) {
+                        std::size_t ix = 0;
+                        if (g.input_coord(col, kx, g.width, ix)) {
+                            pixel_block_add(dy_row + col * kC, wp, dx_row + ix * kC);
+                        }
+                    };
+                    for (std::size_t col = 0; col < begin; ++col) {
+                        border(col);
+                    }
+                    for (std::size_t col = ox; col < g.out_w; ++col) {
+                        border(col);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// dW of weight blocks (ob, ib, :, :), summed over the batch in order.
+void backward_weight_block(const Geometry& g, const Scalar* x, const Scalar* dy, Scalar* dw,
+                           std::size_t ob, std::size_t ib) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    interior_columns(g, begin, end);
+    for (std::size_t n = 0; n < g.batch; ++n) {
+        for (std::size_t oy = 0; oy < g.out_h; ++oy) {
+            for (std::size_t ky = 0; ky < g.kernel_h; ++ky) {
+                std::size_t iy = 0;
+                if (!g.input_coord(oy, ky, g.height, iy)) {
+                    continue;
+                }
+                const Scalar* dy_row = dy + g.out_at(n, ob, oy, 0);
+                const Scalar* x_row = x + g.in_at(n, ib, iy, 0);
+                for (std::size_t kx = 0; kx < g.kernel_w; ++kx) {
+                    Scalar* dwp = dw + g.weight_at(ob, ib, ky, kx);
+                    if (end > begin) {
+                        weight_block_add(x_row + (begin * g.stride + kx - g.padding) * kC,
+                                         g.stride * kC, dy_row + begin * kC, end - begin, dwp);
+                    }
+                    const auto border = [&](std::size_t col) {
+                        std::size_t ix = 0;
+                        if (g.input_coord(col, kx, g.width, ix)) {
+                            weight_block_add(x_row + ix * kC, kC, dy_row + col * kC, 1, dwp);
+                        }
+                    };
+                    for (std::size_t col = 0; col < begin; ++col) {
+                        border(col);
+                    }
+                    for (std::size_t col = end; col < g.out_w; ++col) {
+                        border(col);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+Conv2D::Conv2D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_h,
+               std::size_t kernel_w, std::size_t stride, std::size_t padding)
+    : in_channels_(in_channels), out_channels_(out_channels), kernel_h_(kernel_h),
+      kernel_w_(kernel_w), stride_(stride), padding_(padding),
+      weights_({blocks_of(out_channels), blocks_of(in_channels), kernel_h, kernel_w, kC, kC}),
+      bias_(1, out_channels),
+      weight_grad_({blocks_of(out_channels), blocks_of(in_channels), kernel_h, kernel_w, kC, kC}),
+      bias_grad_(1, out_channels) {
+    if (in_channels == 0 || out_channels == 0 || kernel_h == 0 || kernel_w == 0 || stride == 0) {
+        throw std::invalid_argument(
+            "Conv2D: channels, kernel size and stride must be positive");
+    }
+}
+
+Conv2D::Conv2D(std::size_t in_channels, std::size_t out_channels, std::size_t kernel_h,
+               std::size_t kernel_w, const CounterRng& rng, std::size_t stride,
+               std::size_t padding)
+    : Conv2D(in_channels, out_channels, kernel_h, kernel_w, stride, padding) {
+    const auto fan = static_cast<Scalar>((in_channels + out_channels) * kernel_h * kernel_w);
+    const Scalar limit = std::sqrt(6.0 / fan);
+    Tensor w({out_channels, in_channels, kernel_h, kernel_w});
+    rng.fill_uniform({w.data(), w.numel()}, 0, -limit, limit);
+    set_weights(w, Tensor2D(1, out_channels));
+}
+
+std::size_t Conv2D::in_channels() const noexcept { return in_channels_; }
+
+std::size_t Conv2D::out_channels() const noexcept { return out_channels_; }
+
+std::size_t Conv2D::kernel_h() const noexcept { return kernel_h_; }
+
+std::size_t Conv2D::kernel_w() const noexcept { return kernel_w_; }
+
+std::size_t Conv2D::stride() const noexcept { return stride_; }
+
+std::size_t Conv2D::padding() const noexcept { return padding_; }
+
+std::size_t Conv2D::output_size(std::size_t size, std::size_t kernel) const {
+    const auto padded = size + 2 * padding_;
+    if (padded < kernel) {
+        throw std::invalid_argument("Conv2D: input smaller than the kernel");
+    }
+    return (padded - kernel) / stride_ + 1;
+}
+
+void Conv2D::set_input_size(std::size_t height, std::size_t width) {
+    if (height == 0 || width == 0) {
+        throw std::invalid_argument("Conv2D::set_input_size: zero size");
+    }
+    input_height_ = height;
+    input_width_ = width;
+}
+
+std::size_t Conv2D::input_height() const noexcept { return input_height_; }
+
+std::size_t Conv2D::input_width() const noexcept { return input_width_; }
+
+void Conv2D::set_training(bool training) noexcept {
+    training_ = training;
+    if (!training) {
+        saved_ = false;
+    }
+}
+
+bool Conv2D::training() const noexcept { return training_; }
+
+Tensor Conv2D::weights() const {
+    Tensor out({out_channels_, in_channels_, kernel_h_, kernel_w_});
+    unblock_weights(weights_, out_channels_, in_channels_, out);
+    return out;
+}
+
+void Conv2D::set_weights(const Tensor& weights, const Tensor2D& bias) {
+    if (weights.dims() != Dims{out_channels_, in_channels_, kernel_h_, kernel_w_} ||
+        bias.rows() != 1 || bias.cols() != out_channels_) {
+        throw std::invalid_argument("Conv2D::set_weights: shape mismatch");
+    }
+    const auto in_blocks = weights_.dims()[1];
+    const auto taps = kernel_h_ * kernel_w_;
+    for (std::size_t o = 0; o < out_channels_; ++o) {
+        for (std::size_t i = 0; i < in_channels_; ++i) {
+            for (std::size_t t = 0; t < taps; ++t) {
+                weights_.data()[blocked_index(in_blocks, taps, o, i, t)] =
+                    weights.data()[(o * in_channels_ + i) * taps + t];
+            }
+        }
+    }
+    bias_ = bias;
+    ++version_;
+}
+
+const Tensor2D& Conv2D::bias() const noexcept { return bias_; }
+
+std::uint64_t Conv2D::version() const noexcept { return version_; }
+
+Vector Conv2D::forward(const Vector& input) {
+    if (input_height_ == 0) {
+        throw std::logic_error("Conv2D::forward: call set_input_size() first");
+    }
+    Tensor x({1, blocks_of(in_channels_), input_height_, input_width_, kC});
+    if (input.size() != x.numel()) {
+        throw std::invalid_argument("Conv2D::forward: input size mismatch");
+    }
+    std::copy(input.begin(), input.end(), x.data());
+    const auto y = forward_batch(x);
+    return Vector(y.data(), y.data() + y.numel());
+}
+
+Vector Conv2D::backward(const Vector& d_output) {
+    if (!saved_) {
+        throw std::logic_error("Conv2D::backward: no training forward to differentiate");
+    }
+    const auto& d = input_.dims();
+    Tensor dy({d[0], blocks_of(out_channels_), output_size(d[2], kernel_h_),
+               output_size(d[3], kernel_w_), kC});
+    if (d_output.size() != dy.numel()) {
+        throw std::invalid_argument("Conv2D::backward: gradient size mismatch");
+    }
+    std::copy(d_output.begin(), d_output.end(), dy.data());
+    const auto dx = backward_batch(dy);
+    return Vector(dx.data(), dx.data() + dx.numel());
+}
+
+Tensor Conv2D::forward_batch(const Tensor& input) {
+    const auto& d = input.dims();
+    if (d.size() != 5 || d[1] != blocks_of(in_channels_) || d[4] != kC) {
+        throw std::invalid_argument(
+            "Conv2D::forward_batch: expected (N, ceil(in / 8), H, W, 8)");
+    }
+    const Geometry g{d[0],      d[1],      d[2],    d[3],     blocks_of(out_channels_),
+                     kernel_h_, kernel_w_, stride_, padding_, output_size(d[2], kernel_h_),
+                     output_size(d[3], kernel_w_)};
+    // Bias padded to whole blocks, so the padding channels stay zero.
+    std::vector<Scalar> bias(g.out_blocks * kC, 0.0);
+    std::copy_n(bias_.data(), out_channels_, bias.begin());
+
+    Tensor out({g.batch, g.out_blocks, g.out_h, g.out_w, kC});
+    util::parallel_for(0, g.batch * g.out_blocks * g.out_h, 1,
+                       [&](std::size_t lo, std::size_t hi) {
+                           for (auto r = lo; r < hi; ++r) {
+                               const auto oy = r % g.out_h;
+                               const auto ob = r / g.out_h % g.out_blocks;
+                               const auto n = r / g.out_h / g.out_blocks;
+                               forward_row(g, input.data(), weights_.data(), bias.data(),
+                                           out.data(), n, ob, oy);
+                           }
+                       });
+    if (training_) {
+        input_ = input;
+        saved_ = true;
+    }
+    return out;
+}
+
+Tensor Conv2D::backward_batch(const Tensor& d_output) {
+    if (!saved_) {
+        throw std::logic_error("Conv2D::backward_batch: no training forward to differentiate");
+    }
+    const auto& d = input_.dims();
+    const Geometry g{d[0],      d[1],      d[2],    d[3],     blocks_of(out_channels_),
+                     kernel_h_, kernel_w_, stride_, padding_, output_size(d[2], kernel_h_),
+                     output_size(d[3], kernel_w_)};
+    if (d_output.dims() != Dims{g.batch, g.out_blocks, g.out_h, g.out_w, kC}) {
+        throw std::invalid_argument("Conv2D::backward_batch: gradient shape mismatch");
+    }
+
+    // db: a fixed-order sum per output channel.
+    for (std::size_t o = 0; o < out_channels_; ++o) {
+        Scalar sum = 0.0;
+        for (std::size_t n = 0; n < g.batch; ++n) {
+            const Scalar* p = d_output.data() + g.out_at(n, o / kC, 0, 0) + o % kC;
+            for (std::size_t i = 0; i < g.out_h * g.out_w; ++i) {
+                sum += p[i * kC];
+            }
+        }
+        bias_grad_.data()[o] += sum;
+    }
+
+    // dW: each task owns whole (ob, ib) weight blocks.
+    util::parallel_for(0, g.out_blocks * g.in_blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto blk = lo; blk < hi; ++blk) {
+            backward_weight_block(g, input_.data(), d_output.data(), weight_grad_.data(),
+                                  blk / g.in_blocks, blk % g.in_blocks);
+        }
+    });
+
+    // dX: each task owns whole (n, ib) planes.
+    Tensor wt(weights_.dims());
+    for (std::size_t b = 0; b < weights_.numel() / (kC * kC); ++b) {
+        transpose_strided(weights_.data() + b * kC * kC, kC, wt.data() + b * kC * kC, kC, kC,
+                          kC);
+    }
+    Tensor d_input(d);
+    util::parallel_for(0, g.batch * g.in_blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto p = lo; p < hi; ++p) {
+            backward_input_plane(g, wt.data(), d_output.data(), d_input.data(), p / g.in_blocks,
+                                 p % g.in_blocks);
+        }
+    });
+    return d_input;
+}
+
+Tensor Conv2D::weight_grad() const {
+    Tensor out({out_channels_, in_channels_, kernel_h_, kernel_w_});
+    unblock_weights(weight_grad_, out_channels_, in_channels_, out);
+    return out;
+}
+
+const Tensor2D& Conv2D::bias_grad() const noexcept { return bias_grad_; }
+
+void Conv2D::zero_grad() {
+    std::fill_n(weight_grad_.data(), weight_grad_.numel(), 0.0);
+    bias_grad_.zero_fill();
+}
+
+ActivationMemory Conv2D::activation_memory() const {
+    if (!saved_) {
+        return {};
+    }
+    const auto bytes = input_.numel() * sizeof(Scalar);
+    return {bytes, bytes};
+}
+
+} // namespace fnn
@@ -0,0 +1,329 @@
+#include "fnn/layers/dense.hpp"
+#include "fnn/gemm_tuner.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace fnn {
+
+namespace {
+
+// Backward tiling: a task owns blocks of up to kOutBlock output units (rows
+// of dW, entries of db) and walks the batch kBatchTile rows at a time, so a
+// tile of dZ is at most 256 x 256 doubles (512 KiB) and stays in L2 while
+// the db, dW and dX updates use it.
+constexpr std::size_t kOutBlock = 256;
+constexpr std::size_t kBatchTile = 256;
+// Smallest output block, one micro-kernel width.
+constexpr std::size_t kMinOutBlock = 8;
+// Rows of dX per task when summing the per-task partials.
+constexpr std::size_t kReduceGrain = 16;
+
+// W^T as a strided view of the out x in weights: in x out, column-major.
+MatrixRef transposed(const Tensor2D& w) { return {w.data(), w.cols(), w.rows(), 1, w.cols()}; }
+
+// Whether Dense may call the blocked GEMM / GEMV kernels itself: only when
+// the active backend's matmul() is those kernels.
+bool own_kernels(const Backend& backend) { return backend.prefers_layer_kernels(); }
+
+// dz[i] = dy[i] * f'(z[i]), with f' written in terms of y = f(z).
+void scale_by_derivative(ActivationKind kind, Scalar alpha, const Scalar* y, const Scalar* dy,
+                         Scalar* dz, std::size_t n) {
+    switch (kind) {
+    case ActivationKind::Identity:
+        std::copy(dy, dy + n, dz);
+        break;
+    case ActivationKind::ReLU:
+        for (std::size_t i = 0; i < n; ++i) {
+            dz[i] = y[i] > 0.0 ? dy[i] : 0.0;
+        }
+        break;
+    case ActivationKind::LeakyReLU:
+        for (std::size_t i = 0; i < n; ++i) {
+            dz[i] = y[i] > 0.0 ? dy[i] : alpha * dy[i];
+        }
+        break;
+    case ActivationKind::Sigmoid:
+        for (std::size_t i = 0; i < n; ++i) {
+            dz[i] = dy[i] * y[i] * (1.0 - y[i]);
+        }
+        break;
+    case ActivationKind::Tanh:
+        for (std::size_t i = 0; i < n; ++i) {
+            dz[i] = dy[i] * (1.0 - y[i] * y[i]);
+        }
+        break;
+    }
+}
+
+} // namespace
+
+Dense::Dense(std::size_t in_features, std::size_t out_features)
+    : weights_(out_features, in_features), bias_(1, out_features),
+      weight_grad_(out_features, in_features), bias_grad_(1, out_features) {
+    pack_weights();
+}
+
+Dense::Dense(std::size_t in_features, std::size_t out_features, const CounterRng& rng,
+             ActivationKind activation, Scalar alpha)
+    : Dense(in_features, out_features) {
+    if (activation == ActivationKind::LeakyReLU && !(alpha > 0.0)) {
+        throw std::invalid_argument("Dense: LeakyReLU slope must be positive");
+    }
+    activation_ = activation;
+    alpha_ = alpha;
+    const auto fan = static_cast<Scalar>(in_features + out_features);
+    const Scalar limit = fan > 0.0 ? std::sqrt(6.0 / fan) : 0.0;
+    fill_uniform(weights_, rng, -limit, limit);
+    pack_weights();
+}
+
+std::size_t Dense::in_features() const noexcept { return weights_.cols(); }
+
+std::size_t Dense::out_features() const noexcept { return weights_.rows(); }
+
+ActivationKind Dense::activation() const noexcept { return activation_; }
+
+void Dense::set_training(bool training) noexcept {
+    training_ = training;
+    if (!training) {
+        saved_ = false;
+    }
+}
+
+bool Dense::training() const noexcept { return training_; }
+
+const Tensor2D& Dense::weights() const noexcept { return weights_; }
+
+const Tensor2D& Dense::bias() const noexcept { return bias_; }
+
+Tensor2D& Dense::mutable_weights() noexcept {
+    packed_valid_ = false;
+    ++version_;
+    return weights_;
+}
+
+Tensor2D& Dense::mutable_bias() noexcept {
+    ++version_;
+    return bias_;
+}
+
+void Dense::set_weights(const Tensor2D& weights, const Tensor2D& bias) {
+    if (weights.rows() != out_features() || weights.cols() != in_features() ||
+        bias.rows() != 1 || bias.cols() != out_features()) {
+        throw std::invalid_argument("Dense::set_weights: shape mismatch");
+    }
+    std::copy(weights.data(), weights.data() + weights.size(), weights_.data());
+    std::copy(bias.data(), bias.data() + bias.size(), bias_.data());
+    ++version_;
+    pack_weights();
+}
+
+void Dense::pack_weights() {
+    packed_.pack(transposed(weights_));
+    packed_valid_ = true;
+}
+
+bool Dense::weights_packed() const noexcept { return packed_valid_; }
+
+std::uint64_t Dense::version() const noexcept { return version_; }
+
+void Dense::activate(std::span<Scalar> z) const {
+    if (activation_ != ActivationKind::Identity) {
+        active_backend().activation(activation_, alpha_, z.data(), z.data(), z.size());
+    }
+}
+
+void Dense::affine(const Scalar* x, std::size_t rows, Scalar* out) {
+    const auto n = out_features();
+    const auto in = in_features();
+    for (std::size_t r = 0; r < rows; ++r) {
+        std::copy(bias_.data(), bias_.data() + n, out + r * n);
+    }
+    const auto& backend = active_backend();
+    if (!own_kernels(backend)) {
+        backend.matmul(1.0, {x, rows, in, in, 1}, transposed(weights_), 1.0,
+                       {out, rows, n, n, 1});
+    } else if (rows == 1) {
+        // Online scoring: the 4-row micro-kernel would waste three quarters
+        // of its work on one row, while GEMV streams W once at full width.
+        util::gemv(1.0, {weights_.data(), n, in, in, 1}, std::span<const Scalar>(x, in), 1.0,
+                   std::span<Scalar>(out, n));
+    } else {
+        if (!packed_valid_) {
+            pack_weights();
+        }
+        gemm(1.0, {x, rows, in, in, 1}, packed_, 1.0, {out, rows, n, n, 1});
+    }
+    if (activation_ != ActivationKind::Identity) {
+        backend.activation(activation_, alpha_, out, out, rows * n);
+    }
+}
+
+Vector Dense::forward(const Vector& input) {
+    if (!training_) {
+        Vector out;
+        forward_into(input, out);
+        return out;
+    }
+    Tensor2D batch(1, input.size());
+    std::copy(input.begin(), input.end(), batch.data());
+    const auto out = forward_batch(batch);
+    return Vector(out.data(), out.data() + out.size());
+}
+
+void Dense::forward_into(const Vector& input, Vector& out) {
+    if (training_) {
+        out = forward(input);
+        return;
+    }
+    // Inference: nothing to save, so skip the batch round trip.
+    if (input.size() != in_features()) {
+        throw std::invalid_argument("Dense::forward: input width mismatch");
+    }
+    out.resize(out_features());
+    affine(input.data(), 1, out.data());
+}
+
+Vector Dense::backward(const Vector& d_output) {
+    Tensor2D d_batch(1, d_output.size());
+    std::copy(d_output.begin(), d_output.end(), d_batch.data());
+    const auto d_input = backward_batch(d_batch);
+    return Vector(d_input.data(), d_input.data() + d_input.size());
+}
+
+Tensor2D Dense::forward_batch(const Tensor2D& batch) {
+    if (batch.cols() != in_features()) {
+        throw std::invalid_argument("Dense::forward_batch: input width mismatch");
+    }
+    Tensor2D out(batch.rows(), out_features());
+    affine(batch.data(), batch.rows(), out.data());
+    if (training_) {
+        input_ = batch;
+        if (activation_ != ActivationKind::Identity) {
+            output_ = out;
+        }
+        saved_ = true;
+    }
+    return out;
+}
+
+Tensor2D Dense::backward_batch(const Tensor2D& d_output) {
+    if (!saved_) {
+        throw std::logic_error("Dense::backward_batch: no training forward to differentiate");
+    }
+    const auto batch = input_.rows();
+    const auto in = in_features();
+    const auto out = out_features();
+    if (d_output.rows() != batch || d_output.cols() != out) {
+        throw std::invalid_argument("Dense::backward_batch: gradient shape mismatch");
+    }
+
+    // Output blocks are split over the tasks, so each task owns its rows of
+    // dW and entries of db outright. dX gets a contribution from every
+    // block, so each task sums into its own partial, added up at the end in
+    // a fixed order.
+    // Narrow layers get smaller blocks so every thread still owns one.
+    const auto threads = util::ThreadPool::instance().num_threads();
+    const auto per_thread = (out + threads - 1) / threads;
+    const auto out_block = std::clamp((per_thread + kMinOutBlock - 1) / kMinOutBlock * kMinOutBlock,
+                                      kMinOutBlock, kOutBlock);
+    const auto blocks = (out + out_block - 1) / out_block;
+    const auto tasks = std::max<std::size_t>(1, std::min(blocks, threads));
+    Tensor2D d_input(batch, in);
+    std::vector<Tensor2D> partials(tasks - 1, Tensor2D(batch, in));
+    const bool identity = activation_ == ActivationKind::Identity;
+    const auto& backend = active_backend();
+    const bool direct = own_kernels(backend);
+    const auto product = [&](const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                             const MutableMatrixRef& c) {
+        if (direct) {
+            // The tuned blocking for this shape; with several tasks the pool
+            // is already busy, so the product stays on its task's thread.
+            auto tile_config = gemm_config_for(c.rows, c.cols, a.cols);
+            if (tasks > 1) {
+                tile_config.threads = 1;
+            }
+            gemm(1.0, a, b, beta, c, tile_config);
+        } else {
+            backend.matmul(1.0, a, b, beta, c);
+        }
+    };
+
+    util::parallel_for(0, tasks, 1, [&](std::size_t lo, std::size_t hi) {
+        std::vector<Scalar> dz(kBatchTile * out_block);
+        for (auto t = lo; t < hi; ++t) {
+            Scalar* dx = t == 0 ? d_input.data() : partials[t - 1].data();
+            bool first = true;
+            for (auto blk = t * blocks / tasks; blk < (t + 1) * blocks / tasks; ++blk) {
+                const auto j0 = blk * out_block;
+                const auto ob = std::min(out_block, out - j0);
+                for (std::size_t r0 = 0; r0 < batch; r0 += kBatchTile) {
+                    const auto rb = std::min(kBatchTile, batch - r0);
+                    // The only read of this tile of dY (and of y).
+                    Scalar* db = bias_grad_.data() + j0;
+                    for (std::size_t r = 0; r < rb; ++r) {
+                        const auto offset = (r0 + r) * out + j0;
+                        Scalar* dz_row = dz.data() + r * ob;
+                        scale_by_derivative(activation_, alpha_,
+                                            identity ? nullptr : output_.data() + offset,
+                                            d_output.data() + offset, dz_row, ob);
+                        for (std::size_t j = 0; j < ob; ++j) {
+                            db[j] += dz_row[j];
+                        }
+                    }
+                    const MatrixRef dz_tile{dz.data(), rb, ob, ob, 1};
+                    const MatrixRef dz_tile_t{dz.data(), ob, rb, 1, ob};
+                    // dW[j0:j0+ob, :] += dZ_tile^T * X[r0:r0+rb, :]
+                    product(dz_tile_t, {input_.data() + r0 * in, rb, in, in, 1}, 1.0,
+                            {weight_grad_.data() + j0 * in, ob, in, in, 1});
+                    // dX[r0:r0+rb, :] (+)= dZ_tile * W[j0:j0+ob, :]
+                    product(dz_tile, {weights_.data() + j0 * in, ob, in, in, 1},
+                            first ? 0.0 : 1.0, {dx + r0 * in, rb, in, in, 1});
+                }
+                first = false;
+            }
+        }
+    });
+
+    if (!partials.empty()) {
+        util::parallel_for(0, batch, kReduceGrain, [&](std::size_t lo, std::size_t hi) {
+            for (const auto& p : partials) {
+                const Scalar* src = p.data() + lo * in;
+                Scalar* dst = d_input.data() + lo * in;
+                for (std::size_t i = 0; i < (hi - lo) * in; ++i) {
+                    dst[i] += src[i];
+                }
+            }
+        });
+    }
+    return d_input;
+}
+
+const Tensor2D& Dense::weight_grad() const noexcept { return weight_grad_; }
+
+const Tensor2D& Dense::bias_grad() const noexcept { return bias_grad_; }
+
+void Dense::zero_grad() {
+    weight_grad_.zero_fill();
+    bias_grad_.zero_fill();
+}
+
+ActivationMemory Dense::activation_memory() const {
+    if (!saved_) {
+        return {};
+    }
+    const auto bytes = (input_.size() + (activation_ == ActivationKind::Identity
+                                             ? 0
+                                             : output_.size())) *
+                       sizeof(Scalar);
+    return {bytes, bytes};
+}
+
+} // namespace fnn
@@ -0,0 +1,132 @@
+#include "fnn/layers/dropout.hpp"
+#include "fnn/tensor2D.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// 64-element mask words per thread-pool chunk.
+constexpr std::size_t kWordGrain = 256;
+
+// Keep bits for stream elements [first, first + count), count <= 64.
+std::uint64_t keep_bits(const CounterRng& rng, std::uint64_t first, std::size_t count,
+                        Scalar rate) {
+    Scalar u[64];
+    rng.fill_uniform(std::span<Scalar>(u, count), first, 0.0, 1.0);
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        bits |= static_cast<std::uint64_t>(u[i] >= rate) << i;
+    }
+    return bits;
+}
+
+void scale_by_bits(Scalar* data, std::size_t count, std::uint64_t bits, Scalar scale) {
+    for (std::size_t i = 0; i < count; ++i) {
+        data[i] = ((bits >> i) & 1u) ? data[i] * scale : 0.0;
+    }
+}
+
+} // namespace
+
+Dropout::Dropout(Scalar rate, std::uint64_t seed, std::uint32_t layer_id, MaskStorage storage)
+    : rate_(rate), rng_(seed, 0, layer_id), storage_(storage) {
+    if (rate < 0.0 || rate >= 1.0) {
+        throw std::invalid_argument("Dropout: rate must be in [0, 1)");
+    }
+    scale_ = 1.0 / (1.0 - rate);
+}
+
+void Dropout::set_training(bool training) noexcept { training_ = training; }
+
+bool Dropout::training() const noexcept { return training_; }
+
+Scalar Dropout::rate() const noexcept { return rate_; }
+
+std::uint64_t Dropout::step() const noexcept { return step_; }
+
+Vector Dropout::forward(const Vector& input) {
+    Vector out = input;
+    apply_forward(out.data(), out.size());
+    return out;
+}
+
+Vector Dropout::backward(const Vector& d_output) {
+    Vector out = d_output;
+    apply_backward(out.data(), out.size());
+    return out;
+}
+
+void Dropout::forward_inplace(Tensor2D& batch) { apply_forward(batch.data(), batch.size()); }
+
+void Dropout::backward_inplace(Tensor2D& d_batch) const {
+    apply_backward(d_batch.data(), d_batch.size());
+}
+
+std::size_t Dropout::mask_bytes() const noexcept {
+    return storage_ == MaskStorage::Packed ? mask_.bytes() : 0;
+}
+
+ActivationMemory Dropout::activation_memory() const {
+    if (!mask_valid_) {
+        return {};
+    }
+    return {mask_bytes(), mask_size_ * sizeof(Scalar)};
+}
+
+void Dropout::apply_forward(Scalar* data, std::size_t n) {
+    if (!training_) {
+        return;
+    }
+    mask_step_ = step_++;
+    mask_size_ = n;
+    mask_valid_ = true;
+    if (storage_ == MaskStorage::Packed) {
+        mask_.resize(n);
+    }
+
+    const auto rng = rng_.with_step(mask_step_);
+    const auto num_words = (n + 63) / 64;
+    std::uint64_t* words = storage_ == MaskStorage::Packed ? mask_.words() : nullptr;
+    util::parallel_for(0, num_words, kWordGrain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t w = lo; w < hi; ++w) {
+            const auto first = w * 64;
+            const auto count = std::min<std::size_t>(64, n - first);
+            const auto bits = keep_bits(rng, first, count, rate_);
+            if (words != nullptr) {
+                words[w] = bits;
+            }
+            scale_by_bits(data + first, count, bits, scale_);
+        }
+    });
+}
+
+void Dropout::apply_backward(Scalar* data, std::size_t n) const {
+    if (!training_) {
+        return;
+    }
+    if (!mask_valid_) {
+        throw std::logic_error("Dropout::backward: no training forward pass to differentiate");
+    }
+    if (n != mask_size_) {
+        throw std::invalid_argument("Dropout::backward: gradient size does not match forward");
+    }
+
+    const auto rng = rng_.with_step(mask_step_);
+    const auto num_words = (n + 63) / 64;
+    const std::uint64_t* words = storage_ == MaskStorage::Packed ? mask_.words() : nullptr;
+    util::parallel_for(0, num_words, kWordGrain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t w = lo; w < hi; ++w) {
+            const auto first = w * 64;
+            const auto count = std::min<std::size_t>(64, n - first);
+            const auto bits = words != nullptr ? words[w] : keep_bits(rng, first, count, rate_);
+            scale_by_bits(data + first, count, bits, scale_);
+        }
+    });
+}
+
+} // namespace fnn
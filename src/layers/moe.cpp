@@ -0,0 +1,294 @@
+#include "fnn/layers/moe.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// Rows [first, first + count) of `src` gathered into a new matrix, row t
+// read from src row rows(t) and scaled by scale(t).
+template <typename RowOf, typename ScaleOf>
+Tensor2D gather_rows(const Tensor2D& src, std::size_t count, RowOf&& rows, ScaleOf&& scale) {
+    const auto cols = src.cols();
+    Tensor2D out(count, cols);
+    for (std::size_t t = 0; t < count; ++t) {
+        const Scalar* from = src.data() + rows(t) * cols;
+        Scalar* to = out.data() + t * cols;
+        const Scalar s = scale(t);
+        for (std::size_t c = 0; c < cols; ++c) {
+            to[c] = s * from[c];
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+MixtureOfExperts::MixtureOfExperts(std::size_t in_features, std::size_t out_features,
+                                   std::size_t experts, std::size_t top_k,
+                                   const CounterRng& rng, ActivationKind activation)
+    : top_k_(top_k), gate_(in_features, experts, rng) {
+    if (top_k == 0 || top_k > experts) {
+        throw std::invalid_argument("MixtureOfExperts: need 1 <= top_k <= experts");
+    }
+    experts_.reserve(experts);
+    for (std::size_t e = 0; e < experts; ++e) {
+        experts_.emplace_back(in_features, out_features, rng.with_step(rng.step() + 1 + e),
+                              activation);
+    }
+}
+
+std::size_t MixtureOfExperts::in_features() const noexcept { return gate_.in_features(); }
+
+std::size_t MixtureOfExperts::out_features() const noexcept {
+    return experts_.front().out_features();
+}
+
+std::size_t MixtureOfExperts::expert_count() const noexcept { return experts_.size(); }
+
+std::size_t MixtureOfExperts::top_k() const noexcept { return top_k_; }
+
+void MixtureOfExperts::set_training(bool training) noexcept {
+    training_ = training;
+    gate_.set_training(training);
+    for (auto& e : experts_) {
+        e.set_training(training);
+    }
+    if (!training) {
+        saved_ = false;
+        expert_output_ = Tensor2D(0, 0);
+    }
+}
+
+bool MixtureOfExperts::training() const noexcept { return training_; }
+
+Dense& MixtureOfExperts::gate() noexcept { return gate_; }
+
+const Dense& MixtureOfExperts::gate() const noexcept { return gate_; }
+
+Dense& MixtureOfExperts::expert(std::size_t index) { return experts_.at(index); }
+
+const Dense& MixtureOfExperts::expert(std::size_t index) const { return experts_.at(index); }
+
+Vector MixtureOfExperts::forward(const Vector& input) {
+    Tensor2D x(1, input.size());
+    std::copy(input.begin(), input.end(), x.data());
+    const auto y = forward_batch(x);
+    return Vector(y.data(), y.data() + y.size());
+}
+
+Vector MixtureOfExperts::backward(const Vector& d_output) {
+    Tensor2D dy(1, d_output.size());
+    std::copy(d_output.begin(), d_output.end(), dy.data());
+    const auto dx = backward_batch(dy);
+    return Vector(dx.data(), dx.data() + dx.size());
+}
+
+void MixtureOfExperts::route(const Tensor2D& logits) {
+    const auto experts = experts_.size();
+    const auto pairs = rows_ * top_k_;
+    route_.resize(pairs);
+    weight_.resize(pairs);
+    for (std::size_t r = 0; r < rows_; ++r) {
+        const Scalar* l = logits.data() + r * experts;
+        std::size_t* top = route_.data() + r * top_k_;
+        // Insertion into the running top k, kept sorted by descending logit;
+        // strict comparisons keep the lower index on ties.
+        std::size_t filled = 0;
+        for (std::size_t e = 0; e < experts; ++e) {
+            if (filled == top_k_ && !(l[e] > l[top[top_k_ - 1]])) {
+                continue;
+            }
+            auto i = filled < top_k_ ? filled++ : top_k_ - 1;
+            for (; i > 0 && l[e] > l[top[i - 1]]; --i) {
+                top[i] = top[i - 1];
+            }
+            top[i] = e;
+        }
+        // Softmax over the selected logits; top[0] holds the largest.
+        Scalar* w = weight_.data() + r * top_k_;
+        Scalar sum = 0.0;
+        for (std::size_t j = 0; j < top_k_; ++j) {
+            w[j] = std::exp(l[top[j]] - l[top[0]]);
+            sum += w[j];
+        }
+        for (std::size_t j = 0; j < top_k_; ++j) {
+            w[j] /= sum;
+        }
+    }
+
+    // Counting sort of the pairs by expert, stable in pair order.
+    offset_.assign(experts + 1, 0);
+    for (const auto e : route_) {
+        ++offset_[e + 1];
+    }
+    for (std::size_t e = 0; e < experts; ++e) {
+        offset_[e + 1] += offset_[e];
+    }
+    order_.resize(pairs);
+    position_.resize(pairs);
+    std::vector<std::size_t> next(offset_.begin(), offset_.end() - 1);
+    for (std::size_t a = 0; a < pairs; ++a) {
+        const auto p = next[route_[a]]++;
+        order_[p] = a;
+        position_[a] = p;
+    }
+}
+
+Tensor2D MixtureOfExperts::forward_batch(const Tensor2D& batch) {
+    if (batch.cols() != in_features()) {
+        throw std::invalid_argument("MixtureOfExperts::forward_batch: input width mismatch");
+    }
+    rows_ = batch.rows();
+    route(gate_.forward_batch(batch));
+
+    // One batched forward per expert over its rows, outputs written to the
+    // expert's slice of the sorted buffer.
+    const auto out_features = this->out_features();
+    Tensor2D sorted(rows_ * top_k_, out_features);
+    util::parallel_for(0, experts_.size(), 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto e = lo; e < hi; ++e) {
+            const auto first = offset_[e];
+            const auto count = offset_[e + 1] - first;
+            if (count == 0) {
+                continue;
+            }
+            const auto x = gather_rows(
+                batch, count, [&](std::size_t t) { return order_[first + t] / top_k_; },
+                [](std::size_t) { return 1.0; });
+            const auto y = experts_[e].forward_batch(x);
+            std::copy(y.data(), y.data() + y.size(), sorted.data() + first * out_features);
+        }
+    });
+
+    Tensor2D out(rows_, out_features);
+    for (std::size_t r = 0; r < rows_; ++r) {
+        Scalar* y = out.data() + r * out_features;
+        for (std::size_t j = 0; j < top_k_; ++j) {
+            const auto a = r * top_k_ + j;
+            const Scalar* part = sorted.data() + position_[a] * out_features;
+            for (std::size_t c = 0; c < out_features; ++c) {
+                y[c] += weight_[a] * part[c];
+            }
+        }
+    }
+    if (training_) {
+        expert_output_ = std::move(sorted);
+        saved_ = true;
+    }
+    return out;
+}
+
+Tensor2D MixtureOfExperts::backward_batch(const Tensor2D& d_output) {
+    if (!saved_) {
+        throw std::logic_error(
+            "MixtureOfExperts::backward_batch: no training forward to differentiate");
+    }
+    const auto out_features = this->out_features();
+    if (d_output.rows() != rows_ || d_output.cols() != out_features) {
+        throw std::invalid_argument("MixtureOfExperts::backward_batch: gradient shape mismatch");
+    }
+    const auto in = in_features();
+
+    // Experts see dy scaled by their gate weight; their dx lands in sorted
+    // order like their outputs did.
+    Tensor2D sorted_dx(rows_ * top_k_, in);
+    util::parallel_for(0, experts_.size(), 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto e = lo; e < hi; ++e) {
+            const auto first = offset_[e];
+            const auto count = offset_[e + 1] - first;
+            if (count == 0) {
+                continue;
+            }
+            const auto dy = gather_rows(
+                d_output, count, [&](std::size_t t) { return order_[first + t] / top_k_; },
+                [&](std::size_t t) { return weight_[order_[first + t]]; });
+            const auto dx = experts_[e].backward_batch(dy);
+            std::copy(dx.data(), dx.data() + dx.size(), sorted_dx.data() + first * in);
+        }
+    });
+
+    // Gate: dL/dw_j = dy . expert output, through the softmax over the
+    // selected logits; unselected logits get no gradient.
+    const auto experts = experts_.size();
+    Tensor2D d_logits(rows_, experts);
+    std::vector<Scalar> d_weight(top_k_);
+    for (std::size_t r = 0; r < rows_; ++r) {
+        const Scalar* dy = d_output.data() + r * out_features;
+        Scalar mean = 0.0;
+        for (std::size_t j = 0; j < top_k_; ++j) {
+            const auto a = r * top_k_ + j;
+            const Scalar* part = expert_output_.data() + position_[a] * out_features;
+            Scalar dot = 0.0;
+            for (std::size_t c = 0; c < out_features; ++c) {
+                dot += dy[c] * part[c];
+            }
+            d_weight[j] = dot;
+            mean += weight_[a] * dot;
+        }
+        for (std::size_t j = 0; j < top_k_; ++j) {
+            const auto a = r * top_k_ + j;
+            d_logits(r, route_[a]) = weight_[a] * (d_weight[j] - mean);
+        }
+    }
+    auto d_input = gate_.backward_batch(d_logits);
+    for (std::size_t r = 0; r < rows_; ++r) {
+        Scalar* dx = d_input.data() + r * in;
+        for (std::size_t j = 0; j < top_k_; ++j) {
+            const Scalar* part = sorted_dx.data() + position_[r * top_k_ + j] * in;
+            for (std::size_t c = 0; c < in; ++c) {
+                dx[c] += part[c];
+            }
+        }
+    }
+    return d_input;
+}
+
+void MixtureOfExperts::zero_grad() {
+    gate_.zero_grad();
+    for (auto& e : experts_) {
+        e.zero_grad();
+    }
+}
+
+std::vector<std::size_t> MixtureOfExperts::expert_load() const {
+    std::vector<std::size_t> load(experts_.size(), 0);
+    if (offset_.size() == experts_.size() + 1) {
+        for (std::size_t e = 0; e < experts_.size(); ++e) {
+            load[e] = offset_[e + 1] - offset_[e];
+        }
+    }
+    return load;
+}
+
+std::uint64_t MixtureOfExperts::version() const noexcept {
+    auto total = gate_.version();
+    for (const auto& e : experts_) {
+        total += e.version();
+    }
+    return total;
+}
+
+ActivationMemory MixtureOfExperts::activation_memory() const {
+    if (!saved_) {
+        return {};
+    }
+    auto total = gate_.activation_memory();
+    const auto routing = route_.size() * (3 * sizeof(std::size_t) + sizeof(Scalar)) +
+                         expert_output_.size() * sizeof(Scalar);
+    total.saved_bytes += routing;
+    total.full_bytes += routing;
+    for (const auto& e : experts_) {
+        const auto m = e.activation_memory();
+        total.saved_bytes += m.saved_bytes;
+        total.full_bytes += m.full_bytes;
+    }
+    return total;
+}
+
+} // namespace fnn
@@ -0,0 +1,311 @@
+#include "fnn/layers/pooling.hpp"
+#include "fnn/tensor_permute.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+constexpr std::size_t kC = kChannelBlock;
+
+struct PoolGeometry {
+    std::size_t planes; // N * blocks
+    std::size_t height;
+    std::size_t width;
+    std::size_t kernel;
+    std::size_t stride;
+    std::size_t out_h;
+    std::size_t out_w;
+};
+
+PoolGeometry pool_geometry(const Dims& d, std::size_t kernel, std::size_t stride,
+                           const char* what) {
+    if (d.size() != 5 || d[4] != kC || d[2] < kernel || d[3] < kernel) {
+        throw std::invalid_argument(what);
+    }
+    return {d[0] * d[1], d[2], d[3], kernel, stride, (d[2] - kernel) / stride + 1,
+            (d[3] - kernel) / stride + 1};
+}
+
+std::size_t resolve_stride(std::size_t kernel, std::size_t stride) {
+    return stride == 0 ? kernel : stride;
+}
+
+// Runs fn(plane) over all planes on the pool; planes are independent.
+template <typename F>
+void for_each_plane(const PoolGeometry& g, F&& fn) {
+    util::parallel_for(0, g.planes, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto p = lo; p < hi; ++p) {
+            fn(p);
+        }
+    });
+}
+
+// One image of the Vector interface as a (1, B, height, width, 8) tensor;
+// throws std::invalid_argument(what) unless v holds whole planes.
+Tensor image_tensor(const Vector& v, std::size_t height, std::size_t width, const char* what) {
+    const auto plane = height * width * kC;
+    if (v.empty() || v.size() % plane != 0) {
+        throw std::invalid_argument(what);
+    }
+    Tensor x({1, v.size() / plane, height, width, kC});
+    std::copy(v.begin(), v.end(), x.data());
+    return x;
+}
+
+// The gradient of the output of a forward on `input_dims`, as a tensor;
+// throws std::invalid_argument(what) on a size mismatch.
+Tensor gradient_tensor(const Vector& v, const Dims& input_dims, std::size_t kernel,
+                       std::size_t stride, const char* what) {
+    const auto g = pool_geometry(input_dims, kernel, stride, what);
+    Tensor dy({input_dims[0], input_dims[1], g.out_h, g.out_w, kC});
+    if (v.size() != dy.numel()) {
+        throw std::invalid_argument(what);
+    }
+    std::copy(v.begin(), v.end(), dy.data());
+    return dy;
+}
+
+void check_size(std::size_t height, std::size_t width, const char* what) {
+    if (height == 0 || width == 0) {
+        throw std::invalid_argument(what);
+    }
+}
+
+} // namespace
+
+MaxPool2D::MaxPool2D(std::size_t kernel, std::size_t stride)
+    : kernel_(kernel), stride_(resolve_stride(kernel, stride)) {
+    if (kernel == 0 || kernel * kernel > std::size_t{1} << 16) {
+        throw std::invalid_argument("MaxPool2D: kernel must be in [1, 256]");
+    }
+}
+
+std::size_t MaxPool2D::kernel() const noexcept { return kernel_; }
+
+std::size_t MaxPool2D::stride() const noexcept { return stride_; }
+
+void MaxPool2D::set_input_size(std::size_t height, std::size_t width) {
+    check_size(height, width, "MaxPool2D::set_input_size: zero size");
+    input_height_ = height;
+    input_width_ = width;
+}
+
+std::size_t MaxPool2D::input_height() const noexcept { return input_height_; }
+
+std::size_t MaxPool2D::input_width() const noexcept { return input_width_; }
+
+void MaxPool2D::set_training(bool training) noexcept {
+    training_ = training;
+    if (!training) {
+        saved_ = false;
+    }
+}
+
+bool MaxPool2D::training() const noexcept { return training_; }
+
+Vector MaxPool2D::forward(const Vector& input) {
+    if (input_height_ == 0) {
+        throw std::logic_error("MaxPool2D::forward: call set_input_size() first");
+    }
+    const auto y = forward_batch(image_tensor(input, input_height_, input_width_,
+                                              "MaxPool2D::forward: input size mismatch"));
+    return Vector(y.data(), y.data() + y.numel());
+}
+
+Vector MaxPool2D::backward(const Vector& d_output) {
+    if (!saved_) {
+        throw std::logic_error("MaxPool2D::backward: no training forward to differentiate");
+    }
+    const auto dx = backward_batch(
+        gradient_tensor(d_output, input_dims_, kernel_, stride_,
+                        "MaxPool2D::backward: gradient size mismatch"));
+    return Vector(dx.data(), dx.data() + dx.numel());
+}
+
+Tensor MaxPool2D::forward_batch(const Tensor& input) {
+    const auto& d = input.dims();
+    const auto g = pool_geometry(d, kernel_, stride_,
+                                 "MaxPool2D::forward_batch: expected (N, B, H, W, 8) >= kernel");
+    Tensor out({d[0], d[1], g.out_h, g.out_w, kC});
+    if (training_) {
+        argmax_.resize(out.numel());
+    }
+    const bool keep = training_;
+    for_each_plane(g, [&](std::size_t p) {
+        const Scalar* x = input.data() + p * g.height * g.width * kC;
+        const auto out_offset = p * g.out_h * g.out_w * kC;
+        for (std::size_t oy = 0; oy < g.out_h; ++oy) {
+            for (std::size_t ox = 0; ox < g.out_w; ++ox) {
+                Scalar best[kC];
+                std::uint16_t where[kC] = {};
+                std::fill_n(best, kC, -std::numeric_limits<Scalar>::infinity());
+                for (std::size_t ky = 0; ky < kernel_; ++ky) {
+                    const Scalar* row = x + ((oy * stride_ + ky) * g.width + ox * stride_) * kC;
+                    for (std::size_t kx = 0; kx < kernel_; ++kx) {
+                        const auto pos = static_cast<std::uint16_t>(ky * kernel_ + kx);
+                        for (std::size_t c = 0; c < kC; ++c) {
+                            const Scalar v = row[kx * kC + c];
+                            where[c] = v > best[c] ? pos : where[c];
+                            best[c] = v > best[c] ? v : best[c];
+                        }
+                    }
+                }
+                const auto o = out_offset + (oy * g.out_w + ox) * kC;
+                std::copy_n(best, kC, out.data() + o);
+                if (keep) {
+                    std::copy_n(where, kC, argmax_.data() + o);
+                }
+            }
+        }
+    });
+    if (training_) {
+        input_dims_ = d;
+        saved_ = true;
+    }
+    return out;
+}
+
+Tensor MaxPool2D::backward_batch(const Tensor& d_output) {
+    if (!saved_) {
+        throw std::logic_error("MaxPool2D::backward_batch: no training forward to differentiate");
+    }
+    const auto g = pool_geometry(input_dims_, kernel_, stride_, "MaxPool2D: bad saved shape");
+    if (d_output.dims() != Dims{input_dims_[0], input_dims_[1], g.out_h, g.out_w, kC}) {
+        throw std::invalid_argument("MaxPool2D::backward_batch: gradient shape mismatch");
+    }
+    Tensor d_input(input_dims_);
+    for_each_plane(g, [&](std::size_t p) {
+        Scalar* dx = d_input.data() + p * g.height * g.width * kC;
+        const auto out_offset = p * g.out_h * g.out_w * kC;
+        for (std::size_t oy = 0; oy < g.out_h; ++oy) {
+            for (std::size_t ox = 0; ox < g.out_w; ++ox) {
+                const auto o = out_offset + (oy * g.out_w + ox) * kC;
+                for (std::size_t c = 0; c < kC; ++c) {
+                    const auto ky = argmax_[o + c] / kernel_;
+                    const auto kx = argmax_[o + c] % kernel_;
+                    dx[((oy * stride_ + ky) * g.width + ox * stride_ + kx) * kC + c] +=
+                        d_output.data()[o + c];
+                }
+            }
+        }
+    });
+    return d_input;
+}
+
+ActivationMemory MaxPool2D::activation_memory() const {
+    if (!saved_) {
+        return {};
+    }
+    const auto positions = argmax_.size();
+    return {positions * sizeof(std::uint16_t), positions * sizeof(Scalar)};
+}
+
+AvgPool2D::AvgPool2D(std::size_t kernel, std::size_t stride)
+    : kernel_(kernel), stride_(resolve_stride(kernel, stride)) {
+    if (kernel == 0) {
+        throw std::invalid_argument("AvgPool2D: kernel must be positive");
+    }
+}
+
+std::size_t AvgPool2D::kernel() const noexcept { return kernel_; }
+
+std::size_t AvgPool2D::stride() const noexcept { return stride_; }
+
+void AvgPool2D::set_input_size(std::size_t height, std::size_t width) {
+    check_size(height, width, "AvgPool2D::set_input_size: zero size");
+    input_height_ = height;
+    input_width_ = width;
+}
+
+std::size_t AvgPool2D::input_height() const noexcept { return input_height_; }
+
+std::size_t AvgPool2D::input_width() const noexcept { return input_width_; }
+
+Vector AvgPool2D::forward(const Vector& input) {
+    if (input_height_ == 0) {
+        throw std::logic_error("AvgPool2D::forward: call set_input_size() first");
+    }
+    const auto y = forward_batch(image_tensor(input, input_height_, input_width_,
+                                              "AvgPool2D::forward: input size mismatch"));
+    return Vector(y.data(), y.data() + y.numel());
+}
+
+Vector AvgPool2D::backward(const Vector& d_output) {
+    if (input_dims_.empty()) {
+        throw std::logic_error("AvgPool2D::backward: no forward to differentiate");
+    }
+    const auto dx = backward_batch(
+        gradient_tensor(d_output, input_dims_, kernel_, stride_,
+                        "AvgPool2D::backward: gradient size mismatch"));
+    return Vector(dx.data(), dx.data() + dx.numel());
+}
+
+Tensor AvgPool2D::forward_batch(const Tensor& input) {
+    const auto& d = input.dims();
+    const auto g = pool_geometry(d, kernel_, stride_,
+                                 "AvgPool2D::forward_batch: expected (N, B, H, W, 8) >= kernel");
+    const Scalar scale = 1.0 / static_cast<Scalar>(kernel_ * kernel_);
+    Tensor out({d[0], d[1], g.out_h, g.out_w, kC});
+    for_each_plane(g, [&](std::size_t p) {
+        const Scalar* x = input.data() + p * g.height * g.width * kC;
+        Scalar* y = out.data() + p * g.out_h * g.out_w * kC;
+        for (std::size_t oy = 0; oy < g.out_h; ++oy) {
+            for (std::size_t ox = 0; ox < g.out_w; ++ox) {
+                Scalar sum[kC] = {};
+                for (std::size_t ky = 0; ky < kernel_; ++ky) {
+                    const Scalar* row = x + ((oy * stride_ + ky) * g.width + ox * stride_) * kC;
+                    for (std::size_t kx = 0; kx < kernel_; ++kx) {
+                        for (std::size_t c = 0; c < kC; ++c) {
+                            sum[c] += row[kx * kC + c];
+                        }
+                    }
+                }
+                for (std::size_t c = 0; c < kC; ++c) {
+                    y[(oy * g.out_w + ox) * kC + c] = sum[c] * scale;
+                }
+            }
+        }
+    });
+    input_dims_ = d;
+    return out;
+}
+
+Tensor AvgPool2D::backward_batch(const Tensor& d_output) {
+    if (input_dims_.empty()) {
+        throw std::logic_error("AvgPool2D::backward_batch: no forward to differentiate");
+    }
+    const auto g = pool_geometry(input_dims_, kernel_, stride_, "AvgPool2D: bad saved shape");
+    if (d_output.dims() != Dims{input_dims_[0], input_dims_[1], g.out_h, g.out_w, kC}) {
+        throw std::invalid_argument("AvgPool2D::backward_batch: gradient shape mismatch");
+    }
+    const Scalar scale = 1.0 / static_cast<Scalar>(kernel_ * kernel_);
+    Tensor d_input(input_dims_);
+    for_each_plane(g, [&](std::size_t p) {
+        Scalar* dx = d_input.data() + p * g.height * g.width * kC;
+        const Scalar* dy = d_output.data() + p * g.out_h * g.out_w * kC;
+        for (std::size_t oy = 0; oy < g.out_h; ++oy) {
+            for (std::size_t ox = 0; ox < g.out_w; ++ox) {
+                Scalar share[kC];
+                for (std::size_t c = 0; c < kC; ++c) {
+                    share[c] = dy[(oy * g.out_w + ox) * kC + c] * scale;
+                }
+                for (std::size_t ky = 0; ky < kernel_; ++ky) {
+                    Scalar* row = dx + ((oy * stride_ + ky) * g.width + ox * stride_) * kC;
+                    for (std::size_t kx = 0; kx < kernel_; ++kx) {
+                        for (std::size_t c = 0; c < kC; ++c) {
+                            row[kx * kC + c] += share[c];
+                        }
+                    }
+                }
+            }
+        }
+    });
+    return d_input;
+}
+
+} // namespace fnn
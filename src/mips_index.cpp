@@ -0,0 +1,260 @@
+#include "fnn/mips_index.hpp"
+#include "fnn/gemm.hpp"
+#include "fnn/layers/dense.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// Rows scored per gemm() against the centroids, bounding the scratch.
+constexpr std::size_t kAssignChunk = 1024;
+
+// Best-first order: higher score, then lower index.
+bool better(const ScoredClass& a, const ScoredClass& b) {
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+
+// out[i] = nearest centroid of row i of `rows` (count x dim), in Euclidean
+// distance: the largest x . c - |c|^2 / 2, ties to the lower centroid.
+void nearest(const Scalar* rows, std::size_t count, const Tensor2D& centroids,
+             std::span<std::size_t> out) {
+    const auto partitions = centroids.rows();
+    const auto dim = centroids.cols();
+    std::vector<Scalar> half_norm(partitions);
+    for (std::size_t p = 0; p < partitions; ++p) {
+        const std::span<const Scalar> c(centroids.data() + p * dim, dim);
+        half_norm[p] = 0.5 * util::dot(c, c);
+    }
+    std::vector<Scalar> dots(std::min(count, kAssignChunk) * partitions);
+    for (std::size_t first = 0; first < count; first += kAssignChunk) {
+        const auto n = std::min(kAssignChunk, count - first);
+        gemm(1.0, {rows + first * dim, n, dim, dim, 1}, {centroids.data(), dim, partitions, 1, dim},
+             0.0, {dots.data(), n, partitions, partitions, 1});
+        util::parallel_for(0, n, 64, [&](std::size_t lo, std::size_t hi) {
+            for (auto i = lo; i < hi; ++i) {
+                const Scalar* d = dots.data() + i * partitions;
+                std::size_t best = 0;
+                for (std::size_t p = 1; p < partitions; ++p) {
+                    if (d[p] - half_norm[p] > d[best] - half_norm[best]) {
+                        best = p;
+                    }
+                }
+                out[first + i] = best;
+            }
+        });
+    }
+}
+
+} // namespace
+
+std::vector<ScoredClass> top_k(std::span<const Scalar> scores, std::size_t k) {
+    k = std::min(k, scores.size());
+    std::vector<ScoredClass> all(scores.size());
+    for (std::size_t i = 0; i < scores.size(); ++i) {
+        all[i] = {i, scores[i]};
+    }
+    const auto kth = all.begin() + static_cast<std::ptrdiff_t>(k);
+    if (k < all.size()) {
+        std::nth_element(all.begin(), kth, all.end(), better);
+    }
+    all.erase(kth, all.end());
+    std::sort(all.begin(), all.end(), better);
+    return all;
+}
+
+MipsIndex::MipsIndex(const Tensor2D& weights, const Tensor2D& bias, const CounterRng& rng,
+                     MipsIndexConfig config)
+    : classes_(weights.rows()), dim_(weights.cols()), centroids_(0, 0), weights_(0, 0) {
+    if (classes_ == 0 || dim_ == 0) {
+        throw std::invalid_argument("MipsIndex: empty weights");
+    }
+    if (bias.rows() != 1 || bias.cols() != classes_) {
+        throw std::invalid_argument("MipsIndex: bias must be 1 x classes");
+    }
+    const auto partitions = std::min(
+        classes_, config.partitions != 0
+                      ? config.partitions
+                      : static_cast<std::size_t>(std::lround(std::sqrt(classes_))));
+
+    // Training sample: a partial Fisher-Yates shuffle of the row indices.
+    const auto samples = std::min(
+        classes_, std::max(partitions, partitions * config.sample_per_partition));
+    std::vector<std::size_t> pick(classes_);
+    std::iota(pick.begin(), pick.end(), 0);
+    for (std::size_t i = 0; i < samples; ++i) {
+        const auto left = classes_ - i;
+        const auto j = i + std::min(left - 1, static_cast<std::size_t>(
+                                                  rng.uniform(i) * static_cast<Scalar>(left)));
+        std::swap(pick[i], pick[j]);
+    }
+    Tensor2D sample(samples, dim_);
+    for (std::size_t i = 0; i < samples; ++i) {
+        std::copy_n(weights.data() + pick[i] * dim_, dim_, sample.data() + i * dim_);
+    }
+
+    // Lloyd iterations from the first sampled rows; an empty cluster keeps
+    // its centroid.
+    centroids_ = Tensor2D(partitions, dim_);
+    std::copy_n(sample.data(), partitions * dim_, centroids_.data());
+    std::vector<std::size_t> label(samples);
+    std::vector<std::size_t> count(partitions);
+    for (std::size_t it = 0; it < config.iterations; ++it) {
+        nearest(sample.data(), samples, centroids_, label);
+        Tensor2D sum(partitions, dim_);
+        std::fill(count.begin(), count.end(), 0);
+        for (std::size_t i = 0; i < samples; ++i) {
+            util::axpy(1.0, {sample.data() + i * dim_, dim_},
+                       {sum.data() + label[i] * dim_, dim_});
+            ++count[label[i]];
+        }
+        for (std::size_t p = 0; p < partitions; ++p) {
+            if (count[p] == 0) {
+                continue;
+            }
+            const Scalar inv = 1.0 / static_cast<Scalar>(count[p]);
+            for (std::size_t d = 0; d < dim_; ++d) {
+                centroids_(p, d) = sum(p, d) * inv;
+            }
+        }
+    }
+
+    // Every row to its nearest centroid, then grouped by a counting sort.
+    label.resize(classes_);
+    nearest(weights.data(), classes_, centroids_, label);
+    offset_.assign(partitions + 1, 0);
+    for (const auto p : label) {
+        ++offset_[p + 1];
+    }
+    for (std::size_t p = 0; p < partitions; ++p) {
+        offset_[p + 1] += offset_[p];
+    }
+    class_.resize(classes_);
+    weights_ = Tensor2D(classes_, dim_);
+    bias_.resize(classes_);
+    radius_.assign(partitions, 0.0);
+    max_bias_.assign(partitions, -std::numeric_limits<Scalar>::infinity());
+    std::vector<std::size_t> next(offset_.begin(), offset_.end() - 1);
+    std::vector<Scalar> diff(dim_);
+    for (std::size_t c = 0; c < classes_; ++c) {
+        const auto p = label[c];
+        const auto at = next[p]++;
+        const Scalar* w = weights.data() + c * dim_;
+        std::copy_n(w, dim_, weights_.data() + at * dim_);
+        class_[at] = c;
+        bias_[at] = bias.data()[c];
+        for (std::size_t d = 0; d < dim_; ++d) {
+            diff[d] = w[d] - centroids_(p, d);
+        }
+        radius_[p] = std::max(radius_[p], util::nrm2(diff));
+        max_bias_[p] = std::max(max_bias_[p], bias_[at]);
+    }
+}
+
+MipsIndex::MipsIndex(const Dense& layer, const CounterRng& rng, MipsIndexConfig config)
+    : MipsIndex(layer.weights(), layer.bias(), rng, config) {}
+
+std::size_t MipsIndex::classes() const noexcept { return classes_; }
+
+std::size_t MipsIndex::dim() const noexcept { return dim_; }
+
+std::size_t MipsIndex::partitions() const noexcept { return centroids_.rows(); }
+
+std::size_t MipsIndex::partition_size(std::size_t p) const {
+    if (p >= partitions()) {
+        throw std::out_of_range("MipsIndex::partition_size: no such partition");
+    }
+    return offset_[p + 1] - offset_[p];
+}
+
+std::vector<ScoredClass> MipsIndex::search(std::span<const Scalar> query, std::size_t k,
+                                           std::size_t probes) const {
+    if (query.size() != dim_) {
+        throw std::invalid_argument("MipsIndex::search: query size mismatch");
+    }
+    k = std::min(k, classes_);
+    if (k == 0) {
+        return {};
+    }
+    const auto partitions = this->partitions();
+    probes = std::clamp<std::size_t>(probes, 1, partitions);
+
+    // Partitions are visited by centroid score, the likeliest to hold the
+    // best rows first. The bounds are looser in high dimensions and only
+    // decide when to stop: remaining[i] is the largest bound from the i-th
+    // visited partition on. Empty partitions sort last.
+    std::vector<Scalar> centroid_score(partitions);
+    util::gemv(1.0, {centroids_.data(), partitions, dim_, dim_, 1}, query, 0.0, centroid_score);
+    const Scalar norm = util::nrm2(query);
+    constexpr auto kNone = -std::numeric_limits<Scalar>::infinity();
+    std::vector<Scalar> bound(partitions);
+    for (std::size_t p = 0; p < partitions; ++p) {
+        const bool empty = offset_[p + 1] == offset_[p];
+        bound[p] = empty ? kNone : centroid_score[p] + radius_[p] * norm + max_bias_[p];
+        centroid_score[p] = empty ? kNone : centroid_score[p];
+    }
+    std::vector<std::size_t> order(partitions);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return centroid_score[a] > centroid_score[b] ||
+               (centroid_score[a] == centroid_score[b] && a < b);
+    });
+    std::vector<Scalar> remaining(partitions + 1, kNone);
+    for (auto i = partitions; i-- > 0;) {
+        remaining[i] = std::max(remaining[i + 1], bound[order[i]]);
+    }
+
+    // Running top k as a heap with the worst candidate at the front.
+    std::vector<ScoredClass> heap;
+    heap.reserve(k);
+    std::vector<Scalar> scores;
+    for (std::size_t i = 0; i < probes; ++i) {
+        const auto p = order[i];
+        if (heap.size() == k && remaining[i] < heap.front().score) {
+            break;
+        }
+        const auto first = offset_[p];
+        const auto count = offset_[p + 1] - first;
+        scores.assign(bias_.begin() + static_cast<std::ptrdiff_t>(first),
+                      bias_.begin() + static_cast<std::ptrdiff_t>(first + count));
+        util::gemv(1.0, {weights_.data() + first * dim_, count, dim_, dim_, 1}, query, 1.0,
+                   scores);
+        for (std::size_t t = 0; t < count; ++t) {
+            const ScoredClass candidate{class_[first + t], scores[t]};
+            if (heap.size() < k) {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), better);
+            } else if (better(candidate, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), better);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), better);
+            }
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), better);
+    return heap;
+}
+
+std::vector<std::vector<ScoredClass>>
+MipsIndex::search_batch(const Tensor2D& queries, std::size_t k, std::size_t probes) const {
+    if (queries.cols() != dim_) {
+        throw std::invalid_argument("MipsIndex::search_batch: query size mismatch");
+    }
+    std::vector<std::vector<ScoredClass>> out(queries.rows());
+    util::parallel_for(0, queries.rows(), 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto r = lo; r < hi; ++r) {
+            out[r] = search({queries.data() + r * dim_, dim_}, k, probes);
+        }
+    });
+    return out;
+}
+
+} // namespace fnn
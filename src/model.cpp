@@ -1,4 +1,332 @@
 #include "fnn/model.hpp"
+#include "fnn/layers/dense.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/thread_pool.hpp"
 
-// Intentionally empty for now.
-// TODO: Add a concrete model implementation (e.g., Sequential) later.
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace fnn {
+
+std::uint64_t Model::version() const noexcept { return 0; }
+
+Layer& Sequential::add(std::unique_ptr<Layer> layer) {
+    if (!layer) {
+        throw std::invalid_argument("Sequential::add: null layer");
+    }
+    layer->set_training(training_);
+    layers_.push_back(std::move(layer));
+    cached_ = false;
+    return *layers_.back();
+}
+
+std::size_t Sequential::size() const noexcept { return layers_.size(); }
+
+Layer& Sequential::layer(std::size_t index) { return *layers_.at(index); }
+
+const Layer& Sequential::layer(std::size_t index) const { return *layers_.at(index); }
+
+void Sequential::set_training(bool training) noexcept {
+    training_ = training;
+    for (auto& l : layers_) {
+        l->set_training(training);
+    }
+}
+
+bool Sequential::training() const noexcept { return training_; }
+
+Vector Sequential::predict(const Vector& input) {
+    Vector x = input;
+    for (auto& l : layers_) {
+        x = l->forward(x);
+    }
+    return x;
+}
+
+std::uint64_t Sequential::version() const noexcept {
+    std::uint64_t total = layers_.size();
+    for (const auto& l : layers_) {
+        total += l->version();
+    }
+    return total;
+}
+
+Vector Sequential::predict_incremental(const Vector& input) {
+    auto* first = layers_.empty() ? nullptr : dynamic_cast<Dense*>(layers_.front().get());
+    if (first == nullptr) {
+        throw std::logic_error("Sequential::predict_incremental: layer 0 must be Dense");
+    }
+    const auto in = first->in_features();
+    const auto out = first->out_features();
+    if (input.size() != in) {
+        throw std::invalid_argument("Sequential::predict_incremental: input width mismatch");
+    }
+    if (!cached_ || cached_version_ != first->version()) {
+        weights_t_ = Tensor2D(in, out);
+        const auto& w = first->weights();
+        for (std::size_t o = 0; o < out; ++o) {
+            for (std::size_t i = 0; i < in; ++i) {
+                weights_t_(i, o) = w(o, i);
+            }
+        }
+        cached_ = false;
+    }
+
+    // Sparse update when it pays, otherwise (or when it would not be
+    // exact) the same GEMV the layer itself runs.
+    bool full = !cached_ || ++updates_ >= kIncrementalRefresh;
+    if (!full) {
+        const auto max_changed = in / kIncrementalCrossover;
+        std::size_t changed = 0;
+        for (std::size_t i = 0; i < in && !full; ++i) {
+            if (input[i] != last_input_[i]) {
+                full = ++changed > max_changed || !std::isfinite(input[i] - last_input_[i]);
+            }
+        }
+    }
+    if (full) {
+        const auto& b = first->bias();
+        pre_activation_.assign(b.data(), b.data() + out);
+        util::gemv(1.0, {first->weights().data(), out, in, in, 1}, input, 1.0, pre_activation_);
+        updates_ = 0;
+    } else {
+        for (std::size_t i = 0; i < in; ++i) {
+            if (input[i] != last_input_[i]) {
+                util::axpy(input[i] - last_input_[i], {weights_t_.data() + i * out, out},
+                           pre_activation_);
+            }
+        }
+    }
+    last_input_ = input;
+    cached_version_ = first->version();
+    cached_ = true;
+
+    Vector x = pre_activation_;
+    first->activate(x);
+    for (std::size_t l = 1; l < layers_.size(); ++l) {
+        x = layers_[l]->forward(x);
+    }
+    return x;
+}
+
+void Sequential::reset_incremental() noexcept {
+    cached_ = false;
+    weights_t_ = Tensor2D(0, 0);
+}
+
+GraphModel::GraphModel() { nodes_.push_back({Op::Input, {}, nullptr}); }
+
+GraphModel::NodeId GraphModel::add_node(Op op, std::vector<NodeId> inputs,
+                                        std::unique_ptr<Layer> layer) {
+    if (inputs.empty()) {
+        throw std::invalid_argument("GraphModel: a node needs at least one input");
+    }
+    for (const auto in : inputs) {
+        if (in >= nodes_.size()) {
+            throw std::invalid_argument("GraphModel: input is not an existing node");
+        }
+    }
+    nodes_.push_back({op, std::move(inputs), std::move(layer)});
+    output_ = nodes_.size() - 1;
+    planned_ = false;
+    ++edits_;
+    return output_;
+}
+
+GraphModel::NodeId GraphModel::add_layer(std::unique_ptr<Layer> layer, NodeId input) {
+    if (!layer) {
+        throw std::invalid_argument("GraphModel::add_layer: null layer");
+    }
+    layer->set_training(training_);
+    return add_node(Op::Layer, {input}, std::move(layer));
+}
+
+GraphModel::NodeId GraphModel::add_sum(const std::vector<NodeId>& inputs) {
+    return add_node(Op::Sum, inputs, nullptr);
+}
+
+GraphModel::NodeId GraphModel::add_concat(const std::vector<NodeId>& inputs) {
+    return add_node(Op::Concat, inputs, nullptr);
+}
+
+void GraphModel::set_output(NodeId node) {
+    if (node >= nodes_.size()) {
+        throw std::invalid_argument("GraphModel::set_output: unknown node");
+    }
+    output_ = node;
+    planned_ = false;
+    ++edits_;
+}
+
+GraphModel::NodeId GraphModel::output() const noexcept { return output_; }
+
+std::size_t GraphModel::size() const noexcept { return nodes_.size(); }
+
+Layer& GraphModel::layer(NodeId node) {
+    if (node >= nodes_.size() || nodes_[node].op != Op::Layer) {
+        throw std::invalid_argument("GraphModel::layer: not a layer node");
+    }
+    return *nodes_[node].layer;
+}
+
+const Layer& GraphModel::layer(NodeId node) const {
+    if (node >= nodes_.size() || nodes_[node].op != Op::Layer) {
+        throw std::invalid_argument("GraphModel::layer: not a layer node");
+    }
+    return *nodes_[node].layer;
+}
+
+void GraphModel::set_training(bool training) noexcept {
+    training_ = training;
+    for (auto& node : nodes_) {
+        if (node.layer) {
+            node.layer->set_training(training);
+        }
+    }
+}
+
+bool GraphModel::training() const noexcept { return training_; }
+
+std::size_t GraphModel::level_count() {
+    if (!planned_) {
+        plan();
+    }
+    return levels_.size();
+}
+
+std::size_t GraphModel::buffer_count() {
+    if (!planned_) {
+        plan();
+    }
+    return buffers_.size();
+}
+
+void GraphModel::plan() {
+    const auto count = nodes_.size();
+    // Only nodes the output depends on run; ids are topological, so one
+    // backward sweep finds them.
+    std::vector<bool> needed(count, false);
+    needed[output_] = true;
+    for (auto id = count; id-- > 1;) {
+        if (needed[id]) {
+            for (const auto in : nodes_[id].inputs) {
+                needed[in] = true;
+            }
+        }
+    }
+
+    std::vector<std::size_t> level(count, 0);
+    std::vector<std::size_t> last_read(count, 0);
+    levels_.clear();
+    for (NodeId id = 1; id < count; ++id) {
+        if (!needed[id]) {
+            continue;
+        }
+        for (const auto in : nodes_[id].inputs) {
+            level[id] = std::max(level[id], level[in] + 1);
+        }
+        for (const auto in : nodes_[id].inputs) {
+            last_read[in] = std::max(last_read[in], level[id]);
+        }
+        levels_.resize(std::max(levels_.size(), level[id]));
+        levels_[level[id] - 1].push_back(id);
+    }
+
+    // Greedy reuse, one level at a time: a value's buffer is released once
+    // the level of its last reader has run, never within that level, so the
+    // nodes of a level never share buffers with values they read.
+    std::vector<std::vector<NodeId>> released(levels_.size() + 1);
+    for (NodeId id = 1; id < count; ++id) {
+        if (needed[id] && id != output_) {
+            released[last_read[id]].push_back(id);
+        }
+    }
+    buffer_of_.assign(count, 0);
+    std::vector<std::size_t> free_buffers;
+    std::size_t buffers = 0;
+    for (std::size_t l = 0; l < levels_.size(); ++l) {
+        for (const auto id : levels_[l]) {
+            if (free_buffers.empty()) {
+                buffer_of_[id] = buffers++;
+            } else {
+                buffer_of_[id] = free_buffers.back();
+                free_buffers.pop_back();
+            }
+        }
+        for (const auto id : released[l + 1]) {
+            free_buffers.push_back(buffer_of_[id]);
+        }
+    }
+    buffers_.resize(buffers);
+    planned_ = true;
+}
+
+const Vector& GraphModel::value(NodeId node, const Vector& input) const {
+    return node == kInput ? input : buffers_[buffer_of_[node]];
+}
+
+void GraphModel::run(NodeId id, const Vector& input) {
+    const auto& node = nodes_[id];
+    auto& out = buffers_[buffer_of_[id]];
+    switch (node.op) {
+    case Op::Layer:
+        // Planning never gives a node the buffer of a value it reads.
+        node.layer->forward_into(value(node.inputs.front(), input), out);
+        break;
+    case Op::Sum: {
+        const auto& first = value(node.inputs.front(), input);
+        out.assign(first.begin(), first.end());
+        for (std::size_t i = 1; i < node.inputs.size(); ++i) {
+            const auto& term = value(node.inputs[i], input);
+            if (term.size() != out.size()) {
+                throw std::invalid_argument("GraphModel::predict: sum inputs differ in size");
+            }
+            for (std::size_t j = 0; j < out.size(); ++j) {
+                out[j] += term[j];
+            }
+        }
+        break;
+    }
+    case Op::Concat:
+        out.clear();
+        for (const auto in : node.inputs) {
+            const auto& part = value(in, input);
+            out.insert(out.end(), part.begin(), part.end());
+        }
+        break;
+    case Op::Input:
+        break;
+    }
+}
+
+std::uint64_t GraphModel::version() const noexcept {
+    auto total = edits_;
+    for (const auto& n : nodes_) {
+        if (n.layer) {
+            total += n.layer->version();
+        }
+    }
+    return total;
+}
+
+Vector GraphModel::predict(const Vector& input) {
+    if (!planned_) {
+        plan();
+    }
+    for (const auto& level : levels_) {
+        if (level.size() == 1) {
+            run(level.front(), input);
+            continue;
+        }
+        util::parallel_for(0, level.size(), 1, [&](std::size_t lo, std::size_t hi) {
+            for (auto i = lo; i < hi; ++i) {
+                run(level[i], input);
+            }
+        });
+    }
+    return value(output_, input);
+}
+
+} // namespace fnn
@@ -0,0 +1,147 @@
+#include "fnn/predict_cache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+constexpr std::uint64_t kPrime1 = 0x9e3779b185ebca87ULL;
+constexpr std::uint64_t kPrime2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr std::uint64_t kPrime3 = 0x165667b19e3779f9ULL;
+
+// splitmix64 finalizer.
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t load64(const unsigned char* p) {
+    std::uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+// Hash of the input's bytes and `seed`. Four multiply-rotate lanes take
+// 32 bytes per round, so the loop is not one long dependency chain.
+std::uint64_t hash_input(const Vector& input, std::uint64_t seed) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(input.data());
+    const auto size = input.size() * sizeof(Scalar);
+    std::uint64_t lane[4] = {seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1};
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (std::size_t l = 0; l < 4; ++l) {
+            lane[l] = std::rotl(lane[l] + load64(bytes + i + 8 * l) * kPrime2, 31) * kPrime1;
+        }
+    }
+    std::uint64_t h = std::rotl(lane[0], 1) + std::rotl(lane[1], 7) + std::rotl(lane[2], 12) +
+                      std::rotl(lane[3], 18) + size;
+    for (; i + 8 <= size; i += 8) {
+        h = std::rotl(h ^ (load64(bytes + i) * kPrime2), 27) * kPrime1;
+    }
+    for (; i < size; ++i) {
+        h = std::rotl(h ^ (bytes[i] * kPrime3), 11) * kPrime1;
+    }
+    return mix(h);
+}
+
+// Bitwise equality, matching what the hash sees (so NaN inputs can hit).
+bool same_bytes(const Vector& a, const Vector& b) {
+    return a.size() == b.size() &&
+           (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(Scalar)) == 0);
+}
+
+std::size_t checked_shards(std::size_t capacity, std::size_t shards) {
+    if (capacity == 0 || shards == 0) {
+        throw std::invalid_argument("PredictCache: capacity and shard count must be positive");
+    }
+    return std::min(shards, capacity);
+}
+
+} // namespace
+
+PredictCache::PredictCache(Model& model, std::size_t capacity, std::size_t shards,
+                           bool reentrant)
+    : model_(model), capacity_(capacity), shards_(checked_shards(capacity, shards)),
+      reentrant_(reentrant), version_(model.version()) {
+    const auto count = shards_.size();
+    for (std::size_t s = 0; s < count; ++s) {
+        shards_[s].capacity = capacity / count + (s < capacity % count ? 1 : 0);
+    }
+}
+
+std::size_t PredictCache::capacity() const noexcept { return capacity_; }
+
+std::size_t PredictCache::shard_count() const noexcept { return shards_.size(); }
+
+Vector PredictCache::predict(const Vector& input) {
+    const auto version = model_.version();
+    if (version_.exchange(version) != version) {
+        clear();
+    }
+    const auto key = hash_input(input, version);
+    auto& shard = shards_[(key >> 32) % shards_.size()];
+    {
+        std::lock_guard lock(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it != shard.index.end() && same_bytes(it->second->input, input)) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            ++hits_;
+            return it->second->output;
+        }
+    }
+    ++misses_;
+    Vector output;
+    if (reentrant_) {
+        output = model_.predict(input);
+    } else {
+        std::lock_guard lock(model_mutex_);
+        output = model_.predict(input);
+    }
+
+    std::lock_guard lock(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // Stored by another thread meanwhile, or a colliding input: the
+        // newer result replaces it.
+        it->second->input = input;
+        it->second->output = output;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return output;
+    }
+    shard.lru.push_front({key, input, output});
+    shard.index.emplace(key, shard.lru.begin());
+    if (shard.lru.size() > shard.capacity) {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+        ++evictions_;
+    }
+    return output;
+}
+
+std::uint64_t PredictCache::version() const noexcept { return model_.version(); }
+
+void PredictCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        shard.lru.clear();
+        shard.index.clear();
+    }
+}
+
+CacheStats PredictCache::stats() const {
+    CacheStats out{hits_.load(), misses_.load(), evictions_.load(), 0};
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        out.size += shard.lru.size();
+    }
+    return out;
+}
+
+} // namespace fnn
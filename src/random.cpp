@@ -0,0 +1,225 @@
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// Philox4x32 constants (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3", SC'11).
+constexpr std::uint32_t kMul0 = 0xD2511F53u;
+constexpr std::uint32_t kMul1 = 0xCD9E8D57u;
+constexpr std::uint32_t kWeyl0 = 0x9E3779B9u;
+constexpr std::uint32_t kWeyl1 = 0xBB67AE85u;
+constexpr int kRounds = 10;
+
+// Blocks generated per batch. The round loop runs over all lanes at once,
+// in structure-of-arrays form, so the compiler can vectorize the 32x32->64
+// multiplies.
+constexpr std::size_t kBatch = 16;
+
+// Elements per thread-pool chunk for whole-tensor fills.
+constexpr std::size_t kFillGrain = 1 << 14;
+
+constexpr Scalar kTwoPow53Inv = 1.0 / 9007199254740992.0;
+
+using Words = std::uint32_t[4][kBatch];
+
+// Counter layout: (block bits 0-31, block bits 32-47 | step bits 32-47 in
+// the upper half, layer, step bits 0-31); the key is the 64-bit seed. Every
+// (seed, step, layer, block) with step and block below 2^48 therefore maps
+// to its own Philox input.
+void philox_batch(std::uint64_t seed, std::uint64_t step, std::uint32_t layer,
+                  std::uint64_t first_block, std::size_t count, Words& out) {
+    std::uint32_t c0[kBatch];
+    std::uint32_t c1[kBatch];
+    std::uint32_t c2[kBatch];
+    std::uint32_t c3[kBatch];
+    const auto step_hi = static_cast<std::uint32_t>(step >> 32) << 16;
+    for (std::size_t i = 0; i < kBatch; ++i) {
+        const auto b = first_block + i;
+        c0[i] = static_cast<std::uint32_t>(b);
+        c1[i] = (static_cast<std::uint32_t>(b >> 32) & 0xFFFFu) | step_hi;
+        c2[i] = layer;
+        c3[i] = static_cast<std::uint32_t>(step);
+    }
+    std::uint32_t k0 = static_cast<std::uint32_t>(seed);
+    std::uint32_t k1 = static_cast<std::uint32_t>(seed >> 32);
+
+    for (int r = 0; r < kRounds; ++r) {
+        for (std::size_t i = 0; i < kBatch; ++i) {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(kMul0) * c0[i];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(kMul1) * c2[i];
+            const auto n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1[i] ^ k0;
+            const auto n1 = static_cast<std::uint32_t>(p1);
+            const auto n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3[i] ^ k1;
+            const auto n3 = static_cast<std::uint32_t>(p0);
+            c0[i] = n0;
+            c1[i] = n1;
+            c2[i] = n2;
+            c3[i] = n3;
+        }
+        k0 += kWeyl0;
+        k1 += kWeyl1;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        out[0][i] = c0[i];
+        out[1][i] = c1[i];
+        out[2][i] = c2[i];
+        out[3][i] = c3[i];
+    }
+}
+
+// 53 random bits -> [0, 1).
+inline Scalar to_unit(std::uint32_t lo, std::uint32_t hi) noexcept {
+    const auto bits = (static_cast<std::uint64_t>(hi) << 32 | lo) >> 11;
+    return static_cast<Scalar>(bits) * kTwoPow53Inv;
+}
+
+// 53 random bits -> (0, 1), safe to take the log of.
+inline Scalar to_open_unit(std::uint32_t lo, std::uint32_t hi) noexcept {
+    const auto bits = (static_cast<std::uint64_t>(hi) << 32 | lo) >> 11;
+    return (static_cast<Scalar>(bits) + 0.5) * kTwoPow53Inv;
+}
+
+// Box-Muller: one block gives two independent standard normals.
+inline void to_normal_pair(const std::uint32_t w[4], Scalar out[2]) noexcept {
+    const auto u1 = to_open_unit(w[0], w[1]);
+    const auto u2 = to_unit(w[2], w[3]);
+    const auto radius = std::sqrt(-2.0 * std::log(u1));
+    const auto theta = 2.0 * std::numbers::pi * u2;
+    out[0] = radius * std::cos(theta);
+    out[1] = radius * std::sin(theta);
+}
+
+// Generates stream elements [first, first + out.size()) into `out`.
+// `transform(words, pair)` maps one block to its two elements.
+template <typename Transform>
+void fill_stream(const CounterRng& rng, std::span<Scalar> out, std::uint64_t first,
+                 Transform&& transform) {
+    Words words;
+    Scalar values[2 * kBatch];
+    auto block = first / 2;
+    auto skip = static_cast<std::size_t>(first % 2);
+    std::size_t written = 0;
+    while (written < out.size()) {
+        const auto wanted = skip + (out.size() - written);
+        const auto count = std::min(kBatch, (wanted + 1) / 2);
+        philox_batch(rng.seed(), rng.step(), rng.layer(), block, count, words);
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::uint32_t w[4] = {words[0][i], words[1][i], words[2][i], words[3][i]};
+            transform(w, &values[2 * i]);
+        }
+        const auto take = std::min(2 * count - skip, out.size() - written);
+        std::copy_n(values + skip, take, out.begin() + static_cast<std::ptrdiff_t>(written));
+        written += take;
+        skip = 0;
+        block += count;
+    }
+}
+
+template <typename Fill>
+void parallel_fill(Tensor2D& out, Fill&& fill) {
+    Scalar* data = out.data();
+    util::parallel_for(0, out.size(), kFillGrain, [&](std::size_t lo, std::size_t hi) {
+        fill(std::span<Scalar>(data + lo, hi - lo), static_cast<std::uint64_t>(lo));
+    });
+}
+
+} // namespace
+
+CounterRng::CounterRng(std::uint64_t seed, std::uint64_t step, std::uint32_t layer)
+    : seed_(seed), step_(step), layer_(layer) {}
+
+std::uint64_t CounterRng::seed() const noexcept { return seed_; }
+
+std::uint64_t CounterRng::step() const noexcept { return step_; }
+
+std::uint32_t CounterRng::layer() const noexcept { return layer_; }
+
+CounterRng CounterRng::with_step(std::uint64_t step) const noexcept {
+    return CounterRng(seed_, step, layer_);
+}
+
+CounterRng CounterRng::with_layer(std::uint32_t layer) const noexcept {
+    return CounterRng(seed_, step_, layer);
+}
+
+std::array<std::uint32_t, 4> CounterRng::block(std::uint64_t index) const noexcept {
+    Words words;
+    philox_batch(seed_, step_, layer_, index, 1, words);
+    return {words[0][0], words[1][0], words[2][0], words[3][0]};
+}
+
+Scalar CounterRng::uniform(std::uint64_t element) const noexcept {
+    const auto w = block(element / 2);
+    return element % 2 == 0 ? to_unit(w[0], w[1]) : to_unit(w[2], w[3]);
+}
+
+Scalar CounterRng::normal(std::uint64_t element) const noexcept {
+    const auto w = block(element / 2);
+    Scalar pair[2];
+    to_normal_pair(w.data(), pair);
+    return pair[element % 2];
+}
+
+void CounterRng::fill_uniform(std::span<Scalar> out, std::uint64_t first, Scalar lo,
+                              Scalar hi) const {
+    if (!(lo < hi)) {
+        throw std::invalid_argument("CounterRng::fill_uniform: lo must be less than hi");
+    }
+    const auto scale = hi - lo;
+    fill_stream(*this, out, first, [&](const std::uint32_t w[4], Scalar pair[2]) {
+        pair[0] = lo + scale * to_unit(w[0], w[1]);
+        pair[1] = lo + scale * to_unit(w[2], w[3]);
+    });
+}
+
+void CounterRng::fill_normal(std::span<Scalar> out, std::uint64_t first, Scalar mean,
+                             Scalar stddev) const {
+    if (stddev < 0.0) {
+        throw std::invalid_argument("CounterRng::fill_normal: stddev must be non-negative");
+    }
+    fill_stream(*this, out, first, [&](const std::uint32_t w[4], Scalar pair[2]) {
+        to_normal_pair(w, pair);
+        pair[0] = mean + stddev * pair[0];
+        pair[1] = mean + stddev * pair[1];
+    });
+}
+
+void CounterRng::fill_bernoulli(std::span<Scalar> out, std::uint64_t first, Scalar p) const {
+    if (p < 0.0 || p > 1.0) {
+        throw std::invalid_argument("CounterRng::fill_bernoulli: p must be in [0, 1]");
+    }
+    fill_stream(*this, out, first, [&](const std::uint32_t w[4], Scalar pair[2]) {
+        pair[0] = to_unit(w[0], w[1]) < p ? 1.0 : 0.0;
+        pair[1] = to_unit(w[2], w[3]) < p ? 1.0 : 0.0;
+    });
+}
+
+void fill_uniform(Tensor2D& out, const CounterRng& rng, Scalar lo, Scalar hi) {
+    parallel_fill(out, [&](std::span<Scalar> chunk, std::uint64_t first) {
+        rng.fill_uniform(chunk, first, lo, hi);
+    });
+}
+
+void fill_normal(Tensor2D& out, const CounterRng& rng, Scalar mean, Scalar stddev) {
+    parallel_fill(out, [&](std::span<Scalar> chunk, std::uint64_t first) {
+        rng.fill_normal(chunk, first, mean, stddev);
+    });
+}
+
+void fill_bernoulli(Tensor2D& out, const CounterRng& rng, Scalar p) {
+    parallel_fill(out, [&](std::span<Scalar> chunk, std::uint64_t first) {
+        rng.fill_bernoulli(chunk, first, p);
+    });
+}
+
+} // namespace fnn
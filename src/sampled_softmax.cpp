@@ -0,0 +1,317 @@
+#include "fnn/sampled_softmax.hpp"
+#include "fnn/gemm.hpp"
+#include "fnn/random.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// Rows of the full softmax scored per gemm() in full_loss(), bounding the
+// logits buffer to this many rows of `classes` values.
+constexpr std::size_t kFullLossRows = 32;
+
+void check_labels(std::span<const std::size_t> labels, std::size_t rows, std::size_t classes,
+                  const char* what) {
+    if (labels.size() != rows) {
+        throw std::invalid_argument(what);
+    }
+    for (const auto label : labels) {
+        if (label >= classes) {
+            throw std::invalid_argument(what);
+        }
+    }
+}
+
+} // namespace
+
+LogUniformSampler::LogUniformSampler(std::size_t classes)
+    : classes_(classes), log_range_(std::log(static_cast<Scalar>(classes) + 1.0)) {
+    if (classes == 0) {
+        throw std::invalid_argument("LogUniformSampler: need at least one class");
+    }
+}
+
+std::size_t LogUniformSampler::classes() const noexcept { return classes_; }
+
+Scalar LogUniformSampler::probability(std::size_t c) const {
+    const auto x = static_cast<Scalar>(c);
+    return (std::log(x + 2.0) - std::log(x + 1.0)) / log_range_;
+}
+
+void LogUniformSampler::sample(const CounterRng& rng, std::uint64_t first,
+                               std::span<std::size_t> out) const {
+    std::vector<Scalar> u(2 * out.size());
+    rng.fill_uniform(u, first, 0.0, 1.0);
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        // Inverse CDF: exp(u * log(classes + 1)) lies in [1, classes + 1).
+        const auto c = static_cast<std::size_t>(std::exp(u[2 * i] * log_range_)) - 1;
+        out[i] = std::min(c, classes_ - 1);
+    }
+}
+
+AliasSampler::AliasSampler(std::span<const Scalar> weights)
+    : probability_(weights.size()), accept_(weights.size()), alias_(weights.size()) {
+    Scalar total = 0.0;
+    for (const auto w : weights) {
+        if (!(w >= 0.0) || !std::isfinite(w)) {
+            throw std::invalid_argument("AliasSampler: weights must be finite and non-negative");
+        }
+        total += w;
+    }
+    if (weights.empty() || !(total > 0.0)) {
+        throw std::invalid_argument("AliasSampler: weights must have a positive sum");
+    }
+
+    // Vose: pair each under-full column with an over-full one that tops it
+    // up, so every column holds at most two classes.
+    const auto n = weights.size();
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    for (std::size_t i = 0; i < n; ++i) {
+        probability_[i] = weights[i] / total;
+        accept_[i] = probability_[i] * static_cast<Scalar>(n);
+        alias_[i] = i;
+        (accept_[i] < 1.0 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        const auto s = small.back();
+        small.pop_back();
+        const auto l = large.back();
+        alias_[s] = l;
+        accept_[l] -= 1.0 - accept_[s];
+        if (accept_[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Leftovers are full up to rounding.
+    for (const auto i : small) {
+        accept_[i] = 1.0;
+    }
+    for (const auto i : large) {
+        accept_[i] = 1.0;
+    }
+}
+
+std::size_t AliasSampler::classes() const noexcept { return probability_.size(); }
+
+Scalar AliasSampler::probability(std::size_t c) const { return probability_.at(c); }
+
+void AliasSampler::sample(const CounterRng& rng, std::uint64_t first,
+                          std::span<std::size_t> out) const {
+    const auto n = probability_.size();
+    std::vector<Scalar> u(2 * out.size());
+    rng.fill_uniform(u, first, 0.0, 1.0);
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        const auto column =
+            std::min(static_cast<std::size_t>(u[2 * i] * static_cast<Scalar>(n)), n - 1);
+        out[i] = u[2 * i + 1] < accept_[column] ? column : alias_[column];
+    }
+}
+
+SampledSoftmaxLoss::SampledSoftmaxLoss(const CandidateSampler& sampler, std::size_t num_sampled,
+                                       Mode mode)
+    : sampler_(sampler), num_sampled_(num_sampled), mode_(mode) {
+    if (num_sampled == 0) {
+        throw std::invalid_argument("SampledSoftmaxLoss: need at least one sample");
+    }
+}
+
+std::size_t SampledSoftmaxLoss::num_sampled() const noexcept { return num_sampled_; }
+
+SampledSoftmaxLoss::Mode SampledSoftmaxLoss::mode() const noexcept { return mode_; }
+
+SampledLossResult SampledSoftmaxLoss::compute(const Tensor2D& hidden,
+                                              std::span<const std::size_t> labels,
+                                              const Tensor2D& weights, const Tensor2D& bias,
+                                              const CounterRng& rng) const {
+    const auto batch = hidden.rows();
+    const auto dim = hidden.cols();
+    const auto classes = weights.rows();
+    if (weights.cols() != dim || bias.rows() != 1 || bias.cols() != classes ||
+        sampler_.classes() != classes) {
+        throw std::invalid_argument("SampledSoftmaxLoss::compute: shape mismatch");
+    }
+    check_labels(labels, batch, classes, "SampledSoftmaxLoss::compute: bad labels");
+    const auto count = num_sampled_;
+    const bool softmax = mode_ == Mode::Softmax;
+
+    std::vector<std::size_t> sampled(count);
+    sampler_.sample(rng, 0, sampled);
+    // Sampled logits get the bias and, for the softmax, -log(S * Q(c)), which
+    // makes sum_s exp(logit_s) an unbiased estimate of the partition
+    // function over the non-label classes. The label's logit is exact.
+    const auto sample_logit_offset = [&](std::size_t c) {
+        const Scalar b = bias.data()[c];
+        return softmax ? b - std::log(static_cast<Scalar>(count) * sampler_.probability(c)) : b;
+    };
+
+    // Sampled logits for every row at once: H * W_S^T.
+    Tensor2D ws(count, dim);
+    for (std::size_t s = 0; s < count; ++s) {
+        std::copy_n(weights.data() + sampled[s] * dim, dim, ws.data() + s * dim);
+    }
+    Tensor2D logits(batch, count);
+    gemm(1.0, {hidden.data(), batch, dim, dim, 1}, {ws.data(), dim, count, 1, dim}, 0.0,
+         {logits.data(), batch, count, count, 1});
+    std::vector<Scalar> sample_offset(count);
+    for (std::size_t s = 0; s < count; ++s) {
+        sample_offset[s] = sample_logit_offset(sampled[s]);
+    }
+
+    // Loss and dL/dlogit per row; logits is overwritten by its gradient.
+    // Accidental hits get a zero gradient and no share of the loss.
+    SampledLossResult result;
+    std::vector<Scalar> d_true(batch);
+    const Scalar inv_batch = 1.0 / static_cast<Scalar>(batch);
+    Scalar total = 0.0;
+    for (std::size_t r = 0; r < batch; ++r) {
+        const Scalar* h = hidden.data() + r * dim;
+        Scalar* l = logits.data() + r * count;
+        const Scalar t =
+            util::dot({h, dim}, {weights.data() + labels[r] * dim, dim}) + bias.data()[labels[r]];
+        for (std::size_t s = 0; s < count; ++s) {
+            l[s] = sampled[s] == labels[r] ? -std::numeric_limits<Scalar>::infinity()
+                                           : l[s] + sample_offset[s];
+        }
+        if (softmax) {
+            Scalar top = t;
+            for (std::size_t s = 0; s < count; ++s) {
+                top = std::max(top, l[s]);
+            }
+            Scalar z = std::exp(t - top);
+            for (std::size_t s = 0; s < count; ++s) {
+                l[s] = std::exp(l[s] - top);
+                z += l[s];
+            }
+            total += std::log(z) - (t - top);
+            d_true[r] = (std::exp(t - top) / z - 1.0) * inv_batch;
+            for (std::size_t s = 0; s < count; ++s) {
+                l[s] *= inv_batch / z;
+            }
+        } else {
+            total += util::softplus(-t);
+            d_true[r] = (util::sigmoid(t) - 1.0) * inv_batch;
+            for (std::size_t s = 0; s < count; ++s) {
+                if (std::isinf(l[s])) {
+                    l[s] = 0.0;
+                    continue;
+                }
+                total += util::softplus(l[s]);
+                l[s] = util::sigmoid(l[s]) * inv_batch;
+            }
+        }
+    }
+    result.loss = total * inv_batch;
+
+    // dH = dlogits * W_S + d_true * W_label.
+    result.d_hidden = Tensor2D(batch, dim);
+    gemm(1.0, {logits.data(), batch, count, count, 1}, {ws.data(), count, dim, dim, 1}, 0.0,
+         {result.d_hidden.data(), batch, dim, dim, 1});
+    for (std::size_t r = 0; r < batch; ++r) {
+        const Scalar* w = weights.data() + labels[r] * dim;
+        Scalar* dh = result.d_hidden.data() + r * dim;
+        for (std::size_t c = 0; c < dim; ++c) {
+            dh[c] += d_true[r] * w[c];
+        }
+    }
+
+    // dW_S = dlogits^T * H, then every gradient row merged per distinct
+    // class: a class sampled twice, or also a label, gets the sum.
+    Tensor2D dws(count, dim);
+    gemm(1.0, {logits.data(), count, batch, 1, count}, {hidden.data(), batch, dim, dim, 1}, 0.0,
+         {dws.data(), count, dim, dim, 1});
+    result.classes.assign(sampled.begin(), sampled.end());
+    result.classes.insert(result.classes.end(), labels.begin(), labels.end());
+    std::sort(result.classes.begin(), result.classes.end());
+    result.classes.erase(std::unique(result.classes.begin(), result.classes.end()),
+                         result.classes.end());
+    const auto row_of = [&](std::size_t c) {
+        return static_cast<std::size_t>(
+            std::lower_bound(result.classes.begin(), result.classes.end(), c) -
+            result.classes.begin());
+    };
+    result.d_weights = Tensor2D(result.classes.size(), dim);
+    result.d_bias.assign(result.classes.size(), 0.0);
+    for (std::size_t s = 0; s < count; ++s) {
+        const auto row = row_of(sampled[s]);
+        Scalar* dw = result.d_weights.data() + row * dim;
+        for (std::size_t c = 0; c < dim; ++c) {
+            dw[c] += dws.data()[s * dim + c];
+        }
+        for (std::size_t r = 0; r < batch; ++r) {
+            result.d_bias[row] += logits.data()[r * count + s];
+        }
+    }
+    for (std::size_t r = 0; r < batch; ++r) {
+        const auto row = row_of(labels[r]);
+        const Scalar* h = hidden.data() + r * dim;
+        Scalar* dw = result.d_weights.data() + row * dim;
+        for (std::size_t c = 0; c < dim; ++c) {
+            dw[c] += d_true[r] * h[c];
+        }
+        result.d_bias[row] += d_true[r];
+    }
+    return result;
+}
+
+Scalar SampledSoftmaxLoss::full_loss(const Tensor2D& hidden, std::span<const std::size_t> labels,
+                                     const Tensor2D& weights, const Tensor2D& bias) {
+    const auto batch = hidden.rows();
+    const auto dim = hidden.cols();
+    const auto classes = weights.rows();
+    if (weights.cols() != dim || bias.rows() != 1 || bias.cols() != classes) {
+        throw std::invalid_argument("SampledSoftmaxLoss::full_loss: shape mismatch");
+    }
+    check_labels(labels, batch, classes, "SampledSoftmaxLoss::full_loss: bad labels");
+
+    Tensor2D logits(std::min(batch, kFullLossRows), classes);
+    Scalar total = 0.0;
+    for (std::size_t r0 = 0; r0 < batch; r0 += kFullLossRows) {
+        const auto rows = std::min(kFullLossRows, batch - r0);
+        gemm(1.0, {hidden.data() + r0 * dim, rows, dim, dim, 1},
+             {weights.data(), dim, classes, 1, dim}, 0.0,
+             {logits.data(), rows, classes, classes, 1});
+        for (std::size_t i = 0; i < rows; ++i) {
+            const Scalar* l = logits.data() + i * classes;
+            Scalar top = -std::numeric_limits<Scalar>::infinity();
+            for (std::size_t c = 0; c < classes; ++c) {
+                top = std::max(top, l[c] + bias.data()[c]);
+            }
+            Scalar z = 0.0;
+            for (std::size_t c = 0; c < classes; ++c) {
+                z += std::exp(l[c] + bias.data()[c] - top);
+            }
+            const auto label = labels[r0 + i];
+            total += std::log(z) + top - (l[label] + bias.data()[label]);
+        }
+    }
+    return total / static_cast<Scalar>(batch);
+}
+
+void scatter_add_rows(std::span<const std::size_t> classes, const Tensor2D& rows, Scalar scale,
+                      Tensor2D& target) {
+    if (rows.rows() != classes.size() || rows.cols() != target.cols()) {
+        throw std::invalid_argument("scatter_add_rows: shape mismatch");
+    }
+    const auto dim = target.cols();
+    for (std::size_t i = 0; i < classes.size(); ++i) {
+        if (classes[i] >= target.rows()) {
+            throw std::invalid_argument("scatter_add_rows: class out of range");
+        }
+        Scalar* to = target.data() + classes[i] * dim;
+        const Scalar* from = rows.data() + i * dim;
+        for (std::size_t c = 0; c < dim; ++c) {
+            to[c] += scale * from[c];
+        }
+    }
+}
+
+} // namespace fnn
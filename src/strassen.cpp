@@ -0,0 +1,289 @@
+#include "fnn/strassen.hpp"
+#include "fnn/tensor2D.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+namespace fnn {
+
+namespace {
+
+constexpr std::size_t kDefaultCrossover = 2048;
+constexpr std::size_t kMinCrossover = 16;
+// Block additions are split over threads in chunks of about this many
+// elements.
+constexpr std::size_t kAddChunk = std::size_t{1} << 15;
+
+std::size_t initial_crossover() {
+    if (const char* env = std::getenv("FNN_STRASSEN_CROSSOVER")) {
+        const auto v = std::strtoull(env, nullptr, 10);
+        if (v >= kMinCrossover) {
+            return v;
+        }
+    }
+    return kDefaultCrossover;
+}
+
+std::atomic<std::size_t>& crossover_setting() {
+    static std::atomic<std::size_t> value{initial_crossover()};
+    return value;
+}
+
+std::size_t resolve_crossover(const StrassenConfig& config) {
+    if (config.crossover == 0) {
+        return strassen_crossover();
+    }
+    if (config.crossover < kMinCrossover) {
+        throw std::invalid_argument("gemm_strassen: crossover must be at least 16");
+    }
+    return config.crossover;
+}
+
+MatrixRef block(const MatrixRef& x, std::size_t i, std::size_t j, std::size_t rows,
+                std::size_t cols) {
+    return {x.data + i * x.row_stride + j * x.col_stride, rows, cols, x.row_stride,
+            x.col_stride};
+}
+
+MutableMatrixRef block(const MutableMatrixRef& x, std::size_t i, std::size_t j, std::size_t rows,
+                       std::size_t cols) {
+    return {x.data + i * x.row_stride + j * x.col_stride, rows, cols, x.row_stride,
+            x.col_stride};
+}
+
+MatrixRef as_const(const MutableMatrixRef& x) {
+    return {x.data, x.rows, x.cols, x.row_stride, x.col_stride};
+}
+
+// out = x + sign * y, element-wise; out may be x or y.
+void combine(const MutableMatrixRef& out, const MatrixRef& x, const MatrixRef& y, Scalar sign) {
+    const auto grain = std::max<std::size_t>(1, kAddChunk / std::max<std::size_t>(out.cols, 1));
+    util::parallel_for(0, out.rows, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            Scalar* o = out.data + i * out.row_stride;
+            const Scalar* xr = x.data + i * x.row_stride;
+            const Scalar* yr = y.data + i * y.row_stride;
+            for (std::size_t j = 0; j < out.cols; ++j) {
+                o[j * out.col_stride] = xr[j * x.col_stride] + sign * yr[j * y.col_stride];
+            }
+        }
+    });
+}
+
+bool recurses(std::size_t m, std::size_t n, std::size_t k, std::size_t crossover,
+              std::size_t depth) {
+    return depth > 0 && std::min({m, n, k}) >= crossover;
+}
+
+std::size_t level_workspace(std::size_t m, std::size_t n, std::size_t k, std::size_t crossover,
+                            std::size_t depth) {
+    if (!recurses(m, n, k, crossover, depth)) {
+        return 0;
+    }
+    const auto mh = m / 2;
+    const auto nh = n / 2;
+    const auto kh = k / 2;
+    // The levels below run one after another and share what follows.
+    return mh * kh + kh * nh + mh * nh + level_workspace(mh, nh, kh, crossover, depth - 1);
+}
+
+// C = A * B (C is overwritten). ws holds level_workspace() Scalars.
+void winograd(const MatrixRef& a, const MatrixRef& b, const MutableMatrixRef& c, Scalar* ws,
+              std::size_t crossover, std::size_t depth) {
+    const auto m = c.rows;
+    const auto n = c.cols;
+    const auto k = a.cols;
+    if (!recurses(m, n, k, crossover, depth)) {
+        gemm(1.0, a, b, 0.0, c);
+        return;
+    }
+    const auto mh = m / 2;
+    const auto nh = n / 2;
+    const auto kh = k / 2;
+    const auto a11 = block(a, 0, 0, mh, kh);
+    const auto a12 = block(a, 0, kh, mh, kh);
+    const auto a21 = block(a, mh, 0, mh, kh);
+    const auto a22 = block(a, mh, kh, mh, kh);
+    const auto b11 = block(b, 0, 0, kh, nh);
+    const auto b12 = block(b, 0, nh, kh, nh);
+    const auto b21 = block(b, kh, 0, kh, nh);
+    const auto b22 = block(b, kh, nh, kh, nh);
+    const auto c11 = block(c, 0, 0, mh, nh);
+    const auto c12 = block(c, 0, nh, mh, nh);
+    const auto c21 = block(c, mh, 0, mh, nh);
+    const auto c22 = block(c, mh, nh, mh, nh);
+    // Three temporaries: X for sums of A blocks, Y for sums of B blocks and
+    // Z for one product; the C blocks hold the other partial results.
+    const MutableMatrixRef x{ws, mh, kh, kh, 1};
+    const MutableMatrixRef y{x.data + mh * kh, kh, nh, nh, 1};
+    const MutableMatrixRef z{y.data + kh * nh, mh, nh, nh, 1};
+    Scalar* rest = z.data + mh * nh;
+    const auto product = [&](const MatrixRef& l, const MatrixRef& r, const MutableMatrixRef& out) {
+        winograd(l, r, out, rest, crossover, depth - 1);
+    };
+
+    combine(x, a11, a21, -1.0);                       // S3
+    combine(y, b22, b12, -1.0);                       // T3
+    product(as_const(x), as_const(y), c21);           // P7
+    combine(x, a21, a22, 1.0);                        // S1
+    combine(y, b12, b11, -1.0);                       // T1
+    product(as_const(x), as_const(y), c22);           // P5
+    combine(x, as_const(x), a11, -1.0);               // S2
+    combine(y, b22, as_const(y), -1.0);               // T2
+    product(as_const(x), as_const(y), c12);           // P6
+    combine(x, a12, as_const(x), -1.0);               // S4
+    product(a11, b11, z);                             // P1
+    combine(c12, as_const(c12), as_const(z), 1.0);    // U2 = P1 + P6
+    combine(c21, as_const(c21), as_const(c12), 1.0);  // U3 = U2 + P7
+    combine(c12, as_const(c12), as_const(c22), 1.0);  // U4 = U2 + P5
+    combine(c22, as_const(c21), as_const(c22), 1.0);  // C22 = U3 + P5
+    product(a12, b21, c11);                           // P2
+    combine(c11, as_const(c11), as_const(z), 1.0);    // C11 = P1 + P2
+    product(as_const(x), b22, z);                     // P3
+    combine(c12, as_const(c12), as_const(z), 1.0);    // C12 = U4 + P3
+    combine(y, as_const(y), b21, -1.0);               // T4
+    product(a22, as_const(y), z);                     // P4
+    combine(c21, as_const(c21), as_const(z), -1.0);   // C21 = U3 - P4
+
+    // Odd dimensions: the even-sized core is done; peel off the rest.
+    if (k > 2 * kh) {
+        gemm(1.0, block(a, 0, 2 * kh, 2 * mh, 1), block(b, 2 * kh, 0, 1, 2 * nh), 1.0,
+             block(c, 0, 0, 2 * mh, 2 * nh));
+    }
+    if (n > 2 * nh) {
+        gemm(1.0, a, block(b, 0, 2 * nh, k, 1), 0.0, block(c, 0, 2 * nh, m, 1));
+    }
+    if (m > 2 * mh) {
+        gemm(1.0, block(a, 2 * mh, 0, 1, k), block(b, 0, 0, k, 2 * nh), 0.0,
+             block(c, 2 * mh, 0, 1, 2 * nh));
+    }
+}
+
+double time_once(const std::vector<Scalar>& a, const std::vector<Scalar>& b,
+                 std::vector<Scalar>& c, std::size_t n, const StrassenConfig* config) {
+    const MatrixRef av{a.data(), n, n, n, 1};
+    const MatrixRef bv{b.data(), n, n, n, 1};
+    const MutableMatrixRef cv{c.data(), n, n, n, 1};
+    double best = 0.0;
+    for (int rep = 0; rep < 2; ++rep) {
+        const auto start = std::chrono::steady_clock::now();
+        if (config == nullptr) {
+            gemm(1.0, av, bv, 0.0, cv);
+        } else {
+            gemm_strassen(1.0, av, bv, 0.0, cv, *config);
+        }
+        const std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        best = rep == 0 ? took.count() : std::min(best, took.count());
+    }
+    return best;
+}
+
+} // namespace
+
+std::size_t strassen_crossover() { return crossover_setting().load(std::memory_order_relaxed); }
+
+void set_strassen_crossover(std::size_t crossover) {
+    if (crossover < kMinCrossover) {
+        throw std::invalid_argument("set_strassen_crossover: crossover must be at least 16");
+    }
+    crossover_setting().store(crossover, std::memory_order_relaxed);
+}
+
+std::size_t tune_strassen_crossover(std::size_t n) {
+    std::size_t winner = 0;
+    for (auto s = n; s >= 256; s /= 2) {
+        std::vector<Scalar> a(s * s);
+        std::vector<Scalar> b(s * s);
+        std::vector<Scalar> c(s * s);
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            a[i] = static_cast<Scalar>(i % 7) - 3.0;
+            b[i] = static_cast<Scalar>(i % 5) - 2.0;
+        }
+        const StrassenConfig one_level{s, 1};
+        if (time_once(a, b, c, s, &one_level) >= time_once(a, b, c, s, nullptr)) {
+            break;
+        }
+        winner = s;
+    }
+    if (winner != 0) {
+        set_strassen_crossover(winner);
+    }
+    return winner;
+}
+
+std::size_t strassen_workspace_size(std::size_t m, std::size_t n, std::size_t k, Scalar alpha,
+                                    Scalar beta, const StrassenConfig& config) {
+    const auto crossover = resolve_crossover(config);
+    if (!recurses(m, n, k, crossover, config.max_depth)) {
+        return 0;
+    }
+    const auto result = alpha == 1.0 && beta == 0.0 ? 0 : m * n;
+    return result + level_workspace(m, n, k, crossover, config.max_depth);
+}
+
+void gemm_strassen(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                   const MutableMatrixRef& c, std::span<Scalar> workspace,
+                   const StrassenConfig& config) {
+    if (a.cols != b.rows || a.rows != c.rows || b.cols != c.cols) {
+        throw std::invalid_argument("gemm_strassen: shape mismatch");
+    }
+    const auto m = c.rows;
+    const auto n = c.cols;
+    const auto k = a.cols;
+    const auto crossover = resolve_crossover(config);
+    if (alpha == 0.0 || !recurses(m, n, k, crossover, config.max_depth)) {
+        gemm(alpha, a, b, beta, c);
+        return;
+    }
+    if (workspace.size() < strassen_workspace_size(m, n, k, alpha, beta, config)) {
+        throw std::length_error("gemm_strassen: workspace too small");
+    }
+    if (alpha == 1.0 && beta == 0.0) {
+        winograd(a, b, c, workspace.data(), crossover, config.max_depth);
+        return;
+    }
+    // The recursion overwrites its output, so scaling needs a separate
+    // product buffer.
+    const MutableMatrixRef t{workspace.data(), m, n, n, 1};
+    winograd(a, b, t, workspace.data() + m * n, crossover, config.max_depth);
+    const auto grain = std::max<std::size_t>(1, kAddChunk / n);
+    util::parallel_for(0, m, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            const Scalar* src = t.data + i * n;
+            Scalar* dst = c.data + i * c.row_stride;
+            for (std::size_t j = 0; j < n; ++j) {
+                Scalar& v = dst[j * c.col_stride];
+                v = beta == 0.0 ? alpha * src[j] : alpha * src[j] + beta * v;
+            }
+        }
+    });
+}
+
+void gemm_strassen(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                   const MutableMatrixRef& c, const StrassenConfig& config) {
+    // Reused across calls on the same thread.
+    thread_local std::vector<Scalar> workspace;
+    const auto needed = strassen_workspace_size(c.rows, c.cols, a.cols, alpha, beta, config);
+    if (workspace.size() < needed) {
+        workspace.resize(needed);
+    }
+    gemm_strassen(alpha, a, b, beta, c, workspace, config);
+}
+
+Tensor2D matmul_strassen(const Tensor2D& a, const Tensor2D& b, const StrassenConfig& config) {
+    if (a.cols() != b.rows()) {
+        throw std::invalid_argument("matmul_strassen: inner dimensions must match");
+    }
+    Tensor2D out(a.rows(), b.cols());
+    gemm_strassen(1.0, {a.data(), a.rows(), a.cols(), a.cols(), 1},
+                  {b.data(), b.rows(), b.cols(), b.cols(), 1}, 0.0,
+                  {out.data(), out.rows(), out.cols(), out.cols(), 1}, config);
+    return out;
+}
+
+} // namespace fnn
@@ -10,9 +10,11 @@ Tensor::Tensor(Dims dims) : dims_(std::move(dims)) {
     data_.resize(count);
 }
 
-size_t Tensor::numel() { return util::product(dims_, "Tensor::numel overflows size_t"); }
+size_t Tensor::numel() const { return util::product(dims_, "Tensor::numel overflows size_t"); }
 
-Dims Tensor::shape() { return dims_; }
+Dims Tensor::shape() const { return dims_; }
+
+const Dims& Tensor::dims() const noexcept { return dims_; }
 
 void Tensor::reshape(Dims dims) {
     const auto old_count = numel();
@@ -24,4 +26,8 @@ void Tensor::reshape(Dims dims) {
     dims_ = std::move(dims);
 }
 
+Scalar* Tensor::data() noexcept { return data_.data(); }
+
+const Scalar* Tensor::data() const noexcept { return data_.data(); }
+
 } // namespace fnn
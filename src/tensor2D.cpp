@@ -1,4 +1,5 @@
 #include "fnn/tensor2D.hpp"
+#include "fnn/backend.hpp"
 
 // Source responsibilities (best practice):
 // - Define functions declared in the header.
@@ -29,4 +30,71 @@ void Tensor2D::reshape(std::size_t new_rows, std::size_t new_cols) {
 
 Shape Tensor2D::shape() const noexcept { return {rows_, cols_}; }
 
+std::size_t Tensor2D::rows() const noexcept { return rows_; }
+
+std::size_t Tensor2D::cols() const noexcept { return cols_; }
+
+std::size_t Tensor2D::size() const noexcept { return data_.size(); }
+
+Scalar& Tensor2D::operator()(std::size_t row, std::size_t col) {
+    return data_.data()[row * cols_ + col];
+}
+
+Scalar Tensor2D::operator()(std::size_t row, std::size_t col) const {
+    return data_.data()[row * cols_ + col];
+}
+
+Scalar* Tensor2D::data() noexcept { return data_.data(); }
+
+const Scalar* Tensor2D::data() const noexcept { return data_.data(); }
+
+namespace {
+
+MatrixRef view(const Tensor2D& m) { return {m.data(), m.rows(), m.cols(), m.cols(), 1}; }
+
+Tensor2D elementwise(BinaryOp op, const Tensor2D& a, const Tensor2D& b) {
+    if (a.rows() != b.rows() || a.cols() != b.cols()) {
+        throw std::invalid_argument("Tensor2D: element-wise operands must have the same shape");
+    }
+    Tensor2D out(a.rows(), a.cols());
+    active_backend().elementwise(op, a.data(), b.data(), out.data(), out.size());
+    return out;
+}
+
+} // namespace
+
+Tensor2D matmul(const Tensor2D& a, const Tensor2D& b) {
+    if (a.cols() != b.rows()) {
+        throw std::invalid_argument("matmul: inner dimensions must match");
+    }
+    Tensor2D out(a.rows(), b.cols());
+    active_backend().matmul(1.0, view(a), view(b), 0.0,
+                            {out.data(), out.rows(), out.cols(), out.cols(), 1});
+    return out;
+}
+
+Tensor2D add(const Tensor2D& a, const Tensor2D& b) { return elementwise(BinaryOp::Add, a, b); }
+
+Tensor2D sub(const Tensor2D& a, const Tensor2D& b) { return elementwise(BinaryOp::Sub, a, b); }
+
+Tensor2D mul(const Tensor2D& a, const Tensor2D& b) { return elementwise(BinaryOp::Mul, a, b); }
+
+Tensor2D column_sums(const Tensor2D& m) {
+    Tensor2D out(1, m.cols());
+    active_backend().reduce_sum(view(m), ReduceAxis::Rows, out.data());
+    return out;
+}
+
+Tensor2D row_sums(const Tensor2D& m) {
+    Tensor2D out(m.rows(), 1);
+    active_backend().reduce_sum(view(m), ReduceAxis::Cols, out.data());
+    return out;
+}
+
+Tensor2D activate(const Tensor2D& m, ActivationKind kind, Scalar alpha) {
+    Tensor2D out(m.rows(), m.cols());
+    active_backend().activation(kind, alpha, m.data(), out.data(), out.size());
+    return out;
+}
+
 } // namespace fnn
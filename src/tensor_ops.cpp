@@ -0,0 +1,137 @@
+#include "fnn/tensor_ops.hpp"
+
+#include <stdexcept>
+
+namespace fnn {
+
+namespace detail {
+
+BroadcastPlan make_broadcast_plan(std::initializer_list<const Dims*> inputs) {
+    if (inputs.size() == 0 || inputs.size() > kMaxBroadcastInputs) {
+        throw std::invalid_argument("broadcast: expected between 1 and 3 inputs");
+    }
+
+    BroadcastPlan plan;
+    plan.num_inputs = inputs.size();
+
+    std::size_t rank = 0;
+    for (const Dims* dims : inputs) {
+        rank = std::max(rank, dims->size());
+    }
+
+    // Right-align all shapes and broadcast.
+    plan.out_shape.assign(rank, 1);
+    for (const Dims* dims : inputs) {
+        const auto offset = rank - dims->size();
+        for (std::size_t j = 0; j < dims->size(); ++j) {
+            auto& o = plan.out_shape[offset + j];
+            const auto d = (*dims)[j];
+            if (o == 1) {
+                o = d;
+            } else if (d != 1 && d != o) {
+                throw std::invalid_argument("broadcast: incompatible shapes");
+            }
+        }
+    }
+
+    // Full-rank strides per input, 0 along broadcast dimensions.
+    std::array<std::vector<std::size_t>, kMaxBroadcastInputs> full;
+    std::size_t k = 0;
+    for (const Dims* dims : inputs) {
+        full[k].assign(rank, 0);
+        const auto offset = rank - dims->size();
+        std::size_t stride = 1;
+        for (std::size_t j = dims->size(); j-- > 0;) {
+            const auto d = (*dims)[j];
+            full[k][offset + j] = d == 1 ? 0 : stride;
+            stride *= d;
+        }
+        ++k;
+    }
+
+    const bool empty = std::find(plan.out_shape.begin(), plan.out_shape.end(), std::size_t{0}) !=
+                       plan.out_shape.end();
+    if (!empty) {
+        // Drop size-1 dimensions and merge an outer dimension into the next
+        // inner one when every input (and the dense output) is contiguous
+        // across the pair.
+        for (std::size_t i = 0; i < rank; ++i) {
+            const auto extent = plan.out_shape[i];
+            if (extent == 1) {
+                continue;
+            }
+            bool mergeable = !plan.loop.empty();
+            for (std::size_t n = 0; mergeable && n < plan.num_inputs; ++n) {
+                mergeable = plan.strides[n].back() == full[n][i] * extent;
+            }
+            if (mergeable) {
+                plan.loop.back() *= extent;
+                for (std::size_t n = 0; n < plan.num_inputs; ++n) {
+                    plan.strides[n].back() = full[n][i];
+                }
+            } else {
+                plan.loop.push_back(extent);
+                for (std::size_t n = 0; n < plan.num_inputs; ++n) {
+                    plan.strides[n].push_back(full[n][i]);
+                }
+            }
+        }
+    }
+
+    if (empty || plan.loop.empty()) {
+        // Either nothing to do, or a single element.
+        plan.loop = {empty ? std::size_t{0} : std::size_t{1}};
+        for (std::size_t n = 0; n < plan.num_inputs; ++n) {
+            plan.strides[n] = {0};
+        }
+    }
+
+    plan.row_length = plan.loop.back();
+    plan.rows = 1;
+    for (std::size_t i = 0; i + 1 < plan.loop.size(); ++i) {
+        plan.rows *= plan.loop[i];
+    }
+    return plan;
+}
+
+void check_inplace_shape(const BroadcastPlan& plan, const Dims& dest, const char* what) {
+    if (plan.out_shape != dest) {
+        throw std::invalid_argument(what);
+    }
+}
+
+} // namespace detail
+
+Tensor add(const Tensor& a, const Tensor& b) {
+    return binary(a, b, [](Scalar x, Scalar y) { return x + y; });
+}
+
+Tensor sub(const Tensor& a, const Tensor& b) {
+    return binary(a, b, [](Scalar x, Scalar y) { return x - y; });
+}
+
+Tensor mul(const Tensor& a, const Tensor& b) {
+    return binary(a, b, [](Scalar x, Scalar y) { return x * y; });
+}
+
+Tensor div(const Tensor& a, const Tensor& b) {
+    return binary(a, b, [](Scalar x, Scalar y) { return x / y; });
+}
+
+Tensor maximum(const Tensor& a, const Tensor& b) {
+    return binary(a, b, [](Scalar x, Scalar y) { return x > y ? x : y; });
+}
+
+Tensor fma(const Tensor& a, const Tensor& b, const Tensor& c) {
+    return ternary(a, b, c, [](Scalar x, Scalar y, Scalar z) { return x * y + z; });
+}
+
+void add_inplace(Tensor& a, const Tensor& b) {
+    binary_inplace(a, b, [](Scalar x, Scalar y) { return x + y; });
+}
+
+void mul_inplace(Tensor& a, const Tensor& b) {
+    binary_inplace(a, b, [](Scalar x, Scalar y) { return x * y; });
+}
+
+} // namespace fnn
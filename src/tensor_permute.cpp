@@ -0,0 +1,280 @@
+#include "fnn/tensor_permute.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace fnn {
+
+namespace {
+
+// Tile edge in elements: a 32x32 tile of doubles is 8 KiB per side, so the
+// source and destination tiles stay in L1 while being transposed.
+constexpr std::size_t kTile = 32;
+// Elements per thread-pool chunk.
+constexpr std::size_t kGrain = std::size_t{1} << 15;
+
+#if defined(__AVX__)
+// 4x4 in-register transpose.
+inline void transpose4x4(const Scalar* src, std::size_t src_ld, Scalar* dst, std::size_t dst_ld) {
+    const __m256d r0 = _mm256_loadu_pd(src);
+    const __m256d r1 = _mm256_loadu_pd(src + src_ld);
+    const __m256d r2 = _mm256_loadu_pd(src + 2 * src_ld);
+    const __m256d r3 = _mm256_loadu_pd(src + 3 * src_ld);
+    const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + dst_ld, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2 * dst_ld, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3 * dst_ld, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+constexpr std::size_t kMicro = 4;
+#elif defined(__SSE2__)
+// 2x2 in-register transpose.
+inline void transpose2x2(const Scalar* src, std::size_t src_ld, Scalar* dst, std::size_t dst_ld) {
+    const __m128d r0 = _mm_loadu_pd(src);
+    const __m128d r1 = _mm_loadu_pd(src + src_ld);
+    _mm_storeu_pd(dst, _mm_unpacklo_pd(r0, r1));
+    _mm_storeu_pd(dst + dst_ld, _mm_unpackhi_pd(r0, r1));
+}
+constexpr std::size_t kMicro = 2;
+#else
+constexpr std::size_t kMicro = 1;
+#endif
+
+// Transposes one tile of at most kTile x kTile elements.
+void transpose_tile(const Scalar* src, std::size_t src_ld, Scalar* dst, std::size_t dst_ld,
+                    std::size_t rows, std::size_t cols) {
+    const auto rows_m = rows - rows % kMicro;
+    const auto cols_m = cols - cols % kMicro;
+    for (std::size_t i = 0; i < rows_m; i += kMicro) {
+        for (std::size_t j = 0; j < cols_m; j += kMicro) {
+#if defined(__AVX__)
+            transpose4x4(src + i * src_ld + j, src_ld, dst + j * dst_ld + i, dst_ld);
+#elif defined(__SSE2__)
+            transpose2x2(src + i * src_ld + j, src_ld, dst + j * dst_ld + i, dst_ld);
+#else
+            dst[j * dst_ld + i] = src[i * src_ld + j];
+#endif
+        }
+        for (auto j = cols_m; j < cols; ++j) {
+            for (std::size_t k = i; k < i + kMicro; ++k) {
+                dst[j * dst_ld + k] = src[k * src_ld + j];
+            }
+        }
+    }
+    for (auto i = rows_m; i < rows; ++i) {
+        for (std::size_t j = 0; j < cols; ++j) {
+            dst[j * dst_ld + i] = src[i * src_ld + j];
+        }
+    }
+}
+
+// A collapsed dimension with its stride in the input and in the output.
+struct Dim {
+    std::size_t extent;
+    std::size_t in_stride;
+    std::size_t out_stride;
+};
+
+// Offsets of the "other" dimensions for a linear index.
+void offsets_of(const std::vector<Dim>& dims, std::size_t linear, std::size_t& in_off,
+                std::size_t& out_off) {
+    in_off = 0;
+    out_off = 0;
+    for (std::size_t d = dims.size(); d-- > 0;) {
+        const auto i = linear % dims[d].extent;
+        linear /= dims[d].extent;
+        in_off += i * dims[d].in_stride;
+        out_off += i * dims[d].out_stride;
+    }
+}
+
+} // namespace
+
+void transpose_strided(const Scalar* src, std::size_t src_ld, Scalar* dst, std::size_t dst_ld,
+                       std::size_t rows, std::size_t cols) {
+    for (std::size_t i0 = 0; i0 < rows; i0 += kTile) {
+        for (std::size_t j0 = 0; j0 < cols; j0 += kTile) {
+            transpose_tile(src + i0 * src_ld + j0, src_ld, dst + j0 * dst_ld + i0, dst_ld,
+                           std::min(kTile, rows - i0), std::min(kTile, cols - j0));
+        }
+    }
+}
+
+Tensor permute(const Tensor& t, const std::vector<std::size_t>& perm) {
+    const auto& dims = t.dims();
+    const auto rank = dims.size();
+    if (perm.size() != rank) {
+        throw std::invalid_argument("permute: perm must list every dimension once");
+    }
+    std::vector<bool> seen(rank, false);
+    for (const auto p : perm) {
+        if (p >= rank || seen[p]) {
+            throw std::invalid_argument("permute: perm must list every dimension once");
+        }
+        seen[p] = true;
+    }
+
+    Dims out_dims(rank);
+    for (std::size_t i = 0; i < rank; ++i) {
+        out_dims[i] = dims[perm[i]];
+    }
+    Tensor out(out_dims);
+    const auto n = out.numel();
+    if (n == 0) {
+        return out;
+    }
+
+    // Strides of every input dimension, in the input and in the output.
+    std::vector<std::size_t> in_stride(rank);
+    std::vector<std::size_t> out_stride(rank);
+    for (std::size_t i = rank, s = 1; i-- > 0;) {
+        in_stride[i] = s;
+        s *= dims[i];
+    }
+    for (std::size_t i = rank, s = 1; i-- > 0;) {
+        out_stride[perm[i]] = s;
+        s *= out_dims[i];
+    }
+
+    // Collapse in output order: drop size-1 dims and merge neighbours that
+    // are also neighbours (in the same order) in the input.
+    std::vector<Dim> collapsed;
+    for (std::size_t i = 0; i < rank; ++i) {
+        const auto d = perm[i];
+        if (dims[d] == 1) {
+            continue;
+        }
+        if (!collapsed.empty() && collapsed.back().in_stride == in_stride[d] * dims[d]) {
+            collapsed.back().extent *= dims[d];
+            collapsed.back().in_stride = in_stride[d];
+            collapsed.back().out_stride = out_stride[d];
+        } else {
+            collapsed.push_back({dims[d], in_stride[d], out_stride[d]});
+        }
+    }
+
+    const Scalar* src = t.data();
+    Scalar* dst = out.data();
+    if (collapsed.size() <= 1) {
+        std::memcpy(dst, src, n * sizeof(Scalar));
+        return out;
+    }
+
+    // b: innermost in the output; a: innermost in the input.
+    const auto b_it = collapsed.end() - 1;
+    const auto a_it = std::find_if(collapsed.begin(), collapsed.end(),
+                                   [](const Dim& d) { return d.in_stride == 1; });
+    const Dim a = *a_it;
+    const Dim b = *b_it;
+
+    if (a_it == b_it) {
+        // The innermost dimension survives: copy contiguous runs.
+        std::vector<Dim> others(collapsed.begin(), collapsed.end() - 1);
+        const auto runs = n / a.extent;
+        const auto grain = std::max<std::size_t>(1, kGrain / a.extent);
+        util::parallel_for(0, runs, grain, [&](std::size_t lo, std::size_t hi) {
+            for (auto r = lo; r < hi; ++r) {
+                std::size_t in_off = 0;
+                std::size_t out_off = 0;
+                offsets_of(others, r, in_off, out_off);
+                std::memcpy(dst + out_off, src + in_off, a.extent * sizeof(Scalar));
+            }
+        });
+        return out;
+    }
+
+    // Otherwise every (other index, tile row block) is a 2-D transpose of
+    // the (b, a) plane: rows indexed by b, columns by a in the source.
+    std::vector<Dim> others;
+    for (auto it = collapsed.begin(); it != collapsed.end(); ++it) {
+        if (it != a_it && it != b_it) {
+            others.push_back(*it);
+        }
+    }
+    const auto planes = n / (a.extent * b.extent);
+    const auto row_blocks = (b.extent + kTile - 1) / kTile;
+    const auto grain = std::max<std::size_t>(1, kGrain / (kTile * a.extent));
+    util::parallel_for(0, planes * row_blocks, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto task = lo; task < hi; ++task) {
+            std::size_t in_off = 0;
+            std::size_t out_off = 0;
+            offsets_of(others, task / row_blocks, in_off, out_off);
+            const auto i0 = (task % row_blocks) * kTile;
+            transpose_strided(src + in_off + i0 * b.in_stride, b.in_stride,
+                              dst + out_off + i0, a.out_stride, std::min(kTile, b.extent - i0),
+                              a.extent);
+        }
+    });
+    return out;
+}
+
+Tensor2D transpose(const Tensor2D& m) {
+    const auto rows = m.rows();
+    const auto cols = m.cols();
+    Tensor2D out(cols, rows);
+    const Scalar* src = m.data();
+    Scalar* dst = out.data();
+    const auto row_blocks = (rows + kTile - 1) / kTile;
+    const auto grain = std::max<std::size_t>(1, kGrain / (kTile * std::max<std::size_t>(cols, 1)));
+    util::parallel_for(0, row_blocks, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto blk = lo; blk < hi; ++blk) {
+            const auto i0 = blk * kTile;
+            transpose_strided(src + i0 * cols, cols, dst + i0, rows, std::min(kTile, rows - i0),
+                              cols);
+        }
+    });
+    return out;
+}
+
+Tensor to_nchwc(const Tensor& nchw) {
+    const auto& d = nchw.dims();
+    if (d.size() != 4) {
+        throw std::invalid_argument("to_nchwc: expected (N, C, H, W)");
+    }
+    const auto blocks = (d[1] + kChannelBlock - 1) / kChannelBlock;
+    const auto plane = d[2] * d[3];
+    Tensor out({d[0], blocks, d[2], d[3], kChannelBlock});
+    // Each (image, block) is a channels x plane -> plane x 8 transpose.
+    util::parallel_for(0, d[0] * blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            const auto n = i / blocks;
+            const auto c0 = i % blocks * kChannelBlock;
+            transpose_strided(nchw.data() + (n * d[1] + c0) * plane, plane,
+                              out.data() + i * plane * kChannelBlock, kChannelBlock,
+                              std::min(kChannelBlock, d[1] - c0), plane);
+        }
+    });
+    return out;
+}
+
+Tensor from_nchwc(const Tensor& blocked, std::size_t channels) {
+    const auto& d = blocked.dims();
+    if (d.size() != 5 || d[4] != kChannelBlock || d[1] * kChannelBlock < channels) {
+        throw std::invalid_argument("from_nchwc: expected (N, C / 8, H, W, 8)");
+    }
+    const auto blocks = (channels + kChannelBlock - 1) / kChannelBlock;
+    const auto plane = d[2] * d[3];
+    Tensor out({d[0], channels, d[2], d[3]});
+    util::parallel_for(0, d[0] * blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            const auto n = i / blocks;
+            const auto b = i % blocks;
+            const auto c0 = b * kChannelBlock;
+            transpose_strided(blocked.data() + (n * d[1] + b) * plane * kChannelBlock,
+                              kChannelBlock, out.data() + (n * channels + c0) * plane, plane,
+                              plane, std::min(kChannelBlock, channels - c0));
+        }
+    });
+    return out;
+}
+
+} // namespace fnn
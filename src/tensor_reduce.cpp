@@ -0,0 +1,241 @@
+#include "fnn/tensor_reduce.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace fnn {
+
+namespace {
+
+// Elements per thread-pool chunk.
+constexpr std::size_t kGrain = std::size_t{1} << 15;
+// When the innermost dimension is kept, tasks own this many output columns
+// so concurrent tasks never write the same element.
+constexpr std::size_t kColumnBlock = 256;
+
+struct SumOp {
+    static constexpr Scalar kInit = 0.0;
+    static Scalar combine(Scalar a, Scalar b) noexcept { return a + b; }
+};
+
+struct MaxOp {
+    static constexpr Scalar kInit = -std::numeric_limits<Scalar>::infinity();
+    static Scalar combine(Scalar a, Scalar b) noexcept { return a > b ? a : b; }
+};
+
+// A run of adjacent input dimensions that are all reduced or all kept.
+struct Group {
+    std::size_t extent;
+    std::size_t stride;
+};
+
+// Walks the offsets of a set of groups in row-major order.
+class Odometer {
+public:
+    explicit Odometer(const std::vector<Group>& groups) : groups_(groups), idx_(groups.size()) {}
+
+    void seek(std::size_t linear) {
+        offset_ = 0;
+        for (std::size_t d = groups_.size(); d-- > 0;) {
+            idx_[d] = linear % groups_[d].extent;
+            linear /= groups_[d].extent;
+            offset_ += idx_[d] * groups_[d].stride;
+        }
+    }
+
+    void next() {
+        for (std::size_t d = groups_.size(); d-- > 0;) {
+            offset_ += groups_[d].stride;
+            if (++idx_[d] < groups_[d].extent) {
+                return;
+            }
+            offset_ -= groups_[d].stride * groups_[d].extent;
+            idx_[d] = 0;
+        }
+    }
+
+    [[nodiscard]] std::size_t offset() const noexcept { return offset_; }
+
+private:
+    const std::vector<Group>& groups_;
+    std::vector<std::size_t> idx_;
+    std::size_t offset_{0};
+};
+
+std::size_t count_of(const std::vector<Group>& groups) {
+    std::size_t n = 1;
+    for (const auto& g : groups) {
+        n *= g.extent;
+    }
+    return n;
+}
+
+// Four independent accumulators so the loop vectorizes without reassociation.
+template <typename Op>
+Scalar reduce_contiguous(const Scalar* p, std::size_t n) {
+    Scalar acc[4] = {Op::kInit, Op::kInit, Op::kInit, Op::kInit};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            acc[k] = Op::combine(acc[k], p[i + k]);
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] = Op::combine(acc[0], p[i]);
+    }
+    return Op::combine(Op::combine(acc[0], acc[1]), Op::combine(acc[2], acc[3]));
+}
+
+std::vector<bool> reduced_flags(const Dims& dims, const Axes& axes, const char* what) {
+    std::vector<bool> reduced(dims.size(), axes.empty());
+    for (const auto a : axes) {
+        if (a >= dims.size() || reduced[a]) {
+            throw std::invalid_argument(what);
+        }
+        reduced[a] = true;
+    }
+    return reduced;
+}
+
+template <typename Op>
+Tensor reduce(const Tensor& t, const Axes& axes, bool keepdims, const char* what,
+              std::size_t* reduced_count = nullptr) {
+    const auto& dims = t.dims();
+    const auto reduced = reduced_flags(dims, axes, what);
+
+    Dims out_dims;
+    std::size_t count = 1;
+    for (std::size_t i = 0; i < dims.size(); ++i) {
+        if (!reduced[i]) {
+            out_dims.push_back(dims[i]);
+        } else {
+            count *= dims[i];
+            if (keepdims) {
+                out_dims.push_back(1);
+            }
+        }
+    }
+    if (reduced_count != nullptr) {
+        *reduced_count = count;
+    }
+
+    Tensor out(out_dims);
+    Scalar* o = out.data();
+    const auto out_n = out.numel();
+    if (out_n == 0) {
+        return out;
+    }
+    std::fill(o, o + out_n, Op::kInit);
+    if (count == 0) {
+        return out;
+    }
+
+    // Collapse into alternating reduced/kept groups, dropping size-1 dims.
+    std::vector<Group> kept_groups;
+    std::vector<Group> reduced_groups;
+    bool inner_reduced = false;
+    bool have_last = false;
+    bool last_reduced = false;
+    std::size_t stride = 1;
+    std::vector<std::pair<Group, bool>> groups;
+    for (std::size_t i = dims.size(); i-- > 0;) {
+        if (dims[i] == 1) {
+            continue;
+        }
+        if (have_last && last_reduced == reduced[i]) {
+            groups.back().first.extent *= dims[i];
+        } else {
+            groups.push_back({{dims[i], stride}, reduced[i]});
+        }
+        have_last = true;
+        last_reduced = reduced[i];
+        stride *= dims[i];
+    }
+    if (groups.empty()) {
+        o[0] = Op::combine(Op::kInit, t.data()[0]);
+        return out;
+    }
+    std::reverse(groups.begin(), groups.end());
+    const Group inner = groups.back().first;
+    inner_reduced = groups.back().second;
+    groups.pop_back();
+    for (const auto& [g, r] : groups) {
+        (r ? reduced_groups : kept_groups).push_back(g);
+    }
+
+    const Scalar* in = t.data();
+    const auto outer_kept = count_of(kept_groups);
+    const auto reduced_outer = count_of(reduced_groups);
+
+    if (inner_reduced) {
+        // Each output element reduces reduced_outer contiguous runs.
+        const auto work = inner.extent * reduced_outer;
+        const auto grain = std::max<std::size_t>(1, kGrain / work);
+        util::parallel_for(0, outer_kept, grain, [&](std::size_t lo, std::size_t hi) {
+            Odometer kept(kept_groups);
+            Odometer red(reduced_groups);
+            kept.seek(lo);
+            for (auto e = lo; e < hi; ++e, kept.next()) {
+                Scalar acc = Op::kInit;
+                red.seek(0);
+                for (std::size_t r = 0; r < reduced_outer; ++r, red.next()) {
+                    const Scalar* row = in + kept.offset() + red.offset();
+                    acc = Op::combine(acc, reduce_contiguous<Op>(row, inner.extent));
+                }
+                o[e] = acc;
+            }
+        });
+        return out;
+    }
+
+    // Innermost dimension kept: accumulate whole rows into a block of output
+    // columns, which vectorizes across the columns.
+    const auto blocks = (inner.extent + kColumnBlock - 1) / kColumnBlock;
+    const auto block_work = std::min(kColumnBlock, inner.extent) * reduced_outer;
+    const auto grain = std::max<std::size_t>(1, kGrain / block_work);
+    util::parallel_for(0, outer_kept * blocks, grain, [&](std::size_t lo, std::size_t hi) {
+        Odometer kept(kept_groups);
+        Odometer red(reduced_groups);
+        for (auto task = lo; task < hi; ++task) {
+            const auto e = task / blocks;
+            const auto j0 = (task % blocks) * kColumnBlock;
+            const auto j1 = std::min(inner.extent, j0 + kColumnBlock);
+            kept.seek(e);
+            Scalar* dst = o + e * inner.extent;
+            red.seek(0);
+            for (std::size_t r = 0; r < reduced_outer; ++r, red.next()) {
+                const Scalar* row = in + kept.offset() + red.offset();
+                for (auto j = j0; j < j1; ++j) {
+                    dst[j] = Op::combine(dst[j], row[j]);
+                }
+            }
+        }
+    });
+    return out;
+}
+
+} // namespace
+
+Tensor sum(const Tensor& t, const Axes& axes, bool keepdims) {
+    return reduce<SumOp>(t, axes, keepdims, "sum: invalid or duplicate axis");
+}
+
+Tensor mean(const Tensor& t, const Axes& axes, bool keepdims) {
+    std::size_t count = 0;
+    auto out = reduce<SumOp>(t, axes, keepdims, "mean: invalid or duplicate axis", &count);
+    const Scalar scale = 1.0 / static_cast<Scalar>(count);
+    Scalar* o = out.data();
+    const auto n = out.numel();
+    for (std::size_t i = 0; i < n; ++i) {
+        o[i] *= scale;
+    }
+    return out;
+}
+
+Tensor max(const Tensor& t, const Axes& axes, bool keepdims) {
+    return reduce<MaxOp>(t, axes, keepdims, "max: invalid or duplicate axis");
+}
+
+} // namespace fnn
@@ -0,0 +1,124 @@
+#include "fnn/util/bit_mask.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace fnn::util {
+
+namespace {
+
+// Mask words per thread-pool chunk.
+constexpr std::size_t kWordGrain = 256;
+
+// Bits of x[0..count) > 0, count <= 64.
+std::uint64_t pack_word(const Scalar* x, std::size_t count) {
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+#if defined(__AVX__)
+    const __m256d zero = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        const __m256d gt = _mm256_cmp_pd(_mm256_loadu_pd(x + i), zero, _CMP_GT_OQ);
+        bits |= static_cast<std::uint64_t>(_mm256_movemask_pd(gt)) << i;
+    }
+#elif defined(__SSE2__)
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= count; i += 2) {
+        const __m128d gt = _mm_cmpgt_pd(_mm_loadu_pd(x + i), zero);
+        bits |= static_cast<std::uint64_t>(_mm_movemask_pd(gt)) << i;
+    }
+#endif
+    for (; i < count; ++i) {
+        bits |= static_cast<std::uint64_t>(x[i] > 0.0) << i;
+    }
+    return bits;
+}
+
+// data[i] *= bit i ? if_set : if_clear, count <= 64.
+void scale_word(std::uint64_t bits, Scalar if_set, Scalar if_clear, Scalar* data,
+                std::size_t count) {
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    // Broadcast each nibble to four lanes and test one bit per lane.
+    const __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    const __m256d set = _mm256_set1_pd(if_set);
+    const __m256d clear = _mm256_set1_pd(if_clear);
+    for (; i + 4 <= count; i += 4) {
+        const auto nibble = static_cast<long long>((bits >> i) & 0xFu);
+        const __m256i sel = _mm256_and_si256(_mm256_set1_epi64x(nibble), lane_bits);
+        const __m256d on = _mm256_castsi256_pd(_mm256_cmpeq_epi64(sel, lane_bits));
+        const __m256d factor = _mm256_blendv_pd(clear, set, on);
+        _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), factor));
+    }
+#endif
+    for (; i < count; ++i) {
+        data[i] *= ((bits >> i) & 1u) ? if_set : if_clear;
+    }
+}
+
+} // namespace
+
+BitMask::BitMask(std::size_t size) { resize(size); }
+
+void BitMask::resize(std::size_t size) {
+    size_ = size;
+    words_.assign((size + 63) / 64, 0);
+}
+
+std::size_t BitMask::size() const noexcept { return size_; }
+
+std::size_t BitMask::bytes() const noexcept { return words_.size() * sizeof(std::uint64_t); }
+
+bool BitMask::test(std::size_t i) const {
+    if (i >= size_) {
+        throw std::out_of_range("BitMask::test: index out of range");
+    }
+    return (words_[i / 64] >> (i % 64)) & 1u;
+}
+
+void BitMask::set(std::size_t i, bool value) {
+    if (i >= size_) {
+        throw std::out_of_range("BitMask::set: index out of range");
+    }
+    const auto bit = std::uint64_t{1} << (i % 64);
+    if (value) {
+        words_[i / 64] |= bit;
+    } else {
+        words_[i / 64] &= ~bit;
+    }
+}
+
+std::size_t BitMask::num_words() const noexcept { return words_.size(); }
+
+std::uint64_t* BitMask::words() noexcept { return words_.data(); }
+
+const std::uint64_t* BitMask::words() const noexcept { return words_.data(); }
+
+void pack_positive(const Scalar* x, BitMask& mask) {
+    const auto n = mask.size();
+    std::uint64_t* words = mask.words();
+    parallel_for(0, mask.num_words(), kWordGrain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t w = lo; w < hi; ++w) {
+            const auto first = w * 64;
+            words[w] = pack_word(x + first, std::min<std::size_t>(64, n - first));
+        }
+    });
+}
+
+void scale_by_mask(const BitMask& mask, Scalar if_set, Scalar if_clear, Scalar* data) {
+    const auto n = mask.size();
+    const std::uint64_t* words = mask.words();
+    parallel_for(0, mask.num_words(), kWordGrain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t w = lo; w < hi; ++w) {
+            const auto first = w * 64;
+            scale_word(words[w], if_set, if_clear, data + first,
+                       std::min<std::size_t>(64, n - first));
+        }
+    });
+}
+
+} // namespace fnn::util
@@ -0,0 +1,542 @@
+#include "fnn/util/buffer_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace fnn::util {
+
+namespace {
+
+// Size classes are powers of two from 2^6 (64 B) to 2^26 (64 MiB).
+constexpr std::size_t kMinClassShift = 6;
+constexpr std::size_t kMaxClassShift = 26;
+constexpr std::size_t kNumClasses = kMaxClassShift - kMinClassShift + 1;
+constexpr std::size_t kMaxPooledBytes = std::size_t{1} << kMaxClassShift;
+constexpr std::align_val_t kAlignment{64};
+
+// A thread caches up to this many bytes per class, at least one block and
+// at most kMaxThreadBlocks; the depot up to kDepotClassBytes per class.
+constexpr std::size_t kThreadClassBytes = std::size_t{1} << 20;
+constexpr std::size_t kMaxThreadBlocks = 64;
+constexpr std::size_t kDepotClassBytes = std::size_t{64} << 20;
+
+// Thread counters are added to the shared ones every this many events.
+constexpr std::uint64_t kStatsBatch = 256;
+
+bool pool_enabled() {
+    static const bool enabled = [] {
+        const char* env = std::getenv("FNN_BUFFER_POOL");
+        return env == nullptr || std::string_view(env) != "0";
+    }();
+    return enabled;
+}
+
+std::size_t size_class(std::size_t bytes) {
+    const auto shift = std::max<std::size_t>(kMinClassShift, std::bit_width(bytes - 1));
+    return shift - kMinClassShift;
+}
+
+std::size_t class_bytes(std::size_t c) { return std::size_t{1} << (c + kMinClassShift); }
+
+std::size_t thread_capacity(std::size_t c) {
+    return std::clamp<std::size_t>(kThreadClassBytes / class_bytes(c), 1, kMaxThreadBlocks);
+}
+
+std::size_t depot_capacity(std::size_t c) {
+    return std::max<std::size_t>(kDepotClassBytes / class_bytes(c), 2);
+}
+
+constexpr std::size_t kHugePage = std::size_t{2} << 20;
+
+std::size_t round_up(std::size_t x, std::size_t multiple) {
+    return (x + multiple - 1) / multiple * multiple;
+}
+
+HugePagePolicy policy_from_env() {
+    HugePagePolicy policy;
+    if (const char* env = std::getenv("FNN_HUGE_PAGES")) {
+        const std::string_view v(env);
+        if (v == "off" || v == "0") {
+            policy.mode = HugePages::Off;
+        } else if (v == "hugetlb") {
+            policy.mode = HugePages::HugeTlb;
+        }
+    }
+    if (const char* env = std::getenv("FNN_HUGE_PAGE_THRESHOLD")) {
+        char* end = nullptr;
+        const auto bytes = std::strtoull(env, &end, 10);
+        if (end != env) {
+            policy.threshold = bytes;
+        }
+    }
+    return policy;
+}
+
+// Live huge-page mappings and their mapped lengths; frees of large blocks
+// look themselves up here to know whether to munmap or delete.
+struct HugeMappings {
+    std::atomic<int> mode;
+    std::atomic<std::size_t> threshold;
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> fallbacks{0};
+    std::mutex mutex;
+    std::unordered_map<void*, std::size_t> live;
+
+    HugeMappings() {
+        const auto policy = policy_from_env();
+        mode.store(static_cast<int>(policy.mode));
+        threshold.store(std::max(policy.threshold, kHugePage));
+    }
+};
+
+// Never destroyed, like the depot.
+HugeMappings& huge_mappings() {
+    static HugeMappings* h = new HugeMappings;
+    return *h;
+}
+
+#if defined(__linux__)
+// nullptr when no mapping could be made; returns the mapped length.
+void* map_huge(std::size_t bytes, HugePages mode, std::size_t& mapped) {
+    mapped = round_up(bytes, kHugePage);
+    constexpr int kProt = PROT_READ | PROT_WRITE;
+    constexpr int kFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_HUGETLB)
+    if (mode == HugePages::HugeTlb) {
+        void* p = ::mmap(nullptr, mapped, kProt, kFlags | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            return p;
+        }
+    }
+#endif
+    // Over-map by one huge page and trim both ends to a 2 MiB boundary, so
+    // the kernel can back the whole range with huge pages.
+    auto* raw = static_cast<char*>(::mmap(nullptr, mapped + kHugePage, kProt, kFlags, -1, 0));
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    const auto address = reinterpret_cast<std::uintptr_t>(raw);
+    auto* aligned = raw + (round_up(address, kHugePage) - address);
+    if (aligned != raw) {
+        ::munmap(raw, static_cast<std::size_t>(aligned - raw));
+    }
+    const auto tail = static_cast<std::size_t>(raw + mapped + kHugePage - (aligned + mapped));
+    if (tail > 0) {
+        ::munmap(aligned + mapped, tail);
+    }
+#if defined(MADV_HUGEPAGE)
+    // Advisory: without THP this is plain anonymous memory.
+    ::madvise(aligned, mapped, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+#endif
+
+void* system_allocate(std::size_t bytes) {
+#if defined(__linux__)
+    auto& h = huge_mappings();
+    const auto mode = static_cast<HugePages>(h.mode.load(std::memory_order_relaxed));
+    if (mode != HugePages::Off && bytes >= h.threshold.load(std::memory_order_relaxed)) {
+        std::size_t mapped = 0;
+        if (void* p = map_huge(bytes, mode, mapped)) {
+            try {
+                std::lock_guard lock(h.mutex);
+                h.live.emplace(p, mapped);
+            } catch (...) {
+                ::munmap(p, mapped);
+                throw;
+            }
+            h.allocations.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+        h.fallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+    return ::operator new(bytes, kAlignment);
+}
+
+// `bytes` is what was passed to system_allocate.
+void system_free(void* p, std::size_t bytes) noexcept {
+#if defined(__linux__)
+    if (bytes >= kHugePage) {
+        auto& h = huge_mappings();
+        std::size_t mapped = 0;
+        {
+            std::lock_guard lock(h.mutex);
+            if (const auto it = h.live.find(p); it != h.live.end()) {
+                mapped = it->second;
+                h.live.erase(it);
+            }
+        }
+        if (mapped > 0) {
+            ::munmap(p, mapped);
+            return;
+        }
+    }
+#else
+    (void)bytes;
+#endif
+    ::operator delete(p, kAlignment);
+}
+
+struct Counters {
+    std::uint64_t allocations{0};
+    std::uint64_t thread_hits{0};
+    std::uint64_t depot_hits{0};
+    std::uint64_t system_allocations{0};
+    std::uint64_t deallocations{0};
+};
+
+struct SharedCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> thread_hits{0};
+    std::atomic<std::uint64_t> depot_hits{0};
+    std::atomic<std::uint64_t> system_allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+
+    void add(const Counters& c) noexcept {
+        allocations.fetch_add(c.allocations, std::memory_order_relaxed);
+        thread_hits.fetch_add(c.thread_hits, std::memory_order_relaxed);
+        depot_hits.fetch_add(c.depot_hits, std::memory_order_relaxed);
+        system_allocations.fetch_add(c.system_allocations, std::memory_order_relaxed);
+        deallocations.fetch_add(c.deallocations, std::memory_order_relaxed);
+    }
+};
+
+struct DepotClass {
+    std::mutex mutex;
+    std::vector<void*> blocks;
+};
+
+struct Depot {
+    std::array<DepotClass, kNumClasses> classes;
+    SharedCounters counters;
+};
+
+// Never destroyed: buffers may be freed by static destructors that run
+// after everything else.
+Depot& depot() {
+    static Depot* d = new Depot;
+    return *d;
+}
+
+// Takes ownership of `p`; frees it to the system when the depot is full.
+void depot_push(std::size_t c, void* p) noexcept {
+    auto& dc = depot().classes[c];
+    {
+        std::lock_guard lock(dc.mutex);
+        if (dc.blocks.size() < depot_capacity(c)) {
+            try {
+                dc.blocks.push_back(p);
+                return;
+            } catch (const std::bad_alloc&) {
+                // Fall through and free it.
+            }
+        }
+    }
+    system_free(p, class_bytes(c));
+}
+
+// Set once this thread's cache is gone; later frees go to the depot.
+thread_local bool t_cache_destroyed = false;
+
+struct ThreadCache {
+    std::array<std::vector<void*>, kNumClasses> lists;
+    Counters counters;
+    std::uint64_t pending{0};
+
+    ~ThreadCache() {
+        for (std::size_t c = 0; c < kNumClasses; ++c) {
+            for (void* p : lists[c]) {
+                depot_push(c, p);
+            }
+        }
+        flush();
+        t_cache_destroyed = true;
+    }
+
+    void flush() noexcept {
+        depot().counters.add(counters);
+        counters = {};
+        pending = 0;
+    }
+
+    void event() noexcept {
+        if (++pending >= kStatsBatch) {
+            flush();
+        }
+    }
+};
+
+ThreadCache* thread_cache() {
+    if (t_cache_destroyed) {
+        return nullptr;
+    }
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+void count(ThreadCache* tc, std::uint64_t Counters::*field) noexcept {
+    if (tc != nullptr) {
+        ++(tc->counters.*field);
+        tc->event();
+        return;
+    }
+    Counters one;
+    ++(one.*field);
+    depot().counters.add(one);
+}
+
+} // namespace
+
+double BufferPoolStats::hit_rate() const noexcept {
+    return allocations == 0
+               ? 0.0
+               : static_cast<double>(thread_hits + depot_hits) / static_cast<double>(allocations);
+}
+
+void* pool_allocate(std::size_t bytes) {
+    if (!pool_enabled() || bytes > kMaxPooledBytes) {
+        auto* tc = pool_enabled() ? thread_cache() : nullptr;
+        count(tc, &Counters::allocations);
+        count(tc, &Counters::system_allocations);
+        return system_allocate(std::max<std::size_t>(bytes, 1));
+    }
+    const auto c = size_class(std::max<std::size_t>(bytes, 1));
+    auto* tc = thread_cache();
+    count(tc, &Counters::allocations);
+    if (tc != nullptr) {
+        auto& list = tc->lists[c];
+        if (list.empty()) {
+            // Refill up to half the thread capacity in one trip to the depot.
+            auto& dc = depot().classes[c];
+            list.reserve(thread_capacity(c) + 1);
+            std::lock_guard lock(dc.mutex);
+            const auto take =
+                std::min(dc.blocks.size(), std::max<std::size_t>(1, thread_capacity(c) / 2));
+            list.insert(list.end(), dc.blocks.end() - static_cast<std::ptrdiff_t>(take),
+                        dc.blocks.end());
+            dc.blocks.resize(dc.blocks.size() - take);
+            if (take > 0) {
+                count(tc, &Counters::depot_hits);
+                void* p = list.back();
+                list.pop_back();
+                return p;
+            }
+        } else {
+            count(tc, &Counters::thread_hits);
+            void* p = list.back();
+            list.pop_back();
+            return p;
+        }
+    } else {
+        auto& dc = depot().classes[c];
+        std::lock_guard lock(dc.mutex);
+        if (!dc.blocks.empty()) {
+            count(tc, &Counters::depot_hits);
+            void* p = dc.blocks.back();
+            dc.blocks.pop_back();
+            return p;
+        }
+    }
+    count(tc, &Counters::system_allocations);
+    return system_allocate(class_bytes(c));
+}
+
+void pool_deallocate(void* p, std::size_t bytes) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    if (!pool_enabled() || bytes > kMaxPooledBytes) {
+        count(pool_enabled() ? thread_cache() : nullptr, &Counters::deallocations);
+        system_free(p, std::max<std::size_t>(bytes, 1));
+        return;
+    }
+    const auto c = size_class(std::max<std::size_t>(bytes, 1));
+    auto* tc = thread_cache();
+    count(tc, &Counters::deallocations);
+    if (tc == nullptr) {
+        depot_push(c, p);
+        return;
+    }
+    auto& list = tc->lists[c];
+    const auto cap = thread_capacity(c);
+    if (list.capacity() <= cap) {
+        try {
+            list.reserve(cap + 1);
+        } catch (const std::bad_alloc&) {
+            depot_push(c, p);
+            return;
+        }
+    }
+    list.push_back(p);
+    if (list.size() > cap) {
+        // Hand the older half to the depot so other threads can reuse it.
+        const auto give = list.size() / 2;
+        for (std::size_t i = 0; i < give; ++i) {
+            depot_push(c, list[i]);
+        }
+        list.erase(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(give));
+    }
+}
+
+BufferPoolStats buffer_pool_stats() {
+    if (pool_enabled()) {
+        if (auto* tc = thread_cache()) {
+            tc->flush();
+        }
+    }
+    const auto& s = depot().counters;
+    BufferPoolStats out;
+    out.allocations = s.allocations.load(std::memory_order_relaxed);
+    out.thread_hits = s.thread_hits.load(std::memory_order_relaxed);
+    out.depot_hits = s.depot_hits.load(std::memory_order_relaxed);
+    out.system_allocations = s.system_allocations.load(std::memory_order_relaxed);
+    out.deallocations = s.deallocations.load(std::memory_order_relaxed);
+    out.huge_page_allocations = huge_mappings().allocations.load(std::memory_order_relaxed);
+    out.huge_page_fallbacks = huge_mappings().fallbacks.load(std::memory_order_relaxed);
+    return out;
+}
+
+void reset_buffer_pool_stats() {
+    if (pool_enabled()) {
+        if (auto* tc = thread_cache()) {
+            tc->counters = {};
+            tc->pending = 0;
+        }
+    }
+    auto& s = depot().counters;
+    s.allocations.store(0, std::memory_order_relaxed);
+    s.thread_hits.store(0, std::memory_order_relaxed);
+    s.depot_hits.store(0, std::memory_order_relaxed);
+    s.system_allocations.store(0, std::memory_order_relaxed);
+    s.deallocations.store(0, std::memory_order_relaxed);
+    huge_mappings().allocations.store(0, std::memory_order_relaxed);
+    huge_mappings().fallbacks.store(0, std::memory_order_relaxed);
+}
+
+void set_huge_page_policy(const HugePagePolicy& policy) {
+    auto& h = huge_mappings();
+    h.mode.store(static_cast<int>(policy.mode), std::memory_order_relaxed);
+    h.threshold.store(std::max(policy.threshold, kHugePage), std::memory_order_relaxed);
+}
+
+HugePagePolicy huge_page_policy() {
+    auto& h = huge_mappings();
+    return {static_cast<HugePages>(h.mode.load(std::memory_order_relaxed)),
+            h.threshold.load(std::memory_order_relaxed)};
+}
+
+void trim_buffer_pool() {
+    auto* tc = pool_enabled() ? thread_cache() : nullptr;
+    for (std::size_t c = 0; c < kNumClasses; ++c) {
+        auto& dc = depot().classes[c];
+        std::vector<void*> blocks;
+        if (tc != nullptr) {
+            blocks.swap(tc->lists[c]);
+        }
+        {
+            std::lock_guard lock(dc.mutex);
+            blocks.insert(blocks.end(), dc.blocks.begin(), dc.blocks.end());
+            dc.blocks.clear();
+        }
+        for (void* p : blocks) {
+            system_free(p, class_bytes(c));
+        }
+    }
+}
+
+} // namespace fnn::util
+
+namespace fnn {
+
+namespace {
+
+Scalar* allocate_scalars(std::size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    if (size > std::numeric_limits<std::size_t>::max() / sizeof(Scalar)) {
+        throw std::bad_array_new_length();
+    }
+    return static_cast<Scalar*>(util::pool_allocate(size * sizeof(Scalar)));
+}
+
+} // namespace
+
+Buffer::Buffer(std::size_t size) : data_(allocate_scalars(size)), size_(size) {
+    std::fill_n(data_, size_, 0.0);
+}
+
+Buffer::Buffer(const Buffer& other) : data_(allocate_scalars(other.size_)), size_(other.size_) {
+    std::copy_n(other.data_, size_, data_);
+}
+
+Buffer::Buffer(Buffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+Buffer& Buffer::operator=(const Buffer& other) {
+    if (this != &other) {
+        if (size_ != other.size_) {
+            Buffer copy(other);
+            std::swap(data_, copy.data_);
+            std::swap(size_, copy.size_);
+        } else {
+            std::copy_n(other.data_, size_, data_);
+        }
+    }
+    return *this;
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        util::pool_deallocate(data_, size_ * sizeof(Scalar));
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+Buffer::~Buffer() { util::pool_deallocate(data_, size_ * sizeof(Scalar)); }
+
+void Buffer::resize(std::size_t size) {
+    if (size == size_) {
+        return;
+    }
+    Buffer bigger(size);
+    std::copy_n(data_, std::min(size, size_), bigger.data_);
+    std::swap(data_, bigger.data_);
+    std::swap(size_, bigger.size_);
+}
+
+std::size_t Buffer::size() const noexcept { return size_; }
+
+bool Buffer::empty() const noexcept { return size_ == 0; }
+
+Scalar* Buffer::data() noexcept { return data_; }
+
+const Scalar* Buffer::data() const noexcept { return data_; }
+
+Scalar* Buffer::begin() noexcept { return data_; }
+
+Scalar* Buffer::end() noexcept { return data_ + size_; }
+
+const Scalar* Buffer::begin() const noexcept { return data_; }
+
+const Scalar* Buffer::end() const noexcept { return data_ + size_; }
+
+} // namespace fnn
@@ -0,0 +1,452 @@
+#include "fnn/util/linear_alg.hpp"
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fnn::util {
+
+namespace {
+
+// Below this many elements a routine runs on the calling thread only.
+constexpr std::size_t kParallelThreshold = std::size_t{1} << 16;
+// Reductions produce one partial per chunk of this size, so the summation
+// order is fixed no matter how chunks are spread across threads.
+constexpr std::size_t kReduceChunk = std::size_t{1} << 13;
+// Row-major gemv splits rows across threads from this many elements of A
+// (2 MiB of doubles, past where the matrix fits in L2).
+constexpr std::size_t kGemvSplitThreshold = std::size_t{1} << 18;
+
+#if defined(__AVX2__) && defined(__FMA__)
+inline Scalar hsum(__m256d v) {
+    const __m128d lo = _mm256_castpd256_pd128(v);
+    const __m128d hi = _mm256_extractf128_pd(v, 1);
+    const __m128d s = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+#elif defined(__SSE2__)
+inline Scalar hsum(__m128d v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+#endif
+
+Scalar dot_kernel(const Scalar* x, const Scalar* y, std::size_t n) {
+    std::size_t i = 0;
+    Scalar s = 0.0;
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256d a0 = _mm256_setzero_pd();
+    __m256d a1 = _mm256_setzero_pd();
+    __m256d a2 = _mm256_setzero_pd();
+    __m256d a3 = _mm256_setzero_pd();
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a0);
+        a1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), a1);
+        a2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), a2);
+        a3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), a3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a0);
+    }
+    s = hsum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+#else
+    Scalar a[4] = {0.0, 0.0, 0.0, 0.0};
+    for (; i + 4 <= n; i += 4) {
+        a[0] += x[i] * y[i];
+        a[1] += x[i + 1] * y[i + 1];
+        a[2] += x[i + 2] * y[i + 2];
+        a[3] += x[i + 3] * y[i + 3];
+    }
+    s = (a[0] + a[1]) + (a[2] + a[3]);
+#endif
+    for (; i < n; ++i) {
+        s += x[i] * y[i];
+    }
+    return s;
+}
+
+// How far ahead in each row gemv prefetches: 64 doubles = 8 cache lines,
+// enough to cover memory latency at streaming speed. The hint keeps the
+// lines in every cache level: a non-temporal hint measured ~2x slower.
+constexpr std::size_t kPrefetchAhead = 64;
+
+inline void prefetch(const Scalar* p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
+
+// Dots of four consecutive rows of a row-major A with x. x is loaded once
+// per step for all four rows, each row has two accumulators so the FMA
+// latency is hidden, and every row is prefetched a few lines ahead (four
+// interleaved streams are more than some hardware prefetchers track).
+void dot4_kernel(const Scalar* a, std::size_t lda, const Scalar* x, std::size_t n,
+                 Scalar out[4]) {
+    const Scalar* r0 = a;
+    const Scalar* r1 = a + lda;
+    const Scalar* r2 = a + 2 * lda;
+    const Scalar* r3 = a + 3 * lda;
+    std::size_t j = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256d s00 = _mm256_setzero_pd();
+    __m256d s01 = _mm256_setzero_pd();
+    __m256d s10 = _mm256_setzero_pd();
+    __m256d s11 = _mm256_setzero_pd();
+    __m256d s20 = _mm256_setzero_pd();
+    __m256d s21 = _mm256_setzero_pd();
+    __m256d s30 = _mm256_setzero_pd();
+    __m256d s31 = _mm256_setzero_pd();
+    for (; j + 8 <= n; j += 8) {
+        if (j + kPrefetchAhead < n) {
+            prefetch(r0 + j + kPrefetchAhead);
+            prefetch(r1 + j + kPrefetchAhead);
+            prefetch(r2 + j + kPrefetchAhead);
+            prefetch(r3 + j + kPrefetchAhead);
+        }
+        const __m256d x0 = _mm256_loadu_pd(x + j);
+        const __m256d x1 = _mm256_loadu_pd(x + j + 4);
+        s00 = _mm256_fmadd_pd(_mm256_loadu_pd(r0 + j), x0, s00);
+        s01 = _mm256_fmadd_pd(_mm256_loadu_pd(r0 + j + 4), x1, s01);
+        s10 = _mm256_fmadd_pd(_mm256_loadu_pd(r1 + j), x0, s10);
+        s11 = _mm256_fmadd_pd(_mm256_loadu_pd(r1 + j + 4), x1, s11);
+        s20 = _mm256_fmadd_pd(_mm256_loadu_pd(r2 + j), x0, s20);
+        s21 = _mm256_fmadd_pd(_mm256_loadu_pd(r2 + j + 4), x1, s21);
+        s30 = _mm256_fmadd_pd(_mm256_loadu_pd(r3 + j), x0, s30);
+        s31 = _mm256_fmadd_pd(_mm256_loadu_pd(r3 + j + 4), x1, s31);
+    }
+    for (; j + 4 <= n; j += 4) {
+        const __m256d x0 = _mm256_loadu_pd(x + j);
+        s00 = _mm256_fmadd_pd(_mm256_loadu_pd(r0 + j), x0, s00);
+        s10 = _mm256_fmadd_pd(_mm256_loadu_pd(r1 + j), x0, s10);
+        s20 = _mm256_fmadd_pd(_mm256_loadu_pd(r2 + j), x0, s20);
+        s30 = _mm256_fmadd_pd(_mm256_loadu_pd(r3 + j), x0, s30);
+    }
+    out[0] = hsum(_mm256_add_pd(s00, s01));
+    out[1] = hsum(_mm256_add_pd(s10, s11));
+    out[2] = hsum(_mm256_add_pd(s20, s21));
+    out[3] = hsum(_mm256_add_pd(s30, s31));
+#elif defined(__SSE2__)
+    __m128d s00 = _mm_setzero_pd();
+    __m128d s01 = _mm_setzero_pd();
+    __m128d s10 = _mm_setzero_pd();
+    __m128d s11 = _mm_setzero_pd();
+    __m128d s20 = _mm_setzero_pd();
+    __m128d s21 = _mm_setzero_pd();
+    __m128d s30 = _mm_setzero_pd();
+    __m128d s31 = _mm_setzero_pd();
+    for (; j + 4 <= n; j += 4) {
+        if (j + kPrefetchAhead < n) {
+            prefetch(r0 + j + kPrefetchAhead);
+            prefetch(r1 + j + kPrefetchAhead);
+            prefetch(r2 + j + kPrefetchAhead);
+            prefetch(r3 + j + kPrefetchAhead);
+        }
+        const __m128d x0 = _mm_loadu_pd(x + j);
+        const __m128d x1 = _mm_loadu_pd(x + j + 2);
+        s00 = _mm_add_pd(s00, _mm_mul_pd(_mm_loadu_pd(r0 + j), x0));
+        s01 = _mm_add_pd(s01, _mm_mul_pd(_mm_loadu_pd(r0 + j + 2), x1));
+        s10 = _mm_add_pd(s10, _mm_mul_pd(_mm_loadu_pd(r1 + j), x0));
+        s11 = _mm_add_pd(s11, _mm_mul_pd(_mm_loadu_pd(r1 + j + 2), x1));
+        s20 = _mm_add_pd(s20, _mm_mul_pd(_mm_loadu_pd(r2 + j), x0));
+        s21 = _mm_add_pd(s21, _mm_mul_pd(_mm_loadu_pd(r2 + j + 2), x1));
+        s30 = _mm_add_pd(s30, _mm_mul_pd(_mm_loadu_pd(r3 + j), x0));
+        s31 = _mm_add_pd(s31, _mm_mul_pd(_mm_loadu_pd(r3 + j + 2), x1));
+    }
+    out[0] = hsum(_mm_add_pd(s00, s01));
+    out[1] = hsum(_mm_add_pd(s10, s11));
+    out[2] = hsum(_mm_add_pd(s20, s21));
+    out[3] = hsum(_mm_add_pd(s30, s31));
+#else
+    out[0] = out[1] = out[2] = out[3] = 0.0;
+#endif
+    for (; j < n; ++j) {
+        out[0] += r0[j] * x[j];
+        out[1] += r1[j] * x[j];
+        out[2] += r2[j] * x[j];
+        out[3] += r3[j] * x[j];
+    }
+}
+
+// Sum of partial(lo, hi) over fixed chunks of [0, n), combined in order.
+template <typename Partial>
+Scalar chunked_sum(std::size_t n, Partial partial) {
+    const auto chunks = (n + kReduceChunk - 1) / kReduceChunk;
+    if (chunks <= 1) {
+        return partial(0, n);
+    }
+    std::vector<Scalar> parts(chunks);
+    const auto grain = n >= kParallelThreshold ? 1 : chunks;
+    parallel_for(0, chunks, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto c = lo; c < hi; ++c) {
+            parts[c] = partial(c * kReduceChunk, std::min(n, (c + 1) * kReduceChunk));
+        }
+    });
+    Scalar s = 0.0;
+    for (const auto p : parts) {
+        s += p;
+    }
+    return s;
+}
+
+// Runs body(lo, hi) over [0, n), threaded only when `work` is large.
+template <typename Body>
+void maybe_parallel(std::size_t n, std::size_t work, std::size_t grain, Body body) {
+    if (work < kParallelThreshold) {
+        body(std::size_t{0}, n);
+        return;
+    }
+    parallel_for(0, n, grain, body);
+}
+
+} // namespace
+
+void axpy(Scalar alpha, std::span<const Scalar> x, std::span<Scalar> y) {
+    if (x.size() != y.size()) {
+        throw std::invalid_argument("axpy: x and y must have the same size");
+    }
+    const Scalar* xs = x.data();
+    Scalar* ys = y.data();
+    maybe_parallel(x.size(), x.size(), kReduceChunk, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            ys[i] += alpha * xs[i];
+        }
+    });
+}
+
+void scal(Scalar alpha, std::span<Scalar> x) {
+    Scalar* xs = x.data();
+    maybe_parallel(x.size(), x.size(), kReduceChunk, [&](std::size_t lo, std::size_t hi) {
+        for (auto i = lo; i < hi; ++i) {
+            xs[i] *= alpha;
+        }
+    });
+}
+
+Scalar dot(std::span<const Scalar> x, std::span<const Scalar> y) {
+    if (x.size() != y.size()) {
+        throw std::invalid_argument("dot: x and y must have the same size");
+    }
+    return chunked_sum(x.size(), [&](std::size_t lo, std::size_t hi) {
+        return dot_kernel(x.data() + lo, y.data() + lo, hi - lo);
+    });
+}
+
+Scalar nrm2(std::span<const Scalar> x) {
+    const Scalar ss = dot(x, x);
+    if (std::isfinite(ss) && ss > 0.0 && ss >= std::numeric_limits<Scalar>::min()) {
+        return std::sqrt(ss);
+    }
+    if (x.empty() || std::isnan(ss)) {
+        return ss;
+    }
+    // The plain sum of squares over- or underflowed: rescale by max |x|.
+    const Scalar scale = std::fabs(x[iamax(x)]);
+    if (scale == 0.0 || !std::isfinite(scale)) {
+        return scale;
+    }
+    const Scalar inv = 1.0 / scale;
+    const Scalar scaled = chunked_sum(x.size(), [&](std::size_t lo, std::size_t hi) {
+        Scalar s = 0.0;
+        for (auto i = lo; i < hi; ++i) {
+            const Scalar v = x[i] * inv;
+            s += v * v;
+        }
+        return s;
+    });
+    return scale * std::sqrt(scaled);
+}
+
+Scalar asum(std::span<const Scalar> x) {
+    return chunked_sum(x.size(), [&](std::size_t lo, std::size_t hi) {
+        Scalar a[4] = {0.0, 0.0, 0.0, 0.0};
+        auto i = lo;
+        for (; i + 4 <= hi; i += 4) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                a[k] += std::fabs(x[i + k]);
+            }
+        }
+        for (; i < hi; ++i) {
+            a[0] += std::fabs(x[i]);
+        }
+        return (a[0] + a[1]) + (a[2] + a[3]);
+    });
+}
+
+std::size_t iamax(std::span<const Scalar> x) {
+    if (x.empty()) {
+        throw std::invalid_argument("iamax: x must not be empty");
+    }
+    const auto n = x.size();
+    const auto chunks = (n + kReduceChunk - 1) / kReduceChunk;
+    std::vector<std::size_t> best(chunks);
+    const auto grain = n >= kParallelThreshold ? 1 : chunks;
+    parallel_for(0, chunks, grain, [&](std::size_t lo, std::size_t hi) {
+        for (auto c = lo; c < hi; ++c) {
+            const auto first = c * kReduceChunk;
+            const auto last = std::min(n, first + kReduceChunk);
+            auto arg = first;
+            Scalar m = std::fabs(x[first]);
+            for (auto i = first + 1; i < last; ++i) {
+                const Scalar v = std::fabs(x[i]);
+                if (v > m) {
+                    m = v;
+                    arg = i;
+                }
+            }
+            best[c] = arg;
+        }
+    });
+    auto arg = best[0];
+    for (std::size_t c = 1; c < chunks; ++c) {
+        if (std::fabs(x[best[c]]) > std::fabs(x[arg])) {
+            arg = best[c];
+        }
+    }
+    return arg;
+}
+
+void gemv(Scalar alpha, const MatrixRef& a, std::span<const Scalar> x, Scalar beta,
+          std::span<Scalar> y) {
+    if (x.size() != a.cols || y.size() != a.rows) {
+        throw std::invalid_argument("gemv: shape mismatch");
+    }
+    const auto m = a.rows;
+    const auto n = a.cols;
+    const Scalar* xs = x.data();
+    Scalar* ys = y.data();
+    const auto finish = [&](std::size_t i, Scalar v) {
+        ys[i] = beta == 0.0 ? alpha * v : alpha * v + beta * ys[i];
+    };
+
+    if (a.col_stride == 1 || n <= 1) {
+        // Row-major: one dot per row, four rows at a time. Rows are split
+        // across threads only for very wide matrices; below that, waking the
+        // pool costs more than the extra memory bandwidth buys.
+        const auto grain =
+            std::max<std::size_t>(4, kGemvSplitThreshold / 4 / std::max<std::size_t>(n, 1)) /
+            4 * 4;
+        const auto rows = [&](std::size_t lo, std::size_t hi) {
+            auto i = lo;
+            for (; i + 4 <= hi; i += 4) {
+                Scalar v[4];
+                dot4_kernel(a.data + i * a.row_stride, a.row_stride, xs, n, v);
+                for (std::size_t r = 0; r < 4; ++r) {
+                    finish(i + r, v[r]);
+                }
+            }
+            for (; i < hi; ++i) {
+                finish(i, dot_kernel(a.data + i * a.row_stride, xs, n));
+            }
+        };
+        if (m * n < kGemvSplitThreshold) {
+            rows(0, m);
+        } else {
+            parallel_for(0, m, grain, rows);
+        }
+        return;
+    }
+
+    if (a.row_stride == 1) {
+        // Column-major (e.g. a transposed view): scale the block of y by
+        // beta, then accumulate alpha * x[j] times four columns per pass
+        // straight into it, so no scratch is needed.
+        const auto grain = std::max<std::size_t>(64, kParallelThreshold / n);
+        maybe_parallel(m, m * n, grain, [&](std::size_t lo, std::size_t hi) {
+            Scalar* t = ys + lo;
+            const auto len = hi - lo;
+            for (std::size_t i = 0; i < len; ++i) {
+                t[i] = beta == 0.0 ? 0.0 : beta * t[i];
+            }
+            std::size_t j = 0;
+            for (; j + 4 <= n; j += 4) {
+                const Scalar* c0 = a.data + lo + j * a.col_stride;
+                const Scalar* c1 = c0 + a.col_stride;
+                const Scalar* c2 = c1 + a.col_stride;
+                const Scalar* c3 = c2 + a.col_stride;
+                const Scalar x0 = alpha * xs[j];
+                const Scalar x1 = alpha * xs[j + 1];
+                const Scalar x2 = alpha * xs[j + 2];
+                const Scalar x3 = alpha * xs[j + 3];
+                for (std::size_t i = 0; i < len; ++i) {
+                    t[i] += x0 * c0[i] + x1 * c1[i] + x2 * c2[i] + x3 * c3[i];
+                }
+            }
+            for (; j < n; ++j) {
+                const Scalar* c0 = a.data + lo + j * a.col_stride;
+                const Scalar x0 = alpha * xs[j];
+                for (std::size_t i = 0; i < len; ++i) {
+                    t[i] += x0 * c0[i];
+                }
+            }
+        });
+        return;
+    }
+
+    // Arbitrary strides.
+    for (std::size_t i = 0; i < m; ++i) {
+        Scalar s = 0.0;
+        for (std::size_t j = 0; j < n; ++j) {
+            s += a.data[i * a.row_stride + j * a.col_stride] * xs[j];
+        }
+        finish(i, s);
+    }
+}
+
+void ger(Scalar alpha, std::span<const Scalar> x, std::span<const Scalar> y,
+         const MutableMatrixRef& a) {
+    if (x.size() != a.rows || y.size() != a.cols) {
+        throw std::invalid_argument("ger: shape mismatch");
+    }
+    const auto m = a.rows;
+    const auto n = a.cols;
+    const Scalar* xs = x.data();
+    const Scalar* ys = y.data();
+
+    if (a.col_stride == 1) {
+        // Each row gets an axpy with y.
+        const auto grain =
+            std::max<std::size_t>(1, kParallelThreshold / std::max<std::size_t>(n, 1));
+        maybe_parallel(m, m * n, grain, [&](std::size_t lo, std::size_t hi) {
+            for (auto i = lo; i < hi; ++i) {
+                Scalar* row = a.data + i * a.row_stride;
+                const Scalar s = alpha * xs[i];
+                for (std::size_t j = 0; j < n; ++j) {
+                    row[j] += s * ys[j];
+                }
+            }
+        });
+        return;
+    }
+
+    if (a.row_stride == 1) {
+        // Each column gets an axpy with x.
+        const auto grain =
+            std::max<std::size_t>(1, kParallelThreshold / std::max<std::size_t>(m, 1));
+        maybe_parallel(n, m * n, grain, [&](std::size_t lo, std::size_t hi) {
+            for (auto j = lo; j < hi; ++j) {
+                Scalar* col = a.data + j * a.col_stride;
+                const Scalar s = alpha * ys[j];
+                for (std::size_t i = 0; i < m; ++i) {
+                    col[i] += s * xs[i];
+                }
+            }
+        });
+        return;
+    }
+
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            a.data[i * a.row_stride + j * a.col_stride] += alpha * xs[i] * ys[j];
+        }
+    }
+}
+
+} // namespace fnn::util
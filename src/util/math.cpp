@@ -1,5 +1,7 @@
 #include "fnn/util/math.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <limits>
 #include <stdexcept>
@@ -41,4 +43,8 @@ std::size_t product(const std::vector<int>& vec, const char* what) {
     return p;
 }
 
+Scalar softplus(Scalar x) { return std::max(x, 0.0) + std::log1p(std::exp(-std::abs(x))); }
+
+Scalar sigmoid(Scalar x) { return 1.0 / (1.0 + std::exp(-x)); }
+
 } // namespace fnn::util
@@ -0,0 +1,159 @@
+#include "fnn/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+
+namespace fnn::util {
+
+namespace {
+
+std::size_t default_thread_count() {
+    if (const char* env = std::getenv("FNN_NUM_THREADS")) {
+        try {
+            const auto n = std::stoul(env);
+            if (n > 0) {
+                return n;
+            }
+        } catch (const std::exception&) {
+            // Fall through to the hardware default on a malformed value.
+        }
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Shared state of one parallel_for call. Helpers hold it by shared_ptr so a
+// helper that is dequeued after the loop finished only sees "no chunks left".
+struct Job {
+    const std::function<void(std::size_t, std::size_t)>* fn{nullptr};
+    std::size_t begin{0};
+    std::size_t end{0};
+    std::size_t chunk{1};
+    std::size_t num_chunks{0};
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> remaining{0};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    void drain() {
+        for (;;) {
+            const auto c = next.fetch_add(1, std::memory_order_relaxed);
+            if (c >= num_chunks) {
+                return;
+            }
+            const auto lo = begin + c * chunk;
+            const auto hi = std::min(end, lo + chunk);
+            try {
+                (*fn)(lo, hi);
+            } catch (...) {
+                std::lock_guard lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(default_thread_count());
+    return pool;
+}
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+    // The caller participates in every loop, so spawn one thread fewer.
+    const auto workers = num_threads > 1 ? num_threads - 1 : 0;
+    workers_.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+std::size_t ThreadPool::num_threads() const noexcept { return workers_.size() + 1; }
+
+void ThreadPool::parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                              const std::function<void(std::size_t, std::size_t)>& fn) {
+    if (end <= begin) {
+        return;
+    }
+    const auto n = end - begin;
+    grain = std::max<std::size_t>(grain, 1);
+    if (workers_.empty() || n <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    // A few chunks per thread smooths out uneven chunk costs.
+    const auto max_chunks = num_threads() * 4;
+    const auto num_chunks = std::min((n + grain - 1) / grain, max_chunks);
+
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->begin = begin;
+    job->end = end;
+    job->chunk = (n + num_chunks - 1) / num_chunks;
+    job->num_chunks = (n + job->chunk - 1) / job->chunk;
+    job->remaining.store(job->num_chunks, std::memory_order_relaxed);
+
+    const auto helpers = std::min(job->num_chunks - 1, workers_.size());
+    {
+        std::lock_guard lock(mutex_);
+        for (std::size_t i = 0; i < helpers; ++i) {
+            queue_.emplace_back([job] { job->drain(); });
+        }
+    }
+    cv_.notify_all();
+
+    job->drain();
+    {
+        std::unique_lock lock(job->mutex);
+        job->done.wait(lock, [&] { return job->remaining.load(std::memory_order_acquire) == 0; });
+    }
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+void ThreadPool::worker_loop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_ && queue_.empty()) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+    }
+}
+
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& fn) {
+    ThreadPool::instance().parallel_for(begin, end, grain, fn);
+}
+
+} // namespace fnn::util
@@ -0,0 +1,218 @@
+// Buffer pool: freed blocks come back from the thread's list, overflow
+// reaches other threads through the depot, oversized requests bypass the
+// pool, and the statistics count each path. Large system allocations are
+// huge-page mappings under Advise, plain ones under Off, and fall back to
+// operator new when the mapping fails.
+
+#include "fnn/util/buffer_pool.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using fnn::Buffer;
+using fnn::Scalar;
+using fnn::util::BufferPoolStats;
+
+constexpr std::size_t kMiB = std::size_t{1} << 20;
+
+// Counter increments since `before`.
+BufferPoolStats since(const BufferPoolStats& before) {
+    auto s = fnn::util::buffer_pool_stats();
+    s.allocations -= before.allocations;
+    s.thread_hits -= before.thread_hits;
+    s.depot_hits -= before.depot_hits;
+    s.system_allocations -= before.system_allocations;
+    s.deallocations -= before.deallocations;
+    s.huge_page_allocations -= before.huge_page_allocations;
+    s.huge_page_fallbacks -= before.huge_page_fallbacks;
+    return s;
+}
+
+bool aligned(const void* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+void check_reuse() {
+    fnn::util::trim_buffer_pool();
+    fnn::util::reset_buffer_pool_stats();
+
+    // 1000 and 1024 bytes share a size class, so the second request gets
+    // the block the first one freed.
+    void* first = fnn::util::pool_allocate(1000);
+    FNN_CHECK(aligned(first, 64));
+    fnn::util::pool_deallocate(first, 1000);
+    void* second = fnn::util::pool_allocate(1024);
+    FNN_CHECK(second == first);
+    fnn::util::pool_deallocate(second, 1024);
+    auto s = fnn::util::buffer_pool_stats();
+    FNN_CHECK(s.allocations == 2 && s.system_allocations == 1 && s.thread_hits == 1);
+    FNN_CHECK(s.depot_hits == 0 && s.deallocations == 2);
+    FNN_CHECK(s.hit_rate() == 0.5);
+
+    // A recycled block is zeroed again for a new Buffer.
+    {
+        Buffer dirty(100);
+        std::memset(dirty.data(), 0xff, 100 * sizeof(Scalar));
+    }
+    const Buffer clean(100);
+    bool zero = true;
+    for (const Scalar v : clean) {
+        zero = zero && v == 0.0;
+    }
+    FNN_CHECK(zero);
+
+    fnn::util::reset_buffer_pool_stats();
+    FNN_CHECK(fnn::util::buffer_pool_stats().allocations == 0);
+    FNN_CHECK(BufferPoolStats{}.hit_rate() == 0.0);
+}
+
+void check_depot() {
+    fnn::util::trim_buffer_pool();
+    // Freeing more 64-byte blocks than a thread keeps (64) moves the older
+    // half to the depot, where another thread finds them.
+    std::vector<void*> blocks(65);
+    for (auto& p : blocks) {
+        p = fnn::util::pool_allocate(64);
+    }
+    for (void* p : blocks) {
+        fnn::util::pool_deallocate(p, 64);
+    }
+    const auto before = fnn::util::buffer_pool_stats();
+    bool from_depot = false;
+    std::thread other([&] {
+        void* p = fnn::util::pool_allocate(64);
+        from_depot = std::find(blocks.begin(), blocks.end(), p) != blocks.end();
+        fnn::util::pool_deallocate(p, 64);
+    });
+    other.join();
+    FNN_CHECK(from_depot);
+    // The exiting thread published its counters.
+    const auto s = since(before);
+    FNN_CHECK(s.allocations == 1 && s.depot_hits == 1 && s.system_allocations == 0);
+
+    // Requests above the largest class (64 MiB) always go to the system.
+    const auto big = since({});
+    for (int i = 0; i < 2; ++i) {
+        fnn::util::pool_deallocate(fnn::util::pool_allocate(65 * kMiB), 65 * kMiB);
+    }
+    const auto b = since(big);
+    FNN_CHECK(b.allocations == 2 && b.system_allocations == 2 && b.thread_hits == 0);
+    fnn::util::trim_buffer_pool();
+}
+
+#if defined(__linux__)
+// Virtual address space of this process, from /proc/self/status.
+std::size_t address_space() {
+    std::FILE* f = std::fopen("/proc/self/status", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    char line[256];
+    unsigned long long kib = 0;
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        if (std::sscanf(line, "VmSize: %llu kB", &kib) == 1) {
+            break;
+        }
+    }
+    std::fclose(f);
+    return static_cast<std::size_t>(kib) * 1024;
+}
+#endif
+
+void check_huge_pages() {
+    using fnn::util::HugePages;
+    const auto saved = fnn::util::huge_page_policy();
+    // Thresholds below one huge page are raised to it.
+    fnn::util::set_huge_page_policy({HugePages::Advise, 1});
+    FNN_CHECK(fnn::util::huge_page_policy().threshold == 2 * kMiB);
+    fnn::util::set_huge_page_policy({HugePages::Advise, 4 * kMiB});
+    fnn::util::trim_buffer_pool();
+
+#if defined(__linux__)
+    // Below the threshold: operator new. At or above: a 2 MiB-aligned
+    // mapping that can be written end to end.
+    auto before = since({});
+    fnn::util::pool_deallocate(fnn::util::pool_allocate(kMiB), kMiB);
+    void* p = fnn::util::pool_allocate(6 * kMiB);
+    FNN_CHECK(aligned(p, 2 * kMiB));
+    std::memset(p, 1, 6 * kMiB);
+    fnn::util::pool_deallocate(p, 6 * kMiB);
+    auto s = since(before);
+    FNN_CHECK(s.system_allocations == 2 && s.huge_page_allocations == 1);
+    FNN_CHECK(s.huge_page_fallbacks == 0);
+    fnn::util::trim_buffer_pool();
+
+    fnn::util::set_huge_page_policy({HugePages::Off, 4 * kMiB});
+    before = since({});
+    fnn::util::pool_deallocate(fnn::util::pool_allocate(6 * kMiB), 6 * kMiB);
+    s = since(before);
+    FNN_CHECK(s.system_allocations == 1 && s.huge_page_allocations == 0);
+    fnn::util::trim_buffer_pool();
+
+    // With the address space capped so that the 8 MiB block fits but its
+    // over-aligned 10 MiB mapping does not, the request falls back to
+    // operator new and is counted as such.
+    fnn::util::set_huge_page_policy({HugePages::Advise, 4 * kMiB});
+    rlimit limit{};
+    const auto used = address_space();
+    if (used > 0 && getrlimit(RLIMIT_AS, &limit) == 0) {
+        const auto original = limit;
+        limit.rlim_cur = used + 9 * kMiB;
+        if (setrlimit(RLIMIT_AS, &limit) == 0) {
+            before = since({});
+            void* q = nullptr;
+            try {
+                q = fnn::util::pool_allocate(8 * kMiB);
+            } catch (const std::bad_alloc&) {
+            }
+            setrlimit(RLIMIT_AS, &original);
+            FNN_CHECK(q != nullptr && aligned(q, 64));
+            if (q != nullptr) {
+                std::memset(q, 1, 8 * kMiB);
+                fnn::util::pool_deallocate(q, 8 * kMiB);
+            }
+            s = since(before);
+            FNN_CHECK(s.huge_page_allocations == 0 && s.huge_page_fallbacks == 1);
+            fnn::util::trim_buffer_pool();
+        }
+    }
+#endif
+    fnn::util::set_huge_page_policy(saved);
+}
+
+} // namespace
+
+int main() {
+    check_reuse();
+    check_depot();
+    check_huge_pages();
+
+    // Copies, moves and resizes keep contents and zero new elements.
+    Buffer a(5);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        a.data()[i] = static_cast<Scalar>(i + 1);
+    }
+    Buffer b = a;
+    b.resize(8);
+    const std::vector<Scalar> expected = {1, 2, 3, 4, 5, 0, 0, 0};
+    FNN_CHECK_CLOSE(std::span<const Scalar>(b.data(), b.size()), expected, 0.0, "resize");
+    const Buffer moved = std::move(b);
+    FNN_CHECK(b.empty() && b.data() == nullptr && moved.size() == 8);
+    Buffer empty(0);
+    FNN_CHECK(empty.data() == nullptr);
+    return fnn::test::result();
+}
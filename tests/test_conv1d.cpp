@@ -0,0 +1,194 @@
+// Conv1D forward / backward, in both algorithms, against the defining sums
+// and central finite differences, over several kernel sizes, strides and
+// paddings.
+
+#include "fnn/layers/conv1d.hpp"
+#include "fnn/random.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::Conv1D;
+using fnn::Scalar;
+using fnn::Tensor;
+
+struct Case {
+    std::size_t batch;
+    std::size_t in;
+    std::size_t out;
+    std::size_t kernel;
+    std::size_t stride;
+    std::size_t padding;
+    std::size_t length;
+};
+
+// x[b, c, pos], zero outside [0, length).
+Scalar input_at(const Tensor& x, const Case& c, std::size_t b, std::size_t ch, std::size_t t,
+                std::size_t k) {
+    const auto pos = t * c.stride + k;
+    if (pos < c.padding || pos - c.padding >= c.length) {
+        return 0.0;
+    }
+    return x.data()[(b * c.in + ch) * c.length + pos - c.padding];
+}
+
+Tensor reference_forward(const Case& c, const fnn::Tensor2D& w, const fnn::Tensor2D& bias,
+                         const Tensor& x, std::size_t out_length) {
+    Tensor y({c.batch, c.out, out_length});
+    for (std::size_t b = 0; b < c.batch; ++b) {
+        for (std::size_t o = 0; o < c.out; ++o) {
+            for (std::size_t t = 0; t < out_length; ++t) {
+                Scalar acc = bias(0, o);
+                for (std::size_t ch = 0; ch < c.in; ++ch) {
+                    for (std::size_t k = 0; k < c.kernel; ++k) {
+                        acc += w(o, ch * c.kernel + k) * input_at(x, c, b, ch, t, k);
+                    }
+                }
+                y.data()[(b * c.out + o) * out_length + t] = acc;
+            }
+        }
+    }
+    return y;
+}
+
+// L = sum(dY * Y).
+Scalar loss(const Case& c, const fnn::Tensor2D& w, const fnn::Tensor2D& bias, const Tensor& x,
+            const Tensor& dy) {
+    const auto y = reference_forward(c, w, bias, x, dy.dims()[2]);
+    Scalar total = 0.0;
+    for (std::size_t i = 0; i < y.numel(); ++i) {
+        total += dy.data()[i] * y.data()[i];
+    }
+    return total;
+}
+
+std::span<const Scalar> all(const Tensor& t) { return {t.data(), t.numel()}; }
+
+std::span<const Scalar> all(const fnn::Tensor2D& t) { return {t.data(), t.size()}; }
+
+void check(const Case& c, Conv1D::Algorithm algorithm) {
+    const fnn::CounterRng rng(3, c.kernel * 100 + c.stride * 10 + c.padding);
+    Conv1D conv(c.in, c.out, c.kernel, rng, c.stride, c.padding);
+    conv.set_algorithm(algorithm);
+    fnn::fill_uniform(conv.mutable_bias(), rng.with_step(1000), -0.5, 0.5);
+    const auto out_length = conv.output_length(c.length);
+    Tensor x({c.batch, c.in, c.length});
+    Tensor dy({c.batch, c.out, out_length});
+    rng.with_step(1001).fill_uniform({x.data(), x.numel()}, 0, -1.0, 1.0);
+    rng.with_step(1002).fill_uniform({dy.data(), dy.numel()}, 0, -1.0, 1.0);
+
+    char what[128];
+    std::snprintf(what, sizeof(what), "in %zu out %zu kernel %zu stride %zu padding %zu, %s",
+                  c.in, c.out, c.kernel, c.stride, c.padding,
+                  algorithm == Conv1D::Algorithm::Direct ? "direct" : "gemm");
+
+    const auto y = conv.forward_batch(x);
+    auto w = conv.weights();
+    auto bias = conv.bias();
+    FNN_CHECK_CLOSE(all(y), all(reference_forward(c, w, bias, x, out_length)), 1e-12,
+                    "forward %s", what);
+
+    const auto dx = conv.backward_batch(dy);
+    Tensor dx_ref({c.batch, c.in, c.length});
+    fnn::Tensor2D dw_ref(c.out, c.in * c.kernel);
+    fnn::Tensor2D db_ref(1, c.out);
+    for (std::size_t b = 0; b < c.batch; ++b) {
+        for (std::size_t o = 0; o < c.out; ++o) {
+            for (std::size_t t = 0; t < out_length; ++t) {
+                const Scalar g = dy.data()[(b * c.out + o) * out_length + t];
+                db_ref(0, o) += g;
+                for (std::size_t ch = 0; ch < c.in; ++ch) {
+                    for (std::size_t k = 0; k < c.kernel; ++k) {
+                        dw_ref(o, ch * c.kernel + k) += g * input_at(x, c, b, ch, t, k);
+                        const auto pos = t * c.stride + k;
+                        if (pos >= c.padding && pos - c.padding < c.length) {
+                            dx_ref.data()[(b * c.in + ch) * c.length + pos - c.padding] +=
+                                g * w(o, ch * c.kernel + k);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    FNN_CHECK_CLOSE(all(dx), all(dx_ref), 1e-12, "dX %s", what);
+    FNN_CHECK_CLOSE(all(conv.weight_grad()), all(dw_ref), 1e-12, "dW %s", what);
+    FNN_CHECK_CLOSE(all(conv.bias_grad()), all(db_ref), 1e-12, "db %s", what);
+
+    // Central differences on a few weights and inputs.
+    constexpr Scalar kStep = 1e-6;
+    std::vector<Scalar> numeric;
+    std::vector<Scalar> analytic;
+    for (std::size_t i = 0; i < w.size(); i += w.size() / 5 + 1) {
+        const Scalar saved = w.data()[i];
+        w.data()[i] = saved + kStep;
+        const Scalar up = loss(c, w, bias, x, dy);
+        w.data()[i] = saved - kStep;
+        const Scalar down = loss(c, w, bias, x, dy);
+        w.data()[i] = saved;
+        numeric.push_back((up - down) / (2.0 * kStep));
+        analytic.push_back(conv.weight_grad().data()[i]);
+    }
+    for (std::size_t i = 0; i < x.numel(); i += x.numel() / 5 + 1) {
+        const Scalar saved = x.data()[i];
+        x.data()[i] = saved + kStep;
+        const Scalar up = loss(c, w, bias, x, dy);
+        x.data()[i] = saved - kStep;
+        const Scalar down = loss(c, w, bias, x, dy);
+        x.data()[i] = saved;
+        numeric.push_back((up - down) / (2.0 * kStep));
+        analytic.push_back(dx.data()[i]);
+    }
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-6, "finite differences %s", what);
+}
+
+} // namespace
+
+int main() {
+    // A shallow reduction and a deep one, with lengths that leave a partial
+    // last window for most strides.
+    constexpr Conv1D::Algorithm kAlgorithms[] = {Conv1D::Algorithm::Direct,
+                                                 Conv1D::Algorithm::Gemm};
+    for (const std::size_t kernel : {1, 3, 5}) {
+        for (const std::size_t stride : {1, 2, 3}) {
+            for (const std::size_t padding : {0, 1, 2}) {
+                for (const auto algorithm : kAlgorithms) {
+                    check({2, 3, 4, kernel, stride, padding, 11}, algorithm);
+                    check({3, 16, 9, kernel, stride, padding, 37}, algorithm);
+                }
+            }
+        }
+    }
+
+    // The single-sample interface is a batch of one.
+    const fnn::CounterRng rng(8);
+    Conv1D conv(2, 3, 3, rng, 2, 1);
+    fnn::Vector x(2 * 9);
+    rng.with_step(1).fill_uniform(x, 0, -1.0, 1.0);
+    const auto y = conv.forward(x);
+    Tensor batch({1, 2, 9});
+    std::copy(x.begin(), x.end(), batch.data());
+    const auto y_batch = conv.forward_batch(batch);
+    FNN_CHECK_CLOSE(y, all(y_batch), 0.0, "single-sample forward");
+    FNN_CHECK(conv.backward(fnn::Vector(y.size(), 1.0)).size() == x.size());
+    FNN_CHECK_THROWS(conv.forward(fnn::Vector(5)), std::invalid_argument);
+    FNN_CHECK_THROWS(conv.backward(fnn::Vector(1)), std::invalid_argument);
+
+    // Only the writable accessors bump version().
+    const auto version = conv.version();
+    (void)conv.weights();
+    FNN_CHECK(conv.version() == version);
+    (void)conv.mutable_weights();
+    FNN_CHECK(conv.version() != version);
+
+    Conv1D fresh(2, 3, 3);
+    FNN_CHECK_THROWS(fresh.backward_batch(Tensor({1, 3, 7})), std::logic_error);
+    FNN_CHECK_THROWS(fresh.forward_batch(Tensor({1, 3, 7})), std::invalid_argument);
+    FNN_CHECK_THROWS(Conv1D(0, 3, 3), std::invalid_argument);
+    return fnn::test::result();
+}
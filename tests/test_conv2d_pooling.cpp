@@ -0,0 +1,315 @@
+// Conv2D, MaxPool2D and AvgPool2D on blocked images, against plain NCHW
+// loops (through to_nchwc / from_nchwc) and, for Conv2D, against central
+// finite differences; then the single-sample path through a Sequential.
+
+#include "fnn/layers/conv2d.hpp"
+#include "fnn/layers/pooling.hpp"
+#include "fnn/model.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor_permute.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::Scalar;
+using fnn::Tensor;
+
+std::span<const Scalar> all(const Tensor& t) { return {t.data(), t.numel()}; }
+
+// Element (n, c, h, w) of an NCHW tensor.
+Scalar& at(Tensor& t, std::size_t n, std::size_t c, std::size_t h, std::size_t w) {
+    const auto& d = t.dims();
+    return t.data()[((n * d[1] + c) * d[2] + h) * d[3] + w];
+}
+
+Scalar at(const Tensor& t, std::size_t n, std::size_t c, std::size_t h, std::size_t w) {
+    const auto& d = t.dims();
+    return t.data()[((n * d[1] + c) * d[2] + h) * d[3] + w];
+}
+
+Tensor random_tensor(fnn::Dims dims, const fnn::CounterRng& rng) {
+    Tensor t(std::move(dims));
+    rng.fill_uniform({t.data(), t.numel()}, 0, -1.0, 1.0);
+    return t;
+}
+
+struct Conv {
+    std::size_t in;
+    std::size_t out;
+    std::size_t kh;
+    std::size_t kw;
+    std::size_t stride;
+    std::size_t padding;
+};
+
+// x[n, c, h, w] with zero padding; (i, j) are padded coordinates.
+Scalar padded(const Tensor& x, const Conv& c, std::size_t n, std::size_t ch, std::size_t i,
+              std::size_t j) {
+    const auto& d = x.dims();
+    if (i < c.padding || j < c.padding || i - c.padding >= d[2] || j - c.padding >= d[3]) {
+        return 0.0;
+    }
+    return at(x, n, ch, i - c.padding, j - c.padding);
+}
+
+Tensor reference_conv(const Conv& c, const Tensor& w, const Tensor& b, const Tensor& x,
+                      std::size_t oh, std::size_t ow) {
+    const auto batch = x.dims()[0];
+    Tensor y({batch, c.out, oh, ow});
+    for (std::size_t n = 0; n < batch; ++n) {
+        for (std::size_t o = 0; o < c.out; ++o) {
+            for (std::size_t i = 0; i < oh; ++i) {
+                for (std::size_t j = 0; j < ow; ++j) {
+                    Scalar acc = b.data()[o];
+                    for (std::size_t ch = 0; ch < c.in; ++ch) {
+                        for (std::size_t u = 0; u < c.kh; ++u) {
+                            for (std::size_t v = 0; v < c.kw; ++v) {
+                                acc += at(w, o, ch, u, v) *
+                                       padded(x, c, n, ch, i * c.stride + u, j * c.stride + v);
+                            }
+                        }
+                    }
+                    at(y, n, o, i, j) = acc;
+                }
+            }
+        }
+    }
+    return y;
+}
+
+// L = sum(dY * Y).
+Scalar conv_loss(const Conv& c, const Tensor& w, const Tensor& b, const Tensor& x,
+                 const Tensor& dy) {
+    const auto y = reference_conv(c, w, b, x, dy.dims()[2], dy.dims()[3]);
+    Scalar total = 0.0;
+    for (std::size_t i = 0; i < y.numel(); ++i) {
+        total += dy.data()[i] * y.data()[i];
+    }
+    return total;
+}
+
+void check_conv(const Conv& c, std::size_t height, std::size_t width) {
+    const fnn::CounterRng rng(21, c.in * 100 + c.out,
+                              static_cast<std::uint32_t>(c.kh * 10 + c.kw));
+    fnn::Conv2D conv(c.in, c.out, c.kh, c.kw, c.stride, c.padding);
+    Tensor w = random_tensor({c.out, c.in, c.kh, c.kw}, rng.with_step(1));
+    fnn::Tensor2D bias(1, c.out);
+    fnn::fill_uniform(bias, rng.with_step(2), -0.5, 0.5);
+    conv.set_weights(w, bias);
+    Tensor b({c.out});
+    std::copy(bias.data(), bias.data() + c.out, b.data());
+
+    const auto oh = conv.output_size(height, c.kh);
+    const auto ow = conv.output_size(width, c.kw);
+    Tensor x = random_tensor({2, c.in, height, width}, rng.with_step(3));
+    const Tensor dy = random_tensor({2, c.out, oh, ow}, rng.with_step(4));
+
+    char what[128];
+    std::snprintf(what, sizeof(what), "%zu -> %zu, %zux%zu kernel, stride %zu, padding %zu",
+                  c.in, c.out, c.kh, c.kw, c.stride, c.padding);
+
+    FNN_CHECK_CLOSE(all(conv.weights()), all(w), 0.0, "weights round trip %s", what);
+    const auto y = fnn::from_nchwc(conv.forward_batch(fnn::to_nchwc(x)), c.out);
+    FNN_CHECK_CLOSE(all(y), all(reference_conv(c, w, b, x, oh, ow)), 1e-12, "forward %s",
+                    what);
+
+    const auto dx = fnn::from_nchwc(conv.backward_batch(fnn::to_nchwc(dy)), c.in);
+    Tensor dx_ref({2, c.in, height, width});
+    Tensor dw_ref({c.out, c.in, c.kh, c.kw});
+    std::vector<Scalar> db_ref(c.out, 0.0);
+    for (std::size_t n = 0; n < 2; ++n) {
+        for (std::size_t o = 0; o < c.out; ++o) {
+            for (std::size_t i = 0; i < oh; ++i) {
+                for (std::size_t j = 0; j < ow; ++j) {
+                    const Scalar g = at(dy, n, o, i, j);
+                    db_ref[o] += g;
+                    for (std::size_t ch = 0; ch < c.in; ++ch) {
+                        for (std::size_t u = 0; u < c.kh; ++u) {
+                            for (std::size_t v = 0; v < c.kw; ++v) {
+                                const auto pi = i * c.stride + u;
+                                const auto pj = j * c.stride + v;
+                                at(dw_ref, o, ch, u, v) += g * padded(x, c, n, ch, pi, pj);
+                                if (pi >= c.padding && pj >= c.padding &&
+                                    pi - c.padding < height && pj - c.padding < width) {
+                                    at(dx_ref, n, ch, pi - c.padding, pj - c.padding) +=
+                                        g * at(w, o, ch, u, v);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    FNN_CHECK_CLOSE(all(dx), all(dx_ref), 1e-12, "dX %s", what);
+    FNN_CHECK_CLOSE(all(conv.weight_grad()), all(dw_ref), 1e-12, "dW %s", what);
+    const std::span<const Scalar> db(conv.bias_grad().data(), c.out);
+    FNN_CHECK_CLOSE(db, db_ref, 1e-12, "db %s", what);
+
+    // Central differences on a few weights and inputs.
+    constexpr Scalar kStep = 1e-6;
+    std::vector<Scalar> numeric;
+    std::vector<Scalar> analytic;
+    const auto dw = conv.weight_grad();
+    for (std::size_t i = 0; i < w.numel(); i += w.numel() / 5 + 1) {
+        const Scalar saved = w.data()[i];
+        w.data()[i] = saved + kStep;
+        const Scalar up = conv_loss(c, w, b, x, dy);
+        w.data()[i] = saved - kStep;
+        const Scalar down = conv_loss(c, w, b, x, dy);
+        w.data()[i] = saved;
+        numeric.push_back((up - down) / (2.0 * kStep));
+        analytic.push_back(dw.data()[i]);
+    }
+    for (std::size_t i = 0; i < x.numel(); i += x.numel() / 5 + 1) {
+        const Scalar saved = x.data()[i];
+        x.data()[i] = saved + kStep;
+        const Scalar up = conv_loss(c, w, b, x, dy);
+        x.data()[i] = saved - kStep;
+        const Scalar down = conv_loss(c, w, b, x, dy);
+        x.data()[i] = saved;
+        numeric.push_back((up - down) / (2.0 * kStep));
+        analytic.push_back(dx.data()[i]);
+    }
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-6, "finite differences %s", what);
+}
+
+// Max and mean of every window, and the gradients routed back through
+// them, in NCHW.
+void check_pooling(std::size_t channels, std::size_t kernel, std::size_t stride,
+                   std::size_t height, std::size_t width) {
+    const fnn::CounterRng rng(22, kernel * 10 + stride, static_cast<std::uint32_t>(channels));
+    const Tensor x = random_tensor({2, channels, height, width}, rng.with_step(1));
+    const auto oh = (height - kernel) / stride + 1;
+    const auto ow = (width - kernel) / stride + 1;
+    const Tensor dy = random_tensor({2, channels, oh, ow}, rng.with_step(2));
+
+    Tensor max_ref({2, channels, oh, ow});
+    Tensor avg_ref({2, channels, oh, ow});
+    Tensor dmax_ref({2, channels, height, width});
+    Tensor davg_ref({2, channels, height, width});
+    const Scalar area = static_cast<Scalar>(kernel * kernel);
+    for (std::size_t n = 0; n < 2; ++n) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            for (std::size_t i = 0; i < oh; ++i) {
+                for (std::size_t j = 0; j < ow; ++j) {
+                    std::size_t best_h = i * stride;
+                    std::size_t best_w = j * stride;
+                    Scalar sum = 0.0;
+                    for (std::size_t u = 0; u < kernel; ++u) {
+                        for (std::size_t v = 0; v < kernel; ++v) {
+                            const Scalar value = at(x, n, c, i * stride + u, j * stride + v);
+                            sum += value;
+                            if (value > at(x, n, c, best_h, best_w)) {
+                                best_h = i * stride + u;
+                                best_w = j * stride + v;
+                            }
+                            at(davg_ref, n, c, i * stride + u, j * stride + v) +=
+                                at(dy, n, c, i, j) / area;
+                        }
+                    }
+                    at(max_ref, n, c, i, j) = at(x, n, c, best_h, best_w);
+                    at(avg_ref, n, c, i, j) = sum / area;
+                    at(dmax_ref, n, c, best_h, best_w) += at(dy, n, c, i, j);
+                }
+            }
+        }
+    }
+
+    char what[96];
+    std::snprintf(what, sizeof(what), "%zu channels, kernel %zu, stride %zu", channels, kernel,
+                  stride);
+    fnn::MaxPool2D max_pool(kernel, stride);
+    fnn::AvgPool2D avg_pool(kernel, stride);
+    const auto blocked = fnn::to_nchwc(x);
+    const auto blocked_dy = fnn::to_nchwc(dy);
+    const auto max = fnn::from_nchwc(max_pool.forward_batch(blocked), channels);
+    const auto avg = fnn::from_nchwc(avg_pool.forward_batch(blocked), channels);
+    FNN_CHECK_CLOSE(all(max), all(max_ref), 0.0, "max forward %s", what);
+    FNN_CHECK_CLOSE(all(avg), all(avg_ref), 1e-14, "avg forward %s", what);
+    const auto dmax = fnn::from_nchwc(max_pool.backward_batch(blocked_dy), channels);
+    const auto davg = fnn::from_nchwc(avg_pool.backward_batch(blocked_dy), channels);
+    FNN_CHECK_CLOSE(all(dmax), all(dmax_ref), 1e-14, "max backward %s", what);
+    FNN_CHECK_CLOSE(all(davg), all(davg_ref), 1e-14, "avg backward %s", what);
+}
+
+// One image, flattened in the blocked layout.
+fnn::Vector image(const Tensor& blocked, std::size_t n) {
+    const auto size = blocked.numel() / blocked.dims()[0];
+    return {blocked.data() + n * size, blocked.data() + (n + 1) * size};
+}
+
+void check_sequential() {
+    const fnn::CounterRng rng(23);
+    fnn::Sequential model;
+    auto& conv1 = static_cast<fnn::Conv2D&>(
+        model.add(std::make_unique<fnn::Conv2D>(3, 10, 3, 3, rng.with_layer(1), 1, 1)));
+    auto& pool1 = static_cast<fnn::MaxPool2D&>(model.add(std::make_unique<fnn::MaxPool2D>(2)));
+    auto& conv2 = static_cast<fnn::Conv2D&>(
+        model.add(std::make_unique<fnn::Conv2D>(10, 4, 3, 3, rng.with_layer(2))));
+    auto& pool2 = static_cast<fnn::AvgPool2D&>(model.add(std::make_unique<fnn::AvgPool2D>(3)));
+
+    const auto blocked = fnn::to_nchwc(random_tensor({2, 3, 10, 10}, rng.with_step(1)));
+    FNN_CHECK_THROWS(conv1.forward(image(blocked, 0)), std::logic_error);
+    conv1.set_input_size(10, 10);
+    pool1.set_input_size(10, 10);
+    conv2.set_input_size(5, 5);
+    pool2.set_input_size(3, 3);
+    FNN_CHECK_THROWS(conv2.set_input_size(0, 5), std::invalid_argument);
+    FNN_CHECK_THROWS(conv1.forward(fnn::Vector(3 * 10 * 10)), std::invalid_argument);
+
+    const auto expected = pool2.forward_batch(
+        conv2.forward_batch(pool1.forward_batch(conv1.forward_batch(blocked))));
+    Tensor ones({2, 1, 1, 1, 8});
+    std::fill(ones.data(), ones.data() + ones.numel(), 1.0);
+    const auto d_expected = conv1.backward_batch(
+        pool1.backward_batch(conv2.backward_batch(pool2.backward_batch(ones))));
+
+    // Each image through predict(), then back through the Vector interface.
+    for (std::size_t n = 0; n < 2; ++n) {
+        auto y = model.predict(image(blocked, n));
+        FNN_CHECK_CLOSE(y, image(expected, n), 1e-14, "Sequential predict, image %zu", n);
+        std::fill(y.begin(), y.end(), 1.0);
+        const auto dx = conv1.backward(pool1.backward(conv2.backward(pool2.backward(y))));
+        FNN_CHECK_CLOSE(dx, image(d_expected, n), 1e-14, "single-image backward, image %zu",
+                        n);
+    }
+}
+
+} // namespace
+
+int main() {
+    constexpr Conv kConvs[] = {
+        {3, 5, 3, 3, 1, 0},  {3, 5, 3, 3, 1, 1}, {3, 5, 3, 3, 2, 1}, {9, 17, 1, 1, 1, 0},
+        {9, 17, 2, 3, 2, 0}, {8, 8, 3, 3, 1, 2}, {1, 1, 5, 5, 3, 2},
+    };
+    for (const auto& c : kConvs) {
+        check_conv(c, 7, 6);
+    }
+    for (const std::size_t channels : {3, 8, 11}) {
+        check_pooling(channels, 2, 2, 6, 7);
+        check_pooling(channels, 3, 1, 7, 5);
+        check_pooling(channels, 3, 2, 8, 9);
+    }
+    check_sequential();
+
+    fnn::Conv2D conv(3, 4, 3, 3);
+    FNN_CHECK_THROWS(conv.backward_batch(Tensor({1, 1, 5, 5, 8})), std::logic_error);
+    FNN_CHECK_THROWS(conv.forward_batch(Tensor({1, 3, 5, 5})), std::invalid_argument);
+    FNN_CHECK_THROWS(conv.set_weights(Tensor({4, 3, 2, 3}), fnn::Tensor2D(1, 4)),
+                     std::invalid_argument);
+    fnn::MaxPool2D max_pool(2);
+    FNN_CHECK_THROWS(max_pool.backward_batch(Tensor({1, 1, 2, 2, 8})), std::logic_error);
+    FNN_CHECK_THROWS(fnn::MaxPool2D(0), std::invalid_argument);
+    fnn::AvgPool2D avg_pool(2);
+    FNN_CHECK_THROWS(avg_pool.backward(fnn::Vector(8)), std::logic_error);
+    return fnn::test::result();
+}
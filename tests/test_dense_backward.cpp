@@ -0,0 +1,293 @@
+// Dense::backward_batch against an unfused three-pass reference (forward,
+// then dZ = dY * f'(Z), then dW / db / dX from dZ) and against central
+// finite differences of L = sum(dY * Y), for every activation, for batches
+// that are not whole multiples of the backward tile, and on each backend.
+
+#include "fnn/backend.hpp"
+#include "fnn/layers/dense.hpp"
+#include "fnn/random.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using fnn::ActivationKind;
+using fnn::Scalar;
+using fnn::Tensor2D;
+
+constexpr Scalar kAlpha = 0.05;
+
+Scalar activate(ActivationKind kind, Scalar z) {
+    switch (kind) {
+    case ActivationKind::Identity:
+        return z;
+    case ActivationKind::ReLU:
+        return z > 0.0 ? z : 0.0;
+    case ActivationKind::LeakyReLU:
+        return z > 0.0 ? z : kAlpha * z;
+    case ActivationKind::Sigmoid:
+        return 1.0 / (1.0 + std::exp(-z));
+    case ActivationKind::Tanh:
+        return std::tanh(z);
+    }
+    return z;
+}
+
+Scalar derivative(ActivationKind kind, Scalar z) {
+    switch (kind) {
+    case ActivationKind::Identity:
+        return 1.0;
+    case ActivationKind::ReLU:
+        return z > 0.0 ? 1.0 : 0.0;
+    case ActivationKind::LeakyReLU:
+        return z > 0.0 ? 1.0 : kAlpha;
+    case ActivationKind::Sigmoid: {
+        const Scalar s = activate(kind, z);
+        return s * (1.0 - s);
+    }
+    case ActivationKind::Tanh: {
+        const Scalar t = std::tanh(z);
+        return 1.0 - t * t;
+    }
+    }
+    return 1.0;
+}
+
+const char* name(ActivationKind kind) {
+    constexpr const char* kNames[] = {"Identity", "ReLU", "LeakyReLU", "Sigmoid", "Tanh"};
+    return kNames[static_cast<int>(kind)];
+}
+
+// Z = X W^T + b, plain loops.
+Tensor2D pre_activation(const Tensor2D& w, const Tensor2D& b, const Tensor2D& x) {
+    Tensor2D z(x.rows(), w.rows());
+    for (std::size_t r = 0; r < x.rows(); ++r) {
+        for (std::size_t o = 0; o < w.rows(); ++o) {
+            Scalar acc = b(0, o);
+            for (std::size_t i = 0; i < w.cols(); ++i) {
+                acc += x(r, i) * w(o, i);
+            }
+            z(r, o) = acc;
+        }
+    }
+    return z;
+}
+
+// L = sum(dY * f(Z)).
+Scalar loss(ActivationKind kind, const Tensor2D& w, const Tensor2D& b, const Tensor2D& x,
+            const Tensor2D& dy) {
+    const auto z = pre_activation(w, b, x);
+    Scalar total = 0.0;
+    for (std::size_t r = 0; r < z.rows(); ++r) {
+        for (std::size_t o = 0; o < z.cols(); ++o) {
+            total += dy(r, o) * activate(kind, z(r, o));
+        }
+    }
+    return total;
+}
+
+struct Gradients {
+    Tensor2D dx{0, 0};
+    Tensor2D dw{0, 0};
+    Tensor2D db{0, 0};
+};
+
+Gradients reference(ActivationKind kind, const Tensor2D& w, const Tensor2D& b,
+                    const Tensor2D& x, const Tensor2D& dy) {
+    const auto z = pre_activation(w, b, x);
+    Tensor2D dz(z.rows(), z.cols());
+    for (std::size_t r = 0; r < z.rows(); ++r) {
+        for (std::size_t o = 0; o < z.cols(); ++o) {
+            dz(r, o) = dy(r, o) * derivative(kind, z(r, o));
+        }
+    }
+    Gradients g{Tensor2D(x.rows(), x.cols()), Tensor2D(w.rows(), w.cols()),
+                Tensor2D(1, w.rows())};
+    for (std::size_t o = 0; o < w.rows(); ++o) {
+        for (std::size_t i = 0; i < w.cols(); ++i) {
+            Scalar acc = 0.0;
+            for (std::size_t r = 0; r < x.rows(); ++r) {
+                acc += dz(r, o) * x(r, i);
+            }
+            g.dw(o, i) = acc;
+        }
+        for (std::size_t r = 0; r < x.rows(); ++r) {
+            g.db(0, o) += dz(r, o);
+        }
+    }
+    for (std::size_t r = 0; r < x.rows(); ++r) {
+        for (std::size_t i = 0; i < x.cols(); ++i) {
+            Scalar acc = 0.0;
+            for (std::size_t o = 0; o < w.rows(); ++o) {
+                acc += dz(r, o) * w(o, i);
+            }
+            g.dx(r, i) = acc;
+        }
+    }
+    return g;
+}
+
+std::span<const Scalar> all(const Tensor2D& t) { return {t.data(), t.size()}; }
+
+// Central differences of loss() for a few entries of `param`, against
+// `grad` at the same entries.
+void check_finite_differences(ActivationKind kind, Tensor2D& w, Tensor2D& b, Tensor2D& x,
+                              const Tensor2D& dy, Tensor2D& param, const Tensor2D& grad,
+                              const char* what) {
+    constexpr Scalar kStep = 1e-6;
+    const auto stride = std::max<std::size_t>(1, param.size() / 7);
+    std::vector<Scalar> numeric;
+    std::vector<Scalar> analytic;
+    for (std::size_t i = 0; i < param.size(); i += stride) {
+        const Scalar saved = param.data()[i];
+        param.data()[i] = saved + kStep;
+        const Scalar up = loss(kind, w, b, x, dy);
+        param.data()[i] = saved - kStep;
+        const Scalar down = loss(kind, w, b, x, dy);
+        param.data()[i] = saved;
+        numeric.push_back((up - down) / (2.0 * kStep));
+        analytic.push_back(grad.data()[i]);
+    }
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-6, "%s finite differences, %s", what, name(kind));
+}
+
+void check_layer(std::size_t in, std::size_t out, std::size_t batch, ActivationKind kind,
+                 bool finite_differences) {
+    const fnn::CounterRng rng(11, batch, static_cast<std::uint32_t>(in * 1000 + out));
+    fnn::Dense layer(in, out, rng, kind, kAlpha);
+    fnn::fill_uniform(layer.mutable_bias(), rng.with_step(1000), -0.5, 0.5);
+    Tensor2D x(batch, in);
+    Tensor2D dy(batch, out);
+    fnn::fill_uniform(x, rng.with_step(1001), -1.0, 1.0);
+    fnn::fill_uniform(dy, rng.with_step(1002), -1.0, 1.0);
+
+    const auto y = layer.forward_batch(x);
+    const auto dx = layer.backward_batch(dy);
+    Tensor2D w = layer.weights();
+    Tensor2D b = layer.bias();
+    const auto expected = reference(kind, w, b, x, dy);
+
+    const auto backend = fnn::active_backend().name();
+    char shape[96];
+    std::snprintf(shape, sizeof(shape), "%zu -> %zu, batch %zu, %s, %.*s", in, out, batch,
+                  name(kind), static_cast<int>(backend.size()), backend.data());
+    Tensor2D y_ref = pre_activation(w, b, x);
+    for (std::size_t i = 0; i < y_ref.size(); ++i) {
+        y_ref.data()[i] = activate(kind, y_ref.data()[i]);
+    }
+    FNN_CHECK_CLOSE(all(y), all(y_ref), 1e-12, "forward %s", shape);
+    FNN_CHECK_CLOSE(all(dx), all(expected.dx), 1e-11, "dX %s", shape);
+    FNN_CHECK_CLOSE(all(layer.weight_grad()), all(expected.dw), 1e-11, "dW %s", shape);
+    FNN_CHECK_CLOSE(all(layer.bias_grad()), all(expected.db), 1e-11, "db %s", shape);
+
+    // A second backward accumulates into the parameter gradients only.
+    (void)layer.forward_batch(x);
+    const auto dx_again = layer.backward_batch(dy);
+    FNN_CHECK_CLOSE(all(dx_again), all(expected.dx), 1e-11, "dX again %s", shape);
+    Tensor2D twice = expected.dw;
+    for (std::size_t i = 0; i < twice.size(); ++i) {
+        twice.data()[i] *= 2.0;
+    }
+    FNN_CHECK_CLOSE(all(layer.weight_grad()), all(twice), 1e-11, "dW accumulated %s", shape);
+
+    if (finite_differences) {
+        check_finite_differences(kind, w, b, x, dy, w, expected.dw, "dW");
+        check_finite_differences(kind, w, b, x, dy, b, expected.db, "db");
+        check_finite_differences(kind, w, b, x, dy, x, dx, "dX");
+    }
+}
+
+// Forwards to `inner` and counts matmul() calls; registered under the
+// built-in "optimized" name to check that Dense still goes through it.
+class CountingBackend final : public fnn::Backend {
+public:
+    explicit CountingBackend(std::shared_ptr<const fnn::Backend> inner)
+        : inner_(std::move(inner)) {}
+
+    [[nodiscard]] std::string_view name() const noexcept override { return "optimized"; }
+
+    void matmul(Scalar alpha, const fnn::MatrixRef& a, const fnn::MatrixRef& b, Scalar beta,
+                const fnn::MutableMatrixRef& c) const override {
+        ++calls;
+        inner_->matmul(alpha, a, b, beta, c);
+    }
+
+    void elementwise(fnn::BinaryOp op, const Scalar* a, const Scalar* b, Scalar* out,
+                     std::size_t n) const override {
+        inner_->elementwise(op, a, b, out, n);
+    }
+
+    void reduce_sum(const fnn::MatrixRef& m, fnn::ReduceAxis axis, Scalar* out) const override {
+        inner_->reduce_sum(m, axis, out);
+    }
+
+    void activation(ActivationKind kind, Scalar alpha, const Scalar* in, Scalar* out,
+                    std::size_t n) const override {
+        inner_->activation(kind, alpha, in, out, n);
+    }
+
+    mutable std::atomic<std::size_t> calls{0};
+
+private:
+    std::shared_ptr<const fnn::Backend> inner_;
+};
+
+} // namespace
+
+int main() {
+    struct Shape {
+        std::size_t in;
+        std::size_t out;
+        std::size_t batch;
+        bool finite_differences;
+    };
+    // Batches around the 256-row tile, and widths around the 8- and 256-unit
+    // output blocks.
+    constexpr Shape kShapes[] = {
+        {5, 3, 1, true},      {19, 23, 7, true},     {12, 9, 257, true},
+        {33, 300, 259, false}, {64, 40, 300, false}, {17, 513, 3, false},
+    };
+    constexpr ActivationKind kKinds[] = {ActivationKind::Identity, ActivationKind::ReLU,
+                                         ActivationKind::LeakyReLU, ActivationKind::Sigmoid,
+                                         ActivationKind::Tanh};
+    for (const auto* backend : {"optimized", "reference", "blas"}) {
+        if (!fnn::find_backend(backend)) {
+            continue;
+        }
+        fnn::set_active_backend(backend);
+        for (const auto& s : kShapes) {
+            for (const auto kind : kKinds) {
+                check_layer(s.in, s.out, s.batch, kind, s.finite_differences);
+            }
+        }
+    }
+
+    fnn::Dense layer(4, 3);
+    FNN_CHECK_THROWS(layer.backward_batch(Tensor2D(1, 3)), std::logic_error);
+    (void)layer.forward_batch(Tensor2D(2, 4));
+    FNN_CHECK_THROWS(layer.backward_batch(Tensor2D(3, 3)), std::invalid_argument);
+
+    // A backend registered over "optimized" sees every product: the
+    // single-row forward, the batched forward and backward.
+    auto counting = std::make_shared<CountingBackend>(fnn::find_backend("optimized"));
+    fnn::register_backend(counting);
+    fnn::set_active_backend("optimized");
+    FNN_CHECK(!fnn::active_backend().prefers_layer_kernels());
+    (void)layer.forward(fnn::Vector(4, 1.0));
+    FNN_CHECK(counting->calls == 1);
+    (void)layer.forward_batch(Tensor2D(3, 4));
+    (void)layer.backward_batch(Tensor2D(3, 3));
+    FNN_CHECK(counting->calls >= 3);
+    return fnn::test::result();
+}
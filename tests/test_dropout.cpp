@@ -0,0 +1,115 @@
+// Dropout: Packed and Regenerate masks agree with each other and with the
+// CounterRng stream they are defined by, backward applies the forward's
+// mask, and inference is the identity.
+
+#include "fnn/layers/dropout.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::Dropout;
+using fnn::Scalar;
+using fnn::Tensor2D;
+
+constexpr std::uint64_t kSeed = 99;
+constexpr std::uint32_t kLayer = 5;
+
+std::span<const Scalar> all(const Tensor2D& t) { return {t.data(), t.size()}; }
+
+void check(Scalar rate, std::size_t rows, std::size_t cols) {
+    Dropout packed(rate, kSeed, kLayer, Dropout::MaskStorage::Packed);
+    Dropout regenerate(rate, kSeed, kLayer, Dropout::MaskStorage::Regenerate);
+    const fnn::CounterRng rng(kSeed, 0, kLayer);
+    const Scalar scale = 1.0 / (1.0 - rate);
+    const auto n = rows * cols;
+
+    for (std::uint64_t step = 0; step < 2; ++step) {
+        Tensor2D x(rows, cols);
+        fnn::fill_uniform(x, rng.with_step(1000 + step), 0.5, 1.5);
+        Tensor2D a = x;
+        Tensor2D b = x;
+        FNN_CHECK(packed.step() == step);
+        packed.forward_inplace(a);
+        regenerate.forward_inplace(b);
+        FNN_CHECK_CLOSE(all(a), all(b), 0.0, "Packed vs Regenerate forward, %zu x %zu, step %d",
+                        rows, cols, static_cast<int>(step));
+
+        // Element i survives iff uniform(i) >= rate on this step's stream.
+        Tensor2D expected(rows, cols);
+        const auto mask = rng.with_step(step);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const bool keep = mask.uniform(i) >= rate;
+            kept += keep ? 1 : 0;
+            expected.data()[i] = keep ? x.data()[i] * scale : 0.0;
+        }
+        FNN_CHECK_CLOSE(all(a), all(expected), 1e-15, "forward against the stream, %zu x %zu",
+                        rows, cols);
+        if (n >= 10000) {
+            const Scalar keep_rate = static_cast<Scalar>(kept) / static_cast<Scalar>(n);
+            FNN_CHECK_CLOSE(std::span<const Scalar>(&keep_rate, 1),
+                            std::vector<Scalar>{1.0 - rate}, 0.01, "keep rate %g", rate);
+        }
+
+        // Backward scales by the same mask: dX = mask * scale * dY.
+        Tensor2D dy(rows, cols);
+        fnn::fill_uniform(dy, rng.with_step(2000 + step), -1.0, 1.0);
+        Tensor2D da = dy;
+        Tensor2D db = dy;
+        packed.backward_inplace(da);
+        regenerate.backward_inplace(db);
+        FNN_CHECK_CLOSE(all(da), all(db), 0.0, "Packed vs Regenerate backward, %zu x %zu",
+                        rows, cols);
+        for (std::size_t i = 0; i < n; ++i) {
+            expected.data()[i] = expected.data()[i] == 0.0 ? 0.0 : dy.data()[i] * scale;
+        }
+        FNN_CHECK_CLOSE(all(da), all(expected), 1e-15, "backward against forward, %zu x %zu",
+                        rows, cols);
+    }
+    FNN_CHECK(packed.mask_bytes() == (n + 63) / 64 * sizeof(std::uint64_t));
+    FNN_CHECK(regenerate.mask_bytes() == 0);
+}
+
+} // namespace
+
+int main() {
+    for (const Scalar rate : {0.0, 0.1, 0.5, 0.9}) {
+        check(rate, 1, 1);
+        check(rate, 3, 21);
+        check(rate, 301, 1003);
+    }
+
+    // The single-sample path uses the same stream as a one-row batch.
+    Dropout single(0.3, kSeed, kLayer);
+    Dropout batched(0.3, kSeed, kLayer);
+    const fnn::Vector x(100, 1.0);
+    Tensor2D row(1, 100);
+    std::fill(row.data(), row.data() + 100, 1.0);
+    const auto y = single.forward(x);
+    batched.forward_inplace(row);
+    FNN_CHECK_CLOSE(y, all(row), 0.0, "single-sample forward");
+    FNN_CHECK_CLOSE(single.backward(x), y, 0.0, "single-sample backward");
+
+    // Inference is the identity and keeps no mask.
+    Dropout inference(0.5, kSeed, kLayer);
+    inference.set_training(false);
+    FNN_CHECK_CLOSE(inference.forward(x), x, 0.0, "inference forward");
+    FNN_CHECK(inference.step() == 0);
+    FNN_CHECK(inference.activation_memory().saved_bytes == 0);
+
+    FNN_CHECK_THROWS(Dropout(1.0, kSeed, kLayer), std::invalid_argument);
+    FNN_CHECK_THROWS(Dropout(-0.1, kSeed, kLayer), std::invalid_argument);
+    Dropout fresh(0.5, kSeed, kLayer);
+    FNN_CHECK_THROWS(fresh.backward(x), std::logic_error);
+    (void)fresh.forward(x);
+    FNN_CHECK_THROWS(fresh.backward(fnn::Vector(99)), std::invalid_argument);
+    return fnn::test::result();
+}
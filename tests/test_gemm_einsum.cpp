@@ -0,0 +1,297 @@
+// gemm(), the GemmConfig and pre-packed overloads, gemm_batched() and
+// einsum() against naive loops: transposed and strided views, products
+// below and above the small-GEMM cutoff (32^3 multiply-adds), and einsum
+// specs that map onto strides as well as ones that need packing.
+
+#include "fnn/einsum.hpp"
+#include "fnn/gemm.hpp"
+#include "fnn/random.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using fnn::MatrixRef;
+using fnn::MutableMatrixRef;
+using fnn::Scalar;
+using fnn::Tensor;
+
+std::vector<Scalar> random_values(std::size_t n, std::uint64_t seed) {
+    std::vector<Scalar> v(n);
+    fnn::CounterRng(seed).fill_uniform(v, 0, -1.0, 1.0);
+    return v;
+}
+
+// C = alpha * A * B + beta * C, one element at a time; C is not read when
+// beta == 0.
+void naive_gemm(Scalar alpha, const MatrixRef& a, const MatrixRef& b, Scalar beta,
+                const MutableMatrixRef& c) {
+    for (std::size_t i = 0; i < c.rows; ++i) {
+        for (std::size_t j = 0; j < c.cols; ++j) {
+            Scalar acc = 0.0;
+            for (std::size_t p = 0; p < a.cols; ++p) {
+                acc += a.data[i * a.row_stride + p * a.col_stride] *
+                       b.data[p * b.row_stride + j * b.col_stride];
+            }
+            Scalar& dst = c.data[i * c.row_stride + j * c.col_stride];
+            dst = beta == 0.0 ? alpha * acc : alpha * acc + beta * dst;
+        }
+    }
+}
+
+// An m x n view into storage of `rows` x `cols` (row-major, or column-major
+// when `transposed`), starting at (1, 2) of the storage when `offset`.
+struct View {
+    std::vector<Scalar> storage;
+    MatrixRef ref;
+};
+
+View make_view(std::size_t m, std::size_t n, bool transposed, bool offset, std::uint64_t seed) {
+    const std::size_t pad = offset ? 3 : 0;
+    const auto rows = m + pad;
+    const auto cols = n + pad;
+    View v{random_values(rows * cols, seed), {}};
+    const auto r0 = offset ? std::size_t{1} : 0;
+    const auto c0 = offset ? std::size_t{2} : 0;
+    if (transposed) {
+        v.ref = {v.storage.data() + c0 * rows + r0, m, n, 1, rows};
+    } else {
+        v.ref = {v.storage.data() + r0 * cols + c0, m, n, cols, 1};
+    }
+    return v;
+}
+
+void check_gemm(std::size_t m, std::size_t n, std::size_t k) {
+    for (int layout = 0; layout < 8; ++layout) {
+        const bool ta = (layout & 1) != 0;
+        const bool tb = (layout & 2) != 0;
+        const bool offset = (layout & 4) != 0;
+        const auto a = make_view(m, k, ta, offset, 1 + layout);
+        const auto b = make_view(k, n, tb, offset, 100 + layout);
+        // C strided too: every other column of a wider buffer.
+        const std::size_t c_stride = offset ? 2 * n + 1 : n;
+        const std::size_t c_col = offset ? 2 : 1;
+        for (const auto& [alpha, beta] : {std::pair{1.0, 0.0}, std::pair{-0.5, 1.0},
+                                         std::pair{2.0, 0.25}}) {
+            auto c = random_values(m * c_stride + 1, 7);
+            if (beta == 0.0) {
+                // C must not be read.
+                std::fill(c.begin(), c.end(), std::numeric_limits<Scalar>::quiet_NaN());
+            }
+            auto expected = c;
+            naive_gemm(alpha, a.ref, b.ref, beta, {expected.data(), m, n, c_stride, c_col});
+            fnn::gemm(alpha, a.ref, b.ref, beta, {c.data(), m, n, c_stride, c_col});
+            std::vector<Scalar> got;
+            std::vector<Scalar> want;
+            for (std::size_t i = 0; i < m; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    got.push_back(c[i * c_stride + j * c_col]);
+                    want.push_back(expected[i * c_stride + j * c_col]);
+                }
+            }
+            FNN_CHECK_CLOSE(got, want, 1e-12, "gemm %zux%zux%zu layout %d alpha %g beta %g", m,
+                            n, k, layout, alpha, beta);
+
+            // Small blocks, so every dimension spans several of them.
+            fnn::GemmConfig config;
+            config.mc = 8;
+            config.kc = 16;
+            config.nc = 24;
+            auto blocked = random_values(m * c_stride + 1, 7);
+            if (beta == 0.0) {
+                std::fill(blocked.begin(), blocked.end(),
+                          std::numeric_limits<Scalar>::quiet_NaN());
+            }
+            fnn::gemm(alpha, a.ref, b.ref, beta, {blocked.data(), m, n, c_stride, c_col}, config);
+            got.clear();
+            for (std::size_t i = 0; i < m; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    got.push_back(blocked[i * c_stride + j * c_col]);
+                }
+            }
+            FNN_CHECK_CLOSE(got, want, 1e-12, "gemm config %zux%zux%zu layout %d", m, n, k,
+                            layout);
+        }
+    }
+}
+
+void check_packed(std::size_t m, std::size_t n, std::size_t k) {
+    const auto b = make_view(k, n, true, true, 5);
+    fnn::GemmConfig config;
+    config.kc = 16;
+    config.nc = 40;
+    fnn::PackedMatrix packed(b.ref, config);
+    FNN_CHECK(packed.rows() == k && packed.cols() == n && !packed.empty());
+    for (const std::size_t rows : {std::size_t{1}, m}) {
+        const auto a = make_view(rows, k, false, true, 6 + rows);
+        std::vector<Scalar> c(rows * n, 0.5);
+        auto expected = c;
+        naive_gemm(1.5, a.ref, b.ref, 1.0, {expected.data(), rows, n, n, 1});
+        fnn::gemm(1.5, a.ref, packed, 1.0, {c.data(), rows, n, n, 1});
+        FNN_CHECK_CLOSE(c, expected, 1e-12, "packed %zux%zux%zu", rows, n, k);
+    }
+
+    // Re-packing a different matrix of the same shape reuses the buffer.
+    const auto b2 = make_view(k, n, false, false, 9);
+    packed.pack(b2.ref, config);
+    const auto a = make_view(m, k, false, false, 10);
+    std::vector<Scalar> c(m * n);
+    std::vector<Scalar> expected(m * n);
+    naive_gemm(1.0, a.ref, b2.ref, 0.0, {expected.data(), m, n, n, 1});
+    fnn::gemm(1.0, a.ref, packed, 0.0, {c.data(), m, n, n, 1});
+    FNN_CHECK_CLOSE(c, expected, 1e-12, "repacked %zux%zux%zu", m, n, k);
+}
+
+void check_batched(std::size_t count, std::size_t m, std::size_t n, std::size_t k) {
+    // A batches are contiguous, B is shared (batch stride 0), C batches are
+    // spaced by a gap.
+    const auto a = random_values(count * m * k, 21);
+    const auto b = random_values(k * n, 22);
+    const auto c_step = m * n + 5;
+    auto c = random_values(count * c_step, 23);
+    auto expected = c;
+    for (std::size_t i = 0; i < count; ++i) {
+        naive_gemm(1.0, {a.data() + i * m * k, m, k, k, 1}, {b.data(), k, n, n, 1}, 0.5,
+                   {expected.data() + i * c_step, m, n, n, 1});
+    }
+    fnn::gemm_batched(1.0, {a.data(), m, k, k, 1}, m * k, {b.data(), k, n, n, 1}, 0, 0.5,
+                      {c.data(), m, n, n, 1}, c_step, count);
+    FNN_CHECK_CLOSE(c, expected, 1e-12, "batched %zu x %zux%zux%zu", count, m, n, k);
+}
+
+// Naive einsum: every assignment of every index, summed into the output.
+Tensor naive_einsum(const std::string& spec, const Tensor& a, const Tensor& b) {
+    const auto comma = spec.find(',');
+    const auto arrow = spec.find("->");
+    const auto sa = spec.substr(0, comma);
+    const auto sb = spec.substr(comma + 1, arrow - comma - 1);
+    const auto so = spec.substr(arrow + 2);
+    std::map<char, std::size_t> extent;
+    for (std::size_t i = 0; i < sa.size(); ++i) {
+        extent[sa[i]] = a.dims()[i];
+    }
+    for (std::size_t i = 0; i < sb.size(); ++i) {
+        extent[sb[i]] = b.dims()[i];
+    }
+    fnn::Dims out_dims;
+    for (const char c : so) {
+        out_dims.push_back(extent[c]);
+    }
+    Tensor out(out_dims);
+    std::fill(out.data(), out.data() + out.numel(), 0.0);
+    std::string letters;
+    for (const auto& [c, e] : extent) {
+        letters.push_back(c);
+    }
+    std::map<char, std::size_t> at;
+    const auto offset = [&](const std::string& s, const fnn::Dims& dims) {
+        std::size_t o = 0;
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            o = o * dims[i] + at[s[i]];
+        }
+        return o;
+    };
+    for (;;) {
+        out.data()[offset(so, out_dims)] +=
+            a.data()[offset(sa, a.dims())] * b.data()[offset(sb, b.dims())];
+        std::size_t d = letters.size();
+        while (d > 0 && ++at[letters[d - 1]] == extent[letters[d - 1]]) {
+            at[letters[d - 1]] = 0;
+            --d;
+        }
+        if (d == 0) {
+            return out;
+        }
+    }
+}
+
+Tensor random_tensor(const fnn::Dims& dims, std::uint64_t seed) {
+    Tensor t(dims);
+    fnn::CounterRng(seed).fill_uniform({t.data(), t.numel()}, 0, -1.0, 1.0);
+    return t;
+}
+
+void check_einsum(const std::string& spec, const fnn::Dims& a_dims, const fnn::Dims& b_dims) {
+    const auto a = random_tensor(a_dims, 31);
+    const auto b = random_tensor(b_dims, 32);
+    const auto got = fnn::einsum(spec, a, b);
+    const auto want = naive_einsum(spec, a, b);
+    FNN_CHECK(got.dims() == want.dims());
+    FNN_CHECK_CLOSE(std::span<const Scalar>(got.data(), got.numel()),
+                    std::span<const Scalar>(want.data(), want.numel()), 1e-12, "einsum %s",
+                    spec.c_str());
+}
+
+} // namespace
+
+int main() {
+    // Below the small-GEMM cutoff, just above it, and well above it, with
+    // edges that are not multiples of the 4 x 8 micro-tile.
+    check_gemm(3, 5, 7);
+    check_gemm(31, 33, 29);
+    check_gemm(67, 45, 130);
+    check_gemm(1, 300, 200);
+    check_packed(5, 9, 11);
+    check_packed(70, 90, 65);
+    check_batched(1, 37, 29, 41);
+    check_batched(6, 5, 7, 3);
+    check_batched(9, 40, 36, 33);
+
+    FNN_CHECK(fnn::gemm_grid(16, 16, 16).rows == 1 && fnn::gemm_grid(16, 16, 16).cols == 1);
+    std::vector<Scalar> s(16);
+    const MatrixRef a23{s.data(), 2, 3, 3, 1};
+    const MatrixRef b22{s.data(), 2, 2, 2, 1};
+    FNN_CHECK_THROWS(fnn::gemm(1.0, a23, b22, 0.0, MutableMatrixRef{s.data(), 2, 2, 2, 1}),
+                     std::invalid_argument);
+
+    // Plain and transposed matmuls, below and above the cutoff.
+    check_einsum("ij,jk->ik", {5, 6}, {6, 7});
+    check_einsum("ij,jk->ik", {40, 50}, {50, 45});
+    check_einsum("ij,kj->ik", {40, 50}, {45, 50});
+    check_einsum("ji,jk->ki", {50, 40}, {50, 45});
+    // Batched, including two batch indices and a bilinear form.
+    check_einsum("bij,bjk->bik", {3, 9, 10}, {3, 10, 11});
+    check_einsum("bhqd,bhkd->bhqk", {2, 3, 17, 8}, {2, 3, 19, 8});
+    check_einsum("bi,oij->boj", {4, 6}, {5, 6, 7});
+    // Index orders that no single stride describes, so an operand is packed.
+    check_einsum("bhqd,hbkd->bhqk", {2, 3, 5, 4}, {3, 2, 6, 4});
+    check_einsum("aij,jk->iak", {3, 4, 5}, {5, 6});
+    check_einsum("ijb,bjk->bik", {36, 35, 2}, {2, 35, 33});
+    // An index summed out of one input, and an outer product.
+    check_einsum("ijx,jk->ik", {4, 5, 3}, {5, 6});
+    check_einsum("i,j->ij", {7}, {9});
+
+    // The spec cache holds the parse, not the shapes: the same spec with new
+    // extents, and from several threads at once.
+    check_einsum("bij,bjk->bik", {2, 40, 33}, {2, 33, 38});
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            check_einsum("qtx,qxy->qty", {2, 3 + t, 4}, {2, 4, 5});
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    const auto a = random_tensor({2, 3}, 1);
+    const auto b = random_tensor({3, 4}, 2);
+    FNN_CHECK_THROWS(fnn::einsum("ij,jk", a, b), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::einsum("ij,jk->ik", b, b), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::einsum("ii,ik->k", a, b), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::einsum("ij,jk->iz", a, b), std::invalid_argument);
+    // A cached spec still checks extents.
+    FNN_CHECK_THROWS(fnn::einsum("ij,jk->ik", a, a), std::invalid_argument);
+    return fnn::test::result();
+}
@@ -0,0 +1,177 @@
+// GraphModel: a graph with a skip connection, parallel branches, a sum and
+// a concat against the same layers wired by hand, with buffers shared
+// between nodes whose values are dead; plus output selection, dead
+// branches, version bumps and the construction errors.
+
+#include "fnn/layers/dense.hpp"
+#include "fnn/model.hpp"
+#include "fnn/random.hpp"
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::ActivationKind;
+using fnn::Dense;
+using fnn::GraphModel;
+using fnn::Scalar;
+using fnn::Vector;
+
+// Layer `id` of the graph; the reference copy has the same weights.
+std::unique_ptr<Dense> make_dense(std::size_t in, std::size_t out, std::uint32_t id,
+                                  ActivationKind kind) {
+    auto layer = std::make_unique<Dense>(in, out, fnn::CounterRng(101, 0, id), kind);
+    // Non-zero biases, so a dropped bias shows.
+    auto& bias = layer->mutable_bias();
+    fnn::fill_uniform(bias, fnn::CounterRng(102, 0, id), -0.5, 0.5);
+    layer->set_training(false);
+    return layer;
+}
+
+Vector add(const Vector& a, const Vector& b) {
+    Vector out(a);
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        out[i] += b[i];
+    }
+    return out;
+}
+
+Vector concat(const std::vector<const Vector*>& parts) {
+    Vector out;
+    for (const auto* p : parts) {
+        out.insert(out.end(), p->begin(), p->end());
+    }
+    return out;
+}
+
+struct Spec {
+    std::size_t in;
+    std::size_t out;
+    ActivationKind kind;
+};
+
+// in -> a -> b -> c, s = c + a, then p, q from s and r from the input in
+// parallel, and the output reads concat(p, q, r, s).
+const Spec kSpecs[] = {
+    {6, 8, ActivationKind::ReLU},      // a
+    {8, 8, ActivationKind::Tanh},      // b
+    {8, 8, ActivationKind::Identity},  // c
+    {8, 5, ActivationKind::Sigmoid},   // p
+    {8, 3, ActivationKind::LeakyReLU}, // q
+    {6, 4, ActivationKind::Identity},  // r
+    {20, 2, ActivationKind::Tanh},     // output
+};
+
+struct Reference {
+    std::vector<std::unique_ptr<Dense>> layers;
+
+    Reference() {
+        for (std::uint32_t i = 0; i < std::size(kSpecs); ++i) {
+            layers.push_back(make_dense(kSpecs[i].in, kSpecs[i].out, i, kSpecs[i].kind));
+        }
+    }
+
+    // Values of s and of the output.
+    std::vector<Vector> run(const Vector& x) const {
+        const auto a = layers[0]->forward(x);
+        const auto b = layers[1]->forward(a);
+        const auto c = layers[2]->forward(b);
+        const auto s = add(c, a);
+        const auto p = layers[3]->forward(s);
+        const auto q = layers[4]->forward(s);
+        const auto r = layers[5]->forward(x);
+        return {s, layers[6]->forward(concat({&p, &q, &r, &s}))};
+    }
+};
+
+} // namespace
+
+int main() {
+    GraphModel model;
+    std::vector<GraphModel::NodeId> ids;
+    const auto layer = [&](std::uint32_t i, GraphModel::NodeId input) {
+        ids.push_back(
+            model.add_layer(make_dense(kSpecs[i].in, kSpecs[i].out, i, kSpecs[i].kind), input));
+        return ids.back();
+    };
+    const auto a = layer(0, GraphModel::kInput);
+    const auto b = layer(1, a);
+    const auto c = layer(2, b);
+    const auto s = model.add_sum({c, a});
+    const auto p = layer(3, s);
+    const auto q = layer(4, s);
+    const auto r = layer(5, GraphModel::kInput);
+    // A branch nothing reads: never run, no buffer.
+    (void)model.add_layer(make_dense(8, 8, 50, ActivationKind::ReLU), b);
+    const auto cat = model.add_concat({p, q, r, s});
+    const auto out = layer(6, cat);
+    model.set_training(false);
+    FNN_CHECK(model.output() == out);
+    FNN_CHECK(model.size() == 11);
+    // a, r | b | c | s | p, q | concat | output.
+    FNN_CHECK(model.level_count() == 7);
+    FNN_CHECK(model.buffer_count() < model.size() - 1);
+
+    Reference reference;
+    for (std::uint64_t step = 0; step < 3; ++step) {
+        Vector x(6);
+        fnn::CounterRng(103, step).fill_uniform(x, 0, -1.0, 1.0);
+        const auto expected = reference.run(x);
+        // Twice, so stale values left in reused buffers would show.
+        for (int repeat = 0; repeat < 2; ++repeat) {
+            FNN_CHECK_CLOSE(model.predict(x), expected[1], 1e-14, "graph output, input %d",
+                            static_cast<int>(step));
+        }
+    }
+
+    // A weight change reaches predict() and bumps version().
+    const auto before = model.version();
+    auto& graph_dense = dynamic_cast<Dense&>(model.layer(ids[1]));
+    graph_dense.mutable_weights()(2, 3) += 0.25;
+    reference.layers[1]->mutable_weights()(2, 3) += 0.25;
+    FNN_CHECK(model.version() != before);
+    const Vector x(6, 0.3);
+    const auto expected = reference.run(x);
+    FNN_CHECK_CLOSE(model.predict(x), expected[1], 1e-14, "after a weight change");
+
+    // An inner node as output: only its ancestors run.
+    model.set_output(s);
+    FNN_CHECK(model.level_count() == 4);
+    FNN_CHECK_CLOSE(model.predict(x), expected[0], 1e-14, "sum node as output");
+
+    // A long chain needs two buffers: one value is read while the next is
+    // written.
+    GraphModel chain;
+    auto node = GraphModel::kInput;
+    for (std::uint32_t i = 0; i < 12; ++i) {
+        node = chain.add_layer(make_dense(4, 4, 60 + i, ActivationKind::Tanh), node);
+    }
+    FNN_CHECK(chain.buffer_count() == 2 && chain.size() == 13);
+    Vector v(4, 0.5);
+    const auto chained = chain.predict(v);
+    for (std::uint32_t i = 0; i < 12; ++i) {
+        v = make_dense(4, 4, 60 + i, ActivationKind::Tanh)->forward(v);
+    }
+    FNN_CHECK_CLOSE(chained, v, 1e-14, "chain of 12");
+
+    GraphModel bad;
+    const auto wide = bad.add_layer(make_dense(3, 4, 70, ActivationKind::Identity), 0);
+    const auto narrow = bad.add_layer(make_dense(3, 2, 71, ActivationKind::Identity), 0);
+    const auto version = bad.version();
+    (void)bad.add_sum({wide, narrow});
+    FNN_CHECK(bad.version() != version);
+    FNN_CHECK_THROWS(bad.predict(Vector(3, 1.0)), std::invalid_argument);
+    FNN_CHECK_THROWS(bad.add_sum({}), std::invalid_argument);
+    FNN_CHECK_THROWS(bad.add_concat({wide, 9}), std::invalid_argument);
+    FNN_CHECK_THROWS(bad.add_layer(nullptr, wide), std::invalid_argument);
+    FNN_CHECK_THROWS(bad.add_layer(make_dense(3, 2, 72, ActivationKind::Identity), 9),
+                     std::invalid_argument);
+    FNN_CHECK_THROWS(bad.set_output(9), std::invalid_argument);
+    FNN_CHECK_THROWS(bad.layer(GraphModel::kInput), std::invalid_argument);
+    return fnn::test::result();
+}
@@ -0,0 +1,163 @@
+// HierarchicalSoftmax: the Huffman code lengths, P(c | h) summing to one
+// over the classes, loss_backward's gradients against central finite
+// differences of -log P, and the greedy predict() against the class
+// probabilities.
+
+#include "fnn/hierarchical_softmax.hpp"
+#include "fnn/random.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::HierarchicalSoftmax;
+using fnn::Scalar;
+using fnn::Tensor2D;
+
+fnn::Vector row(const Tensor2D& t, std::size_t r) {
+    return {t.data() + r * t.cols(), t.data() + (r + 1) * t.cols()};
+}
+
+// Mean of -log P(label | h) through log_probability().
+Scalar loss(const HierarchicalSoftmax& tree, const Tensor2D& hidden,
+            std::span<const std::size_t> labels) {
+    Scalar total = 0.0;
+    for (std::size_t r = 0; r < hidden.rows(); ++r) {
+        total -= tree.log_probability(row(hidden, r), labels[r]);
+    }
+    return total / static_cast<Scalar>(hidden.rows());
+}
+
+std::vector<Scalar> frequencies(std::size_t classes) {
+    std::vector<Scalar> f(classes);
+    for (std::size_t c = 0; c < classes; ++c) {
+        f[c] = 1.0 / static_cast<Scalar>(c + 1);
+    }
+    return f;
+}
+
+void check(std::size_t classes, std::size_t hidden_size) {
+    const fnn::CounterRng rng(51, classes);
+    const auto f = frequencies(classes);
+    HierarchicalSoftmax tree(hidden_size, f, rng);
+    fnn::fill_uniform(tree.bias(), rng.with_step(1), -0.5, 0.5);
+    constexpr std::size_t kBatch = 6;
+    Tensor2D hidden(kBatch, hidden_size);
+    fnn::fill_uniform(hidden, rng.with_step(2), -1.0, 1.0);
+    std::vector<std::size_t> labels(kBatch);
+    for (std::size_t r = 0; r < kBatch; ++r) {
+        labels[r] = (r * 7 + 1) % classes;
+    }
+
+    char what[64];
+    std::snprintf(what, sizeof(what), "%zu classes, hidden %zu", classes, hidden_size);
+
+    // Code lengths satisfy Kraft's equality for a full binary tree.
+    Scalar kraft = 0.0;
+    for (std::size_t c = 0; c < classes; ++c) {
+        kraft += std::ldexp(1.0, -static_cast<int>(tree.depth(c)));
+    }
+    FNN_CHECK_CLOSE(std::span<const Scalar>(&kraft, 1), std::vector<Scalar>{1.0}, 1e-12,
+                    "Kraft sum %s", what);
+
+    for (std::size_t r = 0; r < kBatch; ++r) {
+        const auto h = row(hidden, r);
+        std::vector<Scalar> p(classes);
+        Scalar total = 0.0;
+        for (std::size_t c = 0; c < classes; ++c) {
+            p[c] = std::exp(tree.log_probability(h, c));
+            total += p[c];
+        }
+        FNN_CHECK_CLOSE(std::span<const Scalar>(&total, 1), std::vector<Scalar>{1.0}, 1e-12,
+                        "probabilities sum, %s", what);
+        // Every branch towards a class with P > 1/2 has P > 1/2, so greedy
+        // descent must reach it.
+        const auto best = std::max_element(p.begin(), p.end());
+        const auto predicted = tree.predict(h);
+        FNN_CHECK(predicted < classes);
+        FNN_CHECK(*best <= 0.5 || predicted == static_cast<std::size_t>(best - p.begin()));
+    }
+    std::vector<std::size_t> predicted(kBatch);
+    for (std::size_t r = 0; r < kBatch; ++r) {
+        predicted[r] = tree.predict(row(hidden, r));
+    }
+    FNN_CHECK(tree.predict_batch(hidden) == predicted);
+
+    Tensor2D d_hidden(0, 0);
+    const Scalar value = tree.loss_backward(hidden, labels, d_hidden);
+    FNN_CHECK_CLOSE(std::span<const Scalar>(&value, 1),
+                    std::vector<Scalar>{loss(tree, hidden, labels)}, 1e-12, "loss %s", what);
+
+    constexpr Scalar kStep = 1e-6;
+    std::vector<Scalar> numeric;
+    std::vector<Scalar> analytic;
+    const auto probe = [&](Tensor2D& param, const Tensor2D& grad, std::size_t stride) {
+        for (std::size_t i = 0; i < param.size(); i += stride) {
+            const Scalar saved = param.data()[i];
+            param.data()[i] = saved + kStep;
+            const Scalar up = loss(tree, hidden, labels);
+            param.data()[i] = saved - kStep;
+            const Scalar down = loss(tree, hidden, labels);
+            param.data()[i] = saved;
+            numeric.push_back((up - down) / (2.0 * kStep));
+            analytic.push_back(grad.data()[i]);
+        }
+    };
+    probe(hidden, d_hidden, 1);
+    probe(tree.weights(), tree.weight_grad(), 3);
+    probe(tree.bias(), tree.bias_grad(), 1);
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-7, "finite differences %s", what);
+
+    // A second call accumulates; zero_grad() clears.
+    const Tensor2D first = tree.bias_grad();
+    (void)tree.loss_backward(hidden, labels, d_hidden);
+    Tensor2D twice = first;
+    for (std::size_t i = 0; i < twice.size(); ++i) {
+        twice.data()[i] *= 2.0;
+    }
+    FNN_CHECK_CLOSE(std::span<const Scalar>(tree.bias_grad().data(), twice.size()),
+                    std::span<const Scalar>(twice.data(), twice.size()), 1e-14,
+                    "accumulated bias gradient %s", what);
+    tree.zero_grad();
+    FNN_CHECK(std::all_of(tree.bias_grad().data(), tree.bias_grad().data() + twice.size(),
+                          [](Scalar g) { return g == 0.0; }));
+}
+
+} // namespace
+
+int main() {
+    check(2, 3);
+    check(5, 4);
+    check(37, 8);
+    check(300, 5);
+
+    // Dyadic frequencies give code lengths -log2(f / total).
+    const std::vector<Scalar> dyadic = {8.0, 1.0, 4.0, 1.0, 2.0};
+    const HierarchicalSoftmax tree(3, dyadic);
+    const std::vector<std::size_t> expected_depth = {1, 4, 2, 4, 3};
+    for (std::size_t c = 0; c < dyadic.size(); ++c) {
+        FNN_CHECK(tree.depth(c) == expected_depth[c]);
+    }
+    FNN_CHECK(tree.max_depth() == 4);
+    const Scalar mean = tree.mean_depth();
+    FNN_CHECK_CLOSE(std::span<const Scalar>(&mean, 1), std::vector<Scalar>{30.0 / 16.0}, 1e-14,
+                    "mean depth");
+    FNN_CHECK(tree.inner_nodes() == 4);
+
+    const std::vector<Scalar> one = {1.0};
+    const std::vector<Scalar> non_positive = {1.0, 0.0};
+    FNN_CHECK_THROWS(HierarchicalSoftmax(3, one), std::invalid_argument);
+    FNN_CHECK_THROWS(HierarchicalSoftmax(3, non_positive), std::invalid_argument);
+    FNN_CHECK_THROWS(HierarchicalSoftmax(0, dyadic), std::invalid_argument);
+    FNN_CHECK_THROWS(tree.depth(5), std::out_of_range);
+    FNN_CHECK_THROWS(tree.log_probability(fnn::Vector(3), 5), std::out_of_range);
+    FNN_CHECK_THROWS(tree.log_probability(fnn::Vector(2), 0), std::invalid_argument);
+    FNN_CHECK_THROWS(tree.predict(fnn::Vector(4)), std::invalid_argument);
+    return fnn::test::result();
+}
@@ -0,0 +1,95 @@
+// Sequential::predict_incremental against predict() over a stream of
+// inputs that change in no, few, exactly the crossover's worth, one more,
+// or all features, long enough to pass the periodic refresh, and across
+// weight / bias edits, set_weights(), added layers and reset_incremental().
+
+#include "fnn/layers/dense.hpp"
+#include "fnn/layers/dropout.hpp"
+#include "fnn/model.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::ActivationKind;
+using fnn::Dense;
+using fnn::Scalar;
+using fnn::Sequential;
+using fnn::Vector;
+
+constexpr std::size_t kIn = 100;
+
+// Moves `changed` features of `x`, chosen and valued by `rng`.
+void perturb(Vector& x, std::size_t changed, const fnn::CounterRng& rng) {
+    for (std::size_t i = 0; i < changed; ++i) {
+        const auto at = static_cast<std::size_t>(rng.uniform(2 * i) * kIn) % kIn;
+        // Distinct features when all of them change.
+        const auto j = changed == kIn ? i : at;
+        x[j] = 2.0 * rng.uniform(2 * i + 1) - 1.0;
+    }
+}
+
+// Numbers of changed features per step, cycling through the cases around
+// the crossover, and a sparse-only cycle that never forces a full update.
+const std::size_t kMixed[] = {1, 0, 3, kIn / Sequential::kIncrementalCrossover,
+                              kIn / Sequential::kIncrementalCrossover + 1, kIn, 2};
+const std::size_t kSparse[] = {1, 2, 0, 5};
+
+template <std::size_t N>
+void check_stream(Sequential& model, Vector& x, const std::size_t (&pattern)[N],
+                  std::size_t steps, std::uint64_t seed, const char* what) {
+    for (std::size_t s = 0; s < steps; ++s) {
+        perturb(x, pattern[s % N], fnn::CounterRng(seed, s));
+        const auto expected = model.predict(x);
+        FNN_CHECK_CLOSE(model.predict_incremental(x), expected, 1e-12, "%s, step %zu", what, s);
+    }
+}
+
+} // namespace
+
+int main() {
+    Sequential model;
+    auto& first = dynamic_cast<Dense&>(
+        model.add(std::make_unique<Dense>(kIn, 48, fnn::CounterRng(121), ActivationKind::ReLU)));
+    fnn::fill_uniform(first.mutable_bias(), fnn::CounterRng(122), -0.5, 0.5);
+    model.add(std::make_unique<Dense>(48, 10, fnn::CounterRng(123), ActivationKind::Tanh));
+    model.set_training(false);
+
+    Vector x(kIn);
+    fnn::CounterRng(124).fill_uniform(x, 0, -1.0, 1.0);
+    check_stream(model, x, kMixed, 700, 125, "mixed stream");
+    // Past kIncrementalRefresh sparse updates in a row.
+    check_stream(model, x, kSparse, 2 * Sequential::kIncrementalRefresh + 100, 132, "sparse");
+
+    // Edits to layer 0 invalidate the cached pre-activation.
+    first.mutable_weights()(7, 3) += 0.5;
+    check_stream(model, x, kMixed, 20, 126, "after a weight change");
+    first.mutable_bias()(0, 5) -= 0.25;
+    check_stream(model, x, kMixed, 20, 127, "after a bias change");
+    fnn::Tensor2D weights(48, kIn);
+    fnn::Tensor2D bias(1, 48);
+    fnn::fill_uniform(weights, fnn::CounterRng(128), -0.2, 0.2);
+    first.set_weights(weights, bias);
+    check_stream(model, x, kMixed, 20, 128, "after set_weights");
+
+    // Later layers are run in full every call.
+    model.add(std::make_unique<Dense>(10, 4, fnn::CounterRng(129), ActivationKind::Identity));
+    model.set_training(false);
+    check_stream(model, x, kMixed, 20, 130, "after adding a layer");
+    model.reset_incremental();
+    check_stream(model, x, kMixed, 20, 131, "after reset_incremental");
+
+    FNN_CHECK_THROWS(model.predict_incremental(Vector(kIn - 1)), std::invalid_argument);
+    Sequential empty;
+    FNN_CHECK_THROWS(empty.predict_incremental(x), std::logic_error);
+    Sequential dropout_first;
+    dropout_first.add(std::make_unique<fnn::Dropout>(0.5, 1, 0));
+    FNN_CHECK_THROWS(dropout_first.predict_incremental(x), std::logic_error);
+    return fnn::test::result();
+}
@@ -0,0 +1,185 @@
+// BLAS level-1/2 routines against plain loops, on lengths around the
+// unroll width and the threading threshold, and gemv / ger on row-major,
+// column-major and generally strided views.
+
+#include "fnn/random.hpp"
+#include "fnn/util/linear_alg.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::MatrixRef;
+using fnn::MutableMatrixRef;
+using fnn::Scalar;
+
+std::vector<Scalar> random_vector(std::size_t n, std::uint64_t step) {
+    std::vector<Scalar> v(n);
+    fnn::CounterRng(81, step).fill_uniform(v, 0, -1.0, 1.0);
+    return v;
+}
+
+void check_level1(std::size_t n) {
+    const auto x = random_vector(n, 1);
+    const auto y = random_vector(n, 2);
+
+    auto axpy = y;
+    fnn::util::axpy(0.75, x, axpy);
+    auto scal = x;
+    fnn::util::scal(-1.5, scal);
+    std::vector<Scalar> axpy_ref(n);
+    std::vector<Scalar> scal_ref(n);
+    Scalar dot = 0.0;
+    Scalar squares = 0.0;
+    Scalar asum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        axpy_ref[i] = y[i] + 0.75 * x[i];
+        scal_ref[i] = -1.5 * x[i];
+        dot += x[i] * y[i];
+        squares += x[i] * x[i];
+        asum += std::abs(x[i]);
+    }
+    FNN_CHECK_CLOSE(axpy, axpy_ref, 1e-15, "axpy, n = %zu", n);
+    FNN_CHECK_CLOSE(scal, scal_ref, 0.0, "scal, n = %zu", n);
+    const std::vector<Scalar> results = {fnn::util::dot(x, y), fnn::util::nrm2(x),
+                                         fnn::util::asum(x)};
+    const std::vector<Scalar> expected = {dot, std::sqrt(squares), asum};
+    FNN_CHECK_CLOSE(results, expected, 1e-12, "dot / nrm2 / asum, n = %zu", n);
+
+    if (n > 0) {
+        // The largest magnitude planted at a known index, with a tie later.
+        auto planted = x;
+        const auto at = n / 3;
+        planted[at] = -2.0;
+        if (at + 1 < n) {
+            planted[n - 1] = 2.0;
+        }
+        FNN_CHECK(fnn::util::iamax(planted) == at);
+    }
+}
+
+// y = alpha * A x + beta * y over an explicit strided view.
+std::vector<Scalar> naive_gemv(Scalar alpha, const MatrixRef& a, const std::vector<Scalar>& x,
+                               Scalar beta, const std::vector<Scalar>& y) {
+    std::vector<Scalar> out(a.rows);
+    for (std::size_t i = 0; i < a.rows; ++i) {
+        Scalar acc = 0.0;
+        for (std::size_t j = 0; j < a.cols; ++j) {
+            acc += a.data[i * a.row_stride + j * a.col_stride] * x[j];
+        }
+        out[i] = alpha * acc + (beta == 0.0 ? 0.0 : beta * y[i]);
+    }
+    return out;
+}
+
+enum class Layout { RowMajor, ColMajor, Padded, Strided };
+
+const char* name(Layout layout) {
+    constexpr const char* kNames[] = {"row-major", "column-major", "padded", "strided"};
+    return kNames[static_cast<int>(layout)];
+}
+
+// A rows x cols view into `storage` with the given layout.
+MutableMatrixRef make_view(std::vector<Scalar>& storage, std::size_t rows, std::size_t cols,
+                           Layout layout) {
+    switch (layout) {
+    case Layout::RowMajor:
+        storage = random_vector(rows * cols, 3);
+        return {storage.data(), rows, cols, cols, 1};
+    case Layout::ColMajor:
+        storage = random_vector(rows * cols, 3);
+        return {storage.data(), rows, cols, 1, rows};
+    case Layout::Padded:
+        storage = random_vector(rows * (cols + 3), 3);
+        return {storage.data(), rows, cols, cols + 3, 1};
+    case Layout::Strided:
+        break;
+    }
+    // Every other element of a padded column-major array.
+    storage = random_vector(2 * (rows + 1) * cols, 3);
+    return {storage.data(), rows, cols, 2, 2 * (rows + 1)};
+}
+
+void check_level2(std::size_t rows, std::size_t cols, Layout layout) {
+    std::vector<Scalar> storage;
+    const auto view = make_view(storage, rows, cols, layout);
+    const MatrixRef a{view.data, rows, cols, view.row_stride, view.col_stride};
+    const auto x = random_vector(cols, 4);
+    const auto y = random_vector(rows, 5);
+
+    const Scalar params[][2] = {{1.0, 0.0}, {0.5, 1.0}, {-2.0, 0.25}};
+    for (const auto& p : params) {
+        auto out = y;
+        if (p[1] == 0.0) {
+            // beta == 0 must not read y.
+            std::fill(out.begin(), out.end(), std::numeric_limits<Scalar>::quiet_NaN());
+        }
+        fnn::util::gemv(p[0], a, x, p[1], out);
+        FNN_CHECK_CLOSE(out, naive_gemv(p[0], a, x, p[1], y), 1e-12,
+                        "gemv %zu x %zu %s, alpha %g, beta %g", rows, cols, name(layout), p[0],
+                        p[1]);
+    }
+
+    // A^T x through the transposed view of the same storage.
+    const MatrixRef at{view.data, cols, rows, view.col_stride, view.row_stride};
+    std::vector<Scalar> out(cols);
+    fnn::util::gemv(1.0, at, y, 0.0, out);
+    FNN_CHECK_CLOSE(out, naive_gemv(1.0, at, y, 0.0, out), 1e-12, "transposed gemv %zu x %zu %s",
+                    rows, cols, name(layout));
+
+    // ger: A += alpha x y^T, elements outside the view untouched.
+    const auto before = storage;
+    fnn::util::ger(-0.5, y, x, view);
+    auto expected = before;
+    for (std::size_t i = 0; i < rows; ++i) {
+        for (std::size_t j = 0; j < cols; ++j) {
+            expected[i * view.row_stride + j * view.col_stride] += -0.5 * y[i] * x[j];
+        }
+    }
+    FNN_CHECK_CLOSE(storage, expected, 1e-15, "ger %zu x %zu %s", rows, cols, name(layout));
+}
+
+} // namespace
+
+int main() {
+    for (const std::size_t n : {0, 1, 3, 4, 7, 8, 17, 1000, 100003}) {
+        check_level1(n);
+    }
+
+    // Scaled norms survive magnitudes whose squares over- or underflow.
+    const std::vector<Scalar> huge = {3e200, 4e200};
+    const std::vector<Scalar> tiny = {3e-200, 4e-200};
+    const std::vector<Scalar> norms = {fnn::util::nrm2(huge) / 1e200,
+                                       fnn::util::nrm2(tiny) / 1e-200};
+    const std::vector<Scalar> fives = {5.0, 5.0};
+    FNN_CHECK_CLOSE(norms, fives, 1e-14, "nrm2 range");
+    FNN_CHECK(fnn::util::nrm2(std::vector<Scalar>{}) == 0.0);
+
+    // Vectors, tall, wide and large enough to be split across threads.
+    const std::size_t shapes[][2] = {{1, 1}, {5, 3}, {3, 17}, {64, 64}, {301, 7}, {9, 1000},
+                                     {400, 517}};
+    for (const auto& s : shapes) {
+        for (const auto layout : {Layout::RowMajor, Layout::ColMajor, Layout::Padded,
+                                  Layout::Strided}) {
+            check_level2(s[0], s[1], layout);
+        }
+    }
+
+    std::vector<Scalar> three(3);
+    std::vector<Scalar> four(4);
+    FNN_CHECK_THROWS(fnn::util::axpy(1.0, three, four), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::util::dot(three, four), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::util::iamax(std::vector<Scalar>{}), std::invalid_argument);
+    const MatrixRef a{four.data(), 2, 2, 2, 1};
+    FNN_CHECK_THROWS(fnn::util::gemv(1.0, a, three, 0.0, four), std::invalid_argument);
+    const MutableMatrixRef m{four.data(), 2, 2, 2, 1};
+    FNN_CHECK_THROWS(fnn::util::ger(1.0, three, three, m), std::invalid_argument);
+    return fnn::test::result();
+}
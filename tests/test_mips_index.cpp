@@ -0,0 +1,170 @@
+// top_k() against a full stable sort, ties included, and MipsIndex::search
+// against top_k() of every logit: exact with a probe budget of
+// partitions(), on spread-out rows and on tight clusters; narrower budgets
+// still return true scores, best first.
+
+#include "fnn/layers/dense.hpp"
+#include "fnn/mips_index.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::MipsIndex;
+using fnn::Scalar;
+using fnn::ScoredClass;
+using fnn::Tensor2D;
+
+// Best first, equal scores by index: a stable sort on descending score.
+std::vector<ScoredClass> sorted(std::span<const Scalar> scores, std::size_t k) {
+    std::vector<ScoredClass> all(scores.size());
+    for (std::size_t i = 0; i < scores.size(); ++i) {
+        all[i] = {i, scores[i]};
+    }
+    std::stable_sort(all.begin(), all.end(),
+                     [](const ScoredClass& a, const ScoredClass& b) { return a.score > b.score; });
+    all.resize(std::min(k, all.size()));
+    return all;
+}
+
+bool same_classes(const std::vector<ScoredClass>& a, const std::vector<ScoredClass>& b) {
+    const auto same = [](const ScoredClass& x, const ScoredClass& y) { return x.index == y.index; };
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), same);
+}
+
+std::vector<Scalar> scores_of(const std::vector<ScoredClass>& classes) {
+    std::vector<Scalar> out;
+    for (const auto& c : classes) {
+        out.push_back(c.score);
+    }
+    return out;
+}
+
+// W h + b, one row at a time.
+std::vector<Scalar> logits(const Tensor2D& w, const Tensor2D& b, std::span<const Scalar> h) {
+    std::vector<Scalar> out(w.rows());
+    for (std::size_t r = 0; r < w.rows(); ++r) {
+        Scalar acc = b(0, r);
+        for (std::size_t c = 0; c < w.cols(); ++c) {
+            acc += w(r, c) * h[c];
+        }
+        out[r] = acc;
+    }
+    return out;
+}
+
+void check_top_k(std::size_t n, std::uint64_t step) {
+    std::vector<Scalar> scores(n);
+    fnn::CounterRng(111, step).fill_uniform(scores, 0, -1.0, 1.0);
+    // Every other run rounded to a few levels, so most scores tie.
+    if (step % 2 == 1) {
+        for (auto& s : scores) {
+            s = std::round(s * 4.0);
+        }
+    }
+    for (const std::size_t k : {std::size_t{0}, std::size_t{1}, std::size_t{7}, n / 2, n, n + 3}) {
+        const auto expected = sorted(scores, k);
+        FNN_CHECK(fnn::top_k(scores, k) == expected);
+    }
+}
+
+// Every query of `queries` finds the exact top k with a full budget; a
+// budget of one partition still returns k true scores, best first.
+void check_search(const MipsIndex& index, const Tensor2D& w, const Tensor2D& b,
+                  const Tensor2D& queries, std::size_t k, const char* what) {
+    const auto batch = index.search_batch(queries, k, index.partitions());
+    for (std::size_t q = 0; q < queries.rows(); ++q) {
+        const std::span<const Scalar> h(queries.data() + q * w.cols(), w.cols());
+        const auto all = logits(w, b, h);
+        const auto expected = fnn::top_k(all, k);
+        const auto exact = index.search(h, k, index.partitions());
+        FNN_CHECK(same_classes(exact, expected));
+        FNN_CHECK_CLOSE(scores_of(exact), scores_of(expected), 1e-12, "%s, query %zu", what, q);
+        FNN_CHECK(batch[q] == exact);
+
+        const auto probed = index.search(h, k, 1);
+        FNN_CHECK(!probed.empty() && probed.size() <= k);
+        std::vector<Scalar> true_scores;
+        for (const auto& c : probed) {
+            true_scores.push_back(all[c.index]);
+        }
+        FNN_CHECK_CLOSE(scores_of(probed), true_scores, 1e-12, "%s, one probe, query %zu", what,
+                        q);
+        FNN_CHECK(std::is_sorted(probed.begin(), probed.end(),
+                                 [](const ScoredClass& x, const ScoredClass& y) {
+                                     return x.score > y.score;
+                                 }));
+    }
+}
+
+} // namespace
+
+int main() {
+    for (const std::size_t n : {1, 2, 10, 1000}) {
+        check_top_k(n, n);
+        check_top_k(n, n + 1);
+    }
+
+    // Spread-out rows: a Dense layer with random weights and biases.
+    fnn::Dense layer(24, 3000, fnn::CounterRng(112));
+    fnn::fill_uniform(layer.mutable_bias(), fnn::CounterRng(113), -0.1, 0.1);
+    Tensor2D queries(20, 24);
+    fnn::fill_uniform(queries, fnn::CounterRng(114), -1.0, 1.0);
+    const MipsIndex spread(layer, fnn::CounterRng(115));
+    FNN_CHECK(spread.classes() == 3000 && spread.dim() == 24);
+    FNN_CHECK(spread.partitions() == 55);
+    std::size_t rows = 0;
+    for (std::size_t p = 0; p < spread.partitions(); ++p) {
+        rows += spread.partition_size(p);
+    }
+    FNN_CHECK(rows == 3000);
+    check_search(spread, layer.weights(), layer.bias(), queries, 10, "spread rows");
+    const fnn::MipsIndexConfig coarse{7, 3, 16};
+    const MipsIndex few(layer.weights(), layer.bias(), fnn::CounterRng(116), coarse);
+    FNN_CHECK(few.partitions() == 7);
+    check_search(few, layer.weights(), layer.bias(), queries, 25, "7 partitions");
+
+    // Tight clusters around far-apart centres, queries along a centre.
+    const std::size_t clusters = 16;
+    const std::size_t dim = 8;
+    Tensor2D centres(clusters, dim);
+    fnn::fill_uniform(centres, fnn::CounterRng(117), -10.0, 10.0);
+    Tensor2D w(clusters * 50, dim);
+    fnn::fill_uniform(w, fnn::CounterRng(118), -0.05, 0.05);
+    for (std::size_t r = 0; r < w.rows(); ++r) {
+        for (std::size_t c = 0; c < dim; ++c) {
+            w(r, c) += centres(r % clusters, c);
+        }
+    }
+    Tensor2D b(1, w.rows());
+    Tensor2D along(clusters, dim);
+    for (std::size_t q = 0; q < clusters; ++q) {
+        for (std::size_t c = 0; c < dim; ++c) {
+            along(q, c) = centres(q, c);
+        }
+    }
+    const fnn::MipsIndexConfig by_cluster{clusters, 10, 64};
+    const MipsIndex clustered(w, b, fnn::CounterRng(119), by_cluster);
+    check_search(clustered, w, b, along, 5, "clustered rows");
+
+    // k past the row count returns every row.
+    FNN_CHECK(few.search(std::span<const Scalar>(queries.data(), 24), 5000, 7).size() == 3000);
+    FNN_CHECK(few.search(std::span<const Scalar>(queries.data(), 24), 0, 7).empty());
+
+    const std::vector<Scalar> short_query(23);
+    FNN_CHECK_THROWS(spread.search(short_query, 3, 1), std::invalid_argument);
+    FNN_CHECK_THROWS(spread.search_batch(Tensor2D(2, 23), 3, 1), std::invalid_argument);
+    FNN_CHECK_THROWS(spread.partition_size(55), std::out_of_range);
+    FNN_CHECK_THROWS(MipsIndex(Tensor2D(0, 4), Tensor2D(1, 0), fnn::CounterRng(1)),
+                     std::invalid_argument);
+    FNN_CHECK_THROWS(MipsIndex(w, Tensor2D(1, 3), fnn::CounterRng(1)), std::invalid_argument);
+    return fnn::test::result();
+}
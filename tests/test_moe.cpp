@@ -0,0 +1,212 @@
+// MixtureOfExperts against a row-by-row reference (top-k of the gate
+// logits, softmax over them, weighted sum of the chosen experts) and its
+// gradients against central finite differences of that reference.
+
+#include "fnn/layers/moe.hpp"
+#include "fnn/random.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::ActivationKind;
+using fnn::Scalar;
+using fnn::Tensor2D;
+
+Scalar activate(ActivationKind kind, Scalar z) {
+    switch (kind) {
+    case ActivationKind::ReLU:
+        return z > 0.0 ? z : 0.0;
+    case ActivationKind::Tanh:
+        return std::tanh(z);
+    default:
+        return z;
+    }
+}
+
+// Copies of every parameter, so finite differences can nudge them.
+struct Params {
+    Tensor2D gate_w{0, 0};
+    Tensor2D gate_b{0, 0};
+    std::vector<Tensor2D> w;
+    std::vector<Tensor2D> b;
+};
+
+Params params_of(const fnn::MixtureOfExperts& moe) {
+    Params p{moe.gate().weights(), moe.gate().bias(), {}, {}};
+    for (std::size_t e = 0; e < moe.expert_count(); ++e) {
+        p.w.push_back(moe.expert(e).weights());
+        p.b.push_back(moe.expert(e).bias());
+    }
+    return p;
+}
+
+// x W^T + b for row r of x.
+std::vector<Scalar> affine(const Tensor2D& w, const Tensor2D& b, const Tensor2D& x,
+                           std::size_t r) {
+    std::vector<Scalar> z(w.rows());
+    for (std::size_t o = 0; o < w.rows(); ++o) {
+        z[o] = b(0, o);
+        for (std::size_t i = 0; i < w.cols(); ++i) {
+            z[o] += x(r, i) * w(o, i);
+        }
+    }
+    return z;
+}
+
+Tensor2D reference(const Params& p, std::size_t top_k, ActivationKind kind, const Tensor2D& x) {
+    const auto out = p.w.front().rows();
+    Tensor2D y(x.rows(), out);
+    for (std::size_t r = 0; r < x.rows(); ++r) {
+        const auto logits = affine(p.gate_w, p.gate_b, x, r);
+        std::vector<std::size_t> chosen(logits.size());
+        std::iota(chosen.begin(), chosen.end(), 0);
+        std::stable_sort(chosen.begin(), chosen.end(),
+                         [&](std::size_t a, std::size_t b) { return logits[a] > logits[b]; });
+        chosen.resize(top_k);
+        Scalar sum = 0.0;
+        for (const auto e : chosen) {
+            sum += std::exp(logits[e]);
+        }
+        for (const auto e : chosen) {
+            const auto z = affine(p.w[e], p.b[e], x, r);
+            for (std::size_t c = 0; c < out; ++c) {
+                y(r, c) += std::exp(logits[e]) / sum * activate(kind, z[c]);
+            }
+        }
+    }
+    return y;
+}
+
+// L = sum(dY * Y).
+Scalar loss(const Params& p, std::size_t top_k, ActivationKind kind, const Tensor2D& x,
+            const Tensor2D& dy) {
+    const auto y = reference(p, top_k, kind, x);
+    Scalar total = 0.0;
+    for (std::size_t i = 0; i < y.size(); ++i) {
+        total += dy.data()[i] * y.data()[i];
+    }
+    return total;
+}
+
+std::span<const Scalar> all(const Tensor2D& t) { return {t.data(), t.size()}; }
+
+struct Case {
+    std::size_t in;
+    std::size_t out;
+    std::size_t experts;
+    std::size_t top_k;
+    std::size_t batch;
+    ActivationKind kind;
+};
+
+void check(const Case& c) {
+    const fnn::CounterRng rng(31, c.batch, static_cast<std::uint32_t>(c.experts * 10 + c.top_k));
+    fnn::MixtureOfExperts moe(c.in, c.out, c.experts, c.top_k, rng, c.kind);
+    fnn::fill_uniform(moe.gate().mutable_bias(), rng.with_step(100), -0.5, 0.5);
+    for (std::size_t e = 0; e < c.experts; ++e) {
+        fnn::fill_uniform(moe.expert(e).mutable_bias(), rng.with_step(101 + e), -0.5, 0.5);
+    }
+    Tensor2D x(c.batch, c.in);
+    Tensor2D dy(c.batch, c.out);
+    fnn::fill_uniform(x, rng.with_step(200), -1.0, 1.0);
+    fnn::fill_uniform(dy, rng.with_step(201), -1.0, 1.0);
+    auto p = params_of(moe);
+
+    char what[96];
+    std::snprintf(what, sizeof(what), "%zu -> %zu, %zu experts, top %zu, batch %zu", c.in,
+                  c.out, c.experts, c.top_k, c.batch);
+    const auto y = moe.forward_batch(x);
+    FNN_CHECK_CLOSE(all(y), all(reference(p, c.top_k, c.kind, x)), 1e-12, "forward %s", what);
+    const auto load = moe.expert_load();
+    FNN_CHECK(std::accumulate(load.begin(), load.end(), std::size_t{0}) == c.batch * c.top_k);
+
+    const auto dx = moe.backward_batch(dy);
+    constexpr Scalar kStep = 1e-6;
+    std::vector<Scalar> numeric;
+    std::vector<Scalar> analytic;
+    // Central differences of `param` entries against `grad`.
+    const auto probe = [&](Tensor2D& param, const Tensor2D& grad) {
+        for (std::size_t i = 0; i < param.size(); i += param.size() / 6 + 1) {
+            const Scalar saved = param.data()[i];
+            param.data()[i] = saved + kStep;
+            const Scalar up = loss(p, c.top_k, c.kind, x, dy);
+            param.data()[i] = saved - kStep;
+            const Scalar down = loss(p, c.top_k, c.kind, x, dy);
+            param.data()[i] = saved;
+            numeric.push_back((up - down) / (2.0 * kStep));
+            analytic.push_back(grad.data()[i]);
+        }
+    };
+    probe(x, dx);
+    probe(p.gate_w, moe.gate().weight_grad());
+    probe(p.gate_b, moe.gate().bias_grad());
+    for (std::size_t e = 0; e < c.experts; ++e) {
+        probe(p.w[e], moe.expert(e).weight_grad());
+        probe(p.b[e], moe.expert(e).bias_grad());
+    }
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-6, "finite differences %s", what);
+
+    // The single-sample path is a batch of one.
+    moe.zero_grad();
+    const fnn::Vector row(x.data(), x.data() + c.in);
+    const auto y_row = moe.forward(row);
+    FNN_CHECK_CLOSE(y_row, std::span<const Scalar>(y.data(), c.out), 1e-14,
+                    "single-sample forward %s", what);
+    const auto dx_row = moe.backward(fnn::Vector(dy.data(), dy.data() + c.out));
+    Tensor2D x_row(1, c.in);
+    Tensor2D dy_row(1, c.out);
+    std::copy(row.begin(), row.end(), x_row.data());
+    std::copy(dy.data(), dy.data() + c.out, dy_row.data());
+    numeric.clear();
+    analytic.clear();
+    for (std::size_t i = 0; i < c.in; ++i) {
+        const Scalar saved = x_row.data()[i];
+        x_row.data()[i] = saved + kStep;
+        const Scalar up = loss(p, c.top_k, c.kind, x_row, dy_row);
+        x_row.data()[i] = saved - kStep;
+        const Scalar down = loss(p, c.top_k, c.kind, x_row, dy_row);
+        x_row.data()[i] = saved;
+        numeric.push_back((up - down) / (2.0 * kStep));
+        analytic.push_back(dx_row[i]);
+    }
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-6, "single-sample backward %s", what);
+}
+
+} // namespace
+
+int main() {
+    constexpr Case kCases[] = {
+        {6, 4, 5, 2, 9, ActivationKind::Tanh},     {6, 4, 5, 1, 17, ActivationKind::Identity},
+        {5, 3, 3, 3, 4, ActivationKind::ReLU},     {8, 7, 8, 3, 33, ActivationKind::Tanh},
+        {3, 2, 16, 4, 64, ActivationKind::Identity},
+    };
+    for (const auto& c : kCases) {
+        check(c);
+    }
+
+    // Equal logits route to the lowest expert indices.
+    const fnn::CounterRng rng(32);
+    fnn::MixtureOfExperts moe(4, 2, 6, 2, rng);
+    moe.gate().mutable_weights() = Tensor2D(6, 4);
+    (void)moe.forward_batch(Tensor2D(5, 4));
+    const std::vector<std::size_t> expected_load = {5, 5, 0, 0, 0, 0};
+    FNN_CHECK(moe.expert_load() == expected_load);
+
+    FNN_CHECK_THROWS(fnn::MixtureOfExperts(4, 2, 3, 0, rng), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::MixtureOfExperts(4, 2, 3, 4, rng), std::invalid_argument);
+    FNN_CHECK_THROWS(moe.forward_batch(Tensor2D(2, 3)), std::invalid_argument);
+    FNN_CHECK_THROWS(moe.backward_batch(Tensor2D(4, 2)), std::invalid_argument);
+    FNN_CHECK_THROWS(moe.expert(6), std::out_of_range);
+    fnn::MixtureOfExperts fresh(4, 2, 3, 1, rng);
+    FNN_CHECK_THROWS(fresh.backward_batch(Tensor2D(1, 2)), std::logic_error);
+    return fnn::test::result();
+}
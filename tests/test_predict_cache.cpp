@@ -0,0 +1,143 @@
+// PredictCache: a repeated input is served from the cache without calling
+// the model, set_weights() bumps version() and drops every entry, and each
+// shard evicts its least recently used entry at capacity. Lookups from
+// several threads agree with the model, and misses on a model that is not
+// reentrant never overlap.
+
+#include "fnn/layers/dense.hpp"
+#include "fnn/model.hpp"
+#include "fnn/predict_cache.hpp"
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "test_util.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using fnn::PredictCache;
+using fnn::Vector;
+
+// Forwards to a Sequential, counting calls and overlapping calls.
+class CountingModel : public fnn::Model {
+public:
+    explicit CountingModel(fnn::Model& inner) : inner_(inner) {}
+
+    Vector predict(const Vector& input) override {
+        if (in_flight_.fetch_add(1) != 0) {
+            overlaps.fetch_add(1);
+        }
+        calls.fetch_add(1);
+        auto out = inner_.predict(input);
+        in_flight_.fetch_sub(1);
+        return out;
+    }
+    std::uint64_t version() const noexcept override { return inner_.version(); }
+
+    std::atomic<std::size_t> calls{0};
+    std::atomic<std::size_t> overlaps{0};
+
+private:
+    fnn::Model& inner_;
+    std::atomic<int> in_flight_{0};
+};
+
+Vector input(std::size_t i) {
+    Vector x(4);
+    fnn::CounterRng(141, i).fill_uniform(x, 0, -1.0, 1.0);
+    return x;
+}
+
+} // namespace
+
+int main() {
+    fnn::Sequential net;
+    auto& dense = dynamic_cast<fnn::Dense&>(
+        net.add(std::make_unique<fnn::Dense>(4, 3, fnn::CounterRng(140))));
+    net.set_training(false);
+    CountingModel model(net);
+
+    // A hit returns the stored result without calling the model.
+    PredictCache cache(model, 4, 1);
+    FNN_CHECK(cache.capacity() == 4 && cache.shard_count() == 1);
+    const auto first = cache.predict(input(0));
+    FNN_CHECK_CLOSE(first, net.predict(input(0)), 0.0, "miss");
+    FNN_CHECK_CLOSE(cache.predict(input(0)), first, 0.0, "hit");
+    auto s = cache.stats();
+    FNN_CHECK(s.hits == 1 && s.misses == 1 && s.size == 1 && model.calls == 1);
+
+    // set_weights() bumps the version: the same input misses and gets the
+    // new result, and the old entries are gone.
+    (void)cache.predict(input(1));
+    const auto version = cache.version();
+    fnn::Tensor2D weights(3, 4);
+    fnn::fill_uniform(weights, fnn::CounterRng(142), -1.0, 1.0);
+    dense.set_weights(weights, fnn::Tensor2D(1, 3));
+    FNN_CHECK(cache.version() != version);
+    const auto updated = cache.predict(input(0));
+    FNN_CHECK_CLOSE(updated, net.predict(input(0)), 0.0, "after set_weights");
+    FNN_CHECK(fnn::test::max_error(updated, first) > 0.0);
+    s = cache.stats();
+    FNN_CHECK(s.misses == 3 && s.size == 1 && model.calls == 3);
+
+    // Least recently used goes first: 0 is touched again, so 1 is evicted.
+    for (std::size_t i = 1; i < 4; ++i) {
+        (void)cache.predict(input(i));
+    }
+    (void)cache.predict(input(0));
+    (void)cache.predict(input(4));
+    s = cache.stats();
+    FNN_CHECK(s.size == 4 && s.evictions == 1);
+    const auto calls = model.calls.load();
+    (void)cache.predict(input(0));
+    FNN_CHECK(model.calls == calls);
+    (void)cache.predict(input(1));
+    FNN_CHECK(model.calls == calls + 1);
+    cache.clear();
+    FNN_CHECK(cache.stats().size == 0);
+
+    // Shards split the capacity and never hold more than it together.
+    PredictCache sharded(model, 10, 16);
+    FNN_CHECK(sharded.shard_count() == 10);
+    for (std::size_t i = 0; i < 200; ++i) {
+        (void)sharded.predict(input(i));
+    }
+    s = sharded.stats();
+    FNN_CHECK(s.size <= 10 && s.size > 0 && s.evictions == 200 - s.size);
+
+    // Concurrent lookups of a small working set.
+    PredictCache shared(model, 64, 4);
+    std::vector<Vector> expected;
+    for (std::size_t i = 0; i < 20; ++i) {
+        expected.push_back(net.predict(input(i)));
+    }
+    const auto before = model.calls.load();
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (std::size_t n = 0; n < 500; ++n) {
+                const auto i = (n * 7 + t) % 20;
+                if (fnn::test::max_error(shared.predict(input(i)), expected[i]) != 0.0) {
+                    wrong.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    s = shared.stats();
+    FNN_CHECK(wrong == 0 && model.overlaps == 0);
+    FNN_CHECK(s.hits + s.misses == 2000 && s.misses == model.calls - before);
+    FNN_CHECK(s.misses >= 20 && s.size <= 20);
+
+    FNN_CHECK_THROWS(PredictCache(model, 0), std::invalid_argument);
+    FNN_CHECK_THROWS(PredictCache(model, 4, 0), std::invalid_argument);
+    return fnn::test::result();
+}
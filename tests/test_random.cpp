@@ -0,0 +1,156 @@
+// CounterRng: bulk fills, whole-tensor fills split across the thread pool
+// and fills split at arbitrary chunk boundaries all equal the element-wise
+// definition, so results do not depend on FNN_NUM_THREADS (ctest runs this
+// at 1 and 4). Plus stream separation and rough moments.
+
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "fnn/util/thread_pool.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::CounterRng;
+using fnn::Scalar;
+using fnn::Tensor2D;
+
+std::span<const Scalar> all(const Tensor2D& t) { return {t.data(), t.size()}; }
+
+// Element-wise definitions of the three fills.
+std::vector<Scalar> expected_uniform(const CounterRng& rng, std::uint64_t first, std::size_t n,
+                                     Scalar lo, Scalar hi) {
+    std::vector<Scalar> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = lo + (hi - lo) * rng.uniform(first + i);
+    }
+    return out;
+}
+
+std::vector<Scalar> expected_normal(const CounterRng& rng, std::uint64_t first, std::size_t n,
+                                    Scalar mean, Scalar stddev) {
+    std::vector<Scalar> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = mean + stddev * rng.normal(first + i);
+    }
+    return out;
+}
+
+std::vector<Scalar> expected_bernoulli(const CounterRng& rng, std::uint64_t first,
+                                       std::size_t n, Scalar p) {
+    std::vector<Scalar> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = rng.uniform(first + i) < p ? 1.0 : 0.0;
+    }
+    return out;
+}
+
+void check_tensor_fills(const CounterRng& rng, std::size_t rows, std::size_t cols) {
+    Tensor2D t(rows, cols);
+    const auto n = rows * cols;
+    fnn::fill_uniform(t, rng, -2.0, 3.0);
+    FNN_CHECK_CLOSE(all(t), expected_uniform(rng, 0, n, -2.0, 3.0), 1e-15,
+                    "fill_uniform %zu x %zu", rows, cols);
+    fnn::fill_normal(t, rng, 1.0, 0.5);
+    FNN_CHECK_CLOSE(all(t), expected_normal(rng, 0, n, 1.0, 0.5), 1e-15,
+                    "fill_normal %zu x %zu", rows, cols);
+    fnn::fill_bernoulli(t, rng, 0.3);
+    FNN_CHECK_CLOSE(all(t), expected_bernoulli(rng, 0, n, 0.3), 0.0,
+                    "fill_bernoulli %zu x %zu", rows, cols);
+}
+
+// The same stream produced in chunks of `chunk` elements, on a private
+// pool of `threads` threads.
+std::vector<Scalar> chunked_uniform(const CounterRng& rng, std::size_t n, std::size_t chunk,
+                                    std::size_t threads) {
+    std::vector<Scalar> out(n);
+    fnn::util::ThreadPool pool(threads);
+    pool.parallel_for(0, (n + chunk - 1) / chunk, 1, [&](std::size_t lo, std::size_t hi) {
+        for (auto c = lo; c < hi; ++c) {
+            const auto first = c * chunk;
+            const auto count = std::min(chunk, n - first);
+            rng.fill_uniform({out.data() + first, count}, first, 0.0, 1.0);
+        }
+    });
+    return out;
+}
+
+} // namespace
+
+int main() {
+    const CounterRng rng(1234, 7, 3);
+
+    // Spans starting on odd elements and lengths that end mid-block.
+    for (const std::uint64_t first : {0, 1, 2, 5, 1001}) {
+        for (const std::size_t n : {1, 2, 3, 17, 64, 257}) {
+            std::vector<Scalar> out(n);
+            rng.fill_uniform(out, first, 0.0, 1.0);
+            FNN_CHECK_CLOSE(out, expected_uniform(rng, first, n, 0.0, 1.0), 0.0,
+                            "fill_uniform from %llu, %zu elements",
+                            static_cast<unsigned long long>(first), n);
+            rng.fill_normal(out, first, 0.0, 1.0);
+            FNN_CHECK_CLOSE(out, expected_normal(rng, first, n, 0.0, 1.0), 0.0,
+                            "fill_normal from %llu, %zu elements",
+                            static_cast<unsigned long long>(first), n);
+        }
+    }
+
+    // Tensors small enough for one task and large enough to be split.
+    check_tensor_fills(rng, 3, 5);
+    check_tensor_fills(rng, 333, 517);
+
+    const auto whole = chunked_uniform(rng, 100003, 100003, 1);
+    for (const std::size_t threads : {1, 2, 4}) {
+        for (const std::size_t chunk : {1, 7, 4096}) {
+            FNN_CHECK_CLOSE(chunked_uniform(rng, 100003, chunk, threads), whole, 0.0,
+                            "%zu-element chunks on %zu threads", chunk, threads);
+        }
+    }
+
+    // Uniform values in [0, 1) with mean 1/2 and variance 1/12; normals
+    // with mean 0 and variance 1.
+    Scalar sum = 0.0;
+    Scalar square = 0.0;
+    Scalar normal_sum = 0.0;
+    Scalar normal_square = 0.0;
+    std::vector<Scalar> normals(whole.size());
+    rng.fill_normal(normals, 0, 0.0, 1.0);
+    for (std::size_t i = 0; i < whole.size(); ++i) {
+        FNN_CHECK(whole[i] >= 0.0 && whole[i] < 1.0);
+        sum += whole[i];
+        square += whole[i] * whole[i];
+        normal_sum += normals[i];
+        normal_square += normals[i] * normals[i];
+    }
+    const auto n = static_cast<Scalar>(whole.size());
+    const std::vector<Scalar> moments = {sum / n, square / n - (sum / n) * (sum / n),
+                                         normal_sum / n, normal_square / n};
+    const std::vector<Scalar> expected_moments = {0.5, 1.0 / 12.0, 0.0, 1.0};
+    FNN_CHECK_CLOSE(moments, expected_moments, 0.01, "moments");
+
+    // Streams differ in every key component, including steps past 2^32
+    // against the seed's upper half.
+    const CounterRng base(0);
+    const CounterRng variants[] = {CounterRng(1), CounterRng(0, 1), CounterRng(0, 0, 1),
+                                   CounterRng(std::uint64_t{1} << 32),
+                                   CounterRng(0, std::uint64_t{1} << 32)};
+    for (const auto& v : variants) {
+        FNN_CHECK(v.uniform(0) != base.uniform(0));
+    }
+    FNN_CHECK(CounterRng(std::uint64_t{1} << 32).uniform(0) !=
+              CounterRng(0, std::uint64_t{1} << 32).uniform(0));
+    FNN_CHECK(rng.with_step(8).step() == 8 && rng.with_step(8).layer() == 3);
+    FNN_CHECK(rng.with_layer(4).layer() == 4 && rng.with_layer(4).step() == 7);
+
+    std::vector<Scalar> out(4);
+    FNN_CHECK_THROWS(rng.fill_uniform(out, 0, 1.0, 1.0), std::invalid_argument);
+    FNN_CHECK_THROWS(rng.fill_normal(out, 0, 0.0, -1.0), std::invalid_argument);
+    FNN_CHECK_THROWS(rng.fill_bernoulli(out, 0, 1.5), std::invalid_argument);
+    return fnn::test::result();
+}
@@ -0,0 +1,163 @@
+// SampledSoftmaxLoss gradients against central finite differences of its
+// own loss (the samples depend only on the rng, so the loss is a smooth
+// function of the parameters), the samplers against their probabilities,
+// and the Softmax-mode estimate against the full softmax loss.
+
+#include "fnn/random.hpp"
+#include "fnn/sampled_softmax.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::SampledSoftmaxLoss;
+using fnn::Scalar;
+using fnn::Tensor2D;
+
+std::span<const Scalar> all(const Tensor2D& t) { return {t.data(), t.size()}; }
+
+const char* name(SampledSoftmaxLoss::Mode mode) {
+    return mode == SampledSoftmaxLoss::Mode::Softmax ? "softmax" : "negative sampling";
+}
+
+void check_gradients(SampledSoftmaxLoss::Mode mode, std::size_t num_sampled) {
+    constexpr std::size_t kClasses = 40;
+    constexpr std::size_t kHidden = 6;
+    constexpr std::size_t kBatch = 5;
+    const fnn::CounterRng rng(41, num_sampled);
+    const fnn::LogUniformSampler sampler(kClasses);
+    const SampledSoftmaxLoss loss(sampler, num_sampled, mode);
+    Tensor2D hidden(kBatch, kHidden);
+    Tensor2D weights(kClasses, kHidden);
+    Tensor2D bias(1, kClasses);
+    fnn::fill_uniform(hidden, rng.with_step(1), -1.0, 1.0);
+    fnn::fill_uniform(weights, rng.with_step(2), -0.5, 0.5);
+    fnn::fill_uniform(bias, rng.with_step(3), -0.5, 0.5);
+    const std::vector<std::size_t> labels = {0, 3, 3, 17, 39};
+    const auto draw = rng.with_step(4);
+
+    const auto result = loss.compute(hidden, labels, weights, bias, draw);
+    FNN_CHECK(std::isfinite(result.loss));
+    // Dense copies of the sparse parameter gradients.
+    Tensor2D d_weights(kClasses, kHidden);
+    fnn::scatter_add_rows(result.classes, result.d_weights, 1.0, d_weights);
+    Tensor2D d_bias(1, kClasses);
+    for (std::size_t i = 0; i < result.classes.size(); ++i) {
+        d_bias(0, result.classes[i]) = result.d_bias[i];
+    }
+
+    constexpr Scalar kStep = 1e-6;
+    std::vector<Scalar> numeric;
+    std::vector<Scalar> analytic;
+    const auto probe = [&](Tensor2D& param, const Tensor2D& grad, std::size_t stride) {
+        for (std::size_t i = 0; i < param.size(); i += stride) {
+            const Scalar saved = param.data()[i];
+            param.data()[i] = saved + kStep;
+            const Scalar up = loss.compute(hidden, labels, weights, bias, draw).loss;
+            param.data()[i] = saved - kStep;
+            const Scalar down = loss.compute(hidden, labels, weights, bias, draw).loss;
+            param.data()[i] = saved;
+            numeric.push_back((up - down) / (2.0 * kStep));
+            analytic.push_back(grad.data()[i]);
+        }
+    };
+    probe(hidden, result.d_hidden, 1);
+    probe(weights, d_weights, 5);
+    probe(bias, d_bias, 1);
+    FNN_CHECK_CLOSE(analytic, numeric, 1e-7, "finite differences, %s, %zu samples",
+                    name(mode), num_sampled);
+}
+
+// Sample frequencies against probability(), and probability() summing
+// to one.
+void check_sampler(const fnn::CandidateSampler& sampler, const char* what) {
+    constexpr std::size_t kDraws = 200000;
+    const auto classes = sampler.classes();
+    std::vector<std::size_t> drawn(kDraws);
+    sampler.sample(fnn::CounterRng(42), 0, drawn);
+    std::vector<Scalar> frequency(classes, 0.0);
+    std::vector<Scalar> probability(classes);
+    Scalar total = 0.0;
+    for (const auto c : drawn) {
+        FNN_CHECK(c < classes);
+        frequency[c] += 1.0 / static_cast<Scalar>(kDraws);
+    }
+    for (std::size_t c = 0; c < classes; ++c) {
+        probability[c] = sampler.probability(c);
+        total += probability[c];
+    }
+    FNN_CHECK_CLOSE(std::span<const Scalar>(&total, 1), std::vector<Scalar>{1.0}, 1e-12,
+                    "%s probabilities sum", what);
+    // A few standard deviations of a binomial proportion at p <= 1/2.
+    FNN_CHECK_CLOSE(frequency, probability, 0.005, "%s frequencies", what);
+
+    // Samples depend only on (rng, first, i).
+    std::vector<std::size_t> tail(10);
+    sampler.sample(fnn::CounterRng(42), 2 * 100, tail);
+    FNN_CHECK(std::equal(tail.begin(), tail.end(), drawn.begin() + 100));
+}
+
+} // namespace
+
+int main() {
+    for (const auto mode : {SampledSoftmaxLoss::Mode::Softmax,
+                            SampledSoftmaxLoss::Mode::NegativeSampling}) {
+        for (const std::size_t num_sampled : {1, 8, 64}) {
+            check_gradients(mode, num_sampled);
+        }
+    }
+
+    check_sampler(fnn::LogUniformSampler(30), "log-uniform");
+    const std::vector<Scalar> weights = {5.0, 0.0, 1.0, 3.0, 0.5, 0.5, 2.0};
+    const fnn::AliasSampler alias(weights);
+    check_sampler(alias, "alias");
+    FNN_CHECK(alias.probability(1) == 0.0);
+
+    // With many samples the Softmax-mode loss approaches the full softmax
+    // cross-entropy.
+    {
+        constexpr std::size_t kClasses = 200;
+        const fnn::CounterRng rng(43);
+        const fnn::LogUniformSampler sampler(kClasses);
+        const SampledSoftmaxLoss loss(sampler, 20000);
+        Tensor2D hidden(4, 8);
+        Tensor2D w(kClasses, 8);
+        Tensor2D b(1, kClasses);
+        fnn::fill_uniform(hidden, rng.with_step(1), -1.0, 1.0);
+        fnn::fill_uniform(w, rng.with_step(2), -0.3, 0.3);
+        const std::vector<std::size_t> labels = {1, 50, 120, 199};
+        const Scalar full = SampledSoftmaxLoss::full_loss(hidden, labels, w, b);
+        const Scalar sampled = loss.compute(hidden, labels, w, b, rng.with_step(3)).loss;
+        FNN_CHECK_CLOSE(std::span<const Scalar>(&sampled, 1), std::vector<Scalar>{full}, 0.02,
+                        "sampled estimate of the full loss %g", full);
+    }
+
+    Tensor2D target(4, 2);
+    Tensor2D rows(2, 2);
+    rows(0, 0) = 1.0;
+    rows(1, 1) = 2.0;
+    const std::vector<std::size_t> classes = {3, 1};
+    fnn::scatter_add_rows(classes, rows, -0.5, target);
+    const std::vector<Scalar> scattered = {0.0, 0.0, 0.0, -1.0, 0.0, 0.0, -0.5, 0.0};
+    FNN_CHECK_CLOSE(all(target), scattered, 0.0, "scatter_add_rows");
+    const std::vector<std::size_t> past_end = {4, 0};
+    FNN_CHECK_THROWS(fnn::scatter_add_rows(past_end, rows, 1.0, target), std::invalid_argument);
+
+    const fnn::LogUniformSampler sampler(10);
+    FNN_CHECK_THROWS(SampledSoftmaxLoss(sampler, 0), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::LogUniformSampler(0), std::invalid_argument);
+    const std::vector<Scalar> negative = {1.0, -1.0};
+    FNN_CHECK_THROWS(fnn::AliasSampler{negative}, std::invalid_argument);
+    const SampledSoftmaxLoss loss(sampler, 4);
+    const std::vector<std::size_t> bad_label = {10};
+    FNN_CHECK_THROWS(loss.compute(Tensor2D(1, 3), bad_label, Tensor2D(10, 3), Tensor2D(1, 10),
+                                  fnn::CounterRng(1)),
+                     std::invalid_argument);
+    return fnn::test::result();
+}
@@ -0,0 +1,119 @@
+// gemm_strassen() against gemm() with the crossover lowered so small
+// products recurse: odd dimensions that peel a row, column or inner slice
+// at every level, non-square and transposed operands, alpha / beta
+// scaling through the separate product buffer, and the workspace checks.
+
+#include "fnn/gemm.hpp"
+#include "fnn/random.hpp"
+#include "fnn/strassen.hpp"
+#include "fnn/tensor2D.hpp"
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::MatrixRef;
+using fnn::MutableMatrixRef;
+using fnn::Scalar;
+using fnn::StrassenConfig;
+
+std::vector<Scalar> random_values(std::size_t n, std::uint64_t step) {
+    std::vector<Scalar> v(n);
+    fnn::CounterRng(91, step).fill_uniform(v, 0, -1.0, 1.0);
+    return v;
+}
+
+// An m x n operand, stored column-major when `transposed`.
+MatrixRef view(const std::vector<Scalar>& storage, std::size_t m, std::size_t n,
+               bool transposed) {
+    return transposed ? MatrixRef{storage.data(), m, n, 1, m}
+                      : MatrixRef{storage.data(), m, n, n, 1};
+}
+
+void check(std::size_t m, std::size_t n, std::size_t k, Scalar alpha, Scalar beta,
+           bool transposed, std::size_t depth) {
+    const auto a_values = random_values(m * k, 1);
+    const auto b_values = random_values(k * n, 2);
+    const auto a = view(a_values, m, k, transposed);
+    const auto b = view(b_values, k, n, transposed);
+    auto expected = random_values(m * n, 3);
+    auto actual = expected;
+    if (beta == 0.0) {
+        // C is not read when beta == 0.
+        actual.assign(m * n, std::numeric_limits<Scalar>::quiet_NaN());
+    }
+    fnn::gemm(alpha, a, b, beta, MutableMatrixRef{expected.data(), m, n, n, 1});
+
+    const StrassenConfig config{16, depth};
+    std::vector<Scalar> workspace(fnn::strassen_workspace_size(m, n, k, alpha, beta, config));
+    fnn::gemm_strassen(alpha, a, b, beta, MutableMatrixRef{actual.data(), m, n, n, 1},
+                       workspace, config);
+    FNN_CHECK_CLOSE(actual, expected, 1e-12,
+                    "%zu x %zu x %zu, alpha %g, beta %g, transposed %d, depth %zu", m, n, k,
+                    alpha, beta, transposed ? 1 : 0, depth);
+}
+
+} // namespace
+
+int main() {
+    // Square powers of two, odd at every level, and non-square in each
+    // direction; the smallest dimension decides how deep it recurses.
+    const std::size_t shapes[][3] = {{64, 64, 64},  {33, 33, 33},   {67, 45, 51},
+                                     {129, 131, 127}, {40, 100, 17}, {100, 40, 64},
+                                     {17, 200, 96},  {250, 19, 130}, {35, 36, 137}};
+    for (const auto& s : shapes) {
+        for (const std::size_t depth : {1, 4}) {
+            check(s[0], s[1], s[2], 1.0, 0.0, false, depth);
+            check(s[0], s[1], s[2], 0.5, 0.0, true, depth);
+            check(s[0], s[1], s[2], -1.5, 0.75, false, depth);
+        }
+    }
+
+    // Below the crossover it is gemm() itself and needs no workspace.
+    // Scaling needs room for the product besides the recursion's blocks.
+    const StrassenConfig deep{16, 4};
+    FNN_CHECK(fnn::strassen_workspace_size(15, 64, 64, 1.0, 0.0, deep) == 0);
+    FNN_CHECK(fnn::strassen_workspace_size(64, 64, 64, 1.0, 0.0, deep) + 64 * 64 ==
+              fnn::strassen_workspace_size(64, 64, 64, 2.0, 0.0, deep));
+
+    // matmul_strassen() and the thread-owned workspace.
+    fnn::Tensor2D x(70, 90);
+    fnn::Tensor2D y(90, 50);
+    fnn::fill_uniform(x, fnn::CounterRng(92), -1.0, 1.0);
+    fnn::fill_uniform(y, fnn::CounterRng(93), -1.0, 1.0);
+    const auto product = fnn::matmul_strassen(x, y, {16, 3});
+    const auto reference = fnn::matmul(x, y);
+    FNN_CHECK_CLOSE(std::span<const Scalar>(product.data(), product.size()),
+                    std::span<const Scalar>(reference.data(), reference.size()), 1e-12,
+                    "matmul_strassen");
+    fnn::Tensor2D z(70, 50);
+    const MatrixRef xr{x.data(), 70, 90, 90, 1};
+    const MatrixRef yr{y.data(), 90, 50, 50, 1};
+    fnn::gemm_strassen(1.0, xr, yr, 0.0, MutableMatrixRef{z.data(), 70, 50, 50, 1}, {16, 3});
+    FNN_CHECK_CLOSE(std::span<const Scalar>(z.data(), z.size()),
+                    std::span<const Scalar>(reference.data(), reference.size()), 1e-12,
+                    "gemm_strassen, thread workspace");
+
+    const auto a = random_values(64 * 64, 4);
+    std::vector<Scalar> c(64 * 64);
+    const MatrixRef square{a.data(), 64, 64, 64, 1};
+    const MutableMatrixRef out{c.data(), 64, 64, 64, 1};
+    std::vector<Scalar> small(16);
+    const StrassenConfig two_levels{16, 2};
+    const StrassenConfig too_fine{8, 2};
+    FNN_CHECK_THROWS(fnn::gemm_strassen(1.0, square, square, 0.0, out, small, two_levels),
+                     std::length_error);
+    const MatrixRef narrow{a.data(), 64, 32, 64, 1};
+    FNN_CHECK_THROWS(fnn::gemm_strassen(1.0, narrow, square, 0.0, out, two_levels),
+                     std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::gemm_strassen(1.0, square, square, 0.0, out, too_fine),
+                     std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::set_strassen_crossover(15), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::matmul_strassen(x, x), std::invalid_argument);
+    return fnn::test::result();
+}
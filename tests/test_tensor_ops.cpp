@@ -0,0 +1,146 @@
+// Broadcasting element-wise ops against a loop over every output index
+// that maps it into each operand by hand: right-aligned shapes, size-1
+// dimensions read at index 0.
+
+#include "fnn/random.hpp"
+#include "fnn/tensor_ops.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using fnn::Dims;
+using fnn::Scalar;
+using fnn::Tensor;
+
+std::span<const Scalar> all(const Tensor& t) { return {t.data(), t.numel()}; }
+
+Tensor random_tensor(const Dims& dims, std::uint64_t step) {
+    Tensor t(dims);
+    fnn::CounterRng(61, step).fill_uniform({t.data(), t.numel()}, 0, 0.5, 2.0);
+    return t;
+}
+
+Dims broadcast_shape(const std::vector<const Dims*>& shapes) {
+    std::size_t rank = 0;
+    for (const auto* s : shapes) {
+        rank = std::max(rank, s->size());
+    }
+    Dims out(rank, 1);
+    for (const auto* s : shapes) {
+        for (std::size_t i = 0; i < s->size(); ++i) {
+            auto& d = out[rank - s->size() + i];
+            d = std::max(d, (*s)[i]);
+        }
+    }
+    return out;
+}
+
+// Element of `t` read by the output index `index` (of rank >= t's rank).
+Scalar read(const Tensor& t, const Dims& index) {
+    const auto& dims = t.dims();
+    const auto offset = index.size() - dims.size();
+    std::size_t flat = 0;
+    for (std::size_t i = 0; i < dims.size(); ++i) {
+        flat = flat * dims[i] + (dims[i] == 1 ? 0 : index[offset + i]);
+    }
+    return t.data()[flat];
+}
+
+template <typename F>
+Tensor naive(const std::vector<const Tensor*>& in, F f) {
+    std::vector<const Dims*> shapes;
+    for (const auto* t : in) {
+        shapes.push_back(&t->dims());
+    }
+    Tensor out(broadcast_shape(shapes));
+    const auto& dims = out.dims();
+    Dims index(dims.size(), 0);
+    for (std::size_t flat = 0; flat < out.numel(); ++flat) {
+        std::vector<Scalar> args;
+        for (const auto* t : in) {
+            args.push_back(read(*t, index));
+        }
+        out.data()[flat] = f(args);
+        for (std::size_t d = dims.size(); d-- > 0;) {
+            if (++index[d] < dims[d]) {
+                break;
+            }
+            index[d] = 0;
+        }
+    }
+    return out;
+}
+
+void check_binary(const Dims& a_dims, const Dims& b_dims) {
+    const auto a = random_tensor(a_dims, 1);
+    const auto b = random_tensor(b_dims, 2);
+    const auto c = random_tensor(b_dims, 3);
+    const std::vector<const Tensor*> ab = {&a, &b};
+    const auto expect = [&](auto op) {
+        return naive(ab, [&](const std::vector<Scalar>& v) { return op(v[0], v[1]); });
+    };
+    const auto shape = broadcast_shape({&a_dims, &b_dims});
+    const auto sum = fnn::add(a, b);
+    FNN_CHECK(sum.dims() == shape);
+    FNN_CHECK_CLOSE(all(sum), all(expect([](Scalar x, Scalar y) { return x + y; })), 0.0, "add");
+    FNN_CHECK_CLOSE(all(fnn::sub(a, b)), all(expect([](Scalar x, Scalar y) { return x - y; })),
+                    0.0, "sub");
+    FNN_CHECK_CLOSE(all(fnn::mul(a, b)), all(expect([](Scalar x, Scalar y) { return x * y; })),
+                    0.0, "mul");
+    FNN_CHECK_CLOSE(all(fnn::div(a, b)), all(expect([](Scalar x, Scalar y) { return x / y; })),
+                    0.0, "div");
+    FNN_CHECK_CLOSE(all(fnn::maximum(a, b)),
+                    all(expect([](Scalar x, Scalar y) { return std::max(x, y); })), 0.0,
+                    "maximum");
+    // Commuted operands broadcast the same way.
+    FNN_CHECK_CLOSE(all(fnn::add(b, a)), all(sum), 0.0, "add commuted");
+
+    const std::vector<const Tensor*> abc = {&a, &b, &c};
+    const auto fma = naive(abc, [](const std::vector<Scalar>& v) { return v[0] * v[1] + v[2]; });
+    FNN_CHECK_CLOSE(all(fnn::fma(a, b, c)), all(fma), 1e-15, "fma");
+    const auto unary = naive({&a}, [](const std::vector<Scalar>& v) { return std::sqrt(v[0]); });
+    FNN_CHECK_CLOSE(all(fnn::unary(a, [](Scalar x) { return std::sqrt(x); })), all(unary), 0.0,
+                    "unary");
+
+    // In place only when the result keeps a's shape.
+    if (shape == a_dims) {
+        Tensor in_place = a;
+        fnn::add_inplace(in_place, b);
+        FNN_CHECK_CLOSE(all(in_place), all(sum), 0.0, "add_inplace");
+        in_place = a;
+        fnn::mul_inplace(in_place, b);
+        FNN_CHECK_CLOSE(all(in_place), all(fnn::mul(a, b)), 0.0, "mul_inplace");
+    } else {
+        Tensor in_place = a;
+        FNN_CHECK_THROWS(fnn::add_inplace(in_place, b), std::invalid_argument);
+    }
+}
+
+} // namespace
+
+int main() {
+    // Same shapes, bias rows, outer products, rank mismatch, interleaved
+    // size-1 dimensions, scalars, and shapes big enough to be split across
+    // the thread pool.
+    const std::vector<std::pair<Dims, Dims>> cases = {
+        {{3, 4}, {3, 4}},       {{3, 4}, {4}},          {{3, 1}, {1, 4}},
+        {{2, 3, 4}, {3, 1}},    {{5, 1, 7}, {1, 6, 1}}, {{1}, {2, 3}},
+        {{2, 1, 3, 1}, {4, 1, 5}}, {{256, 300}, {300}}, {{256, 300}, {256, 1}},
+        {{7, 64, 97}, {7, 1, 97}},
+    };
+    for (const auto& [a, b] : cases) {
+        check_binary(a, b);
+    }
+
+    FNN_CHECK_THROWS(fnn::add(Tensor({3, 4}), Tensor({5})), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::mul(Tensor({2, 3}), Tensor({3, 3})), std::invalid_argument);
+    return fnn::test::result();
+}
@@ -0,0 +1,220 @@
+// sum / mean / max over every subset of axes and permute over every
+// permutation, against loops over the multi-index; transpose and the
+// channel-blocked layout against their definitions, and its round trip.
+
+#include "fnn/random.hpp"
+#include "fnn/tensor2D.hpp"
+#include "fnn/tensor_permute.hpp"
+#include "fnn/tensor_reduce.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using fnn::Axes;
+using fnn::Dims;
+using fnn::Scalar;
+using fnn::Tensor;
+
+std::span<const Scalar> all(const Tensor& t) { return {t.data(), t.numel()}; }
+
+Tensor random_tensor(const Dims& dims, std::uint64_t step) {
+    Tensor t(dims);
+    fnn::CounterRng(71, step).fill_uniform({t.data(), t.numel()}, 0, -1.0, 1.0);
+    return t;
+}
+
+// Advances `index` through `dims` in row-major order.
+void next(Dims& index, const Dims& dims) {
+    for (std::size_t d = dims.size(); d-- > 0;) {
+        if (++index[d] < dims[d]) {
+            return;
+        }
+        index[d] = 0;
+    }
+}
+
+enum class Op { Sum, Mean, Max };
+
+// Reduction of `t` over the axes flagged in `reduced`, keepdims shape.
+Tensor naive_reduce(const Tensor& t, const std::vector<bool>& reduced, Op op) {
+    const auto& dims = t.dims();
+    Dims out_dims = dims;
+    std::size_t count = 1;
+    for (std::size_t d = 0; d < dims.size(); ++d) {
+        if (reduced[d]) {
+            out_dims[d] = 1;
+            count *= dims[d];
+        }
+    }
+    Tensor out(out_dims);
+    std::fill(out.data(), out.data() + out.numel(),
+              op == Op::Max ? -std::numeric_limits<Scalar>::infinity() : 0.0);
+    Dims index(dims.size(), 0);
+    for (std::size_t flat = 0; flat < t.numel(); ++flat, next(index, dims)) {
+        std::size_t o = 0;
+        for (std::size_t d = 0; d < dims.size(); ++d) {
+            o = o * out_dims[d] + (reduced[d] ? 0 : index[d]);
+        }
+        const Scalar v = t.data()[flat];
+        out.data()[o] = op == Op::Max ? std::max(out.data()[o], v) : out.data()[o] + v;
+    }
+    if (op == Op::Mean) {
+        for (std::size_t i = 0; i < out.numel(); ++i) {
+            out.data()[i] /= static_cast<Scalar>(count);
+        }
+    }
+    return out;
+}
+
+void check_reductions(const Dims& dims) {
+    const auto t = random_tensor(dims, dims.size());
+    const auto rank = dims.size();
+    for (std::size_t subset = 0; subset < (std::size_t{1} << rank); ++subset) {
+        Axes axes;
+        std::vector<bool> reduced(rank, subset == 0);
+        // Listed in descending order to check that order does not matter.
+        for (std::size_t d = rank; d-- > 0;) {
+            if (subset & (std::size_t{1} << d)) {
+                axes.push_back(d);
+                reduced[d] = true;
+            }
+        }
+        Dims squeezed;
+        for (std::size_t d = 0; d < rank; ++d) {
+            if (!reduced[d]) {
+                squeezed.push_back(dims[d]);
+            }
+        }
+        for (const auto op : {Op::Sum, Op::Mean, Op::Max}) {
+            const auto expected = naive_reduce(t, reduced, op);
+            const auto reduce = [&](bool keepdims) {
+                return op == Op::Sum    ? fnn::sum(t, axes, keepdims)
+                       : op == Op::Mean ? fnn::mean(t, axes, keepdims)
+                                        : fnn::max(t, axes, keepdims);
+            };
+            const auto kept = reduce(true);
+            const auto dropped = reduce(false);
+            FNN_CHECK(kept.dims() == expected.dims());
+            FNN_CHECK(dropped.dims() == squeezed || (squeezed.empty() && dropped.numel() == 1));
+            FNN_CHECK_CLOSE(all(kept), all(expected), 1e-12, "reduction %d, rank %zu, axes %zu",
+                            static_cast<int>(op), rank, subset);
+            FNN_CHECK_CLOSE(all(dropped), all(expected), 1e-12, "keepdims=false, axes %zu",
+                            subset);
+        }
+    }
+}
+
+Tensor naive_permute(const Tensor& t, const std::vector<std::size_t>& perm) {
+    const auto& dims = t.dims();
+    Dims out_dims(dims.size());
+    for (std::size_t i = 0; i < perm.size(); ++i) {
+        out_dims[i] = dims[perm[i]];
+    }
+    Tensor out(out_dims);
+    Dims index(dims.size(), 0);
+    for (std::size_t flat = 0; flat < out.numel(); ++flat, next(index, out_dims)) {
+        // Output index i reads input dimension perm[i] at index[i].
+        Dims source(dims.size());
+        for (std::size_t i = 0; i < perm.size(); ++i) {
+            source[perm[i]] = index[i];
+        }
+        std::size_t s = 0;
+        for (std::size_t d = 0; d < dims.size(); ++d) {
+            s = s * dims[d] + source[d];
+        }
+        out.data()[flat] = t.data()[s];
+    }
+    return out;
+}
+
+void check_permutations(const Dims& dims) {
+    const auto t = random_tensor(dims, 10 + dims.size());
+    std::vector<std::size_t> perm(dims.size());
+    std::iota(perm.begin(), perm.end(), 0);
+    do {
+        const auto out = fnn::permute(t, perm);
+        const auto expected = naive_permute(t, perm);
+        FNN_CHECK(out.dims() == expected.dims());
+        FNN_CHECK_CLOSE(all(out), all(expected), 0.0, "permute of rank %zu", dims.size());
+    } while (std::next_permutation(perm.begin(), perm.end()));
+}
+
+void check_blocked(std::size_t n, std::size_t c, std::size_t h, std::size_t w) {
+    const auto nchw = random_tensor({n, c, h, w}, 20);
+    const auto blocks = (c + fnn::kChannelBlock - 1) / fnn::kChannelBlock;
+    const auto blocked = fnn::to_nchwc(nchw);
+    const Dims blocked_dims = {n, blocks, h, w, fnn::kChannelBlock};
+    FNN_CHECK(blocked.dims() == blocked_dims);
+    // blocked[n, ch / 8, y, x, ch % 8] = nchw[n, ch, y, x], zero past c.
+    Tensor expected(blocked_dims);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t ch = 0; ch < blocks * fnn::kChannelBlock; ++ch) {
+            for (std::size_t y = 0; y < h; ++y) {
+                for (std::size_t x = 0; x < w; ++x) {
+                    const auto b = ch / fnn::kChannelBlock;
+                    const auto lane = ch % fnn::kChannelBlock;
+                    expected.data()[(((i * blocks + b) * h + y) * w + x) * fnn::kChannelBlock +
+                                    lane] =
+                        ch < c ? nchw.data()[((i * c + ch) * h + y) * w + x] : 0.0;
+                }
+            }
+        }
+    }
+    FNN_CHECK_CLOSE(all(blocked), all(expected), 0.0, "to_nchwc (%zu, %zu, %zu, %zu)", n, c, h,
+                    w);
+    FNN_CHECK_CLOSE(all(fnn::from_nchwc(blocked, c)), all(nchw), 0.0,
+                    "from_nchwc round trip (%zu, %zu, %zu, %zu)", n, c, h, w);
+}
+
+} // namespace
+
+int main() {
+    check_reductions({7});
+    check_reductions({3, 5});
+    check_reductions({2, 3, 4, 5});
+    check_reductions({4, 1, 33});
+    check_reductions({300, 129});
+    check_reductions({3, 70, 2, 65});
+
+    check_permutations({5, 7});
+    check_permutations({2, 3, 4});
+    check_permutations({3, 1, 4, 6});
+    check_permutations({130, 67});
+    check_permutations({4, 33, 5, 17});
+
+    // transpose: element (r, c) moves to (c, r).
+    fnn::Tensor2D m(123, 77);
+    fnn::fill_uniform(m, fnn::CounterRng(72), -1.0, 1.0);
+    const auto mt = fnn::transpose(m);
+    FNN_CHECK(mt.rows() == 77 && mt.cols() == 123);
+    std::vector<Scalar> expected(m.size());
+    for (std::size_t r = 0; r < m.rows(); ++r) {
+        for (std::size_t c = 0; c < m.cols(); ++c) {
+            expected[c * m.rows() + r] = m(r, c);
+        }
+    }
+    FNN_CHECK_CLOSE(std::span<const Scalar>(mt.data(), mt.size()), expected, 0.0, "transpose");
+
+    for (const std::size_t channels : {1, 3, 8, 11, 16}) {
+        check_blocked(2, channels, 5, 7);
+    }
+    check_blocked(1, 19, 1, 33);
+
+    const auto t = random_tensor({2, 3, 4}, 30);
+    FNN_CHECK_THROWS(fnn::sum(t, {3}), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::mean(t, {1, 1}), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::permute(t, {0, 1}), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::permute(t, {0, 1, 1}), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::to_nchwc(t), std::invalid_argument);
+    FNN_CHECK_THROWS(fnn::from_nchwc(fnn::to_nchwc(random_tensor({1, 8, 2, 2}, 31)), 9),
+                     std::invalid_argument);
+    return fnn::test::result();
+}
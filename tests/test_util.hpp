@@ -0,0 +1,85 @@
+#pragma once
+
+// Minimal checking helpers for the ctest executables. A failed check prints
+// where and why and is counted; main() returns test::result(), so ctest
+// sees a non-zero exit status when anything failed.
+
+#include "fnn/config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <span>
+
+namespace fnn::test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* what) {
+    std::fprintf(stderr, "%s:%d: FAILED: %s\n", file, line, what);
+    ++failures();
+}
+
+// Largest |a[i] - b[i]| / max(1, |b[i]|); infinity on a size mismatch or
+// a NaN on either side.
+inline Scalar max_error(std::span<const Scalar> a, std::span<const Scalar> b) {
+    if (a.size() != b.size()) {
+        return INFINITY;
+    }
+    Scalar worst = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        const Scalar err = std::abs(a[i] - b[i]) / std::max<Scalar>(1.0, std::abs(b[i]));
+        if (std::isnan(err)) {
+            return INFINITY;
+        }
+        worst = std::max(worst, err);
+    }
+    return worst;
+}
+
+inline int result() {
+    if (failures() != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace fnn::test
+
+#define FNN_CHECK(cond)                                                                   \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            ::fnn::test::fail(__FILE__, __LINE__, #cond);                                 \
+        }                                                                                 \
+    } while (false)
+
+// max_error(actual, expected) <= tol, reporting the error and `context`
+// (a printf-style format and arguments) on failure.
+#define FNN_CHECK_CLOSE(actual, expected, tol, ...)                                       \
+    do {                                                                                  \
+        const auto fnn_err_ = ::fnn::test::max_error(actual, expected);                   \
+        if (!(fnn_err_ <= (tol))) {                                                       \
+            std::fprintf(stderr, "  error %.3g > %.3g in: ", fnn_err_, double(tol));      \
+            std::fprintf(stderr, __VA_ARGS__);                                            \
+            std::fprintf(stderr, "\n");                                                   \
+            ::fnn::test::fail(__FILE__, __LINE__, #actual " ~ " #expected);               \
+        }                                                                                 \
+    } while (false)
+
+#define FNN_CHECK_THROWS(expr, type)                                                      \
+    do {                                                                                  \
+        bool fnn_thrown_ = false;                                                         \
+        try {                                                                             \
+            (void)(expr);                                                                 \
+        } catch (const type&) {                                                           \
+            fnn_thrown_ = true;                                                           \
+        }                                                                                 \
+        if (!fnn_thrown_) {                                                               \
+            ::fnn::test::fail(__FILE__, __LINE__, #expr " throws " #type);                \
+        }                                                                                 \
+    } while (false)